@@ -0,0 +1,164 @@
+#include "arena.h"
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT alignof(max_align_t)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t capacity;          // Usable bytes after the header
+    size_t used;
+} ArenaBlock;
+
+// Record of a heap block adopted by the arena, allocated from the arena itself
+typedef struct ArenaAdoption {
+    struct ArenaAdoption* next;
+    void* memory;
+} ArenaAdoption;
+
+// Header size rounded up so the first allocation of a block is aligned
+#define ARENA_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+struct Arena {
+    ArenaBlock* blocks;       // Current block first; only it has room for small requests
+    ArenaAdoption* adopted;   // Heap blocks to free with the arena
+    size_t block_size;
+    ArenaStats stats;
+};
+
+static unsigned char* block_data(ArenaBlock* block) {
+    return (unsigned char*)block + ARENA_HEADER;
+}
+
+static ArenaBlock* create_block(Arena* arena, size_t capacity) {
+    ArenaBlock* block = malloc(ARENA_HEADER + capacity);
+    if (!block) return NULL;
+
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    arena->stats.bytes_reserved += ARENA_HEADER + capacity;
+    arena->stats.blocks++;
+    return block;
+}
+
+Arena* create_arena(size_t block_size) {
+    Arena* arena = malloc(sizeof(Arena));
+    if (!arena) return NULL;
+
+    arena->blocks = NULL;
+    arena->adopted = NULL;
+    arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK;
+    memset(&arena->stats, 0, sizeof(ArenaStats));
+    return arena;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena) return NULL;
+
+    size_t rounded = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    if (rounded < size) return NULL;
+    if (rounded == 0) rounded = ARENA_ALIGNMENT;
+
+    ArenaBlock* block = arena->blocks;
+    if (!block || block->capacity - block->used < rounded) {
+        if (rounded > arena->block_size / 4) {
+            // A block of its own, behind the current one so its free space is kept
+            block = create_block(arena, rounded);
+            if (!block) return NULL;
+            if (arena->blocks) {
+                block->next = arena->blocks->next;
+                arena->blocks->next = block;
+            } else {
+                arena->blocks = block;
+            }
+        } else {
+            block = create_block(arena, arena->block_size);
+            if (!block) return NULL;
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    void* memory = block_data(block) + block->used;
+    block->used += rounded;
+    arena->stats.bytes_allocated += size;
+    arena->stats.allocations++;
+    return memory;
+}
+
+char* arena_strdup(Arena* arena, const char* text) {
+    if (!text) return NULL;
+
+    size_t length = strlen(text);
+    char* copy = arena_alloc(arena, length + 1);
+    if (copy) memcpy(copy, text, length + 1);
+    return copy;
+}
+
+int arena_adopt(Arena* arena, void* memory) {
+    if (!memory) return 1;
+    if (!arena) return 0;
+
+    ArenaAdoption* adoption = arena_alloc(arena, sizeof(ArenaAdoption));
+    if (!adoption) return 0;
+    adoption->memory = memory;
+    adoption->next = arena->adopted;
+    arena->adopted = adoption;
+    arena->stats.adopted++;
+    return 1;
+}
+
+void absorb_arena(Arena* arena, Arena* other) {
+    if (!arena || !other || arena == other) return;
+
+    // The other arena's blocks go behind the current block, which keeps its free space
+    if (other->blocks) {
+        ArenaBlock* last = other->blocks;
+        while (last->next) last = last->next;
+        if (arena->blocks) {
+            last->next = arena->blocks->next;
+            arena->blocks->next = other->blocks;
+        } else {
+            arena->blocks = other->blocks;
+        }
+    }
+    if (other->adopted) {
+        ArenaAdoption* last = other->adopted;
+        while (last->next) last = last->next;
+        last->next = arena->adopted;
+        arena->adopted = other->adopted;
+    }
+    arena->stats.bytes_allocated += other->stats.bytes_allocated;
+    arena->stats.bytes_reserved += other->stats.bytes_reserved;
+    arena->stats.allocations += other->stats.allocations;
+    arena->stats.blocks += other->stats.blocks;
+    arena->stats.adopted += other->stats.adopted;
+    free(other);
+}
+
+void get_arena_stats(const Arena* arena, ArenaStats* stats) {
+    if (!stats) return;
+    if (arena) {
+        *stats = arena->stats;
+    } else {
+        memset(stats, 0, sizeof(ArenaStats));
+    }
+}
+
+void free_arena(Arena* arena) {
+    if (!arena) return;
+
+    // The adoption records live in the blocks, so release what they point to first
+    for (ArenaAdoption* adoption = arena->adopted; adoption; adoption = adoption->next) {
+        free(adoption->memory);
+    }
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
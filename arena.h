@@ -0,0 +1,59 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Default block size; requests over a quarter of the block size get a block of their own
+#define ARENA_DEFAULT_BLOCK ((size_t)64 << 10)
+
+/**
+ * Region allocator: allocations are carved in order from large blocks and are never
+ * freed one by one; free_arena() releases them all at once. Not thread-safe: use one
+ * arena per thread and merge them afterwards with absorb_arena().
+ */
+typedef struct Arena Arena;
+
+typedef struct {
+    size_t bytes_allocated;   // Sum of the requested sizes
+    size_t bytes_reserved;    // Size of the blocks
+    long long allocations;
+    int blocks;
+    long long adopted;        // Heap blocks handed over with arena_adopt()
+} ArenaStats;
+
+/**
+ * @param block_size Size of each block (0 for ARENA_DEFAULT_BLOCK)
+ * @return New empty arena, or NULL on allocation failure
+ */
+Arena* create_arena(size_t block_size);
+
+/**
+ * Allocate size bytes, aligned for any type
+ * @return The memory (uninitialized), or NULL on allocation failure
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * Copy of text in the arena (NULL for NULL text or on allocation failure)
+ */
+char* arena_strdup(Arena* arena, const char* text);
+
+/**
+ * Hand a malloc'd block to the arena, which frees it in free_arena(): memory built on
+ * the heap can then live as long as the arena without being copied into it
+ * @return 1 if the arena owns memory (or memory is NULL), 0 on allocation failure (the
+ *         caller still owns it)
+ */
+int arena_adopt(Arena* arena, void* memory);
+
+/**
+ * Move the blocks, adopted memory and statistics of other into arena and free other; what was
+ * allocated from other stays valid until arena is freed
+ */
+void absorb_arena(Arena* arena, Arena* other);
+
+void get_arena_stats(const Arena* arena, ArenaStats* stats);
+
+void free_arena(Arena* arena);
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * Times parse_git_diff() on synthetic single-file diffs of growing size against the
+ * strcat-based parser it replaced (kept below as legacy_parse_diff), which rescans the
+ * whole hunk buffer on every appended line. Half the lines are removals and half are
+ * additions, about 45 bytes each. Both parsers must produce the same modifications, so
+ * their counts and code bytes are printed next to the times as a check.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -I. -o diff_parse_benchmark benchmarks/diff_parse_benchmark.c \
+ *       $(ls *.c | grep -v '^main.c$') -lm -pthread
+ * Run anywhere (no repository needed):
+ *   diff_parse_benchmark [--lines 10000,100000,1000000] [--legacy-max N]
+ * The legacy parser is quadratic, so sizes above --legacy-max (default 100000) are
+ * only timed with parse_git_diff().
+ */
+#include "git_local.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SIZES 16
+#define LEGACY_MAX_LINE_LENGTH 2048
+
+typedef struct {
+    int modifications;
+    long long code_bytes;
+} DiffTotals;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// The diff parser as it was before hunks went into string builders
+static List* legacy_parse_diff(FILE* fp) {
+    List* modifications = initialize_list();
+    char line[LEGACY_MAX_LINE_LENGTH];
+    char* current_file = NULL;
+    char* old_code = NULL;
+    char* new_code = NULL;
+    size_t old_code_len = 0;
+    size_t new_code_len = 0;
+    size_t old_code_capacity = 1024;
+    size_t new_code_capacity = 1024;
+    int start_line = 0;
+    int in_hunk = 0;
+
+    old_code = malloc(old_code_capacity);
+    new_code = malloc(new_code_capacity);
+    if (!old_code || !new_code) {
+        free(old_code);
+        free(new_code);
+        return modifications;
+    }
+    old_code[0] = '\0';
+    new_code[0] = '\0';
+
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = 0;
+
+        if (strncmp(line, "diff --git", 10) == 0) {
+            if (current_file && (old_code_len > 0 || new_code_len > 0)) {
+                Modification* mod = initialize_modification(current_file, old_code, new_code, start_line);
+                if (mod) insert_item(modifications, mod);
+            }
+
+            old_code[0] = '\0';
+            new_code[0] = '\0';
+            old_code_len = 0;
+            new_code_len = 0;
+            start_line = 0;
+            in_hunk = 0;
+
+            char* space = strchr(line + 11, ' ');
+            if (space) {
+                char* filename = space + 3;
+                free(current_file);
+                current_file = malloc(strlen(filename) + 1);
+                if (current_file) {
+                    strcpy(current_file, filename);
+                }
+            }
+        }
+        else if (strncmp(line, "@@", 2) == 0) {
+            char* plus_pos = strchr(line, '+');
+            if (plus_pos) {
+                start_line = atoi(plus_pos + 1);
+            }
+            in_hunk = 1;
+        }
+        else if (in_hunk) {
+            if (line[0] == '-' && line[1] != '-') {
+                size_t line_len = strlen(line + 1) + 1;
+                if (old_code_len + line_len + 1 >= old_code_capacity) {
+                    old_code_capacity *= 2;
+                    char* temp = realloc(old_code, old_code_capacity);
+                    if (temp) {
+                        old_code = temp;
+                    } else {
+                        continue;
+                    }
+                }
+                strcat(old_code, line + 1);
+                strcat(old_code, "\n");
+                old_code_len += line_len;
+            }
+            else if (line[0] == '+' && line[1] != '+') {
+                size_t line_len = strlen(line + 1) + 1;
+                if (new_code_len + line_len + 1 >= new_code_capacity) {
+                    new_code_capacity *= 2;
+                    char* temp = realloc(new_code, new_code_capacity);
+                    if (temp) {
+                        new_code = temp;
+                    } else {
+                        continue;
+                    }
+                }
+                strcat(new_code, line + 1);
+                strcat(new_code, "\n");
+                new_code_len += line_len;
+            }
+        }
+    }
+
+    if (current_file && (old_code_len > 0 || new_code_len > 0)) {
+        Modification* mod = initialize_modification(current_file, old_code, new_code, start_line);
+        if (mod) insert_item(modifications, mod);
+    }
+
+    free(current_file);
+    free(old_code);
+    free(new_code);
+    return modifications;
+}
+
+// A single-file diff whose hunk has lines changed lines, alternating - and +
+static FILE* write_synthetic_diff(int lines) {
+    FILE* fp = tmpfile();
+    if (!fp) return NULL;
+
+    fprintf(fp, "diff --git a/src/generated.c b/src/generated.c\n");
+    fprintf(fp, "index 0123456..89abcde 100644\n");
+    fprintf(fp, "--- a/src/generated.c\n");
+    fprintf(fp, "+++ b/src/generated.c\n");
+    fprintf(fp, "@@ -1,%d +1,%d @@\n", lines / 2, lines - lines / 2);
+    for (int i = 0; i < lines; i++) {
+        fprintf(fp, "%c    value_%08d = compute_entry(table, %08d);\n", i % 2 ? '+' : '-', i, i);
+    }
+    rewind(fp);
+    return fp;
+}
+
+static DiffTotals count_modifications(List* modifications) {
+    DiffTotals totals = {0, 0};
+    for (Node* node = modifications ? get_first_node(modifications) : NULL; node; node = get_next_node(node)) {
+        Modification* mod = (Modification*)get_node_data(node);
+        const char* old_code = get_modification_old_code(mod);
+        const char* new_code = get_modification_new_code(mod);
+        totals.modifications++;
+        totals.code_bytes += (long long)(old_code ? strlen(old_code) : 0) + (long long)(new_code ? strlen(new_code) : 0);
+    }
+    return totals;
+}
+
+static void free_modifications(List* modifications) {
+    for (Node* node = modifications ? get_first_node(modifications) : NULL; node; node = get_next_node(node)) {
+        free_modification((Modification*)get_node_data(node));
+    }
+    free_list(modifications);
+}
+
+// Seconds to parse fp from the start, or a negative time on failure
+static double time_parse(List* (*parse)(FILE*), FILE* fp, DiffTotals* totals) {
+    rewind(fp);
+    double start = now_seconds();
+    List* modifications = parse(fp);
+    double elapsed = now_seconds() - start;
+    if (!modifications) return -1.0;
+
+    *totals = count_modifications(modifications);
+    free_modifications(modifications);
+    return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int sizes[MAX_SIZES] = {10000, 100000, 1000000};
+    int size_count = 3;
+    int legacy_max = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            size_count = 0;
+            for (char* token = strtok(argv[++i], ","); token && size_count < MAX_SIZES; token = strtok(NULL, ",")) {
+                sizes[size_count++] = atoi(token);
+            }
+        } else if (strcmp(argv[i], "--legacy-max") == 0 && i + 1 < argc) {
+            legacy_max = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--lines 10000,100000,1000000] [--legacy-max N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%10s %12s %12s %14s %14s\n", "Lines", "Current", "Legacy", "Modifications", "Code bytes");
+    for (int i = 0; i < size_count; i++) {
+        FILE* fp = write_synthetic_diff(sizes[i]);
+        if (!fp) {
+            fprintf(stderr, "Error: could not create a temporary file\n");
+            return 1;
+        }
+
+        DiffTotals current_totals = {0, 0};
+        DiffTotals legacy_totals = {0, 0};
+        double current = time_parse(parse_git_diff, fp, &current_totals);
+        double legacy = sizes[i] <= legacy_max ? time_parse(legacy_parse_diff, fp, &legacy_totals) : -1.0;
+        fclose(fp);
+
+        char legacy_text[32];
+        if (sizes[i] > legacy_max) {
+            snprintf(legacy_text, sizeof(legacy_text), "skipped");
+        } else if (legacy < 0) {
+            snprintf(legacy_text, sizeof(legacy_text), "failed");
+        } else if (legacy_totals.modifications != current_totals.modifications ||
+                   legacy_totals.code_bytes != current_totals.code_bytes) {
+            snprintf(legacy_text, sizeof(legacy_text), "MISMATCH");
+        } else {
+            snprintf(legacy_text, sizeof(legacy_text), "%.3fs", legacy);
+        }
+
+        if (current < 0) {
+            printf("%10d %12s %12s\n", sizes[i], "failed", legacy_text);
+        } else {
+            printf("%10d %11.3fs %12s %14d %14lld\n", sizes[i], current, legacy_text,
+                   current_totals.modifications, current_totals.code_bytes);
+        }
+    }
+    return 0;
+}
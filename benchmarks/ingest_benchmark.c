@@ -0,0 +1,132 @@
+/**
+ * Times get_git_commits() for each ingestion mode on the repository in the current
+ * directory. Every mode must load the same history, so the commit, modification and
+ * diff byte counts are printed next to the times as a check.
+ *
+ * Build from the repository root:
+ *   gcc -O2 -std=c11 -I. -o ingest_benchmark benchmarks/ingest_benchmark.c \
+ *       $(ls *.c | grep -v '^main.c$') -lm -pthread
+ * Run inside the repository to measure:
+ *   ingest_benchmark [--max-commits N] [--runs N] [--workers 1,2,4]
+ * Per-commit ingestion is timed once per worker count in the --workers list (0 = one
+ * per CPU; default 1 and 0), then streamed and native ingestion.
+ */
+#include "git_local.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_WORKER_COUNTS 16
+
+typedef struct {
+    char name[32];
+    GitIngestMode mode;
+    int workers;
+} IngestCase;
+
+typedef struct {
+    int commits;
+    long long modifications;
+    long long diff_bytes;
+} IngestTotals;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static IngestTotals count_history(List* commits) {
+    IngestTotals totals = {0, 0, 0};
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        totals.commits++;
+        List* mods = get_commit_modifications(commit);
+        for (Node* m = mods ? get_first_node(mods) : NULL; m; m = get_next_node(m)) {
+            Modification* mod = (Modification*)get_node_data(m);
+            const char* old_code = get_modification_old_code(mod);
+            const char* new_code = get_modification_new_code(mod);
+            totals.modifications++;
+            totals.diff_bytes += (long long)(old_code ? strlen(old_code) : 0) + (long long)(new_code ? strlen(new_code) : 0);
+        }
+    }
+    return totals;
+}
+
+// Best wall time of runs loads, or a negative time if a load failed
+static double time_ingest(const IngestCase* ingest, int max_commits, int runs, IngestTotals* totals) {
+    double best = -1.0;
+    set_git_ingest_mode(ingest->mode);
+    set_git_diff_workers(ingest->workers);
+
+    for (int run = 0; run < runs; run++) {
+        double start = now_seconds();
+        List* commits = get_git_commits(max_commits);
+        double elapsed = now_seconds() - start;
+        if (!commits) return -1.0;
+
+        *totals = count_history(commits);
+        free_commit_list(commits);
+        cleanup_git_data();
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int max_commits = 0;
+    int runs = 3;
+    int workers[MAX_WORKER_COUNTS] = {1, 0};
+    int worker_count = 2;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-commits") == 0 && i + 1 < argc) {
+            max_commits = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            worker_count = 0;
+            for (char* token = strtok(argv[++i], ","); token && worker_count < MAX_WORKER_COUNTS; token = strtok(NULL, ",")) {
+                workers[worker_count++] = atoi(token);
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--max-commits N] [--runs N] [--workers 1,2,4]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (runs < 1) runs = 1;
+
+    IngestCase cases[MAX_WORKER_COUNTS + 2];
+    int case_count = 0;
+    for (int i = 0; i < worker_count; i++) {
+        IngestCase* ingest = &cases[case_count++];
+        if (workers[i] > 0) {
+            snprintf(ingest->name, sizeof(ingest->name), "per-commit x%d", workers[i]);
+        } else {
+            snprintf(ingest->name, sizeof(ingest->name), "per-commit xCPU");
+        }
+        ingest->mode = GIT_INGEST_PER_COMMIT;
+        ingest->workers = workers[i];
+    }
+    cases[case_count++] = (IngestCase){"streamed", GIT_INGEST_STREAMED, 1};
+    cases[case_count++] = (IngestCase){"native", GIT_INGEST_NATIVE, 1};
+
+    double seconds[MAX_WORKER_COUNTS + 2];
+    IngestTotals totals[MAX_WORKER_COUNTS + 2];
+
+    for (int i = 0; i < case_count; i++) {
+        seconds[i] = time_ingest(&cases[i], max_commits, runs, &totals[i]);
+    }
+
+    printf("\n%-16s %10s %8s %14s %14s\n", "Mode", "Seconds", "Commits", "Modifications", "Diff bytes");
+    for (int i = 0; i < case_count; i++) {
+        if (seconds[i] < 0) {
+            printf("%-16s %10s\n", cases[i].name, "failed");
+            continue;
+        }
+        printf("%-16s %10.3f %8d %14lld %14lld\n", cases[i].name, seconds[i],
+               totals[i].commits, totals[i].modifications, totals[i].diff_bytes);
+    }
+    printf("(best of %d run%s each)\n", runs, runs == 1 ? "" : "s");
+    return 0;
+}
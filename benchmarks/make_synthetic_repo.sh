@@ -0,0 +1,93 @@
+#!/bin/sh
+# Create a git repository with a reproducible synthetic history for the benchmarks:
+# seven 200-line files, then COMMITS commits by three authors, each editing 1-3 files
+# at 1-8 random lines (the same history on every run).
+#
+# Usage: benchmarks/make_synthetic_repo.sh DIRECTORY [COMMITS]
+set -e
+
+if [ -z "$1" ]; then
+    echo "Usage: $0 DIRECTORY [COMMITS]" >&2
+    exit 1
+fi
+DIR=$1
+COMMITS=${2:-400}
+
+if [ -e "$DIR" ]; then
+    echo "Error: $DIR already exists" >&2
+    exit 1
+fi
+mkdir -p "$DIR"
+cd "$DIR"
+git init -q
+git config user.name "Dev One"
+git config user.email "one@example.com"
+
+FILES="src/a.c src/b.c src/c.h test/t1.c docs/x.md config.json lib/util.c"
+for f in $FILES; do
+    mkdir -p "$(dirname "$f")"
+    awk -v f="$f" 'BEGIN { for (i = 0; i < 200; i++) printf "line %d of %s\n", i, f }' > "$f"
+done
+git add -A
+GIT_AUTHOR_DATE="1700000000 +0000" GIT_COMMITTER_DATE="1700000000 +0000" git commit -qm "initial import"
+
+when=1700000000
+c=0
+while [ "$c" -lt "$COMMITS" ]; do
+    # Files, author, message and time step of commit c
+    set -- $(awk -v seed="$c" -v files="$FILES" 'BEGIN {
+        srand(seed + 1)
+        n = split(files, f, " ")
+        picks = 1 + int(rand() * 3)
+        for (i = 1; i <= picks; i++) {
+            j = i + int(rand() * (n - i + 1))
+            t = f[i]; f[i] = f[j]; f[j] = t
+        }
+        printf "%d %d %d", 1 + int(rand() * 3), int(rand() * 6), 60 + int(rand() * 7141)
+        for (i = 1; i <= picks; i++) printf " %s", f[i]
+    }')
+    author=$1 kind=$2 step=$3
+    shift 3
+
+    for f in "$@"; do
+        awk -v seed="$c" -v salt="$f" 'BEGIN { srand(seed * 31 + length(salt)) }
+            { lines[n++] = $0 }
+            END {
+                edits = 1 + int(rand() * 8)
+                for (e = 0; e < edits; e++) {
+                    i = int(rand() * n); op = rand()
+                    if (op < 0.4) {
+                        lines[i] = "changed " seed " " i
+                    } else if (op < 0.7) {
+                        for (k = n; k > i; k--) lines[k] = lines[k - 1]
+                        lines[i] = "inserted " seed; n++
+                    } else if (n > 5) {
+                        for (k = i; k < n - 1; k++) lines[k] = lines[k + 1]
+                        n--
+                    }
+                }
+                for (k = 0; k < n; k++) print lines[k]
+            }' "$f" > "$f.tmp"
+        mv "$f.tmp" "$f"
+    done
+
+    case $author in
+        1) name="Dev One" email="one@example.com" ;;
+        2) name="Dev Two" email="two@example.com" ;;
+        *) name="Dev Three" email="three@example.com" ;;
+    esac
+    case $kind in
+        0) message="fix: bug in parser" ;;
+        1) message="feat: add new option" ;;
+        2) message="refactor cleanup module" ;;
+        3) message="docs: update readme" ;;
+        4) message="test: add spec" ;;
+        *) message="chore: bump" ;;
+    esac
+    when=$((when + step))
+    GIT_AUTHOR_NAME="$name" GIT_AUTHOR_EMAIL="$email" \
+    GIT_AUTHOR_DATE="$when +0000" GIT_COMMITTER_DATE="$when +0000" \
+        git commit -qam "$message #$c"
+    c=$((c + 1))
+done
+echo "Created $DIR with $((COMMITS + 1)) commits"
@@ -3,42 +3,160 @@
 #include <string.h>
 #include <stdio.h>
 
+// AVL tree: the heights of a node's subtrees differ by at most one, so the height
+// stays below 1.45 log2(n) even for sorted input (git log order) and the recursive
+// functions below never go deep
 struct TreeNode{
 
     void* data;
     TreeNode* left;
     TreeNode* right;
+    int height;     // Longest path down to a leaf (0 for a leaf)
 
 };  
 
 TreeNode* initialize_tree(void* data){
 
     TreeNode* tree = malloc(sizeof(TreeNode));
+    if(tree == NULL){
+        return NULL;
+    }
     tree->data = data;
     tree->left = NULL;
     tree->right = NULL;
+    tree->height = 0;
     return tree;
 
 }
 
+static int node_height(TreeNode* tree){
+    return tree == NULL ? -1 : tree->height;
+}
+
+static void update_height(TreeNode* tree){
+    int left_height = node_height(tree->left);
+    int right_height = node_height(tree->right);
+    tree->height = 1 + (left_height > right_height ? left_height : right_height);
+}
+
+static TreeNode* rotate_right(TreeNode* tree){
+    TreeNode* pivot = tree->left;
+    tree->left = pivot->right;
+    pivot->right = tree;
+    update_height(tree);
+    update_height(pivot);
+    return pivot;
+}
+
+static TreeNode* rotate_left(TreeNode* tree){
+    TreeNode* pivot = tree->right;
+    tree->right = pivot->left;
+    pivot->left = tree;
+    update_height(tree);
+    update_height(pivot);
+    return pivot;
+}
+
+// Restore the AVL property at a node whose subtrees are balanced and differ in height by at most two
+static TreeNode* rebalance(TreeNode* tree){
+    update_height(tree);
+    int balance = node_height(tree->left) - node_height(tree->right);
+    
+    if(balance > 1){
+        if(node_height(tree->left->left) < node_height(tree->left->right)){
+            tree->left = rotate_left(tree->left);
+        }
+        return rotate_right(tree);
+    }
+    if(balance < -1){
+        if(node_height(tree->right->right) < node_height(tree->right->left)){
+            tree->right = rotate_right(tree->right);
+        }
+        return rotate_left(tree);
+    }
+    return tree;
+}
+
 TreeNode* insert_bst(TreeNode* tree, void* data, int (*compare)(void* a, void* b)){
     
     if(tree == NULL){
-        tree = (TreeNode*)malloc(sizeof(TreeNode));
-        tree->data = data;
-        tree->left = tree->right = NULL;
+        return initialize_tree(data);
+    }
+    
+    int cmp = compare(data, tree->data);
+    if(cmp < 0){
+        tree->left = insert_bst(tree->left, data, compare);
+    }
+    else if(cmp > 0){ 
+        tree->right = insert_bst(tree->right, data, compare);
     }
     else {
-        int cmp = compare(data, tree->data);
-        if(cmp < 0){
-            tree->left = insert_bst(tree->left, data, compare);
+        /* if cmp == 0, data already exists, don't insert duplicates */
+        return tree;
+    }
+    
+    return rebalance(tree);
+}
+
+// Perfectly balanced tree over items[first, last] (sorted, no duplicates)
+static TreeNode* build_balanced(void** items, int first, int last){
+    
+    if(first > last){
+        return NULL;
+    }
+    
+    int middle = first + (last - first) / 2;
+    TreeNode* tree = initialize_tree(items[middle]);
+    if(tree == NULL){
+        return NULL;
+    }
+    tree->left = build_balanced(items, first, middle - 1);
+    tree->right = build_balanced(items, middle + 1, last);
+    update_height(tree);
+    return tree;
+}
+
+TreeNode* build_bst(void** items, int count, int (*compare)(void* a, void* b)){
+    
+    if(items == NULL || count <= 0){
+        return NULL;
+    }
+    
+    // Sorted one way or the other (git log lists commits newest first)?
+    int ascending = 1;
+    int descending = 1;
+    for(int i = 1; i < count && (ascending || descending); i++){
+        int cmp = compare(items[i - 1], items[i]);
+        if(cmp > 0) ascending = 0;
+        if(cmp < 0) descending = 0;
+    }
+    
+    void** sorted = (ascending || descending) ? malloc(count * sizeof(void*)) : NULL;
+    if(sorted == NULL){
+        TreeNode* tree = NULL;
+        for(int i = 0; i < count; i++){
+            tree = insert_bst(tree, items[i], compare);
         }
-        else if(cmp > 0){ 
-            tree->right = insert_bst(tree->right, data, compare);
+        return tree;
+    }
+    
+    // Keep the first of each run of equal items, as inserting them in order would
+    int kept = 0;
+    for(int i = 0; i < count; i++){
+        if(kept == 0 || compare(sorted[kept - 1], items[i]) != 0){
+            sorted[kept++] = items[i];
+        }
+    }
+    if(!ascending){
+        for(int i = 0, j = kept - 1; i < j; i++, j--){
+            void* item = sorted[i];
+            sorted[i] = sorted[j];
+            sorted[j] = item;
         }
-        /* if cmp == 0, data already exists, don't insert duplicates */
     }
     
+    TreeNode* tree = build_balanced(sorted, 0, kept - 1);
+    free(sorted);
     return tree;
 }
 
@@ -152,25 +270,11 @@ TreeNode* delete_node(TreeNode* tree, void* data, int (*compare)(void* a, void*
         }
     }
     
-    return tree;
+    return rebalance(tree);
 }
 
 int tree_height(TreeNode* tree){
-    if(tree == NULL){
-        return -1;  // Height of empty tree is -1
-    }
-    
-    int left_height = tree_height(tree->left);
-    int right_height = tree_height(tree->right);
-    
-    int max_height;
-    if(left_height > right_height){
-        max_height = left_height;
-    } else {
-        max_height = right_height;
-    }
-    
-    return 1 + max_height;
+    return node_height(tree);  // Height of empty tree is -1
 }
 
 int tree_size(TreeNode* tree){
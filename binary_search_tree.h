@@ -5,7 +5,12 @@ typedef struct TreeNode TreeNode;
 
 // Core tree functions
 TreeNode* create_node(void* data);
+// Insert keeps the tree balanced (AVL), so n inserts cost O(n log n) in any order;
+// data equal to an existing item is not inserted
 TreeNode* insert_bst(TreeNode* tree, void* data, int (*compare)(void* a, void* b));
+// Build a balanced tree from count items: O(n) if they are already sorted by compare
+// (ascending or descending), otherwise inserted one by one. Equal items keep the first.
+TreeNode* build_bst(void** items, int count, int (*compare)(void* a, void* b));
 TreeNode* search(TreeNode* tree, void* data, int (*compare)(void* a, void* b));
 TreeNode* delete_node(TreeNode* tree, void* data, int (*compare)(void* a, void* b));
 void free_tree(TreeNode* tree);
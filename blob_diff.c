@@ -0,0 +1,248 @@
+#include "blob_diff.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DIFF_CONTEXT_LINES 3
+#define MAX_EDIT_DISTANCE 2048   // Beyond this the changed middle is reported as fully replaced
+#define BINARY_CHECK_BYTES 8000
+
+typedef struct {
+    const char* start;
+    size_t length;        // Includes the trailing '\n' when present
+    unsigned long hash;
+} DiffLine;
+
+static DiffLine* split_lines(const char* data, size_t size, int* count) {
+    *count = 0;
+    if (!data || size == 0) return malloc(sizeof(DiffLine)); // Non-NULL placeholder
+
+    int lines = 0;
+    for (size_t i = 0; i < size; i++) if (data[i] == '\n') lines++;
+    if (data[size - 1] != '\n') lines++;
+
+    DiffLine* result = malloc(lines * sizeof(DiffLine));
+    if (!result) return NULL;
+
+    const char* p = data;
+    const char* end = data + size;
+    int index = 0;
+    while (p < end) {
+        const char* newline = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = newline ? newline + 1 : end;
+
+        unsigned long hash = 5381;
+        for (const char* c = p; c < line_end; c++) hash = hash * 33 + (unsigned char)*c;
+
+        result[index].start = p;
+        result[index].length = (size_t)(line_end - p);
+        result[index].hash = hash;
+        index++;
+        p = line_end;
+    }
+
+    *count = index;
+    return result;
+}
+
+static int lines_equal(const DiffLine* a, const DiffLine* b) {
+    return a->hash == b->hash && a->length == b->length && memcmp(a->start, b->start, a->length) == 0;
+}
+
+// Mark changed lines of a[0..n) and b[0..m) with Myers' O(ND) algorithm.
+// Returns 0 if the edit distance exceeds MAX_EDIT_DISTANCE or memory runs out.
+static int mark_changes_myers(const DiffLine* a, int n, const DiffLine* b, int m, char* a_changed, char* b_changed) {
+    int max_d = n + m;
+    if (max_d > MAX_EDIT_DISTANCE) max_d = MAX_EDIT_DISTANCE;
+
+    int offset = max_d + 1;
+    int* v = calloc((size_t)(2 * max_d + 3), sizeof(int));
+    int** trace = calloc((size_t)(max_d + 1), sizeof(int*));
+    if (!v || !trace) {
+        free(v);
+        free(trace);
+        return 0;
+    }
+
+    int found_d = -1;
+    for (int d = 0; d <= max_d && found_d < 0; d++) {
+        // Snapshot of the furthest-reaching paths before step d, for k in [-d, d]
+        trace[d] = malloc((size_t)(2 * d + 1) * sizeof(int));
+        if (!trace[d]) break;
+        memcpy(trace[d], v + offset - d, (size_t)(2 * d + 1) * sizeof(int));
+
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+                x = v[offset + k + 1];       // Step down: insertion
+            } else {
+                x = v[offset + k - 1] + 1;   // Step right: deletion
+            }
+            int y = x - k;
+            while (x < n && y < m && lines_equal(&a[x], &b[y])) {
+                x++;
+                y++;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                found_d = d;
+                break;
+            }
+        }
+    }
+
+    if (found_d >= 0) {
+        // Walk the snapshots backwards to recover which lines were edited
+        int x = n, y = m;
+        for (int d = found_d; d > 0; d--) {
+            const int* vd = trace[d];
+            int k = x - y;
+            int prev_k;
+            if (k == -d || (k != d && vd[k - 1 + d] < vd[k + 1 + d])) {
+                prev_k = k + 1;
+            } else {
+                prev_k = k - 1;
+            }
+            int prev_x = vd[prev_k + d];
+            int prev_y = prev_x - prev_k;
+
+            while (x > prev_x && y > prev_y) {
+                x--;
+                y--;
+            }
+            if (x == prev_x) {
+                b_changed[prev_y] = 1;
+            } else {
+                a_changed[prev_x] = 1;
+            }
+            x = prev_x;
+            y = prev_y;
+        }
+    }
+
+    for (int d = 0; d <= max_d; d++) free(trace[d]);
+    free(trace);
+    free(v);
+    return found_d >= 0;
+}
+
+// Concatenate the marked lines, each terminated by exactly one '\n'
+static char* join_changed_lines(const DiffLine* lines, const char* changed, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        if (!changed[i]) continue;
+        size_t length = lines[i].length;
+        if (length > 0 && lines[i].start[length - 1] == '\n') length--;
+        total += length + 1;
+    }
+
+    char* result = malloc(total + 1);
+    if (!result) return NULL;
+
+    size_t pos = 0;
+    for (int i = 0; i < count; i++) {
+        if (!changed[i]) continue;
+        size_t length = lines[i].length;
+        if (length > 0 && lines[i].start[length - 1] == '\n') length--;
+        memcpy(result + pos, lines[i].start, length);
+        pos += length;
+        result[pos++] = '\n';
+    }
+    result[pos] = '\0';
+    return result;
+}
+
+int diff_blobs(const char* old_data, size_t old_size, const char* new_data, size_t new_size, BlobDiff* result) {
+    if (!result) return 0;
+    result->removed_lines = NULL;
+    result->added_lines = NULL;
+    result->start_line = 0;
+    result->changed = 0;
+
+    int n, m;
+    DiffLine* a = split_lines(old_data, old_size, &n);
+    DiffLine* b = split_lines(new_data, new_size, &m);
+    char* a_changed = calloc((size_t)n + 1, 1);
+    char* b_changed = calloc((size_t)m + 1, 1);
+    if (!a || !b || !a_changed || !b_changed) {
+        free(a);
+        free(b);
+        free(a_changed);
+        free(b_changed);
+        return 0;
+    }
+
+    // Common prefix and suffix never take part in the edit script
+    int prefix = 0;
+    while (prefix < n && prefix < m && lines_equal(&a[prefix], &b[prefix])) prefix++;
+    int suffix = 0;
+    while (suffix < n - prefix && suffix < m - prefix &&
+           lines_equal(&a[n - 1 - suffix], &b[m - 1 - suffix])) {
+        suffix++;
+    }
+
+    int middle_n = n - prefix - suffix;
+    int middle_m = m - prefix - suffix;
+    int replace_middle = (middle_n == 0 || middle_m == 0);
+    if (!replace_middle &&
+        !mark_changes_myers(a + prefix, middle_n, b + prefix, middle_m, a_changed + prefix, b_changed + prefix)) {
+        // Too different (or out of memory): report the whole middle as replaced
+        replace_middle = 1;
+    }
+    if (replace_middle) {
+        memset(a_changed + prefix, 1, (size_t)middle_n);
+        memset(b_changed + prefix, 1, (size_t)middle_m);
+    }
+
+    // Locate the last hunk the way unified diff groups changes: runs of more
+    // than 2 * context equal lines split hunks
+    int i = 0, j = 0, equal_run = 0, hunk_new_start = 0;
+    while (i < n || j < m) {
+        if (i < n && a_changed[i]) {
+            if (!result->changed || equal_run > 2 * DIFF_CONTEXT_LINES) hunk_new_start = j;
+            result->changed = 1;
+            equal_run = 0;
+            i++;
+        } else if (j < m && b_changed[j]) {
+            if (!result->changed || equal_run > 2 * DIFF_CONTEXT_LINES) hunk_new_start = j;
+            result->changed = 1;
+            equal_run = 0;
+            j++;
+        } else {
+            i++;
+            j++;
+            equal_run++;
+        }
+    }
+    if (result->changed && m > 0) {
+        int context_start = hunk_new_start - DIFF_CONTEXT_LINES;
+        result->start_line = (context_start > 0 ? context_start : 0) + 1;
+    }
+
+    result->removed_lines = join_changed_lines(a, a_changed, n);
+    result->added_lines = join_changed_lines(b, b_changed, m);
+
+    free(a);
+    free(b);
+    free(a_changed);
+    free(b_changed);
+
+    if (!result->removed_lines || !result->added_lines) {
+        free_blob_diff(result);
+        return 0;
+    }
+    return 1;
+}
+
+int is_binary_blob(const char* data, size_t size) {
+    if (!data) return 0;
+    size_t check = size < BINARY_CHECK_BYTES ? size : BINARY_CHECK_BYTES;
+    return memchr(data, '\0', check) != NULL;
+}
+
+void free_blob_diff(BlobDiff* diff) {
+    if (!diff) return;
+    free(diff->removed_lines);
+    free(diff->added_lines);
+    diff->removed_lines = NULL;
+    diff->added_lines = NULL;
+}
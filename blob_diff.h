@@ -0,0 +1,38 @@
+#ifndef BLOB_DIFF_H
+#define BLOB_DIFF_H
+
+#include <stddef.h>
+
+typedef struct BlobDiff BlobDiff;
+
+/**
+ * Line-level difference between two versions of a file, shaped like the
+ * '-' and '+' lines of a unified diff (as consumed by Modification)
+ */
+struct BlobDiff {
+    char* removed_lines;   // Removed lines in order, each terminated by '\n'
+    char* added_lines;     // Added lines in order, each terminated by '\n'
+    int start_line;        // New-file start of the last hunk (3 lines of context), like "+N" in its @@ header
+    int changed;           // Nonzero if at least one line differs
+};
+
+/**
+ * Diff two blobs line by line (Myers algorithm with common prefix/suffix trimming)
+ * @param old_data Old contents (may be NULL when old_size is 0)
+ * @param new_data New contents (may be NULL when new_size is 0)
+ * @param result Receives the removed/added lines; release with free_blob_diff()
+ * @return 1 on success, 0 on allocation failure
+ */
+int diff_blobs(const char* old_data, size_t old_size, const char* new_data, size_t new_size, BlobDiff* result);
+
+/**
+ * Check whether a blob should be treated as binary (NUL byte in its first 8000 bytes, as git does)
+ */
+int is_binary_blob(const char* data, size_t size);
+
+/**
+ * Release the buffers held by a BlobDiff
+ */
+void free_blob_diff(BlobDiff* diff);
+
+#endif
@@ -9,12 +9,16 @@ struct Commit{
     char* message;
     List* modifications;
     long long timestamp; // unix epoch seconds
+    char* hash;          // full commit hash, NULL if unknown
+    Arena* arena;        // Holds the commit and its strings; NULL if they were malloc'd
 };
 
 struct Author{
 
     int author_id;
     char* name;
+    int name_id;         // In the author name table (-1: name is a private copy)
+    Arena* arena;
     
 };
 
@@ -24,94 +28,235 @@ struct Modification {
     char* old_code;      
     char* new_code;    
     int start_line;   
+    int lines_removed;   // Summary of the code, kept when the code itself is not
+    int lines_added;
+    int declares_struct;
+    int path_id;         // In the file path table (-1: filepath is a private copy)
+    Arena* arena;
 };
 
+// Arena new commits, authors and modifications are allocated from (NULL = malloc)
+static Arena* commit_arena = NULL;
+
+void set_commit_arena(Arena* arena){
+    commit_arena = arena;
+}
+
+Arena* get_commit_arena(void){
+    return commit_arena;
+}
+
+// Intern tables shared by new authors and modifications (NULL = private copies)
+static StringTable* author_names = NULL;
+static StringTable* file_paths = NULL;
+
+void set_commit_string_tables(StringTable* names, StringTable* paths){
+    author_names = names;
+    file_paths = paths;
+}
+
+StringTable* get_author_name_table(void){
+    return author_names;
+}
+
+StringTable* get_file_path_table(void){
+    return file_paths;
+}
+
+// new_ids[old id] for a table of count strings: ids still -1 (not seen in the commits)
+// follow the rest in their old order. Returns 0 if the table could not be renumbered.
+static int apply_new_string_ids(StringTable* table, int* new_ids, int count, int next_id){
+    for (int id = 0; id < count; id++) {
+        if (new_ids[id] < 0) new_ids[id] = next_id++;
+    }
+    return renumber_string_table(table, new_ids);
+}
+
+int renumber_commit_strings(List* commits){
+    int name_count = get_string_table_count(author_names);
+    int path_count = get_string_table_count(file_paths);
+    int* name_ids = malloc((name_count > 0 ? name_count : 1) * sizeof(int));
+    int* path_ids = malloc((path_count > 0 ? path_count : 1) * sizeof(int));
+    if (!name_ids || !path_ids) {
+        free(name_ids);
+        free(path_ids);
+        return 0;
+    }
+    for (int id = 0; id < name_count; id++) name_ids[id] = -1;
+    for (int id = 0; id < path_count; id++) path_ids[id] = -1;
+
+    int next_name = 0;
+    int next_path = 0;
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        Author* author = commit ? commit->author : NULL;
+        if (author && author->name_id >= 0 && name_ids[author->name_id] < 0) name_ids[author->name_id] = next_name++;
+        for (Node* m = commit ? get_first_node(commit->modifications) : NULL; m; m = get_next_node(m)) {
+            Modification* mod = (Modification*)get_node_data(m);
+            if (mod && mod->path_id >= 0 && path_ids[mod->path_id] < 0) path_ids[mod->path_id] = next_path++;
+        }
+    }
+
+    // Each table and the ids pointing into it change together
+    int names_done = apply_new_string_ids(author_names, name_ids, name_count, next_name);
+    int paths_done = apply_new_string_ids(file_paths, path_ids, path_count, next_path);
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        Author* author = commit ? commit->author : NULL;
+        if (names_done && author && author->name_id >= 0) {
+            author->name_id = name_ids[author->name_id];
+            author->author_id = author->name_id;
+        }
+        for (Node* m = paths_done && commit ? get_first_node(commit->modifications) : NULL; m; m = get_next_node(m)) {
+            Modification* mod = (Modification*)get_node_data(m);
+            if (mod && mod->path_id >= 0) mod->path_id = path_ids[mod->path_id];
+        }
+    }
+    free(name_ids);
+    free(path_ids);
+    return names_done && paths_done;
+}
+
+static void* allocate_commit_data(size_t size){
+    return commit_arena ? arena_alloc(commit_arena, size) : malloc(size);
+}
+
+// Copy of text from the current arena or the heap; NULL for NULL text or on allocation failure
+static char* copy_commit_string(const char* text){
+    if (!text) return NULL;
+    if (commit_arena) return arena_strdup(commit_arena, text);
+    
+    char* copy = malloc(strlen(text) + 1);
+    if (copy) strcpy(copy, text);
+    return copy;
+}
+
 Commit* initialize_commit(int commit_id, Author* author, List* modifications, char* message, long long timestamp){
-    Commit* commit = malloc(sizeof(Commit));
+    Commit* commit = allocate_commit_data(sizeof(Commit));
     if (!commit) return NULL;
+    commit->arena = commit_arena;
     commit->id = commit_id;
     commit->author = author;
     
-    // Allocate memory for message string
-    if (message) {
-        commit->message = malloc(strlen(message) + 1);
-        if (!commit->message) {
-            free(commit);
-            return NULL;
-        }
-        strcpy(commit->message, message);
-    } else {
-        commit->message = NULL;
+    // Copy the message string
+    commit->message = copy_commit_string(message);
+    if (message && !commit->message) {
+        if (!commit->arena) free(commit);
+        return NULL;
     }
     
     commit->modifications = modifications;
     commit->timestamp = timestamp;
+    commit->hash = NULL;
     return commit;
 }
 
+static int count_code_lines(const char* code){
+    int lines = 0;
+    if (code) {
+        for (const char* p = code; (p = strchr(p, '\n')) != NULL; p++) lines++;
+    }
+    return lines;
+}
+
+// Derive the line counts and struct flag from the code buffers
+static void summarize_modification_code(Modification* mod){
+    mod->lines_removed = count_code_lines(mod->old_code);
+    mod->lines_added = count_code_lines(mod->new_code);
+    mod->declares_struct = mod->new_code && (strstr(mod->new_code, "struct ") || strstr(mod->new_code, "typedef struct"));
+}
+
 Modification* initialize_modification(char* filepath, char* old_code, char* new_code, int start_line){
-    Modification* mod = malloc(sizeof(Modification));
+    Modification* mod = allocate_commit_data(sizeof(Modification));
     if (!mod) return NULL;
+    mod->arena = commit_arena;
 
-    // Allocate memory for filepath string
-    if (filepath) {
-        mod->filepath = malloc(strlen(filepath) + 1);
-        if (!mod->filepath) {
+    // Share the interned filepath, copy both code buffers
+    mod->path_id = intern_string(file_paths, filepath);
+    mod->filepath = mod->path_id >= 0 ? (char*)get_interned_string(file_paths, mod->path_id) : copy_commit_string(filepath);
+    mod->old_code = copy_commit_string(old_code);
+    mod->new_code = copy_commit_string(new_code);
+    if ((filepath && !mod->filepath) || (old_code && !mod->old_code) || (new_code && !mod->new_code)) {
+        if (!mod->arena) {
+            if (mod->path_id < 0) free(mod->filepath);
+            free(mod->old_code);
+            free(mod->new_code);
             free(mod);
-            return NULL;
         }
-        strcpy(mod->filepath, filepath);
-    } else {
-        mod->filepath = NULL;
+        return NULL;
     }
     
-    // Allocate memory for old_code string
-    if (old_code) {
-        mod->old_code = malloc(strlen(old_code) + 1);
-        if (!mod->old_code) {
-            free(mod->filepath);
-            free(mod);
-            return NULL;
-        }
-        strcpy(mod->old_code, old_code);
-    } else {
-        mod->old_code = NULL;
-    }
+    mod->start_line = start_line;
+    summarize_modification_code(mod);
+
+    return mod;
+}
+
+Modification* initialize_modification_summary(char* filepath, int start_line, int lines_removed, int lines_added, int declares_struct){
+    Modification* mod = initialize_modification(filepath, NULL, NULL, start_line);
+    if (!mod) return NULL;
     
-    // Allocate memory for new_code string
-    if (new_code) {
-        mod->new_code = malloc(strlen(new_code) + 1);
-        if (!mod->new_code) {
-            free(mod->filepath);
-            free(mod->old_code);
-            free(mod);
-            return NULL;
+    mod->lines_removed = lines_removed;
+    mod->lines_added = lines_added;
+    mod->declares_struct = declares_struct != 0;
+    return mod;
+}
+
+// Hand the malloc'd strings to the commit arena; those not taken are freed on failure
+static int adopt_commit_strings(char** strings, int count){
+    for (int i = 0; i < count; i++) {
+        if (!arena_adopt(commit_arena, strings[i])) {
+            for (; i < count; i++) free(strings[i]);
+            return 0;
         }
-        strcpy(mod->new_code, new_code);
-    } else {
-        mod->new_code = NULL;
     }
-    
+    return 1;
+}
+
+Modification* adopt_modification(char* filepath, char* old_code, char* new_code, int start_line){
+    Modification* mod = allocate_commit_data(sizeof(Modification));
+    if (!mod) {
+        free(filepath);
+        free(old_code);
+        free(new_code);
+        return NULL;
+    }
+    mod->arena = commit_arena;
+
+    // Share the interned filepath
+    mod->path_id = intern_string(file_paths, filepath);
+    if (mod->path_id >= 0) {
+        free(filepath);
+        filepath = (char*)get_interned_string(file_paths, mod->path_id);
+    }
+
+    // The buffers were built by the caller; keep them as-is instead of copying (an arena
+    // takes them over and frees them with its own memory)
+    if (mod->arena) {
+        char* strings[] = { mod->path_id < 0 ? filepath : NULL, old_code, new_code };
+        if (!adopt_commit_strings(strings, 3)) return NULL;
+    }
+    mod->filepath = filepath;
+    mod->old_code = old_code;
+    mod->new_code = new_code;
     mod->start_line = start_line;
+    summarize_modification_code(mod);
 
     return mod;
 }
 
 Author* initialize_author(int author_id, char* name){
-    Author* author = malloc(sizeof(Author));
+    Author* author = allocate_commit_data(sizeof(Author));
     if (!author) return NULL;
-    author->author_id = author_id;
+    author->arena = commit_arena;
     
-    // Allocate memory for name string
-    if (name) {
-        author->name = malloc(strlen(name) + 1);
-        if (!author->name) {
-            free(author);
-            return NULL;
-        }
-        strcpy(author->name, name);
-    } else {
-        author->name = NULL;
+    // Share the interned name, whose id then identifies the author across commits
+    author->name_id = intern_string(author_names, name);
+    author->author_id = author->name_id >= 0 ? author->name_id : author_id;
+    author->name = author->name_id >= 0 ? (char*)get_interned_string(author_names, author->name_id) : copy_commit_string(name);
+    if (name && !author->name) {
+        if (!author->arena) free(author);
+        return NULL;
     }
     
     return author;
@@ -123,13 +268,8 @@ void print_mod(Modification* mod){
         return;
     }
     
-    // Count lines changed without printing code content
-    int removed_lines = 0;
-    for (const char* p = mod->old_code; *p; ++p) if (*p == '\n') removed_lines++;
-    int added_lines = 0;
-    for (const char* p = mod->new_code; *p; ++p) if (*p == '\n') added_lines++;
-
-    printf("- %s (start: %d, -%d +%d)\n", mod->filepath, mod->start_line, removed_lines, added_lines);
+    // Print the line counts, not the code content
+    printf("- %s (start: %d, -%d +%d)\n", mod->filepath, mod->start_line, mod->lines_removed, mod->lines_added);
 }
 
 void print_commit(Commit* commit){
@@ -192,6 +332,37 @@ int get_commit_id(Commit* commit) {
     return commit->id;
 }
 
+char* get_commit_hash(Commit* commit) {
+    if (!commit) return NULL;
+    return commit->hash;
+}
+
+int set_commit_hash(Commit* commit, const char* hash) {
+    if (!commit) return 0;
+    char* copy = NULL;
+    if (hash) {
+        // Kept with the rest of the commit (a replaced hash stays in the arena until it is freed)
+        if (commit->arena) {
+            copy = arena_strdup(commit->arena, hash);
+        } else {
+            copy = malloc(strlen(hash) + 1);
+            if (copy) strcpy(copy, hash);
+        }
+        if (!copy) return 0;
+    }
+    if (!commit->arena) free(commit->hash);
+    commit->hash = copy;
+    return 1;
+}
+
+void set_commit_id(Commit* commit, int commit_id) {
+    if (!commit) return;
+    commit->id = commit_id;
+    // Without a name table ingestion gives each commit's author record the commit's id;
+    // keep them in step (interned authors keep their name id)
+    if (commit->author && commit->author->name_id < 0) commit->author->author_id = commit_id;
+}
+
 // Accessor functions for modification data
 char* get_modification_filepath(Modification* mod) {
     if (!mod) return NULL;
@@ -213,6 +384,26 @@ int get_modification_start_line(Modification* mod) {
     return mod->start_line;
 }
 
+int get_modification_lines_removed(Modification* mod) {
+    if (!mod) return 0;
+    return mod->lines_removed;
+}
+
+int get_modification_lines_added(Modification* mod) {
+    if (!mod) return 0;
+    return mod->lines_added;
+}
+
+int modification_declares_struct(Modification* mod) {
+    if (!mod) return 0;
+    return mod->declares_struct;
+}
+
+int get_modification_path_id(Modification* mod) {
+    if (!mod) return -1;
+    return mod->path_id;
+}
+
 // Accessor functions for author data
 char* get_author_name(Author* author) {
     if (!author) return NULL;
@@ -235,17 +426,18 @@ void print_commit_for_tree(void* data){
     printf("id=%d ts=%lld | %s | %s", c->id, c->timestamp, c->author->name, c->message);
 }
 
-// Cleanup functions to free dynamically allocated memory
+// Cleanup functions to free dynamically allocated memory (objects from an arena are
+// released with it instead)
 void free_author(Author* author) {
-    if (author) {
-        free(author->name);
+    if (author && !author->arena) {
+        if (author->name_id < 0) free(author->name);
         free(author);
     }
 }
 
 void free_modification(Modification* mod) {
-    if (mod) {
-        free(mod->filepath);
+    if (mod && !mod->arena) {
+        if (mod->path_id < 0) free(mod->filepath);
         free(mod->old_code);
         free(mod->new_code);
         free(mod);
@@ -254,9 +446,28 @@ void free_modification(Modification* mod) {
 
 void free_commit(Commit* commit) {
     if (commit) {
-        free(commit->message);
         free_author(commit->author);
         // Note: modifications list should be freed separately using the list's cleanup function
-        free(commit);
+        if (!commit->arena) {
+            free(commit->hash);
+            free(commit->message);
+            free(commit);
+        }
     }
-}
\ No newline at end of file
+}
+
+void free_commit_list(List* commits) {
+    if (!commits) return;
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        if (!commit) continue;
+        if (commit->modifications) {
+            for (Node* mod = get_first_node(commit->modifications); mod; mod = get_next_node(mod)) {
+                free_modification((Modification*)get_node_data(mod));
+            }
+            free_list(commit->modifications);
+        }
+        free_commit(commit);
+    }
+    free_list(commits);
+}
@@ -1,14 +1,51 @@
 #ifndef COMMIT_H
 #define COMMIT_H
 #include "list.h"
+#include "arena.h"
+#include "string_table.h"
 
 typedef struct Commit Commit;
 typedef struct Modification Modification;
 typedef struct Author Author;
 
+/**
+ * Allocate the commits, authors and modifications created from now on, with their
+ * strings, from arena instead of one malloc each (NULL restores malloc). The free_*
+ * functions below skip such objects; free_arena() releases them all at once, after
+ * the last use of the commits. Objects must then be created from one thread at a time.
+ */
+void set_commit_arena(Arena* arena);
+Arena* get_commit_arena(void);
+
+/**
+ * Intern the names of the authors and the file paths of the modifications created from
+ * now on in these tables (NULL for private copies, as before). An interned author's id
+ * is the id of its name, so one person has one id across commits; an interned
+ * modification's filepath is the table's string. The tables must outlive those objects
+ * and, like the arena, be used from one thread at a time.
+ */
+void set_commit_string_tables(StringTable* author_names, StringTable* file_paths);
+StringTable* get_author_name_table(void);
+StringTable* get_file_path_table(void);
+
+/**
+ * Renumber the interned author names and file paths in order of first appearance in
+ * commits (each commit's author, then its modifications), which is the order a fresh
+ * ingestion interns them in, and update the ids held by the commits. Strings no commit
+ * refers to go last.
+ * @return 1 on success, 0 on allocation failure (ids keep their old order)
+ */
+int renumber_commit_strings(List* commits);
+
 // Initialize a commit with a numeric id, author, modifications, message, and unix timestamp (seconds since epoch)
 Commit* initialize_commit(int commit_id, Author* author, List* modifications, char* message, long long timestamp);
 Modification* initialize_modification(char* filepath, char* old_code, char* new_code, int start_line);
+// A modification without code, from the summary of code seen earlier (e.g. a saved state)
+Modification* initialize_modification_summary(char* filepath, int start_line, int lines_removed, int lines_added, int declares_struct);
+// Like initialize_modification, but takes ownership of the malloc'd strings instead of copying them,
+// also under a commit arena, which then frees them (they are freed on failure)
+Modification* adopt_modification(char* filepath, char* old_code, char* new_code, int start_line);
+// author_id is used when no author name table is set
 Author* initialize_author(int author_id, char* name);
 void print_mod(Modification* mod);
 void print_commit(Commit* commit);
@@ -27,20 +64,35 @@ char* get_commit_message(Commit* commit);
 List* get_commit_modifications(Commit* commit);
 Author* get_commit_author(Commit* commit);
 int get_commit_id(Commit* commit);
+// Full commit hash recorded at ingestion (NULL if unknown)
+char* get_commit_hash(Commit* commit);
+
+// Setters used when merging newly ingested commits into an existing list
+int set_commit_hash(Commit* commit, const char* hash); // copies hash; returns 0 on allocation failure
+void set_commit_id(Commit* commit, int commit_id);
 
 // Accessor functions for modification data
 char* get_modification_filepath(Modification* mod);
+// Removed/added code (NULL for a modification created from a summary)
 char* get_modification_old_code(Modification* mod);
 char* get_modification_new_code(Modification* mod);
 int get_modification_start_line(Modification* mod);
+// Number of removed and added lines, and whether the added code declares a struct
+int get_modification_lines_removed(Modification* mod);
+int get_modification_lines_added(Modification* mod);
+int modification_declares_struct(Modification* mod);
+// Id of the filepath in the file path table (-1 if it was not interned)
+int get_modification_path_id(Modification* mod);
 
 // Accessor functions for author data
 char* get_author_name(Author* author);
-int get_author_id(Author* author);
+int get_author_id(Author* author); // Id of the name in the author name table when interned
 
 // Cleanup functions to free dynamically allocated memory
 void free_author(Author* author);
 void free_modification(Modification* mod);
 void free_commit(Commit* commit);
+// Free every commit in the list together with its modifications, then the list itself
+void free_commit_list(List* commits);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "commit_index_map.h"
+#include "hash.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    Commit* commit; // NULL = empty slot
+    int index;
+} CommitIndexSlot;
+
+// Two linear-probing tables over the same entries: one keyed by pointer, one by hash.
+// Both have capacity slots (a power of two) and stay at most half full.
+struct CommitIndexMap {
+    CommitIndexSlot* by_pointer;
+    CommitIndexSlot* by_hash;
+    int capacity;
+    int count;
+};
+
+static size_t pointer_slot(const Commit* commit, int capacity) {
+    // Fibonacci hashing; the low bits of heap pointers carry little information
+    uint64_t key = (uint64_t)(uintptr_t)commit * 0x9E3779B97F4A7C15ull;
+    return (size_t)(key >> 32) & (size_t)(capacity - 1);
+}
+
+static size_t hash_slot(const char* hash, int capacity) {
+    return (size_t)fnv1a_32(hash) & (size_t)(capacity - 1);
+}
+
+static const char* indexed_hash(Commit* commit) {
+    const char* hash = get_commit_hash(commit);
+    return hash && *hash ? hash : NULL;
+}
+
+// Slot holding commit, or the empty slot where it belongs
+static CommitIndexSlot* find_pointer_slot(CommitIndexSlot* slots, int capacity, const Commit* commit) {
+    size_t slot = pointer_slot(commit, capacity);
+    while (slots[slot].commit && slots[slot].commit != commit) {
+        slot = (slot + 1) & (size_t)(capacity - 1);
+    }
+    return &slots[slot];
+}
+
+static CommitIndexSlot* find_hash_slot(CommitIndexSlot* slots, int capacity, const char* hash) {
+    size_t slot = hash_slot(hash, capacity);
+    while (slots[slot].commit && strcmp(get_commit_hash(slots[slot].commit), hash) != 0) {
+        slot = (slot + 1) & (size_t)(capacity - 1);
+    }
+    return &slots[slot];
+}
+
+static int resize_commit_index_map(CommitIndexMap* map, int capacity) {
+    CommitIndexSlot* by_pointer = calloc((size_t)capacity, sizeof(CommitIndexSlot));
+    CommitIndexSlot* by_hash = calloc((size_t)capacity, sizeof(CommitIndexSlot));
+    if (!by_pointer || !by_hash) {
+        free(by_pointer);
+        free(by_hash);
+        return 0;
+    }
+
+    for (int i = 0; i < map->capacity; i++) {
+        if (map->by_pointer[i].commit) {
+            *find_pointer_slot(by_pointer, capacity, map->by_pointer[i].commit) = map->by_pointer[i];
+        }
+        if (map->by_hash[i].commit) {
+            *find_hash_slot(by_hash, capacity, get_commit_hash(map->by_hash[i].commit)) = map->by_hash[i];
+        }
+    }
+
+    free(map->by_pointer);
+    free(map->by_hash);
+    map->by_pointer = by_pointer;
+    map->by_hash = by_hash;
+    map->capacity = capacity;
+    return 1;
+}
+
+CommitIndexMap* create_commit_index_map(int capacity) {
+    CommitIndexMap* map = calloc(1, sizeof(CommitIndexMap));
+    if (!map) return NULL;
+
+    int slots = 16;
+    while (slots < 2 * capacity && slots < (1 << 30)) slots *= 2;
+    if (!resize_commit_index_map(map, slots)) {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+int put_commit_index(CommitIndexMap* map, Commit* commit, int index) {
+    if (!map || !commit) return 0;
+
+    if (2 * (map->count + 1) > map->capacity && !resize_commit_index_map(map, map->capacity * 2)) return 0;
+
+    CommitIndexSlot* slot = find_pointer_slot(map->by_pointer, map->capacity, commit);
+    if (!slot->commit) map->count++;
+    slot->commit = commit;
+    slot->index = index;
+
+    // A later commit with the same hash takes over the hash key
+    const char* hash = indexed_hash(commit);
+    if (hash) {
+        slot = find_hash_slot(map->by_hash, map->capacity, hash);
+        slot->commit = commit;
+        slot->index = index;
+    }
+    return 1;
+}
+
+int get_commit_index(const CommitIndexMap* map, const Commit* commit) {
+    if (!map || !commit) return -1;
+
+    const CommitIndexSlot* slot = find_pointer_slot(map->by_pointer, map->capacity, commit);
+    return slot->commit ? slot->index : -1;
+}
+
+int get_commit_index_by_hash(const CommitIndexMap* map, const char* hash) {
+    if (!map || !hash || !*hash) return -1;
+
+    const CommitIndexSlot* slot = find_hash_slot(map->by_hash, map->capacity, hash);
+    return slot->commit ? slot->index : -1;
+}
+
+int get_commit_index_map_count(const CommitIndexMap* map) {
+    return map ? map->count : 0;
+}
+
+void free_commit_index_map(CommitIndexMap* map) {
+    if (!map) return;
+
+    free(map->by_pointer);
+    free(map->by_hash);
+    free(map);
+}
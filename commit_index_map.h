@@ -0,0 +1,40 @@
+#ifndef COMMIT_INDEX_MAP_H
+#define COMMIT_INDEX_MAP_H
+
+#include "commit.h"
+
+/**
+ * Open-addressing hash map from commits to array indices. Every entry can be
+ * found by its Commit pointer and, when the commit has one, by its hash string.
+ * Keys are borrowed: commits must outlive the map and keep their hash.
+ */
+typedef struct CommitIndexMap CommitIndexMap;
+
+/**
+ * Create an empty map
+ * @param capacity Expected number of commits (grows as needed)
+ * @return New map, or NULL on allocation failure
+ */
+CommitIndexMap* create_commit_index_map(int capacity);
+
+/**
+ * Map commit (and its hash) to index, replacing any previous index
+ * @return 1 on success, 0 on allocation failure (the map is unchanged)
+ */
+int put_commit_index(CommitIndexMap* map, Commit* commit, int index);
+
+/**
+ * Index stored for commit, or -1 if it is not in the map
+ */
+int get_commit_index(const CommitIndexMap* map, const Commit* commit);
+
+/**
+ * Index stored for the commit with this full hash, or -1 if there is none
+ */
+int get_commit_index_by_hash(const CommitIndexMap* map, const char* hash);
+
+int get_commit_index_map_count(const CommitIndexMap* map);
+
+void free_commit_index_map(CommitIndexMap* map);
+
+#endif
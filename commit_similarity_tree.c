@@ -1,59 +1,131 @@
 #include "commit_similarity_tree.h"
+#include "similarity_kernels.h"
+#include "thread_pool.h"
+#include "hash.h"
 #include "list.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
 
+// Rows/columns per block of the matrix product in build_similarity_matrix. Blocks
+// match the matrix's storage tiles, so each column of tiles is finished before the
+// next one starts (as a matrix file requires); two 32 x 32 blocks of doubles stay in L1.
+#define SIMILARITY_TILE SIMILARITY_MATRIX_TILE
+
+// Matrix blocks (tiles, or columns at reduced precision) per task, and tasks per worker
+// in each batch of build_similarity_matrix
+#define MATRIX_TILES_PER_TASK 16
+#define MATRIX_TASKS_PER_WORKER 4
+
+// Precision used by build_similarity_matrix
+static FingerprintPrecision similarity_precision = FINGERPRINT_PRECISION_DOUBLE;
+
+void set_similarity_precision(FingerprintPrecision precision) {
+    similarity_precision = precision;
+}
+
+FingerprintPrecision get_similarity_precision(void) {
+    return similarity_precision;
+}
+
+// Element type of the cached matrix
+static SimilarityStorage similarity_storage = SIMILARITY_STORAGE_FLOAT32;
+
+void set_similarity_storage(SimilarityStorage storage) {
+    similarity_storage = storage;
+}
+
+SimilarityStorage get_similarity_storage(void) {
+    return similarity_storage;
+}
+
+// Out-of-core matrix file (NULL = keep the matrix in memory) and its band size
+static const char* similarity_matrix_path = NULL;
+static size_t similarity_matrix_budget = 0;
+
+void set_similarity_matrix_file(const char* path, size_t memory_budget) {
+    similarity_matrix_path = path;
+    similarity_matrix_budget = memory_budget;
+}
+
+// Neighbours kept per commit in a sparse graph (0 = dense matrix)
+static int similarity_neighbors = 0;
+
+void set_similarity_neighbors(int neighbors) {
+    similarity_neighbors = neighbors > 0 ? neighbors : 0;
+}
+
+int get_similarity_neighbors(void) {
+    return similarity_neighbors;
+}
+
+// File keeping the approximate neighbour index between runs (NULL = rebuilt every run)
+static const char* similarity_ann_path = NULL;
+static int hnsw_m = HNSW_DEFAULT_M;
+static int hnsw_ef_construction = HNSW_DEFAULT_EF_CONSTRUCTION;
+static int hnsw_ef_search = HNSW_DEFAULT_EF_SEARCH;
+
+void set_similarity_ann_file(const char* path) {
+    similarity_ann_path = path;
+}
+
+void set_hnsw_parameters(int m, int ef_construction, int ef_search) {
+    if (m > 1) hnsw_m = m;
+    if (ef_construction > 0) hnsw_ef_construction = ef_construction;
+    if (ef_search > 0) hnsw_ef_search = ef_search;
+}
+
 // Helper function to find the commit index in the matrix
 static int find_commit_index(CommitSimilarityTree* tree, Commit* commit) {
     if (!tree || !commit) return -1;
-    
-    for (int i = 0; i < tree->total_commits; i++) {
-        if (tree->commit_index[i] == commit) {
-            return i;
-        }
-    }
-    return -1;
+    return get_commit_index(tree->commit_lookup, commit);
 }
 
-// Helper function to calculate all pairwise similarities
-static List* calculate_all_similarities(List* commits) {
-    if (!commits) return NULL;
-    
-    List* similarity_pairs = create_list();
-    if (!similarity_pairs) return NULL;
-    
-    Node* node1 = get_first_node(commits);
-    while (node1) {
-        Commit* commit1 = (Commit*)get_node_data(node1);
-        SemanticFingerprint* fp1 = create_semantic_fingerprint(commit1);
-        
-        Node* node2 = get_next_node(node1);
-        while (node2) {
-            Commit* commit2 = (Commit*)get_node_data(node2);
-            SemanticFingerprint* fp2 = create_semantic_fingerprint(commit2);
-            
-            if (fp1 && fp2) {
-                SimilarityPair* pair = malloc(sizeof(SimilarityPair));
-                if (pair) {
-                    pair->commit1 = commit1;
-                    pair->commit2 = commit2;
-                    pair->fp1 = fp1;
-                    pair->fp2 = fp2;
-                    pair->similarity_score = calculate_fingerprint_similarity(fp1, fp2);
-                    
-                    insert_item(similarity_pairs, pair);
-                }
-            }
-            
-            node2 = get_next_node(node2);
-        }
-        
-        node1 = get_next_node(node1);
+// Node holding commit; scans all_nodes only when there is no matrix to index it
+static SimilarityTreeNode* find_tree_node(CommitSimilarityTree* tree, Commit* commit) {
+    if (tree->commit_lookup && tree->matrix_nodes) {
+        int index = find_commit_index(tree, commit);
+        return index >= 0 ? tree->matrix_nodes[index] : NULL;
     }
     
-    return similarity_pairs;
+    Node* node = get_first_node(tree->all_nodes);
+    while (node) {
+        SimilarityTreeNode* tree_node = (SimilarityTreeNode*)get_node_data(node);
+        if (tree_node->commit == commit) return tree_node;
+        node = get_next_node(node);
+    }
+    return NULL;
+}
+
+static void discard_ann_index(CommitSimilarityTree* tree) {
+    free_hnsw_index(tree->ann_index);
+    free(tree->ann_positions);
+    tree->ann_index = NULL;
+    tree->ann_positions = NULL;
+    tree->ann_capacity = 0;
+}
+
+// Release the cached matrix or graph and their indexes
+static void discard_similarity_matrix(CommitSimilarityTree* tree) {
+    free_similarity_matrix(tree->similarity_matrix);
+    free_similarity_graph(tree->similarity_graph);
+    free(tree->commit_index);
+    free(tree->matrix_nodes);
+    free_commit_index_map(tree->commit_lookup);
+    free_fingerprint_index(tree->fingerprint_index);
+    discard_ann_index(tree);
+    free_vantage_tree(tree->vantage_tree);
+    free_commit_time_index(tree->time_index);
+    tree->similarity_matrix = NULL;
+    tree->similarity_graph = NULL;
+    tree->commit_index = NULL;
+    tree->matrix_nodes = NULL;
+    tree->commit_lookup = NULL;
+    tree->fingerprint_index = NULL;
+    tree->vantage_tree = NULL;
+    tree->time_index = NULL;
+    tree->indexed_commits = 0;
 }
 
 // Helper function to find the best placement for a commit in the tree
@@ -62,14 +134,13 @@ static SimilarityTreeNode* find_best_insertion_point(SimilarityTreeNode* root, S
     
     double similarity_to_root = calculate_fingerprint_similarity(root->fingerprint, target_fp);
     
-    // If this is more similar than both children, place it as a child of root
-    if (!root->most_similar || 
-        similarity_to_root > calculate_fingerprint_similarity(root->fingerprint, root->most_similar->fingerprint)) {
+    // If this is more similar than both children, place it as a child of root (the
+    // similarities to the children were stored when they were attached)
+    if (!root->most_similar || similarity_to_root > root->similarity_to_left) {
         return root;
     }
     
-    if (!root->second_similar || 
-        similarity_to_root > calculate_fingerprint_similarity(root->fingerprint, root->second_similar->fingerprint)) {
+    if (!root->second_similar || similarity_to_root > root->similarity_to_right) {
         return root;
     }
     
@@ -88,14 +159,19 @@ static SimilarityTreeNode* find_best_insertion_point(SimilarityTreeNode* root, S
     return root;
 }
 
+SemanticFingerprint* get_tree_fingerprint(CommitSimilarityTree* tree, Commit* commit) {
+    if (!tree) return NULL;
+    return get_registered_fingerprint(tree->fingerprints, commit);
+}
+
 SimilarityTreeNode* create_similarity_node(Commit* commit, SemanticFingerprint* fingerprint) {
-    if (!commit) return NULL;
+    if (!commit || !fingerprint) return NULL;
     
     SimilarityTreeNode* node = malloc(sizeof(SimilarityTreeNode));
     if (!node) return NULL;
     
     node->commit = commit;
-    node->fingerprint = fingerprint ? fingerprint : create_semantic_fingerprint(commit);
+    node->fingerprint = fingerprint;
     node->most_similar = NULL;
     node->second_similar = NULL;
     node->parent = NULL;
@@ -110,6 +186,7 @@ SimilarityTreeNode* create_similarity_node(Commit* commit, SemanticFingerprint*
 void insert_commit_by_similarity(CommitSimilarityTree* tree, Commit* commit, SemanticFingerprint* fingerprint) {
     if (!tree || !commit) return;
     
+    if (!fingerprint) fingerprint = get_tree_fingerprint(tree, commit);
     SimilarityTreeNode* new_node = create_similarity_node(commit, fingerprint);
     if (!new_node) return;
     
@@ -163,26 +240,47 @@ void insert_commit_by_similarity(CommitSimilarityTree* tree, Commit* commit, Sem
     tree->total_commits++;
 }
 
-CommitSimilarityTree* build_similarity_tree(List* commits) {
-    if (!commits || get_number_of_items(commits) == 0) return NULL;
+CommitSimilarityTree* build_similarity_tree(List* commits, FingerprintRegistry* fingerprints) {
+    if (!commits || get_number_of_items(commits) == 0) {
+        free_fingerprint_registry(fingerprints);
+        return NULL;
+    }
     
     CommitSimilarityTree* tree = malloc(sizeof(CommitSimilarityTree));
-    if (!tree) return NULL;
+    if (!tree) {
+        free_fingerprint_registry(fingerprints);
+        return NULL;
+    }
     
     tree->root = NULL;
     tree->all_nodes = create_list();
     tree->total_commits = 0;
     tree->average_similarity = 0.0;
+    tree->matrix_error_bound = 0.0;
     tree->similarity_matrix = NULL;
+    tree->similarity_graph = NULL;
     tree->commit_index = NULL;
+    tree->matrix_nodes = NULL;
+    tree->commit_lookup = NULL;
+    tree->fingerprint_index = NULL;
+    tree->ann_index = NULL;
+    tree->ann_positions = NULL;
+    tree->ann_capacity = 0;
+    tree->vantage_tree = NULL;
+    tree->time_index = NULL;
+    tree->indexed_commits = 0;
+    tree->fingerprints = fingerprints ? fingerprints : create_fingerprint_registry();
     
-    if (!tree->all_nodes) {
-        free(tree);
+    if (!tree->all_nodes || !tree->fingerprints) {
+        free_commit_similarity_tree(tree);
         return NULL;
     }
     
     printf("Building semantic similarity tree...\n");
     
+    // Fingerprint the commits in parallel up front; insertion then only looks them up
+    register_fingerprints(tree->fingerprints, commits, 0);
+    
     // Insert each commit into the tree
     Node* current = get_first_node(commits);
     int processed = 0;
@@ -190,8 +288,7 @@ CommitSimilarityTree* build_similarity_tree(List* commits) {
         Commit* commit = (Commit*)get_node_data(current);
         printf("Processing commit %d/%d\n", processed + 1, get_number_of_items(commits));
         
-        SemanticFingerprint* fingerprint = create_semantic_fingerprint(commit);
-        insert_commit_by_similarity(tree, commit, fingerprint);
+        insert_commit_by_similarity(tree, commit, get_tree_fingerprint(tree, commit));
         
         processed++;
         current = get_next_node(current);
@@ -204,83 +301,780 @@ CommitSimilarityTree* build_similarity_tree(List* commits) {
     return tree;
 }
 
+// Identifies what a matrix file holds: the commits in order, which of them have a
+// fingerprint, and how the values were computed (FNV-1a)
+static unsigned long long similarity_matrix_key(CommitSimilarityTree* tree, const char* has_fingerprint, int num_commits) {
+    unsigned long long key = FNV1A_64_INIT;
+    char buffer[64];
+    for (int i = 0; i < num_commits; i++) {
+        const char* hash = get_commit_hash(tree->commit_index[i]);
+        if (!hash) {
+            snprintf(buffer, sizeof(buffer), "#%d", get_commit_id(tree->commit_index[i]));
+            hash = buffer;
+        }
+        key = fnv1a_64_update(key, hash);
+        key = fnv1a_64_update(key, has_fingerprint[i] ? "+" : "-");
+    }
+    snprintf(buffer, sizeof(buffer), "schema %d precision %d", FINGERPRINT_SCHEMA_VERSION, (int)similarity_precision);
+    return fnv1a_64_update(key, buffer);
+}
+
+// A tile of the upper triangle of the matrix, or (from quantized vectors) a column of it
+typedef struct {
+    int row_start;         // Tile origin (0 for a column)
+    int column_start;      // Tile origin, or the column
+    double total;          // Sum of the off-diagonal similarities over ordered pairs
+    long long count;       // Ordered pairs in total
+} MatrixBlock;
+
+// Blocks [first, end) of a batch; block b is computed into buffers + b * buffer_size
+typedef struct {
+    const double* vectors;
+    const CompactFingerprintSet* compact; // Columns are computed from it (NULL: tiles)
+    const char* has_fingerprint;
+    int num_commits;
+    MatrixBlock* blocks;
+    double* buffers;
+    size_t buffer_size;
+    int first;
+    int end;
+} MatrixTask;
+
+static void compute_matrix_blocks(void* argument) {
+    MatrixTask* task = (MatrixTask*)argument;
+    int num_commits = task->num_commits;
+    
+    for (int b = task->first; b < task->end; b++) {
+        MatrixBlock* block = &task->blocks[b];
+        double* buffer = task->buffers + b * task->buffer_size;
+        block->total = 0.0;
+        block->count = 0;
+        
+        if (!task->compact) {
+            // Cache-blocked F * F^T tile on or above the diagonal
+            int rows = num_commits - block->row_start < SIMILARITY_TILE ? num_commits - block->row_start : SIMILARITY_TILE;
+            int columns = num_commits - block->column_start < SIMILARITY_TILE ?
+                          num_commits - block->column_start : SIMILARITY_TILE;
+            similarity_dot_block(task->vectors + (size_t)block->row_start * FINGERPRINT_DIMENSIONS, rows,
+                                 task->vectors + (size_t)block->column_start * FINGERPRINT_DIMENSIONS, columns,
+                                 FINGERPRINT_DIMENSIONS, buffer, SIMILARITY_TILE);
+            
+            // Zero pairs without fingerprints; entries on or below the diagonal are not stored
+            for (int r = 0; r < rows; r++) {
+                int i = block->row_start + r;
+                double* tile_row = buffer + r * SIMILARITY_TILE;
+                for (int c = i < block->column_start ? 0 : i - block->column_start + 1; c < columns; c++) {
+                    if (task->has_fingerprint[i] && task->has_fingerprint[block->column_start + c]) {
+                        block->total += 2.0 * tile_row[c];
+                        block->count += 2;
+                    } else {
+                        tile_row[c] = 0.0;
+                    }
+                }
+            }
+        } else {
+            // Row j up to the diagonal is column j of the upper triangle
+            int j = block->column_start;
+            compact_similarity_many(task->compact, j, buffer);
+            for (int i = 0; i < j; i++) {
+                if (task->has_fingerprint[i] && task->has_fingerprint[j]) {
+                    block->total += 2.0 * buffer[i];
+                    block->count += 2;
+                } else {
+                    buffer[i] = 0.0;
+                }
+            }
+        }
+    }
+}
+
 void build_similarity_matrix(CommitSimilarityTree* tree, List* commits) {
     if (!tree || !commits) return;
     
     int num_commits = get_number_of_items(commits);
     
-    // Allocate similarity matrix
-    tree->similarity_matrix = malloc(num_commits * sizeof(double*));
+    // Allocate the commit indexes
     tree->commit_index = malloc(num_commits * sizeof(Commit*));
+    tree->matrix_nodes = calloc(num_commits > 0 ? num_commits : 1, sizeof(SimilarityTreeNode*));
+    tree->commit_lookup = create_commit_index_map(num_commits);
     
-    if (!tree->similarity_matrix || !tree->commit_index) return;
-    
-    for (int i = 0; i < num_commits; i++) {
-        tree->similarity_matrix[i] = malloc(num_commits * sizeof(double));
-        if (!tree->similarity_matrix[i]) return;
+    // Build commit index and copy each commit's vector into one contiguous block,
+    // so the matrix is a blocked product over it (the block is kept for searches)
+    tree->fingerprint_index = create_fingerprint_index(FINGERPRINT_DIMENSIONS, num_commits);
+    char* has_fingerprint = malloc(num_commits > 0 ? num_commits : 1);
+    if (!tree->commit_index || !tree->matrix_nodes || !tree->commit_lookup || !tree->fingerprint_index ||
+        !has_fingerprint) {
+        free(has_fingerprint);
+        discard_similarity_matrix(tree);
+        return;
     }
     
-    // Build commit index
     Node* current = get_first_node(commits);
     int index = 0;
     while (current && index < num_commits) {
         tree->commit_index[index] = (Commit*)get_node_data(current);
+        SemanticFingerprint* fingerprint = get_tree_fingerprint(tree, tree->commit_index[index]);
+        has_fingerprint[index] = fingerprint != NULL;
+        if (!put_commit_index(tree->commit_lookup, tree->commit_index[index], index) ||
+            add_fingerprint_vector(tree->fingerprint_index, fingerprint ? fingerprint->vector : NULL) < 0) {
+            free(has_fingerprint);
+            discard_similarity_matrix(tree);
+            return;
+        }
         current = get_next_node(current);
         index++;
     }
+    tree->indexed_commits = index;
+    const double* vectors = get_fingerprint_index_vectors(tree->fingerprint_index);
     
-    // Calculate similarity matrix
-    double total_similarity = 0.0;
-    int similarity_count = 0;
+    current = get_first_node(tree->all_nodes);
+    while (current) {
+        SimilarityTreeNode* tree_node = (SimilarityTreeNode*)get_node_data(current);
+        int node_index = find_commit_index(tree, tree_node->commit);
+        if (node_index >= 0) tree->matrix_nodes[node_index] = tree_node;
+        current = get_next_node(current);
+    }
     
-    for (int i = 0; i < num_commits; i++) {
-        for (int j = 0; j < num_commits; j++) {
-            if (i == j) {
-                tree->similarity_matrix[i][j] = 1.0;
+    // In graph mode only each commit's nearest neighbours are kept (exact similarities)
+    if (similarity_neighbors > 0) {
+        tree->similarity_graph = build_similarity_graph(vectors, has_fingerprint, num_commits, FINGERPRINT_DIMENSIONS,
+                                                        similarity_neighbors, 0, &tree->average_similarity);
+        tree->matrix_error_bound = 0.0;
+        free(has_fingerprint);
+        if (!tree->similarity_graph) discard_similarity_matrix(tree);
+        return;
+    }
+    
+    // A matrix file from an earlier run over the same commits is mapped instead of recomputed
+    SimilarityMatrixInfo info;
+    info.key = 0;
+    if (similarity_matrix_path) {
+        info.key = similarity_matrix_key(tree, has_fingerprint, num_commits);
+        tree->similarity_matrix = open_similarity_matrix_file(similarity_matrix_path, similarity_storage,
+                                                              num_commits, info.key, &info);
+        if (tree->similarity_matrix) {
+            printf("Reused similarity matrix from %s\n", similarity_matrix_path);
+            tree->average_similarity = info.average_similarity;
+            tree->matrix_error_bound = info.error_bound;
+            free(has_fingerprint);
+            return;
+        }
+        tree->similarity_matrix = create_similarity_matrix_file(similarity_storage, num_commits,
+                                                                similarity_matrix_path, similarity_matrix_budget);
+    } else {
+        tree->similarity_matrix = create_similarity_matrix(similarity_storage, num_commits);
+    }
+    if (!tree->similarity_matrix) {
+        if (similarity_matrix_path) printf("Warning: could not create similarity matrix file %s\n", similarity_matrix_path);
+        free(has_fingerprint);
+        discard_similarity_matrix(tree);
+        return;
+    }
+    
+    // At reduced precision the rows are computed from a quantized copy of the vectors
+    CompactFingerprintSet* compact = NULL;
+    if (similarity_precision != FINGERPRINT_PRECISION_DOUBLE) {
+        compact = create_compact_fingerprint_set(similarity_precision, num_commits);
+        for (int i = 0; compact && i < num_commits; i++) {
+            if (add_compact_vector(compact, vectors + (size_t)i * FINGERPRINT_DIMENSIONS) < 0) {
+                free_compact_fingerprint_set(compact);
+                compact = NULL; // Fall back to double precision
+            }
+        }
+    }
+    tree->matrix_error_bound = (compact ? compact_max_error_bound(compact) : 0.0) +
+                               get_similarity_storage_error(similarity_storage);
+    
+    // Calculate the upper triangle in increasing column order (a matrix file is written
+    // front to back). Blocks are computed in parallel a batch at a time and stored in
+    // order on this thread; the average over ordered off-diagonal pairs is summed per
+    // block, in block order, so it does not depend on the number of workers.
+    int tiled = compact == NULL;
+    size_t buffer_size = tiled ? SIMILARITY_TILE * SIMILARITY_TILE : (size_t)num_commits;
+    int blocks_per_task = tiled ? MATRIX_TILES_PER_TASK : 1;
+    ThreadPool* pool = num_commits > SIMILARITY_TILE ? create_thread_pool(0) : NULL;
+    int batch = (pool ? get_thread_pool_size(pool) * MATRIX_TASKS_PER_WORKER : 1) * blocks_per_task;
+    MatrixBlock* blocks = malloc(batch * sizeof(MatrixBlock));
+    double* buffers = malloc(batch * buffer_size * sizeof(double));
+    MatrixTask* tasks = malloc((batch / blocks_per_task) * sizeof(MatrixTask));
+    if ((!blocks || !buffers || !tasks) && batch > 1) {
+        // Retry with one block at a time
+        free_thread_pool(pool);
+        pool = NULL;
+        free(blocks);
+        free(buffers);
+        free(tasks);
+        batch = blocks_per_task = 1;
+        blocks = malloc(sizeof(MatrixBlock));
+        buffers = malloc(buffer_size * sizeof(double));
+        tasks = malloc(sizeof(MatrixTask));
+    }
+    
+    double total_similarity = 0.0;
+    long long similarity_count = 0;
+    int column_start = 0;
+    int row_start = 0;
+    while (blocks && buffers && tasks && column_start < num_commits) {
+        // Next blocks in storage order: tiles down each column of tiles, or single columns
+        int block_count = 0;
+        while (block_count < batch && column_start < num_commits) {
+            blocks[block_count].row_start = row_start;
+            blocks[block_count].column_start = column_start;
+            block_count++;
+            if (tiled && row_start + SIMILARITY_TILE <= column_start) {
+                row_start += SIMILARITY_TILE;
             } else {
-                // Find the nodes corresponding to these commits
-                SemanticFingerprint* fp1 = NULL;
-                SemanticFingerprint* fp2 = NULL;
-                
-                Node* node = get_first_node(tree->all_nodes);
-                while (node) {
-                    SimilarityTreeNode* tree_node = (SimilarityTreeNode*)get_node_data(node);
-                    if (tree_node->commit == tree->commit_index[i]) {
-                        fp1 = tree_node->fingerprint;
-                    }
-                    if (tree_node->commit == tree->commit_index[j]) {
-                        fp2 = tree_node->fingerprint;
-                    }
-                    node = get_next_node(node);
-                }
-                
-                if (fp1 && fp2) {
-                    double similarity = calculate_fingerprint_similarity(fp1, fp2);
-                    tree->similarity_matrix[i][j] = similarity;
-                    total_similarity += similarity;
-                    similarity_count++;
-                } else {
-                    tree->similarity_matrix[i][j] = 0.0;
-                }
+                row_start = 0;
+                column_start += tiled ? SIMILARITY_TILE : 1;
             }
         }
+        
+        int task_count = (block_count + blocks_per_task - 1) / blocks_per_task;
+        for (int t = 0; t < task_count; t++) {
+            MatrixTask* task = &tasks[t];
+            task->vectors = vectors;
+            task->compact = compact;
+            task->has_fingerprint = has_fingerprint;
+            task->num_commits = num_commits;
+            task->blocks = blocks;
+            task->buffers = buffers;
+            task->buffer_size = buffer_size;
+            task->first = t * blocks_per_task;
+            task->end = task->first + blocks_per_task < block_count ? task->first + blocks_per_task : block_count;
+            if (!pool || !submit_thread_pool_task(pool, compute_matrix_blocks, task)) {
+                compute_matrix_blocks(task);
+            }
+        }
+        if (pool) wait_thread_pool(pool);
+        
+        for (int b = 0; b < block_count; b++) {
+            MatrixBlock* block = &blocks[b];
+            double* buffer = buffers + b * buffer_size;
+            if (tiled) {
+                int rows = num_commits - block->row_start < SIMILARITY_TILE ? num_commits - block->row_start : SIMILARITY_TILE;
+                int columns = num_commits - block->column_start < SIMILARITY_TILE ?
+                              num_commits - block->column_start : SIMILARITY_TILE;
+                store_similarity_block(tree->similarity_matrix, block->row_start, block->column_start, rows, columns,
+                                       buffer, SIMILARITY_TILE);
+            } else {
+                store_similarity_column(tree->similarity_matrix, block->column_start, 0, buffer, block->column_start);
+            }
+            total_similarity += block->total;
+            similarity_count += block->count;
+        }
     }
+    if (!blocks || !buffers || !tasks) discard_similarity_matrix(tree);
+    free_thread_pool(pool);
+    free(tasks);
+    free(buffers);
+    free(blocks);
+    free(has_fingerprint);
+    free_compact_fingerprint_set(compact);
     
     tree->average_similarity = similarity_count > 0 ? total_similarity / similarity_count : 0.0;
+    
+    if (similarity_matrix_path && tree->similarity_matrix) {
+        info.average_similarity = tree->average_similarity;
+        info.error_bound = tree->matrix_error_bound;
+        if (!finish_similarity_matrix_file(tree->similarity_matrix, &info)) {
+            printf("Warning: could not write similarity matrix file %s\n", similarity_matrix_path);
+            discard_similarity_matrix(tree);
+        }
+    }
+}
+
+Commit* find_commit_by_hash(CommitSimilarityTree* tree, const char* hash) {
+    if (!tree || !tree->commit_index) return NULL;
+    
+    int index = get_commit_index_by_hash(tree->commit_lookup, hash);
+    return index >= 0 ? tree->commit_index[index] : NULL;
+}
+
+// Identifies the commit of a stored ANN vector across runs (FNV-1a of the hash; 0 for
+// commits without a hash, which are never matched)
+static unsigned long long ann_commit_label(Commit* commit) {
+    const char* hash = get_commit_hash(commit);
+    if (!hash || !*hash) return 0;
+    
+    unsigned long long label = fnv1a_64(hash);
+    return label ? label : 1;
+}
+
+// Identifies how the vectors and links of an ANN file were computed
+static unsigned long long ann_index_key(void) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "hnsw schema %d dimensions %d m %d ef_construction %d",
+             FINGERPRINT_SCHEMA_VERSION, FINGERPRINT_DIMENSIONS, hnsw_m, hnsw_ef_construction);
+    return fnv1a_64(buffer);
+}
+
+// Insert indexed commit i into the ANN index; 0 on allocation failure
+static int add_ann_commit(CommitSimilarityTree* tree, int i) {
+    SimilarityTreeNode* node = tree->matrix_nodes[i];
+    if (!node) return 1; // No fingerprint
+    
+    int count = get_hnsw_count(tree->ann_index);
+    if (count == tree->ann_capacity) {
+        int capacity = count > 0 ? count * 2 : 64;
+        int* positions = realloc(tree->ann_positions, capacity * sizeof(int));
+        if (!positions) return 0;
+        tree->ann_positions = positions;
+        tree->ann_capacity = capacity;
+    }
+    
+    int id = add_hnsw_vector(tree->ann_index, node->fingerprint->vector, ann_commit_label(tree->commit_index[i]));
+    if (id < 0) return 0;
+    tree->ann_positions[id] = i;
+    return 1;
+}
+
+typedef struct {
+    unsigned long long label;
+    int index;
+} LabeledCommit;
+
+static int compare_labeled_commits(const void* a, const void* b) {
+    unsigned long long first = ((const LabeledCommit*)a)->label;
+    unsigned long long second = ((const LabeledCommit*)b)->label;
+    return first < second ? -1 : first > second;
+}
+
+// Vectors in the ANN file of commits no longer in the history cannot be removed from
+// the graph; once they exceed this fraction of the file the index is rebuilt instead
+#define ANN_REBUILD_FRACTION 4
+
+// Build the ANN index over the indexed commits, or load it from the ANN file and
+// insert only the commits it does not hold yet
+static int ensure_ann_index(CommitSimilarityTree* tree) {
+    if (tree->ann_index) return 1;
+    if (!tree->commit_lookup) return 0;
+    
+    unsigned long long key = ann_index_key();
+    HnswIndex* index = similarity_ann_path ? load_hnsw_index(similarity_ann_path, key) : NULL;
+    int stored = get_hnsw_count(index);
+    if (!index) index = create_hnsw_index(FINGERPRINT_DIMENSIONS, hnsw_m, hnsw_ef_construction);
+    int capacity = stored + tree->indexed_commits + 1;
+    int* positions = malloc(capacity * sizeof(int));
+    char* present = calloc(tree->indexed_commits > 0 ? tree->indexed_commits : 1, 1);
+    LabeledCommit* labels = malloc((tree->indexed_commits > 0 ? tree->indexed_commits : 1) * sizeof(LabeledCommit));
+    if (!index || !positions || !present || !labels) {
+        free_hnsw_index(index);
+        free(positions);
+        free(present);
+        free(labels);
+        return 0;
+    }
+    set_hnsw_ef_search(index, hnsw_ef_search);
+    tree->ann_index = index;
+    tree->ann_positions = positions;
+    tree->ann_capacity = capacity;
+    
+    // Vectors from the file are matched back to commits by label; those of commits no
+    // longer in the history are never returned, but take result slots until a rebuild
+    int labelled = 0;
+    for (int i = 0; stored > 0 && i < tree->indexed_commits; i++) {
+        unsigned long long label = ann_commit_label(tree->commit_index[i]);
+        if (!label || !tree->matrix_nodes[i]) continue;
+        labels[labelled].label = label;
+        labels[labelled].index = i;
+        labelled++;
+    }
+    qsort(labels, labelled, sizeof(LabeledCommit), compare_labeled_commits);
+    int matched = 0;
+    for (int id = 0; id < stored; id++) {
+        LabeledCommit probe = { get_hnsw_label(index, id), 0 };
+        LabeledCommit* match = probe.label ?
+            bsearch(&probe, labels, labelled, sizeof(LabeledCommit), compare_labeled_commits) : NULL;
+        positions[id] = match && !present[match->index] ? match->index : -1;
+        if (positions[id] >= 0) {
+            present[positions[id]] = 1;
+            matched++;
+        }
+    }
+    free(labels);
+    
+    int stale = stored - matched;
+    if (stale > 0 && stale > stored / ANN_REBUILD_FRACTION) {
+        HnswIndex* rebuilt = create_hnsw_index(FINGERPRINT_DIMENSIONS, hnsw_m, hnsw_ef_construction);
+        if (!rebuilt) {
+            free(present);
+            discard_ann_index(tree);
+            return 0;
+        }
+        set_hnsw_ef_search(rebuilt, hnsw_ef_search);
+        free_hnsw_index(index);
+        index = rebuilt;
+        tree->ann_index = rebuilt;
+        memset(present, 0, tree->indexed_commits > 0 ? tree->indexed_commits : 1);
+        printf("Rebuilding ANN index %s (%d of %d stored commits are no longer in the history)\n",
+               similarity_ann_path, stale, stored);
+        stored = 0;
+    }
+    
+    int inserted = 0;
+    for (int i = 0; i < tree->indexed_commits; i++) {
+        if (present[i] || !tree->matrix_nodes[i]) continue;
+        if (!add_ann_commit(tree, i)) {
+            free(present);
+            discard_ann_index(tree);
+            return 0;
+        }
+        inserted++;
+    }
+    free(present);
+    
+    if (stored > 0) printf("Reused ANN index from %s (%d commits, %d added)\n", similarity_ann_path, stored, inserted);
+    if (similarity_ann_path && inserted > 0 && !save_hnsw_index(index, similarity_ann_path, key)) {
+        printf("Warning: could not write ANN index %s\n", similarity_ann_path);
+    }
+    return 1;
+}
+
+// Node of an ANN result, or NULL for the target itself and commits not in this tree
+static SimilarityTreeNode* ann_match_node(CommitSimilarityTree* tree, const SimilarityMatch* match,
+                                          SimilarityTreeNode* target) {
+    int position = tree->ann_positions[match->index];
+    SimilarityTreeNode* node = position >= 0 ? tree->matrix_nodes[position] : NULL;
+    return node != target ? node : NULL;
+}
+
+List* find_most_similar_commits(CommitSimilarityTree* tree, Commit* target_commit, int max_results) {
+    if (!tree || !target_commit) return NULL;
+    
+    SimilarityTreeNode* target = find_tree_node(tree, target_commit);
+    if (!target) return NULL;
+    
+    List* similar = create_list();
+    if (!similar || max_results <= 0) return similar;
+    
+    // Without an ANN index (no commit index, or out of memory) the exact search is used
+    if (!ensure_ann_index(tree)) {
+        SimilarityMatch* matches = tree->fingerprint_index ? malloc(max_results * sizeof(SimilarityMatch)) : NULL;
+        int found = matches ?
+            find_top_similar(tree->fingerprint_index, target->fingerprint->vector, max_results, -HUGE_VAL,
+                             find_commit_index(tree, target_commit), matches) : 0;
+        for (int i = 0; i < found; i++) {
+            if (tree->matrix_nodes[matches[i].index]) insert_item(similar, tree->matrix_nodes[matches[i].index]);
+        }
+        free(matches);
+        return similar;
+    }
+    
+    // The target and stale vectors take result slots, so the search widens until
+    // enough results remain
+    int count = get_hnsw_count(tree->ann_index);
+    SimilarityMatch* matches = NULL;
+    int found = 0;
+    for (int request = max_results + 1; count > 0; request *= 2) {
+        if (request > count) request = count;
+        SimilarityMatch* resized = realloc(matches, request * sizeof(SimilarityMatch));
+        if (!resized) break;
+        matches = resized;
+        found = search_hnsw_index(tree->ann_index, target->fingerprint->vector, request, matches);
+        
+        int usable = 0;
+        for (int i = 0; i < found; i++) {
+            if (ann_match_node(tree, &matches[i], target)) usable++;
+        }
+        if (usable >= max_results || found < request || request == count) break;
+    }
+    
+    // Most similar first
+    for (int i = 0, added = 0; i < found && added < max_results; i++) {
+        SimilarityTreeNode* node = ann_match_node(tree, &matches[i], target);
+        if (!node) continue;
+        insert_item(similar, node);
+        added++;
+    }
+    free(matches);
+    return similar;
+}
+
+// Commits added after the vantage tree was built are compared directly; once they
+// exceed this fraction of the tree it is rebuilt
+#define VANTAGE_REBUILD_FRACTION 8
+
+// All nodes in insertion order (malloc'd), for searches without a commit index
+static SimilarityTreeNode** collect_tree_nodes(CommitSimilarityTree* tree, int* count) {
+    *count = get_number_of_items(tree->all_nodes);
+    SimilarityTreeNode** nodes = malloc((*count > 0 ? *count : 1) * sizeof(SimilarityTreeNode*));
+    Node* node = get_first_node(tree->all_nodes);
+    for (int i = 0; nodes && node; i++, node = get_next_node(node)) {
+        nodes[i] = (SimilarityTreeNode*)get_node_data(node);
+    }
+    return nodes;
+}
+
+static int compare_similarity_matches(const void* a, const void* b) {
+    const SimilarityMatch* first = (const SimilarityMatch*)a;
+    const SimilarityMatch* second = (const SimilarityMatch*)b;
+    if (first->similarity != second->similarity) return first->similarity > second->similarity ? -1 : 1;
+    return (first->index > second->index) - (first->index < second->index);
+}
+
+List* get_similarity_cluster(CommitSimilarityTree* tree, Commit* center_commit, double min_similarity) {
+    if (!tree || !center_commit) return NULL;
+    
+    SimilarityTreeNode* center = find_tree_node(tree, center_commit);
+    if (!center) return NULL;
+    
+    List* cluster = create_list();
+    if (!cluster) return NULL;
+    
+    // Candidates are the indexed commits or, without a commit index, all nodes
+    int indexed = tree->matrix_nodes && tree->fingerprint_index ? tree->indexed_commits : 0;
+    SimilarityTreeNode** nodes = tree->matrix_nodes;
+    if (indexed == 0) {
+        nodes = collect_tree_nodes(tree, &indexed);
+        if (!nodes) return cluster;
+    } else {
+        if (tree->vantage_tree) {
+            int built = get_vantage_tree_size(tree->vantage_tree);
+            if (indexed - built > built / VANTAGE_REBUILD_FRACTION) {
+                free_vantage_tree(tree->vantage_tree);
+                tree->vantage_tree = NULL;
+            }
+        }
+        char* has_node = tree->vantage_tree ? NULL : malloc(indexed > 0 ? indexed : 1);
+        if (has_node) {
+            for (int i = 0; i < indexed; i++) has_node[i] = nodes[i] != NULL;
+            tree->vantage_tree = build_vantage_tree(get_fingerprint_index_vectors(tree->fingerprint_index), has_node,
+                                                    indexed, FINGERPRINT_DIMENSIONS);
+            free(has_node);
+        }
+    }
+    
+    // Commits the vantage tree covers are found through it, the rest are compared directly
+    SimilarityMatch* matches = NULL;
+    int found = 0;
+    int covered = 0;
+    if (nodes == tree->matrix_nodes && tree->vantage_tree) {
+        found = find_vantage_range(tree->vantage_tree, center->fingerprint->vector, min_similarity, &matches);
+        covered = found >= 0 ? get_vantage_tree_size(tree->vantage_tree) : 0;
+        if (found < 0) found = 0;
+    }
+    SimilarityMatch* resized = realloc(matches, (found + indexed - covered + 1) * sizeof(SimilarityMatch));
+    if (resized) {
+        matches = resized;
+        int listed = found;
+        for (int i = covered; i < indexed; i++) {
+            if (!nodes[i]) continue;
+            double similarity = calculate_fingerprint_similarity(center->fingerprint, nodes[i]->fingerprint);
+            if (similarity < min_similarity) continue;
+            matches[found].index = i;
+            matches[found].similarity = similarity;
+            found++;
+        }
+        if (found > listed) qsort(matches, found, sizeof(SimilarityMatch), compare_similarity_matches);
+    } else {
+        found = 0;
+    }
+    
+    // Most similar first
+    for (int i = 0; i < found; i++) insert_item(cluster, nodes[matches[i].index]);
+    
+    free(matches);
+    if (nodes != tree->matrix_nodes) free(nodes);
+    return cluster;
+}
+
+/*
+ * Vectors for the pair joins: the indexed commits' contiguous vectors or, without a
+ * commit index, a copy of every node's vector (*copied, to be freed). *nodes is the
+ * node of each vector (freed by the caller unless it is tree->matrix_nodes) and
+ * *has_node marks the ones present. Returns 0 on allocation failure.
+ */
+static int gather_join_vectors(CommitSimilarityTree* tree, SimilarityTreeNode*** nodes, int* count,
+                               const double** vectors, double** copied, char** has_node) {
+    *count = tree->matrix_nodes && tree->fingerprint_index ? tree->indexed_commits : 0;
+    *nodes = tree->matrix_nodes;
+    *vectors = *count > 0 ? get_fingerprint_index_vectors(tree->fingerprint_index) : NULL;
+    *copied = NULL;
+    if (*count == 0) {
+        *nodes = collect_tree_nodes(tree, count);
+        *copied = malloc(((size_t)*count > 0 ? (size_t)*count : 1) * FINGERPRINT_DIMENSIONS * sizeof(double));
+        for (int i = 0; *nodes && *copied && i < *count; i++) {
+            memcpy(*copied + (size_t)i * FINGERPRINT_DIMENSIONS, (*nodes)[i]->fingerprint->vector,
+                   FINGERPRINT_DIMENSIONS * sizeof(double));
+        }
+        *vectors = *copied;
+    }
+    
+    *has_node = malloc(*count > 0 ? *count : 1);
+    if (!*nodes || !*vectors || !*has_node) return 0;
+    for (int i = 0; i < *count; i++) (*has_node)[i] = (*nodes)[i] != NULL;
+    return 1;
+}
+
+List* get_top_similar_pairs(CommitSimilarityTree* tree, int top_n) {
+    if (!tree) return NULL;
+    
+    List* pairs = create_list();
+    if (!pairs || top_n <= 0) return pairs;
+    
+    SimilarityTreeNode** nodes;
+    int count;
+    const double* vectors;
+    double* copied;
+    char* has_node;
+    int gathered = gather_join_vectors(tree, &nodes, &count, &vectors, &copied, &has_node);
+    
+    long long pair_count = (long long)count * (count - 1) / 2;
+    if (top_n > pair_count) top_n = (int)pair_count;
+    SimilarityJoinPair* best = malloc((top_n > 0 ? top_n : 1) * sizeof(SimilarityJoinPair));
+    int found = 0;
+    if (gathered && best) {
+        found = find_top_similar_pairs(vectors, has_node, count, FINGERPRINT_DIMENSIONS, top_n, 0, best);
+    }
+    
+    // Most similar first
+    for (int i = 0; i < found; i++) {
+        SimilarityPair* pair = malloc(sizeof(SimilarityPair));
+        if (!pair) break;
+        SimilarityTreeNode* first = nodes[best[i].first];
+        SimilarityTreeNode* second = nodes[best[i].second];
+        pair->commit1 = first->commit;
+        pair->commit2 = second->commit;
+        pair->fp1 = first->fingerprint;
+        pair->fp2 = second->fingerprint;
+        pair->similarity_score = best[i].similarity;
+        insert_item(pairs, pair);
+    }
+    
+    free(best);
+    free(has_node);
+    free(copied);
+    if (nodes != tree->matrix_nodes) free(nodes);
+    return pairs;
+}
+
+typedef struct {
+    SimilarityTreeNode** nodes;
+    similarity_pair_visitor visitor;
+    void* context;
+} CommitPairJoin;
+
+static int visit_joined_pair(const SimilarityJoinPair* joined, void* context) {
+    CommitPairJoin* join = (CommitPairJoin*)context;
+    SimilarityTreeNode* first = join->nodes[joined->first];
+    SimilarityTreeNode* second = join->nodes[joined->second];
+    SimilarityPair pair = { first->commit, second->commit, first->fingerprint, second->fingerprint,
+                            joined->similarity };
+    return join->visitor(&pair, join->context);
+}
+
+int find_similar_commit_pairs(CommitSimilarityTree* tree, double min_similarity, similarity_pair_visitor visitor,
+                              void* context, SimilarityJoinStats* stats) {
+    if (stats) memset(stats, 0, sizeof(SimilarityJoinStats));
+    if (!tree || !visitor) return 0;
+    
+    SimilarityTreeNode** nodes;
+    int count;
+    const double* vectors;
+    double* copied;
+    char* has_node;
+    int joined = gather_join_vectors(tree, &nodes, &count, &vectors, &copied, &has_node);
+    if (joined) {
+        CommitPairJoin join = { nodes, visitor, context };
+        joined = join_similar_pairs(vectors, has_node, count, FINGERPRINT_DIMENSIONS, min_similarity, 0,
+                                    visit_joined_pair, &join, stats);
+    }
+    
+    free(has_node);
+    free(copied);
+    if (nodes != tree->matrix_nodes) free(nodes);
+    return joined;
 }
 
 double get_cached_similarity(CommitSimilarityTree* tree, Commit* commit1, Commit* commit2) {
-    if (!tree || !tree->similarity_matrix || !commit1 || !commit2) return 0.0;
+    if (!tree || !tree->commit_lookup || !commit1 || !commit2) return 0.0;
     
     int index1 = find_commit_index(tree, commit1);
     int index2 = find_commit_index(tree, commit2);
     
-    if (index1 >= 0 && index2 >= 0 && 
-        index1 < tree->total_commits && index2 < tree->total_commits) {
-        return tree->similarity_matrix[index1][index2];
+    if (index1 < 0 || index2 < 0) return 0.0;
+    
+    if (tree->similarity_matrix) {
+        int stored = get_similarity_matrix_size(tree->similarity_matrix);
+        if (index1 < stored && index2 < stored) {
+            return get_matrix_similarity(tree->similarity_matrix, index1, index2);
+        }
+    } else {
+        double similarity;
+        if (find_graph_similarity(tree->similarity_graph, index1, index2, &similarity)) return similarity;
     }
     
-    return 0.0;
+    // Pairs outside the graph, and commits added after a matrix file was mapped, are
+    // compared directly
+    SimilarityTreeNode* node1 = tree->matrix_nodes[index1];
+    SimilarityTreeNode* node2 = tree->matrix_nodes[index2];
+    if (index1 == index2) return 1.0;
+    return node1 && node2 ? calculate_fingerprint_similarity(node1->fingerprint, node2->fingerprint) : 0.0;
+}
+
+// Grow the cached matrix by one row/column for the node just added to the tree
+static void extend_similarity_matrix(CommitSimilarityTree* tree, SimilarityTreeNode* new_node) {
+    int old_count = tree->indexed_commits;
+    int new_count = old_count + 1;
+
+    Commit** index = realloc(tree->commit_index, new_count * sizeof(Commit*));
+    if (index) tree->commit_index = index;
+    SimilarityTreeNode** nodes = realloc(tree->matrix_nodes, new_count * sizeof(SimilarityTreeNode*));
+    if (nodes) tree->matrix_nodes = nodes;
+    double* column = calloc(old_count > 0 ? old_count : 1, sizeof(double));
+    if (!index || !nodes || !column || !put_commit_index(tree->commit_lookup, new_node->commit, old_count) ||
+        add_fingerprint_vector(tree->fingerprint_index, new_node->fingerprint->vector) != old_count) {
+        free(column);
+        discard_similarity_matrix(tree);
+        return;
+    }
+    tree->commit_index[old_count] = new_node->commit;
+    tree->matrix_nodes[old_count] = new_node;
+    tree->indexed_commits = new_count;
+
+    // An ANN index built earlier takes the commit too (its file is only rewritten when
+    // the index is next built)
+    if (tree->ann_index && !add_ann_commit(tree, old_count)) discard_ann_index(tree);
+
+    // Commits without a node (no fingerprint) keep similarity 0, as in build_similarity_matrix
+    double new_similarity = 0.0;
+    for (int i = 0; i < old_count; i++) {
+        SimilarityTreeNode* tree_node = tree->matrix_nodes[i];
+        if (tree_node) {
+            double similarity = calculate_fingerprint_similarity(tree_node->fingerprint, new_node->fingerprint);
+            column[i] = similarity;
+            new_similarity += 2.0 * similarity;
+        }
+    }
+
+    // A graph and a matrix file are not extended: pairs with later commits are
+    // computed on lookup
+    int appended = !tree->similarity_matrix || is_similarity_matrix_mapped(tree->similarity_matrix) ||
+                   append_similarity_column(tree->similarity_matrix, column);
+    free(column);
+    if (!appended) {
+        discard_similarity_matrix(tree);
+        return;
+    }
+
+    // Average over ordered off-diagonal pairs, as build_similarity_matrix computes it
+    double old_pairs = (double)old_count * (old_count - 1);
+    double new_pairs = (double)new_count * (new_count - 1);
+    tree->average_similarity = new_pairs > 0 ?
+        (tree->average_similarity * old_pairs + new_similarity) / new_pairs : 0.0;
+}
+
+void update_tree_with_new_commit(CommitSimilarityTree* tree, Commit* new_commit) {
+    if (!tree || !new_commit) return;
+    
+    int old_count = tree->total_commits;
+    insert_commit_by_similarity(tree, new_commit, NULL);
+    if (tree->total_commits == old_count) return; // Not inserted
+    
+    // The new node was appended to all_nodes; add its row and column to the cached matrix
+    if ((tree->similarity_matrix || tree->similarity_graph) && tree->commit_index) {
+        extend_similarity_matrix(tree, (SimilarityTreeNode*)get_node_data(get_last_node(tree->all_nodes)));
+    }
 }
 
 void print_similarity_tree(SimilarityTreeNode* root, int depth, double min_similarity) {
@@ -322,6 +1116,20 @@ void print_tree_statistics(CommitSimilarityTree* tree) {
     printf("\n========== COMMIT SIMILARITY TREE STATISTICS ==========\n");
     printf("Total Commits: %d\n", tree->total_commits);
     printf("Average Similarity: %.4f\n", tree->average_similarity);
+    if (tree->similarity_matrix) {
+        printf("Similarity Matrix: %.1f KB (%s, tiled upper triangle%s)\n",
+               get_similarity_matrix_bytes(tree->similarity_matrix) / 1024.0,
+               get_similarity_storage_name(get_similarity_matrix_storage(tree->similarity_matrix)),
+               is_similarity_matrix_mapped(tree->similarity_matrix) ? ", memory-mapped file" : "");
+    }
+    if (tree->similarity_graph) {
+        printf("Similarity Graph: %.1f KB (%d nearest neighbours per commit)\n",
+               get_similarity_graph_bytes(tree->similarity_graph) / 1024.0,
+               get_similarity_graph_degree(tree->similarity_graph));
+    }
+    if (tree->matrix_error_bound > 0.0) {
+        printf("Similarity Error Bound: %.2e (reduced-precision matrix)\n", tree->matrix_error_bound);
+    }
     
     // Calculate tree depth
     int max_depth = 0;
@@ -353,6 +1161,32 @@ void print_tree_statistics(CommitSimilarityTree* tree) {
     printf("=======================================================\n");
 }
 
+// Similarity a commit must exceed to count as a precedent
+#define PRECEDENT_MIN_SIMILARITY 0.3
+
+static HistoricalPrecedent* create_historical_precedent(Commit* commit, double similarity) {
+    HistoricalPrecedent* precedent = malloc(sizeof(HistoricalPrecedent));
+    if (!precedent) return NULL;
+    
+    precedent->similar_commit = commit;
+    precedent->similarity_score = similarity;
+    
+    // Create explanation based on similarity
+    precedent->similarity_explanation = malloc(256);
+    if (precedent->similarity_explanation) {
+        if (similarity > 0.7) {
+            strcpy(precedent->similarity_explanation, "Very similar commit pattern");
+        } else if (similarity > 0.5) {
+            strcpy(precedent->similarity_explanation, "Similar development approach");
+        } else {
+            strcpy(precedent->similarity_explanation, "Somewhat related change");
+        }
+    }
+    
+    precedent->common_characteristics = create_list();
+    return precedent;
+}
+
 List* find_historical_precedents(CommitSimilarityTree* tree, Commit* current_commit, int max_results) {
     if (!tree || !current_commit) return NULL;
     
@@ -360,58 +1194,105 @@ List* find_historical_precedents(CommitSimilarityTree* tree, Commit* current_com
     if (!precedents) return NULL;
     
     // Find the node for the current commit
-    SimilarityTreeNode* current_node = NULL;
-    Node* node = get_first_node(tree->all_nodes);
-    while (node) {
-        SimilarityTreeNode* tree_node = (SimilarityTreeNode*)get_node_data(node);
-        if (tree_node->commit == current_commit) {
-            current_node = tree_node;
-            break;
-        }
-        node = get_next_node(node);
-    }
-    
+    SimilarityTreeNode* current_node = find_tree_node(tree, current_commit);
     if (!current_node) {
         free_list(precedents);
         return NULL;
     }
+    if (max_results <= 0) return precedents;
     
-    // Find similar commits by traversing the tree and checking all nodes
-    node = get_first_node(tree->all_nodes);
-    while (node && get_number_of_items(precedents) < max_results) {
-        SimilarityTreeNode* candidate = (SimilarityTreeNode*)get_node_data(node);
-        
-        if (candidate != current_node) {
-            double similarity = calculate_fingerprint_similarity(
-                current_node->fingerprint, candidate->fingerprint);
-            
-            if (similarity > 0.3) { // Minimum threshold for precedents
-                HistoricalPrecedent* precedent = malloc(sizeof(HistoricalPrecedent));
-                if (precedent) {
-                    precedent->similar_commit = candidate->commit;
-                    precedent->similarity_score = similarity;
-                    
-                    // Create explanation based on similarity
-                    precedent->similarity_explanation = malloc(256);
-                    if (precedent->similarity_explanation) {
-                        if (similarity > 0.7) {
-                            strcpy(precedent->similarity_explanation, "Very similar commit pattern");
-                        } else if (similarity > 0.5) {
-                            strcpy(precedent->similarity_explanation, "Similar development approach");
-                        } else {
-                            strcpy(precedent->similarity_explanation, "Somewhat related change");
-                        }
-                    }
-                    
-                    precedent->common_characteristics = create_list();
-                    insert_item(precedents, precedent);
-                }
-            }
+    // Without the tree's index (it could not be allocated), search a temporary one over all nodes
+    FingerprintIndex* index = tree->fingerprint_index;
+    Commit** commits = tree->commit_index;
+    int exclude = find_commit_index(tree, current_commit);
+    if (!index) {
+        int node_count = get_number_of_items(tree->all_nodes);
+        index = create_fingerprint_index(FINGERPRINT_DIMENSIONS, node_count);
+        commits = malloc((node_count > 0 ? node_count : 1) * sizeof(Commit*));
+        Node* node = get_first_node(tree->all_nodes);
+        for (int i = 0; index && commits && node; i++, node = get_next_node(node)) {
+            SimilarityTreeNode* tree_node = (SimilarityTreeNode*)get_node_data(node);
+            if (tree_node == current_node) exclude = i;
+            commits[i] = tree_node->commit;
+            add_fingerprint_vector(index, tree_node->fingerprint->vector);
         }
-        
-        node = get_next_node(node);
     }
     
+    SimilarityMatch* matches = malloc(max_results * sizeof(SimilarityMatch));
+    int found = index && commits && matches ?
+        find_top_similar_bounded(index, current_node->fingerprint->vector, max_results, PRECEDENT_MIN_SIMILARITY,
+                                 exclude, matches, NULL) : 0;
+    
+    // Most similar first
+    for (int i = 0; i < found; i++) {
+        HistoricalPrecedent* precedent = create_historical_precedent(commits[matches[i].index], matches[i].similarity);
+        if (precedent) insert_item(precedents, precedent);
+    }
+    
+    free(matches);
+    if (index != tree->fingerprint_index) {
+        free_fingerprint_index(index);
+        free(commits);
+    }
+    return precedents;
+}
+
+List* find_historical_precedents_in_window(CommitSimilarityTree* tree, Commit* current_commit, int max_results,
+                                           long long start, long long end) {
+    if (!tree || !current_commit) return NULL;
+    
+    SimilarityTreeNode* current_node = find_tree_node(tree, current_commit);
+    if (!current_node) return NULL;
+    
+    List* precedents = create_list();
+    if (!precedents || max_results <= 0) return precedents;
+    
+    // The indexed commits keep a time index (rebuilt when commits were added since);
+    // without a commit index a temporary one is built over all nodes
+    SimilarityTreeNode** nodes = tree->matrix_nodes;
+    int count = tree->indexed_commits;
+    CommitTimeIndex* index = NULL;
+    if (nodes && tree->commit_index) {
+        if (tree->time_index && get_time_index_size(tree->time_index) != count) {
+            free_commit_time_index(tree->time_index);
+            tree->time_index = NULL;
+        }
+        if (!tree->time_index) tree->time_index = build_commit_time_index(tree->commit_index, count);
+        index = tree->time_index;
+    } else {
+        nodes = collect_tree_nodes(tree, &count);
+        Commit** commits = malloc((count > 0 ? count : 1) * sizeof(Commit*));
+        for (int i = 0; nodes && commits && i < count; i++) commits[i] = nodes[i]->commit;
+        if (nodes && commits) index = build_commit_time_index(commits, count);
+        free(commits);
+    }
+    
+    int first;
+    int window = find_time_range(index, start, end, &first);
+    SimilarityMatch* matches = malloc((window > 0 ? window : 1) * sizeof(SimilarityMatch));
+    int found = 0;
+    for (int rank = first; matches && rank < first + window; rank++) {
+        int position = get_time_index_position(index, rank);
+        SimilarityTreeNode* node = nodes[position];
+        if (!node || node == current_node) continue;
+        double similarity = calculate_fingerprint_similarity(current_node->fingerprint, node->fingerprint);
+        if (!(similarity > PRECEDENT_MIN_SIMILARITY)) continue; // Same rule as find_top_similar_bounded()
+        matches[found].index = position;
+        matches[found].similarity = similarity;
+        found++;
+    }
+    if (found > 1) qsort(matches, found, sizeof(SimilarityMatch), compare_similarity_matches);
+    
+    // Most similar first
+    for (int i = 0; i < found && i < max_results; i++) {
+        HistoricalPrecedent* precedent = create_historical_precedent(nodes[matches[i].index]->commit,
+                                                                     matches[i].similarity);
+        if (precedent) insert_item(precedents, precedent);
+    }
+    
+    free(matches);
+    if (index != tree->time_index) free_commit_time_index(index);
+    if (nodes != tree->matrix_nodes) free(nodes);
     return precedents;
 }
 
@@ -443,7 +1324,7 @@ void print_historical_precedents(List* precedents) {
 void free_similarity_tree_node(SimilarityTreeNode* node) {
     if (!node) return;
     
-    free_semantic_fingerprint(node->fingerprint);
+    // The fingerprint belongs to the tree's registry
     free(node);
 }
 
@@ -451,14 +1332,7 @@ void free_commit_similarity_tree(CommitSimilarityTree* tree) {
     if (!tree) return;
     
     // Free similarity matrix
-    if (tree->similarity_matrix) {
-        for (int i = 0; i < tree->total_commits; i++) {
-            free(tree->similarity_matrix[i]);
-        }
-        free(tree->similarity_matrix);
-    }
-    
-    free(tree->commit_index);
+    discard_similarity_matrix(tree);
     
     // Free all nodes
     if (tree->all_nodes) {
@@ -471,6 +1345,7 @@ void free_commit_similarity_tree(CommitSimilarityTree* tree) {
         free_list(tree->all_nodes);
     }
     
+    free_fingerprint_registry(tree->fingerprints);
     free(tree);
 }
 
@@ -487,6 +1362,6 @@ void free_historical_precedent(HistoricalPrecedent* precedent) {
 void free_similarity_pair(SimilarityPair* pair) {
     if (!pair) return;
     
-    // Note: fingerprints are owned by the tree nodes, don't free them here
+    // Note: fingerprints are owned by the tree's registry, don't free them here
     free(pair);
 }
@@ -3,6 +3,15 @@
 
 #include "commit.h"
 #include "semantic_fingerprint.h"
+#include "compact_fingerprints.h"
+#include "similarity_matrix.h"
+#include "similarity_graph.h"
+#include "commit_index_map.h"
+#include "fingerprint_index.h"
+#include "hnsw_index.h"
+#include "vantage_tree.h"
+#include "similarity_join.h"
+#include "commit_time_index.h"
 #include "list.h"
 
 typedef struct SimilarityTreeNode SimilarityTreeNode;
@@ -15,7 +24,7 @@ typedef struct SimilarityPair SimilarityPair;
  */
 struct SimilarityTreeNode {
     Commit* commit;
-    SemanticFingerprint* fingerprint;
+    SemanticFingerprint* fingerprint; // Shared from the tree's registry, not owned
     
     // Left child: most semantically similar commit
     SimilarityTreeNode* most_similar;
@@ -56,26 +65,130 @@ struct CommitSimilarityTree {
     int total_commits;
     double average_similarity; // Average similarity in the tree
     
-    // Cached similarity matrix for quick lookups
-    double** similarity_matrix;
+    // Cached similarity matrix for quick lookups (tiled upper triangle, in memory or mapped)
+    SimilarityMatrix* similarity_matrix;
+    SimilarityGraph* similarity_graph; // Top-k neighbours per commit, kept instead of the matrix
     Commit** commit_index;     // Maps matrix indices to commits
+    SimilarityTreeNode** matrix_nodes; // Node of each matrix commit (NULL if it was not inserted)
+    CommitIndexMap* commit_lookup;     // Maps commits and commit hashes to matrix indices
+    FingerprintIndex* fingerprint_index; // Vector of each indexed commit, for top-k searches
+    HnswIndex* ann_index;              // Approximate neighbour index, built on first use
+    int* ann_positions;                // Commit index of each ann_index vector (-1: not in this tree)
+    int ann_capacity;                  // Entries allocated in ann_positions
+    VantageTree* vantage_tree;         // Exact range index over the first indexed commits, built on first use
+    CommitTimeIndex* time_index;       // Indexed commits by timestamp, rebuilt on first use after a change
+    int indexed_commits;               // Entries in commit_index (beyond the matrix if it is a file or graph)
+    double matrix_error_bound; // Max deviation from exact similarity (vector precision plus storage)
+    
+    // One fingerprint per commit, shared by nodes, pairs and callers; owned by the tree
+    FingerprintRegistry* fingerprints;
 };
 
 // Core tree construction functions
-CommitSimilarityTree* build_similarity_tree(List* commits);
+
+/**
+ * Build the similarity tree for commits. The tree takes ownership of fingerprints
+ * (fingerprints already created through it are reused); pass NULL to start a new registry.
+ */
+CommitSimilarityTree* build_similarity_tree(List* commits, FingerprintRegistry* fingerprints);
 SimilarityTreeNode* create_similarity_node(Commit* commit, SemanticFingerprint* fingerprint);
+// fingerprint is borrowed; NULL takes it from tree->fingerprints
 void insert_commit_by_similarity(CommitSimilarityTree* tree, Commit* commit, SemanticFingerprint* fingerprint);
+// Shared fingerprint of a commit (created on first use, freed with the tree)
+SemanticFingerprint* get_tree_fingerprint(CommitSimilarityTree* tree, Commit* commit);
 
 // Tree analysis and navigation
-SimilarityTreeNode* find_most_similar_commits(CommitSimilarityTree* tree, Commit* target_commit, int max_results);
+
+// Commit in the similarity matrix with this full hash, or NULL
+Commit* find_commit_by_hash(CommitSimilarityTree* tree, const char* hash);
+
+/**
+ * The (approximately) max_results nodes most similar to target_commit, most similar
+ * first, from an HNSW index built on the first call (or loaded from the ANN file)
+ */
+List* find_most_similar_commits(CommitSimilarityTree* tree, Commit* target_commit, int max_results);
+
+/**
+ * Every node whose similarity to center_commit is at least min_similarity (the center
+ * included), most similar first. Exact: a vantage-point tree skips the commits that
+ * cannot qualify.
+ */
 List* get_similarity_cluster(CommitSimilarityTree* tree, Commit* center_commit, double min_similarity);
 List* find_commits_by_pattern(CommitSimilarityTree* tree, const char* intent_type, const char* module);
 
 // Similarity matrix operations
+
+/**
+ * Select the vector precision build_similarity_matrix() computes with
+ * (default FINGERPRINT_PRECISION_DOUBLE; lower precisions report matrix_error_bound)
+ */
+void set_similarity_precision(FingerprintPrecision precision);
+FingerprintPrecision get_similarity_precision(void);
+
+/**
+ * Select the element type of the cached matrix (default SIMILARITY_STORAGE_FLOAT32)
+ */
+void set_similarity_storage(SimilarityStorage storage);
+SimilarityStorage get_similarity_storage(void);
+
+/**
+ * Keep the matrix in a memory-mapped file at path instead of in memory (NULL turns this
+ * off). The build holds at most memory_budget bytes of the matrix at once; a file left
+ * by an earlier run over the same commits and settings is reused without recomputing.
+ * The path string must stay valid while trees are built.
+ */
+void set_similarity_matrix_file(const char* path, size_t memory_budget);
+
+/**
+ * Keep only each commit's neighbors most similar commits, in a sparse graph built in
+ * parallel, instead of the dense matrix (0, the default, keeps the matrix). Memory is
+ * O(commits * neighbors); get_cached_similarity() computes pairs outside the graph.
+ */
+void set_similarity_neighbors(int neighbors);
+int get_similarity_neighbors(void);
+
+/**
+ * Keep the index of find_most_similar_commits() in a file at path (NULL turns this off):
+ * an index saved by an earlier run is loaded and only new commits are inserted. The
+ * path string must stay valid while trees are used.
+ */
+void set_similarity_ann_file(const char* path);
+
+/**
+ * HNSW parameters of the index (defaults HNSW_DEFAULT_M, HNSW_DEFAULT_EF_CONSTRUCTION,
+ * HNSW_DEFAULT_EF_SEARCH); m below 2 and other values below 1 keep the current setting
+ */
+void set_hnsw_parameters(int m, int ef_construction, int ef_search);
+
 void build_similarity_matrix(CommitSimilarityTree* tree, List* commits);
+// Cached similarity (matrix or graph); other pairs of indexed commits are computed directly
 double get_cached_similarity(CommitSimilarityTree* tree, Commit* commit1, Commit* commit2);
+
+/**
+ * The top_n most similar pairs of distinct commits over the whole tree, most similar
+ * first, as SimilarityPair* (free each with free_similarity_pair()). Tiles of the
+ * all-pairs product are computed in parallel and only the best pairs are kept.
+ */
 List* get_top_similar_pairs(CommitSimilarityTree* tree, int top_n);
 
+/**
+ * Called for each pair found by find_similar_commit_pairs(); the pair is only valid
+ * during the call
+ * @return Nonzero to stop the search
+ */
+typedef int (*similarity_pair_visitor)(const SimilarityPair* pair, void* context);
+
+/**
+ * Every pair of distinct commits with similarity >= min_similarity (e.g. 0.95 to flag
+ * re-implemented functionality), passed to visitor as they are found, in no particular
+ * order. Exact: pairs are pruned by a ball tree before they are scored.
+ * @param stats Receives the pair counts (may be NULL); candidate_pairs / total_pairs is
+ *        the share of the all-pairs product that was scored
+ * @return 1 if the search ran to the end or was stopped by visitor, 0 on allocation failure
+ */
+int find_similar_commit_pairs(CommitSimilarityTree* tree, double min_similarity, similarity_pair_visitor visitor,
+                              void* context, SimilarityJoinStats* stats);
+
 // Tree visualization and analysis
 void print_similarity_tree(SimilarityTreeNode* root, int depth, double min_similarity);
 void print_commit_clusters(CommitSimilarityTree* tree);
@@ -102,7 +215,18 @@ typedef struct {
     List* common_characteristics;
 } HistoricalPrecedent;
 
+/**
+ * The max_results commits most similar to current_commit (similarity above 0.3), most
+ * similar first; exact, but blocks of commits that cannot make the list are skipped
+ */
 List* find_historical_precedents(CommitSimilarityTree* tree, Commit* current_commit, int max_results);
+
+/**
+ * find_historical_precedents() restricted to commits with start <= timestamp <= end:
+ * a time index narrows the search to the window first, so only its commits are scored
+ */
+List* find_historical_precedents_in_window(CommitSimilarityTree* tree, Commit* current_commit, int max_results,
+                                           long long start, long long end);
 void print_historical_precedents(List* precedents);
 void free_historical_precedent(HistoricalPrecedent* precedent);
 
@@ -0,0 +1,116 @@
+#include "commit_store.h"
+#include "commit_index_map.h"
+#include <stdlib.h>
+
+struct CommitStore {
+    int count;
+    int capacity;
+
+    // Columns, one entry per index
+    Commit** commits;
+    int* author_ids;
+
+    CommitIndexMap* lookup;      // Commit -> index, so each commit is stored once
+    List* list;                  // List view built for list_count commits (NULL: not built)
+    int list_count;
+};
+
+static int grow_commit_store(CommitStore* store, int capacity) {
+    size_t slots = (size_t)capacity;
+
+    Commit** commits = realloc(store->commits, slots * sizeof(Commit*));
+    if (commits) store->commits = commits;
+    int* author_ids = realloc(store->author_ids, slots * sizeof(int));
+    if (author_ids) store->author_ids = author_ids;
+    if (!commits || !author_ids) return 0;
+
+    store->capacity = capacity;
+    return 1;
+}
+
+CommitStore* create_commit_store(int capacity) {
+    CommitStore* store = calloc(1, sizeof(CommitStore));
+    if (!store) return NULL;
+
+    store->lookup = create_commit_index_map(capacity);
+    if (!store->lookup || !grow_commit_store(store, capacity > 16 ? capacity : 16)) {
+        free_commit_store(store);
+        return NULL;
+    }
+    return store;
+}
+
+CommitStore* build_commit_store(List* commits) {
+    if (!commits) return NULL;
+
+    CommitStore* store = create_commit_store(get_number_of_items(commits));
+    if (!store) return NULL;
+
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        if (commit && add_commit_to_store(store, commit) < 0) {
+            free_commit_store(store);
+            return NULL;
+        }
+    }
+    return store;
+}
+
+int add_commit_to_store(CommitStore* store, Commit* commit) {
+    if (!store || !commit) return -1;
+
+    int index = get_commit_index(store->lookup, commit);
+    if (index >= 0) return index;
+
+    if (store->count == store->capacity && !grow_commit_store(store, store->capacity * 2)) return -1;
+
+    index = store->count;
+    if (!put_commit_index(store->lookup, commit, index)) return -1;
+
+    store->commits[index] = commit;
+    store->author_ids[index] = get_author_id(get_commit_author(commit));
+    store->count++;
+    return index;
+}
+
+int get_commit_store_size(const CommitStore* store) {
+    return store ? store->count : 0;
+}
+
+const int* get_commit_store_author_ids(const CommitStore* store) {
+    return store ? store->author_ids : NULL;
+}
+
+Commit* get_store_commit(const CommitStore* store, int index) {
+    if (!store || index < 0 || index >= store->count) return NULL;
+    return store->commits[index];
+}
+
+List* get_commit_store_list(CommitStore* store) {
+    if (!store) return NULL;
+    if (store->list && store->list_count == store->count) return store->list;
+
+    // Rebuilt after adds, so the nodes stay in one array
+    List* list = create_list_with_capacity(store->count);
+    if (!list) return NULL;
+    for (int i = 0; i < store->count; i++) insert_item(list, store->commits[i]);
+    if (get_number_of_items(list) != store->count) {
+        free_list(list);
+        return NULL;
+    }
+
+    free_list(store->list);
+    store->list = list;
+    store->list_count = store->count;
+    return list;
+}
+
+void free_commit_store(CommitStore* store) {
+    if (!store) return;
+
+    free(store->commits);
+    free(store->author_ids);
+    free_commit_index_map(store->lookup);
+    free_list(store->list);
+    free(store);
+}
@@ -0,0 +1,52 @@
+#ifndef COMMIT_STORE_H
+#define COMMIT_STORE_H
+
+#include "commit.h"
+#include "list.h"
+
+/**
+ * Column-oriented view of a commit history. Each commit gets a stable index (its
+ * position, in the order added) into contiguous arrays of commits and author ids, so
+ * per-author scans read sequential memory instead of chasing each commit's author.
+ * The commits themselves are borrowed: they must outlive the store.
+ */
+typedef struct CommitStore CommitStore;
+
+/**
+ * Create an empty store
+ * @param capacity Expected number of commits (grows as needed)
+ * @return New store, or NULL on allocation failure
+ */
+CommitStore* create_commit_store(int capacity);
+
+/**
+ * Store of every commit in commits, in list order
+ * @return New store, or NULL on allocation failure
+ */
+CommitStore* build_commit_store(List* commits);
+
+/**
+ * Append a commit (a commit already in the store keeps its index)
+ * @return Index of the commit, or -1 on allocation failure
+ */
+int add_commit_to_store(CommitStore* store, Commit* commit);
+
+int get_commit_store_size(const CommitStore* store);
+
+// Author id of each index, 0 to get_commit_store_size() - 1 (valid until the next add)
+const int* get_commit_store_author_ids(const CommitStore* store);
+
+// Commit at index (NULL out of range)
+Commit* get_store_commit(const CommitStore* store, int index);
+
+/**
+ * The commits as a List, in index order, for the APIs that take one: its nodes are a
+ * single array, so walking it reads sequential memory. Owned by the store; valid until
+ * the next add.
+ * @return The list, or NULL on allocation failure
+ */
+List* get_commit_store_list(CommitStore* store);
+
+void free_commit_store(CommitStore* store);
+
+#endif
@@ -0,0 +1,170 @@
+#include "commit_time_index.h"
+#include <limits.h>
+#include <stdlib.h>
+
+// Prefetch distance of the search: eight timestamps (one cache line) hold a node's
+// descendants three levels down
+#define TIME_PREFETCH_NODES 8
+
+#if defined(__GNUC__)
+#define PREFETCH_TIMESTAMP(address) __builtin_prefetch(address)
+#else
+#define PREFETCH_TIMESTAMP(address) ((void)0)
+#endif
+
+typedef struct {
+    long long timestamp;
+    int position;           // In the array given to build_commit_time_index()
+} TimeEntry;
+
+struct CommitTimeIndex {
+    int count;
+    Commit** commits;       // By rank
+    TimeEntry* entries;     // By rank
+    long long* layout;      // Timestamps in Eytzinger order, 1-based (layout[0] unused)
+    int* layout_ranks;      // Rank of each layout slot
+};
+
+static int compare_time_entries(const void* a, const void* b) {
+    const TimeEntry* first = (const TimeEntry*)a;
+    const TimeEntry* second = (const TimeEntry*)b;
+    if (first->timestamp != second->timestamp) return first->timestamp < second->timestamp ? -1 : 1;
+    return (first->position > second->position) - (first->position < second->position);
+}
+
+// Fill the subtree of layout slot k with the ranks from *rank on, in order
+static void fill_layout(CommitTimeIndex* index, int k, int* rank) {
+    if (k > index->count) return;
+
+    fill_layout(index, 2 * k, rank);
+    index->layout[k] = index->entries[*rank].timestamp;
+    index->layout_ranks[k] = (*rank)++;
+    fill_layout(index, 2 * k + 1, rank);
+}
+
+CommitTimeIndex* build_commit_time_index(Commit* const* commits, int count) {
+    if (!commits || count < 0) return NULL;
+
+    CommitTimeIndex* index = malloc(sizeof(CommitTimeIndex));
+    if (!index) return NULL;
+
+    int present = 0;
+    for (int i = 0; i < count; i++) present += commits[i] != NULL;
+    size_t slots = (size_t)present + 1;
+    index->count = present;
+    index->commits = malloc(slots * sizeof(Commit*));
+    index->entries = malloc(slots * sizeof(TimeEntry));
+    index->layout = malloc(slots * sizeof(long long));
+    index->layout_ranks = malloc(slots * sizeof(int));
+    if (!index->commits || !index->entries || !index->layout || !index->layout_ranks) {
+        free_commit_time_index(index);
+        return NULL;
+    }
+
+    int rank = 0;
+    for (int i = 0; i < count; i++) {
+        if (!commits[i]) continue;
+        index->entries[rank].timestamp = get_commit_timestamp(commits[i]);
+        index->entries[rank].position = i;
+        rank++;
+    }
+    qsort(index->entries, present, sizeof(TimeEntry), compare_time_entries);
+    for (rank = 0; rank < present; rank++) index->commits[rank] = commits[index->entries[rank].position];
+
+    rank = 0;
+    fill_layout(index, 1, &rank);
+    return index;
+}
+
+// Rank of the first commit with a timestamp >= timestamp (count if none). The descent
+// always runs to the bottom of the layout; the last right turn it took (the lowest
+// set bit of k once the trailing ones are dropped) is the answer.
+static int lower_bound_rank(const CommitTimeIndex* index, long long timestamp) {
+    size_t count = (size_t)index->count;
+    size_t k = 1;
+    while (k <= count) {
+        if (k * TIME_PREFETCH_NODES <= count) PREFETCH_TIMESTAMP(index->layout + k * TIME_PREFETCH_NODES);
+        k = 2 * k + (index->layout[k] < timestamp);
+    }
+    while (k & 1) k >>= 1;
+    k >>= 1;
+    return k ? index->layout_ranks[k] : index->count;
+}
+
+// Rank of the first commit with a timestamp > timestamp (count if none)
+static int upper_bound_rank(const CommitTimeIndex* index, long long timestamp) {
+    return timestamp == LLONG_MAX ? index->count : lower_bound_rank(index, timestamp + 1);
+}
+
+int get_time_index_size(const CommitTimeIndex* index) {
+    return index ? index->count : 0;
+}
+
+Commit* get_time_index_commit(const CommitTimeIndex* index, int rank) {
+    if (!index || rank < 0 || rank >= index->count) return NULL;
+    return index->commits[rank];
+}
+
+long long get_time_index_timestamp(const CommitTimeIndex* index, int rank) {
+    if (!index || rank < 0 || rank >= index->count) return 0;
+    return index->entries[rank].timestamp;
+}
+
+int get_time_index_position(const CommitTimeIndex* index, int rank) {
+    if (!index || rank < 0 || rank >= index->count) return -1;
+    return index->entries[rank].position;
+}
+
+int find_time_range(const CommitTimeIndex* index, long long start, long long end, int* first) {
+    if (first) *first = 0;
+    if (!index || start > end) return 0;
+
+    int begin = lower_bound_rank(index, start);
+    if (first) *first = begin;
+    return upper_bound_rank(index, end) - begin;
+}
+
+int find_time_floor(const CommitTimeIndex* index, long long timestamp) {
+    if (!index) return -1;
+    return upper_bound_rank(index, timestamp) - 1;
+}
+
+int find_time_ceiling(const CommitTimeIndex* index, long long timestamp) {
+    if (!index) return -1;
+    int rank = lower_bound_rank(index, timestamp);
+    return rank < index->count ? rank : -1;
+}
+
+int find_time_nearest(const CommitTimeIndex* index, long long timestamp) {
+    int after = find_time_ceiling(index, timestamp);
+    if (after < 0) return find_time_floor(index, timestamp);
+    if (index->entries[after].timestamp == timestamp || after == 0) return after;
+
+    // The newest commit before the ceiling is the floor; the older wins a tie
+    int before = after - 1;
+    unsigned long long to_before = (unsigned long long)timestamp - (unsigned long long)index->entries[before].timestamp;
+    unsigned long long to_after = (unsigned long long)index->entries[after].timestamp - (unsigned long long)timestamp;
+    return to_before <= to_after ? before : after;
+}
+
+List* get_commits_in_time_range(const CommitTimeIndex* index, long long start, long long end) {
+    if (!index) return NULL;
+
+    List* commits = create_list();
+    if (!commits) return NULL;
+
+    int first;
+    int count = find_time_range(index, start, end, &first);
+    for (int rank = first; rank < first + count; rank++) insert_item(commits, index->commits[rank]);
+    return commits;
+}
+
+void free_commit_time_index(CommitTimeIndex* index) {
+    if (!index) return;
+
+    free(index->commits);
+    free(index->entries);
+    free(index->layout);
+    free(index->layout_ranks);
+    free(index);
+}
@@ -0,0 +1,52 @@
+#ifndef COMMIT_TIME_INDEX_H
+#define COMMIT_TIME_INDEX_H
+
+#include "commit.h"
+#include "list.h"
+
+/**
+ * Commits sorted by get_commit_timestamp(), for time-window queries. Commits are
+ * addressed by rank, 0 for the oldest; commits with equal timestamps keep the order
+ * they were given in. Searches run over a copy of the timestamps in Eytzinger (BFS)
+ * order, so the first levels of every search share a few cache lines and the next
+ * ones are prefetched: O(log n) with no unpredictable branches.
+ */
+typedef struct CommitTimeIndex CommitTimeIndex;
+
+/**
+ * Build the index over count commits (NULL entries are left out). O(n log n).
+ * @return New index, or NULL on allocation failure
+ */
+CommitTimeIndex* build_commit_time_index(Commit* const* commits, int count);
+
+int get_time_index_size(const CommitTimeIndex* index);
+
+// Commit, timestamp, and position in the array given to build_commit_time_index() of a rank
+Commit* get_time_index_commit(const CommitTimeIndex* index, int rank);
+long long get_time_index_timestamp(const CommitTimeIndex* index, int rank);
+int get_time_index_position(const CommitTimeIndex* index, int rank);
+
+/**
+ * Commits with start <= timestamp <= end: ranks *first to *first + count - 1. O(log n).
+ * @return Number of commits (0 if none, or if start > end)
+ */
+int find_time_range(const CommitTimeIndex* index, long long start, long long end, int* first);
+
+/**
+ * Rank of the newest commit at or before timestamp (floor), of the oldest one at or
+ * after it (ceiling), or of the one closest to it (nearest; ties go to the older)
+ * @return Rank, or -1 if there is none
+ */
+int find_time_floor(const CommitTimeIndex* index, long long timestamp);
+int find_time_ceiling(const CommitTimeIndex* index, long long timestamp);
+int find_time_nearest(const CommitTimeIndex* index, long long timestamp);
+
+/**
+ * The commits with start <= timestamp <= end, oldest first. O(log n + k).
+ * @return New list of Commit* (the commits are not owned), or NULL on allocation failure
+ */
+List* get_commits_in_time_range(const CommitTimeIndex* index, long long start, long long end);
+
+void free_commit_time_index(CommitTimeIndex* index);
+
+#endif
@@ -0,0 +1,209 @@
+#include "compact_fingerprints.h"
+#include "similarity_kernels.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INT8_LEVELS 127
+#define RESULT_CHUNK 256
+
+struct CompactFingerprintSet {
+    FingerprintPrecision precision;
+    int count;
+    int capacity;
+    float* float_vectors;       // FLOAT32: count x FINGERPRINT_DIMENSIONS
+    signed char* int8_vectors;  // INT8: count x FINGERPRINT_DIMENSIONS
+    float* scales;              // INT8: component = value * scale
+    double* norms;              // ||original||
+    double* errors;             // ||stored - original||
+    double max_norm;
+    double max_error;
+};
+
+static int grow_compact_set(CompactFingerprintSet* set, int capacity) {
+    if (set->precision == FINGERPRINT_PRECISION_FLOAT32) {
+        float* vectors = realloc(set->float_vectors, (size_t)capacity * FINGERPRINT_DIMENSIONS * sizeof(float));
+        if (!vectors) return 0;
+        set->float_vectors = vectors;
+    } else {
+        signed char* vectors = realloc(set->int8_vectors, (size_t)capacity * FINGERPRINT_DIMENSIONS);
+        if (!vectors) return 0;
+        set->int8_vectors = vectors;
+        float* scales = realloc(set->scales, (size_t)capacity * sizeof(float));
+        if (!scales) return 0;
+        set->scales = scales;
+    }
+
+    double* norms = realloc(set->norms, (size_t)capacity * sizeof(double));
+    if (!norms) return 0;
+    set->norms = norms;
+    double* errors = realloc(set->errors, (size_t)capacity * sizeof(double));
+    if (!errors) return 0;
+    set->errors = errors;
+
+    set->capacity = capacity;
+    return 1;
+}
+
+CompactFingerprintSet* create_compact_fingerprint_set(FingerprintPrecision precision, int capacity) {
+    if (precision != FINGERPRINT_PRECISION_FLOAT32 && precision != FINGERPRINT_PRECISION_INT8) return NULL;
+
+    CompactFingerprintSet* set = calloc(1, sizeof(CompactFingerprintSet));
+    if (!set) return NULL;
+    set->precision = precision;
+
+    if (!grow_compact_set(set, capacity > 0 ? capacity : 16)) {
+        free_compact_fingerprint_set(set);
+        return NULL;
+    }
+    return set;
+}
+
+int add_compact_vector(CompactFingerprintSet* set, const double* vector) {
+    if (!set || !vector) return -1;
+    if (set->count == set->capacity && !grow_compact_set(set, set->capacity * 2)) return -1;
+
+    int index = set->count;
+    double norm_squared = 0.0;
+    double error_squared = 0.0;
+
+    if (set->precision == FINGERPRINT_PRECISION_FLOAT32) {
+        float* stored = set->float_vectors + (size_t)index * FINGERPRINT_DIMENSIONS;
+        for (int i = 0; i < FINGERPRINT_DIMENSIONS; i++) {
+            stored[i] = (float)vector[i];
+            double difference = (double)stored[i] - vector[i];
+            norm_squared += vector[i] * vector[i];
+            error_squared += difference * difference;
+        }
+    } else {
+        // Symmetric quantization: the largest component maps to +/-127
+        double largest = 0.0;
+        for (int i = 0; i < FINGERPRINT_DIMENSIONS; i++) {
+            if (fabs(vector[i]) > largest) largest = fabs(vector[i]);
+        }
+        float scale = (float)(largest / INT8_LEVELS);
+        set->scales[index] = scale;
+
+        signed char* stored = set->int8_vectors + (size_t)index * FINGERPRINT_DIMENSIONS;
+        for (int i = 0; i < FINGERPRINT_DIMENSIONS; i++) {
+            long level = scale > 0.0f ? lround(vector[i] / scale) : 0;
+            if (level > INT8_LEVELS) level = INT8_LEVELS;
+            if (level < -INT8_LEVELS) level = -INT8_LEVELS;
+            stored[i] = (signed char)level;
+
+            double difference = (double)level * scale - vector[i];
+            norm_squared += vector[i] * vector[i];
+            error_squared += difference * difference;
+        }
+    }
+
+    set->norms[index] = sqrt(norm_squared);
+    set->errors[index] = sqrt(error_squared);
+    if (set->norms[index] > set->max_norm) set->max_norm = set->norms[index];
+    if (set->errors[index] > set->max_error) set->max_error = set->errors[index];
+    set->count++;
+    return index;
+}
+
+int get_compact_count(const CompactFingerprintSet* set) {
+    return set ? set->count : 0;
+}
+
+FingerprintPrecision get_compact_precision(const CompactFingerprintSet* set) {
+    return set ? set->precision : FINGERPRINT_PRECISION_DOUBLE;
+}
+
+size_t get_compact_vector_bytes(FingerprintPrecision precision) {
+    switch (precision) {
+    case FINGERPRINT_PRECISION_FLOAT32: return FINGERPRINT_DIMENSIONS * sizeof(float);
+    case FINGERPRINT_PRECISION_INT8: return FINGERPRINT_DIMENSIONS + sizeof(float);
+    default: return FINGERPRINT_DIMENSIONS * sizeof(double);
+    }
+}
+
+double compact_similarity(const CompactFingerprintSet* set, int a, int b) {
+    if (!set || a < 0 || b < 0 || a >= set->count || b >= set->count) return 0.0;
+
+    if (set->precision == FINGERPRINT_PRECISION_FLOAT32) {
+        return similarity_dot_float(set->float_vectors + (size_t)a * FINGERPRINT_DIMENSIONS,
+                                    set->float_vectors + (size_t)b * FINGERPRINT_DIMENSIONS,
+                                    FINGERPRINT_DIMENSIONS);
+    }
+    int dot = similarity_dot_int8(set->int8_vectors + (size_t)a * FINGERPRINT_DIMENSIONS,
+                                  set->int8_vectors + (size_t)b * FINGERPRINT_DIMENSIONS,
+                                  FINGERPRINT_DIMENSIONS);
+    return (double)dot * set->scales[a] * set->scales[b];
+}
+
+void compact_similarity_many(const CompactFingerprintSet* set, int query, double* results) {
+    if (!set || !results || query < 0 || query >= set->count) return;
+
+    // Kernel results go through a small buffer and are widened in chunks
+    if (set->precision == FINGERPRINT_PRECISION_FLOAT32) {
+        const float* query_vector = set->float_vectors + (size_t)query * FINGERPRINT_DIMENSIONS;
+        float chunk[RESULT_CHUNK];
+        for (int first = 0; first < set->count; first += RESULT_CHUNK) {
+            int count = set->count - first < RESULT_CHUNK ? set->count - first : RESULT_CHUNK;
+            similarity_dot_float_many(query_vector, set->float_vectors + (size_t)first * FINGERPRINT_DIMENSIONS,
+                                      count, FINGERPRINT_DIMENSIONS, chunk);
+            for (int i = 0; i < count; i++) {
+                results[first + i] = chunk[i];
+            }
+        }
+        return;
+    }
+
+    const signed char* query_vector = set->int8_vectors + (size_t)query * FINGERPRINT_DIMENSIONS;
+    double query_scale = set->scales[query];
+    int chunk[RESULT_CHUNK];
+    for (int first = 0; first < set->count; first += RESULT_CHUNK) {
+        int count = set->count - first < RESULT_CHUNK ? set->count - first : RESULT_CHUNK;
+        similarity_dot_int8_many(query_vector, set->int8_vectors + (size_t)first * FINGERPRINT_DIMENSIONS,
+                                 count, FINGERPRINT_DIMENSIONS, chunk);
+        for (int i = 0; i < count; i++) {
+            results[first + i] = (double)chunk[i] * query_scale * set->scales[first + i];
+        }
+    }
+}
+
+/*
+ * With x' = x + ex and y' = y + ey:
+ *   |x'.y' - x.y| <= |ex|.|y| + |x|.|ey| + |ex|.|ey|
+ * plus the rounding of the dot product itself: none for int8 (exact integer sum,
+ * then two double multiplications), gamma(n) * |x'|.|y'| for float32 accumulation.
+ */
+static double pair_error_bound(const CompactFingerprintSet* set, double norm_a, double error_a,
+                               double norm_b, double error_b) {
+    double bound = error_a * norm_b + norm_a * error_b + error_a * error_b;
+    double stored_norms = (norm_a + error_a) * (norm_b + error_b);
+    if (set->precision == FINGERPRINT_PRECISION_FLOAT32) {
+        double unit = FLT_EPSILON / 2.0;
+        double gamma = FINGERPRINT_DIMENSIONS * unit / (1.0 - FINGERPRINT_DIMENSIONS * unit);
+        bound += gamma * stored_norms;
+    } else {
+        bound += 3.0 * DBL_EPSILON * stored_norms;
+    }
+    return bound;
+}
+
+double compact_similarity_error_bound(const CompactFingerprintSet* set, int a, int b) {
+    if (!set || a < 0 || b < 0 || a >= set->count || b >= set->count) return 0.0;
+    return pair_error_bound(set, set->norms[a], set->errors[a], set->norms[b], set->errors[b]);
+}
+
+double compact_max_error_bound(const CompactFingerprintSet* set) {
+    if (!set) return 0.0;
+    return pair_error_bound(set, set->max_norm, set->max_error, set->max_norm, set->max_error);
+}
+
+void free_compact_fingerprint_set(CompactFingerprintSet* set) {
+    if (!set) return;
+
+    free(set->float_vectors);
+    free(set->int8_vectors);
+    free(set->scales);
+    free(set->norms);
+    free(set->errors);
+    free(set);
+}
@@ -0,0 +1,67 @@
+#ifndef COMPACT_FINGERPRINTS_H
+#define COMPACT_FINGERPRINTS_H
+
+#include "semantic_fingerprint.h"
+#include <stddef.h>
+
+/**
+ * Storage precision for fingerprint vectors used in similarity scans
+ */
+typedef enum {
+    FINGERPRINT_PRECISION_DOUBLE,  // SemanticFingerprint::vector as is (reference)
+    FINGERPRINT_PRECISION_FLOAT32, // float32 copy of each vector
+    FINGERPRINT_PRECISION_INT8     // int8 components with one scale per vector
+} FingerprintPrecision;
+
+/**
+ * Fingerprint vectors in one contiguous array at reduced precision.
+ * Each vector also records how far its stored form is from the original
+ * (error = ||stored - original||) so similarities come with a guaranteed bound.
+ */
+typedef struct CompactFingerprintSet CompactFingerprintSet;
+
+/**
+ * Create an empty set (precision FLOAT32 or INT8)
+ * @param capacity Expected number of vectors (grows as needed)
+ * @return New set, or NULL on allocation failure or unsupported precision
+ */
+CompactFingerprintSet* create_compact_fingerprint_set(FingerprintPrecision precision, int capacity);
+
+/**
+ * Quantize and append a FINGERPRINT_DIMENSIONS vector
+ * @return Index of the stored vector, or -1 on allocation failure
+ */
+int add_compact_vector(CompactFingerprintSet* set, const double* vector);
+
+int get_compact_count(const CompactFingerprintSet* set);
+FingerprintPrecision get_compact_precision(const CompactFingerprintSet* set);
+
+/**
+ * Bytes stored per vector at a precision (vector plus scale; excludes error bookkeeping)
+ */
+size_t get_compact_vector_bytes(FingerprintPrecision precision);
+
+/**
+ * Approximate cosine similarity between stored vectors a and b
+ */
+double compact_similarity(const CompactFingerprintSet* set, int a, int b);
+
+/**
+ * Approximate similarity of stored vector query to every stored vector
+ * @param results Array of get_compact_count(set) values
+ */
+void compact_similarity_many(const CompactFingerprintSet* set, int query, double* results);
+
+/**
+ * Upper bound on |compact_similarity(a, b) - exact double similarity|
+ */
+double compact_similarity_error_bound(const CompactFingerprintSet* set, int a, int b);
+
+/**
+ * Upper bound on the similarity error over every pair in the set
+ */
+double compact_max_error_bound(const CompactFingerprintSet* set);
+
+void free_compact_fingerprint_set(CompactFingerprintSet* set);
+
+#endif
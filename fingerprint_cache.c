@@ -0,0 +1,512 @@
+#include "fingerprint_cache.h"
+#include "git_objects.h"
+#include "mapped_file.h"
+#include "string_builder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * File layout: CacheHeader, record_count CacheRecords sorted by raw commit id, then
+ * a blob of NUL-terminated strings the records point into. Records are read in place
+ * from the mapping, so the file is tied to the layout of this build (record_size and
+ * byte_order guard against reading one written elsewhere).
+ */
+#define CACHE_MAGIC "GDFP"
+#define CACHE_BYTE_ORDER 0x01020304u
+#define NO_STRING 0xFFFFFFFFu
+
+typedef struct {
+    char magic[4];
+    unsigned int schema_version;   // FINGERPRINT_SCHEMA_VERSION at write time
+    unsigned int record_size;      // sizeof(CacheRecord) at write time
+    unsigned int byte_order;       // CACHE_BYTE_ORDER as stored by the writer
+    unsigned int record_count;
+    unsigned int reserved;
+    unsigned long long strings_size;
+} CacheHeader;
+
+typedef struct {
+    unsigned char sha[GIT_SHA1_RAWSZ];
+    unsigned int keyword_count;
+    double vector[FINGERPRINT_DIMENSIONS];
+    double magnitude;
+    double sentiment_score;
+    double file_diversity;
+    double semantic_distance;
+    double complexity_delta;
+    int total_files_changed;
+    int lines_added;
+    int lines_removed;
+    int functions_modified;
+    int classes_modified;
+    unsigned int intent_offset;    // Offsets into the string blob (NO_STRING for NULL)
+    unsigned int ticket_offset;
+    unsigned int module_offset;
+    unsigned int keywords_offset;  // keyword_count consecutive strings
+} CacheRecord;
+
+// Entry added during this run, with its own string blob
+typedef struct {
+    CacheRecord record;
+    char* strings;
+    size_t strings_size;
+} PendingRecord;
+
+struct FingerprintCache {
+    char* path;
+    MappedFile* file;
+    const CacheRecord* records;   // Inside the mapping, sorted by sha
+    unsigned int record_count;
+    unsigned char* used;          // Per mapped record: 1 once looked up this run
+    unsigned int used_count;
+    const char* strings;
+    size_t strings_size;
+    PendingRecord** pending;      // Sorted by sha
+    int pending_count;
+    int pending_capacity;
+    int hits;
+    int misses;
+};
+
+/* ---------- Strings ---------- */
+
+// Resolve a blob offset; 0 if it points outside the blob or the string is unterminated
+static int cached_string(const char* strings, size_t strings_size, unsigned int offset, const char** text) {
+    if (offset == NO_STRING) {
+        *text = NULL;
+        return 1;
+    }
+    if (offset >= strings_size || !memchr(strings + offset, '\0', strings_size - offset)) return 0;
+    *text = strings + offset;
+    return 1;
+}
+
+static int append_cached_string(StringBuilder* blob, const char* text, unsigned int* offset) {
+    if (!text) {
+        *offset = NO_STRING;
+        return 1;
+    }
+    *offset = (unsigned int)blob->length;
+    return string_builder_append(blob, text, strlen(text) + 1);
+}
+
+static char* copy_string(const char* text) {
+    if (!text) return NULL;
+    char* copy = malloc(strlen(text) + 1);
+    if (copy) strcpy(copy, text);
+    return copy;
+}
+
+// Copy a record and its strings into blob, pointing the copy's offsets at the new location
+static int rebase_record(const CacheRecord* source, const char* strings, size_t strings_size,
+                         CacheRecord* target, StringBuilder* blob) {
+    const char* intent;
+    const char* ticket;
+    const char* module;
+    if (!cached_string(strings, strings_size, source->intent_offset, &intent) ||
+        !cached_string(strings, strings_size, source->ticket_offset, &ticket) ||
+        !cached_string(strings, strings_size, source->module_offset, &module)) {
+        return 0;
+    }
+
+    *target = *source;
+    if (!append_cached_string(blob, intent, &target->intent_offset) ||
+        !append_cached_string(blob, ticket, &target->ticket_offset) ||
+        !append_cached_string(blob, module, &target->module_offset)) {
+        return 0;
+    }
+
+    target->keywords_offset = source->keyword_count ? (unsigned int)blob->length : NO_STRING;
+    unsigned int offset = source->keywords_offset;
+    for (unsigned int i = 0; i < source->keyword_count; i++) {
+        const char* keyword;
+        unsigned int ignored;
+        if (!cached_string(strings, strings_size, offset, &keyword) || !keyword ||
+            !append_cached_string(blob, keyword, &ignored)) {
+            return 0;
+        }
+        offset += (unsigned int)strlen(keyword) + 1;
+    }
+    return 1;
+}
+
+/* ---------- Records <-> fingerprints ---------- */
+
+static int record_from_fingerprint(const SemanticFingerprint* fingerprint, const unsigned char* sha,
+                                   CacheRecord* record, StringBuilder* blob) {
+    const CommitKeywords* keywords = fingerprint->keywords;
+    const FilePathAnalysis* files = fingerprint->file_analysis;
+    const CodeDeltaAnalysis* delta = fingerprint->code_delta;
+
+    memset(record, 0, sizeof(CacheRecord));
+    memcpy(record->sha, sha, GIT_SHA1_RAWSZ);
+    memcpy(record->vector, fingerprint->vector, sizeof(record->vector));
+    record->magnitude = fingerprint->magnitude;
+    record->sentiment_score = keywords->sentiment_score;
+    record->file_diversity = files->file_diversity;
+    record->semantic_distance = delta->semantic_distance;
+    record->complexity_delta = delta->complexity_delta;
+    record->total_files_changed = files->total_files_changed;
+    record->lines_added = delta->lines_added;
+    record->lines_removed = delta->lines_removed;
+    record->functions_modified = delta->functions_modified;
+    record->classes_modified = delta->classes_modified;
+    record->keyword_count = (unsigned int)keywords->keyword_count;
+
+    if (!append_cached_string(blob, keywords->intent_type, &record->intent_offset) ||
+        !append_cached_string(blob, keywords->ticket_reference, &record->ticket_offset) ||
+        !append_cached_string(blob, files->primary_module, &record->module_offset)) {
+        return 0;
+    }
+    record->keywords_offset = keywords->keyword_count ? (unsigned int)blob->length : NO_STRING;
+    for (int i = 0; i < keywords->keyword_count; i++) {
+        unsigned int ignored;
+        if (!append_cached_string(blob, keywords->keywords[i] ? keywords->keywords[i] : "", &ignored)) return 0;
+    }
+    return 1;
+}
+
+static SemanticFingerprint* fingerprint_from_record(const CacheRecord* record, const char* strings,
+                                                    size_t strings_size, const char* commit_hash) {
+    const char* intent;
+    const char* ticket;
+    const char* module;
+    if (record->keyword_count > MAX_KEYWORDS ||
+        !cached_string(strings, strings_size, record->intent_offset, &intent) ||
+        !cached_string(strings, strings_size, record->ticket_offset, &ticket) ||
+        !cached_string(strings, strings_size, record->module_offset, &module)) {
+        return NULL;
+    }
+    const char* keyword_texts[MAX_KEYWORDS];
+    unsigned int offset = record->keywords_offset;
+    for (unsigned int i = 0; i < record->keyword_count; i++) {
+        if (!cached_string(strings, strings_size, offset, &keyword_texts[i]) || !keyword_texts[i]) return NULL;
+        offset += (unsigned int)strlen(keyword_texts[i]) + 1;
+    }
+
+    SemanticFingerprint* fingerprint = calloc(1, sizeof(SemanticFingerprint));
+    if (!fingerprint) return NULL;
+    fingerprint->keywords = calloc(1, sizeof(CommitKeywords));
+    fingerprint->file_analysis = calloc(1, sizeof(FilePathAnalysis));
+    fingerprint->code_delta = calloc(1, sizeof(CodeDeltaAnalysis));
+    fingerprint->commit_hash = copy_string(commit_hash);
+    if (!fingerprint->keywords || !fingerprint->file_analysis || !fingerprint->code_delta || !fingerprint->commit_hash) {
+        free_semantic_fingerprint(fingerprint);
+        return NULL;
+    }
+
+    memcpy(fingerprint->vector, record->vector, sizeof(fingerprint->vector));
+    fingerprint->magnitude = record->magnitude;
+
+    CommitKeywords* keywords = fingerprint->keywords;
+    keywords->intent_type = copy_string(intent);
+    keywords->ticket_reference = copy_string(ticket);
+    keywords->sentiment_score = record->sentiment_score;
+    for (unsigned int i = 0; i < record->keyword_count; i++) {
+        keywords->keywords[keywords->keyword_count] = copy_string(keyword_texts[i]);
+        if (keywords->keywords[keywords->keyword_count]) keywords->keyword_count++;
+    }
+
+    fingerprint->file_analysis->primary_module = copy_string(module);
+    fingerprint->file_analysis->file_diversity = record->file_diversity;
+    fingerprint->file_analysis->total_files_changed = record->total_files_changed;
+
+    CodeDeltaAnalysis* delta = fingerprint->code_delta;
+    delta->semantic_distance = record->semantic_distance;
+    delta->lines_added = record->lines_added;
+    delta->lines_removed = record->lines_removed;
+    delta->functions_modified = record->functions_modified;
+    delta->classes_modified = record->classes_modified;
+    delta->complexity_delta = record->complexity_delta;
+    return fingerprint;
+}
+
+/* ---------- Lookup ---------- */
+
+static const CacheRecord* find_mapped_record(const FingerprintCache* cache, const unsigned char* sha) {
+    unsigned int low = 0;
+    unsigned int high = cache->record_count;
+    while (low < high) {
+        unsigned int middle = low + (high - low) / 2;
+        int order = memcmp(cache->records[middle].sha, sha, GIT_SHA1_RAWSZ);
+        if (order == 0) return &cache->records[middle];
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+// Returns 1 if found; *index is the match or the insertion point
+static int find_pending_record(const FingerprintCache* cache, const unsigned char* sha, int* index) {
+    int low = 0;
+    int high = cache->pending_count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int order = memcmp(cache->pending[middle]->record.sha, sha, GIT_SHA1_RAWSZ);
+        if (order == 0) {
+            *index = middle;
+            return 1;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *index = low;
+    return 0;
+}
+
+static int parse_commit_hash(const char* commit_hash, unsigned char* sha) {
+    return commit_hash && strlen(commit_hash) == GIT_SHA1_HEXSZ && git_sha_from_hex(commit_hash, sha);
+}
+
+SemanticFingerprint* lookup_cached_fingerprint(FingerprintCache* cache, const char* commit_hash) {
+    unsigned char sha[GIT_SHA1_RAWSZ];
+    if (!cache || !parse_commit_hash(commit_hash, sha)) return NULL;
+
+    SemanticFingerprint* fingerprint = NULL;
+    int index;
+    if (find_pending_record(cache, sha, &index)) {
+        PendingRecord* entry = cache->pending[index];
+        fingerprint = fingerprint_from_record(&entry->record, entry->strings, entry->strings_size, commit_hash);
+    } else {
+        const CacheRecord* record = find_mapped_record(cache, sha);
+        if (record) {
+            fingerprint = fingerprint_from_record(record, cache->strings, cache->strings_size, commit_hash);
+            unsigned int index = (unsigned int)(record - cache->records);
+            if (fingerprint && !cache->used[index]) {
+                cache->used[index] = 1;
+                cache->used_count++;
+            }
+        }
+    }
+
+    if (fingerprint) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+    return fingerprint;
+}
+
+void store_cached_fingerprint(FingerprintCache* cache, const SemanticFingerprint* fingerprint) {
+    unsigned char sha[GIT_SHA1_RAWSZ];
+    if (!cache || !fingerprint || !fingerprint->keywords || !fingerprint->file_analysis ||
+        !fingerprint->code_delta || !parse_commit_hash(fingerprint->commit_hash, sha)) {
+        return;
+    }
+
+    int index;
+    if (find_pending_record(cache, sha, &index)) return; // Already stored this run
+
+    if (cache->pending_count == cache->pending_capacity) {
+        int capacity = cache->pending_capacity ? cache->pending_capacity * 2 : 64;
+        PendingRecord** temp = realloc(cache->pending, capacity * sizeof(PendingRecord*));
+        if (!temp) return;
+        cache->pending = temp;
+        cache->pending_capacity = capacity;
+    }
+
+    PendingRecord* entry = malloc(sizeof(PendingRecord));
+    if (!entry) return;
+    StringBuilder blob;
+    init_string_builder(&blob);
+    if (!record_from_fingerprint(fingerprint, sha, &entry->record, &blob)) {
+        free_string_builder(&blob);
+        free(entry);
+        return;
+    }
+    entry->strings_size = blob.length;
+    entry->strings = string_builder_detach(&blob);
+
+    memmove(&cache->pending[index + 1], &cache->pending[index], (cache->pending_count - index) * sizeof(PendingRecord*));
+    cache->pending[index] = entry;
+    cache->pending_count++;
+}
+
+/* ---------- Open / save ---------- */
+
+// Point the cache at the records of the mapped file; 0 if the file cannot be used
+static int attach_mapped_records(FingerprintCache* cache) {
+    const char* data = (const char*)get_mapped_data(cache->file);
+    size_t size = get_mapped_size(cache->file);
+    if (!data || size < sizeof(CacheHeader)) return 0;
+
+    CacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, 4) != 0 ||
+        header.schema_version != FINGERPRINT_SCHEMA_VERSION ||
+        header.record_size != sizeof(CacheRecord) ||
+        header.byte_order != CACHE_BYTE_ORDER) {
+        return 0; // Written by another version of the fingerprint algorithm or another build
+    }
+
+    size_t available = size - sizeof(CacheHeader);
+    if (header.record_count > available / sizeof(CacheRecord)) return 0;
+    size_t records_size = (size_t)header.record_count * sizeof(CacheRecord);
+    if (header.strings_size > available - records_size) return 0;
+    cache->used = calloc(header.record_count ? header.record_count : 1, 1);
+    if (!cache->used) return 0;
+
+    cache->records = (const CacheRecord*)(data + sizeof(CacheHeader));
+    cache->record_count = header.record_count;
+    cache->strings = data + sizeof(CacheHeader) + records_size;
+    cache->strings_size = (size_t)header.strings_size;
+    return 1;
+}
+
+static void detach_mapped_file(FingerprintCache* cache) {
+    unmap_file(cache->file);
+    cache->file = NULL;
+    cache->records = NULL;
+    cache->record_count = 0;
+    free(cache->used);
+    cache->used = NULL;
+    cache->used_count = 0;
+    cache->strings = NULL;
+    cache->strings_size = 0;
+}
+
+static void map_cache_file(FingerprintCache* cache) {
+    cache->file = map_file_readonly(cache->path);
+    if (cache->file && !attach_mapped_records(cache)) {
+        detach_mapped_file(cache);
+    }
+}
+
+FingerprintCache* open_fingerprint_cache(const char* path) {
+    if (!path) return NULL;
+
+    FingerprintCache* cache = calloc(1, sizeof(FingerprintCache));
+    if (!cache) return NULL;
+    cache->path = copy_string(path);
+    if (!cache->path) {
+        free(cache);
+        return NULL;
+    }
+
+    map_cache_file(cache);
+    return cache;
+}
+
+static void free_pending_records(FingerprintCache* cache) {
+    for (int i = 0; i < cache->pending_count; i++) {
+        free(cache->pending[i]->strings);
+        free(cache->pending[i]);
+    }
+    cache->pending_count = 0;
+}
+
+// Merge mapped and pending records (pending wins on equal ids) into one sorted array,
+// leaving out mapped records nobody looked up when prune is set
+static CacheRecord* merge_records(FingerprintCache* cache, int prune, unsigned int* count, StringBuilder* blob) {
+    size_t total = (size_t)cache->record_count + (size_t)cache->pending_count;
+    CacheRecord* merged = malloc(total * sizeof(CacheRecord));
+    if (!merged) return NULL;
+
+    unsigned int mapped = 0;
+    int pending = 0;
+    *count = 0;
+    while (mapped < cache->record_count || pending < cache->pending_count) {
+        int order;
+        if (mapped == cache->record_count) {
+            order = 1;
+        } else if (pending == cache->pending_count) {
+            order = -1;
+        } else {
+            order = memcmp(cache->records[mapped].sha, cache->pending[pending]->record.sha, GIT_SHA1_RAWSZ);
+        }
+
+        int ok;
+        if (order < 0 && prune && !cache->used[mapped]) {
+            mapped++;
+            ok = 0;
+        } else if (order < 0) {
+            // Damaged entries from the old file are simply dropped
+            ok = rebase_record(&cache->records[mapped++], cache->strings, cache->strings_size, &merged[*count], blob);
+        } else {
+            if (order == 0) mapped++;
+            PendingRecord* entry = cache->pending[pending++];
+            ok = rebase_record(&entry->record, entry->strings, entry->strings_size, &merged[*count], blob);
+        }
+        if (ok) (*count)++;
+    }
+    return merged;
+}
+
+int save_fingerprint_cache(FingerprintCache* cache) {
+    if (!cache) return 0;
+    // Commits rewritten away or outside the analysed window are never looked up again;
+    // drop their records once they outnumber the live ones so the file cannot only grow
+    unsigned int stale = cache->record_count - cache->used_count;
+    int prune = stale > cache->used_count + (unsigned int)cache->pending_count;
+    if (cache->pending_count == 0 && !prune) return 1;
+
+    StringBuilder blob;
+    init_string_builder(&blob);
+    unsigned int count = 0;
+    CacheRecord* records = merge_records(cache, prune, &count, &blob);
+    if (!records) {
+        free_string_builder(&blob);
+        return 0;
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, 4);
+    header.schema_version = FINGERPRINT_SCHEMA_VERSION;
+    header.record_size = sizeof(CacheRecord);
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.record_count = count;
+    header.strings_size = blob.length;
+
+    size_t path_length = strlen(cache->path);
+    char* temp_path = malloc(path_length + 5);
+    FILE* fp = NULL;
+    if (temp_path) {
+        memcpy(temp_path, cache->path, path_length);
+        strcpy(temp_path + path_length, ".tmp");
+        fp = fopen(temp_path, "wb");
+    }
+
+    int ok = fp != NULL &&
+             fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             (count == 0 || fwrite(records, sizeof(CacheRecord), count, fp) == count) &&
+             (blob.length == 0 || fwrite(blob.data, 1, blob.length, fp) == blob.length);
+    if (fp && fclose(fp) != 0) ok = 0;
+    free(records);
+    free_string_builder(&blob);
+
+    // The old file must be unmapped before it can be replaced (required on Windows)
+    if (ok) {
+        detach_mapped_file(cache);
+#ifdef _WIN32
+        remove(cache->path);
+#endif
+        ok = rename(temp_path, cache->path) == 0;
+        map_cache_file(cache);
+        if (ok) free_pending_records(cache);
+    }
+    if (!ok && temp_path) remove(temp_path);
+    free(temp_path);
+    return ok;
+}
+
+void get_fingerprint_cache_stats(FingerprintCache* cache, int* hits, int* misses) {
+    if (hits) *hits = cache ? cache->hits : 0;
+    if (misses) *misses = cache ? cache->misses : 0;
+}
+
+void close_fingerprint_cache(FingerprintCache* cache) {
+    if (!cache) return;
+    detach_mapped_file(cache);
+    free_pending_records(cache);
+    free(cache->pending);
+    free(cache->path);
+    free(cache);
+}
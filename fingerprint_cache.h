@@ -0,0 +1,47 @@
+#ifndef FINGERPRINT_CACHE_H
+#define FINGERPRINT_CACHE_H
+
+#include "semantic_fingerprint.h"
+
+// Cache file written inside the repository's .git directory
+#define FINGERPRINT_CACHE_FILENAME "gitdive-fingerprints"
+
+typedef struct FingerprintCache FingerprintCache;
+
+/**
+ * Open (memory-map) the fingerprint cache at path. A missing file, a file written for
+ * another FINGERPRINT_SCHEMA_VERSION, or one from an incompatible build gives an empty cache.
+ * @return Cache handle, or NULL on allocation failure
+ */
+FingerprintCache* open_fingerprint_cache(const char* path);
+
+/**
+ * Look up the fingerprint of a commit by its full hash
+ * @return New fingerprint (free with free_semantic_fingerprint), or NULL if not cached
+ */
+SemanticFingerprint* lookup_cached_fingerprint(FingerprintCache* cache, const char* commit_hash);
+
+/**
+ * Add a freshly computed fingerprint (keyed by fingerprint->commit_hash) to the cache.
+ * New entries are kept in memory until save_fingerprint_cache().
+ */
+void store_cached_fingerprint(FingerprintCache* cache, const SemanticFingerprint* fingerprint);
+
+/**
+ * Write the cache back to disk if entries were added. Records that were not looked up
+ * since the cache was opened are dropped once they outnumber those that were.
+ * @return 1 on success (or nothing to write), 0 on error
+ */
+int save_fingerprint_cache(FingerprintCache* cache);
+
+/**
+ * Lookup counters since the cache was opened
+ */
+void get_fingerprint_cache_stats(FingerprintCache* cache, int* hits, int* misses);
+
+/**
+ * Unmap the file and release the cache (unsaved entries are discarded)
+ */
+void close_fingerprint_cache(FingerprintCache* cache);
+
+#endif
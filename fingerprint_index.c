@@ -0,0 +1,287 @@
+#include "fingerprint_index.h"
+#include "similarity_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK FINGERPRINT_INDEX_BLOCK
+
+// Added to every block bound so rounding in the bound never drops a true match
+#define BOUND_SLACK 1e-9
+
+struct FingerprintIndex {
+    int dimensions;
+    int count;
+    int capacity;          // Multiple of BLOCK
+    double* vectors;
+    char* present;         // 0 for entries added without a vector
+
+    // Per block, over its present vectors
+    double* centroids;     // Mean vector
+    double* radii;         // Largest distance from the centroid (-1 if the block has none)
+    double* lower;         // Smallest value of each dimension
+    double* upper;         // Largest value of each dimension
+};
+
+typedef struct {
+    double bound;
+    int block;
+} BlockBound;
+
+static int grow_fingerprint_index(FingerprintIndex* index, int capacity) {
+    size_t dimensions = (size_t)index->dimensions;
+    size_t blocks = (size_t)capacity / BLOCK;
+
+    double* vectors = realloc(index->vectors, (size_t)capacity * dimensions * sizeof(double));
+    if (vectors) index->vectors = vectors;
+    char* present = realloc(index->present, (size_t)capacity);
+    if (present) index->present = present;
+    double* centroids = realloc(index->centroids, blocks * dimensions * sizeof(double));
+    if (centroids) index->centroids = centroids;
+    double* radii = realloc(index->radii, blocks * sizeof(double));
+    if (radii) index->radii = radii;
+    double* lower = realloc(index->lower, blocks * dimensions * sizeof(double));
+    if (lower) index->lower = lower;
+    double* upper = realloc(index->upper, blocks * dimensions * sizeof(double));
+    if (upper) index->upper = upper;
+    if (!vectors || !present || !centroids || !radii || !lower || !upper) return 0;
+
+    index->capacity = capacity;
+    return 1;
+}
+
+FingerprintIndex* create_fingerprint_index(int dimensions, int capacity) {
+    if (dimensions < 1) return NULL;
+
+    FingerprintIndex* index = calloc(1, sizeof(FingerprintIndex));
+    if (!index) return NULL;
+    index->dimensions = dimensions;
+
+    int blocks = capacity > BLOCK ? (capacity + BLOCK - 1) / BLOCK : 1;
+    if (!grow_fingerprint_index(index, blocks * BLOCK)) {
+        free_fingerprint_index(index);
+        return NULL;
+    }
+    return index;
+}
+
+// Recompute the bounds of a block from its vectors
+static void update_block_bounds(FingerprintIndex* index, int block) {
+    int dimensions = index->dimensions;
+    int first = block * BLOCK;
+    int end = index->count - first < BLOCK ? index->count : first + BLOCK;
+    double* centroid = index->centroids + (size_t)block * dimensions;
+    double* lower = index->lower + (size_t)block * dimensions;
+    double* upper = index->upper + (size_t)block * dimensions;
+
+    int members = 0;
+    for (int i = first; i < end; i++) {
+        if (!index->present[i]) continue;
+        const double* vector = index->vectors + (size_t)i * dimensions;
+        for (int d = 0; d < dimensions; d++) {
+            if (members == 0) {
+                centroid[d] = 0.0;
+                lower[d] = upper[d] = vector[d];
+            }
+            centroid[d] += vector[d];
+            if (vector[d] < lower[d]) lower[d] = vector[d];
+            if (vector[d] > upper[d]) upper[d] = vector[d];
+        }
+        members++;
+    }
+
+    index->radii[block] = -1.0;
+    if (members == 0) return;
+
+    for (int d = 0; d < dimensions; d++) centroid[d] /= members;
+    for (int i = first; i < end; i++) {
+        if (!index->present[i]) continue;
+        const double* vector = index->vectors + (size_t)i * dimensions;
+        double distance = 0.0;
+        for (int d = 0; d < dimensions; d++) {
+            double difference = vector[d] - centroid[d];
+            distance += difference * difference;
+        }
+        distance = sqrt(distance);
+        if (distance > index->radii[block]) index->radii[block] = distance;
+    }
+}
+
+int add_fingerprint_vector(FingerprintIndex* index, const double* vector) {
+    if (!index) return -1;
+
+    if (index->count == index->capacity && !grow_fingerprint_index(index, index->capacity * 2)) return -1;
+
+    int position = index->count++;
+    double* stored = index->vectors + (size_t)position * index->dimensions;
+    if (vector) {
+        memcpy(stored, vector, (size_t)index->dimensions * sizeof(double));
+    } else {
+        memset(stored, 0, (size_t)index->dimensions * sizeof(double));
+    }
+    index->present[position] = vector != NULL;
+    update_block_bounds(index, position / BLOCK);
+    return position;
+}
+
+int get_fingerprint_index_count(const FingerprintIndex* index) {
+    return index ? index->count : 0;
+}
+
+const double* get_fingerprint_index_vectors(const FingerprintIndex* index) {
+    return index ? index->vectors : NULL;
+}
+
+/* ---------- Top-k selection: min-heap of k matches, worst first ---------- */
+
+// 1 if a ranks below b: less similar, ties to the higher position
+static int match_ranks_below(const SimilarityMatch* a, const SimilarityMatch* b) {
+    return a->similarity < b->similarity || (a->similarity == b->similarity && a->index > b->index);
+}
+
+static void sift_down_match(SimilarityMatch* heap, int length, int slot) {
+    for (;;) {
+        int worst = slot;
+        int left = 2 * slot + 1;
+        int right = left + 1;
+        if (left < length && match_ranks_below(&heap[left], &heap[worst])) worst = left;
+        if (right < length && match_ranks_below(&heap[right], &heap[worst])) worst = right;
+        if (worst == slot) return;
+
+        SimilarityMatch swap = heap[slot];
+        heap[slot] = heap[worst];
+        heap[worst] = swap;
+        slot = worst;
+    }
+}
+
+static void offer_match(SimilarityMatch* heap, int* length, int k, int index, double similarity) {
+    SimilarityMatch match = { index, similarity };
+    if (*length < k) {
+        int slot = (*length)++;
+        while (slot > 0 && match_ranks_below(&match, &heap[(slot - 1) / 2])) {
+            heap[slot] = heap[(slot - 1) / 2];
+            slot = (slot - 1) / 2;
+        }
+        heap[slot] = match;
+    } else if (match_ranks_below(&heap[0], &match)) {
+        heap[0] = match;
+        sift_down_match(heap, *length, 0);
+    }
+}
+
+// Heap sort: each removed worst match goes to the end, leaving the best first
+static void sort_matches(SimilarityMatch* heap, int length) {
+    for (int end = length - 1; end > 0; end--) {
+        SimilarityMatch swap = heap[0];
+        heap[0] = heap[end];
+        heap[end] = swap;
+        sift_down_match(heap, end, 0);
+    }
+}
+
+// Score count vectors starting at first and offer those above min_similarity
+static void score_vectors(const FingerprintIndex* index, const double* query, int first, int count,
+                          double min_similarity, int exclude, SimilarityMatch* heap, int* length, int k) {
+    double scores[BLOCK];
+    similarity_dot_many(query, index->vectors + (size_t)first * index->dimensions, count, index->dimensions, scores);
+    for (int i = 0; i < count; i++) {
+        int position = first + i;
+        if (!index->present[position] || position == exclude || !(scores[i] > min_similarity)) continue;
+        offer_match(heap, length, k, position, scores[i]);
+    }
+}
+
+int find_top_similar(const FingerprintIndex* index, const double* query, int k, double min_similarity, int exclude,
+                     SimilarityMatch* results) {
+    if (!index || !query || !results || k < 1) return 0;
+
+    int length = 0;
+    for (int first = 0; first < index->count; first += BLOCK) {
+        int count = index->count - first < BLOCK ? index->count - first : BLOCK;
+        score_vectors(index, query, first, count, min_similarity, exclude, results, &length, k);
+    }
+    sort_matches(results, length);
+    return length;
+}
+
+// Upper bound on query . v for every present v in a block: the smaller of the ball
+// bound (query . centroid + |query| * radius) and the box bound over the block's
+// per-dimension ranges
+static double block_similarity_bound(const FingerprintIndex* index, int block, const double* query, double query_norm) {
+    int dimensions = index->dimensions;
+    const double* centroid = index->centroids + (size_t)block * dimensions;
+    const double* lower = index->lower + (size_t)block * dimensions;
+    const double* upper = index->upper + (size_t)block * dimensions;
+
+    double ball = 0.0;
+    double box = 0.0;
+    for (int d = 0; d < dimensions; d++) {
+        ball += query[d] * centroid[d];
+        box += query[d] >= 0.0 ? query[d] * upper[d] : query[d] * lower[d];
+    }
+    ball += query_norm * index->radii[block];
+    return (ball < box ? ball : box) + BOUND_SLACK;
+}
+
+int find_top_similar_bounded(const FingerprintIndex* index, const double* query, int k, double min_similarity,
+                             int exclude, SimilarityMatch* results, int* blocks_scored) {
+    if (blocks_scored) *blocks_scored = 0;
+    if (!index || !query || !results || k < 1) return 0;
+
+    int blocks = (index->count + BLOCK - 1) / BLOCK;
+    BlockBound* order = malloc((blocks > 0 ? blocks : 1) * sizeof(BlockBound));
+    if (!order) {
+        if (blocks_scored) *blocks_scored = blocks;
+        return find_top_similar(index, query, k, min_similarity, exclude, results);
+    }
+
+    double query_norm = 0.0;
+    for (int d = 0; d < index->dimensions; d++) query_norm += query[d] * query[d];
+    query_norm = sqrt(query_norm);
+
+    // Blocks that cannot reach min_similarity are never scored
+    int candidates = 0;
+    for (int block = 0; block < blocks; block++) {
+        if (index->radii[block] < 0.0) continue;
+        double bound = block_similarity_bound(index, block, query, query_norm);
+        if (bound <= min_similarity) continue;
+        order[candidates].bound = bound;
+        order[candidates].block = block;
+        candidates++;
+    }
+    // Scoring the block with the highest bound first raises the k-th match early. The
+    // rest are visited in index order (sequential reads); bounds exceed every score in
+    // their block, so a block whose bound is no better than the k-th match is skipped.
+    int best = 0;
+    for (int i = 1; i < candidates; i++) {
+        if (order[i].bound > order[best].bound) best = i;
+    }
+    int length = 0;
+    int scored = 0;
+    for (int step = 0; step < candidates; step++) {
+        int i = step == 0 ? best : (step <= best ? step - 1 : step);
+        if (length == k && order[i].bound <= results[0].similarity) continue;
+        int first = order[i].block * BLOCK;
+        int count = index->count - first < BLOCK ? index->count - first : BLOCK;
+        score_vectors(index, query, first, count, min_similarity, exclude, results, &length, k);
+        scored++;
+    }
+    free(order);
+
+    sort_matches(results, length);
+    if (blocks_scored) *blocks_scored = scored;
+    return length;
+}
+
+void free_fingerprint_index(FingerprintIndex* index) {
+    if (!index) return;
+
+    free(index->vectors);
+    free(index->present);
+    free(index->centroids);
+    free(index->radii);
+    free(index->lower);
+    free(index->upper);
+    free(index);
+}
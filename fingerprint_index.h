@@ -0,0 +1,65 @@
+#ifndef FINGERPRINT_INDEX_H
+#define FINGERPRINT_INDEX_H
+
+// Vectors per block of the index; each block keeps bounds on its vectors
+#define FINGERPRINT_INDEX_BLOCK 32
+
+/**
+ * Unit-length fingerprint vectors stored back to back, in blocks of
+ * FINGERPRINT_INDEX_BLOCK, for exact top-k similarity search. Every block keeps its
+ * centroid, radius and per-dimension range, which bound the similarity of a query to
+ * anything in the block.
+ */
+typedef struct FingerprintIndex FingerprintIndex;
+
+/**
+ * One search result
+ */
+typedef struct {
+    int index;          // Position of the vector in the index
+    double similarity;
+} SimilarityMatch;
+
+/**
+ * Create an empty index
+ * @param capacity Expected number of vectors (grows as needed)
+ * @return New index, or NULL on allocation failure
+ */
+FingerprintIndex* create_fingerprint_index(int dimensions, int capacity);
+
+/**
+ * Append a vector (copied)
+ * @param vector The vector, or NULL for an entry that is never matched (stored as zeros)
+ * @return Position of the vector, or -1 on allocation failure
+ */
+int add_fingerprint_vector(FingerprintIndex* index, const double* vector);
+
+int get_fingerprint_index_count(const FingerprintIndex* index);
+
+/**
+ * All vectors, back to back (vector i starts at i * dimensions)
+ */
+const double* get_fingerprint_index_vectors(const FingerprintIndex* index);
+
+/**
+ * The k vectors most similar to query with similarity > min_similarity, scoring
+ * every vector (ties go to the lower position)
+ * @param exclude Position to leave out (-1 for none)
+ * @param results Array of k matches, filled most similar first
+ * @return Number of matches
+ */
+int find_top_similar(const FingerprintIndex* index, const double* query, int k, double min_similarity, int exclude,
+                     SimilarityMatch* results);
+
+/**
+ * Same results as find_top_similar(), but a block is skipped without reading its
+ * vectors when its similarity bound cannot beat min_similarity or the k-th match
+ * found so far (the block with the highest bound is scored first)
+ * @param blocks_scored Receives the number of blocks whose vectors were scored (may be NULL)
+ */
+int find_top_similar_bounded(const FingerprintIndex* index, const double* query, int k, double min_similarity,
+                             int exclude, SimilarityMatch* results, int* blocks_scored);
+
+void free_fingerprint_index(FingerprintIndex* index);
+
+#endif
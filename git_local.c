@@ -1,4 +1,11 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // popen/pclose
+#endif
+
 #include "git_local.h"
+#include "git_native.h"
+#include "thread_pool.h"
+#include "string_builder.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,6 +21,18 @@
 #define MAX_COMMAND_LENGTH 512
 #define MAX_LINE_LENGTH 2048
 #define MAX_COMMIT_HASH_LENGTH 41
+#define MAX_DATE_LENGTH 64
+#define COMMIT_HEADER_MARKER '\x01'
+
+#ifdef _WIN32
+#define DISCARD_STDERR "2>nul"
+#else
+#define DISCARD_STDERR "2>/dev/null"
+#endif
+
+static GitIngestMode ingest_mode = GIT_INGEST_STREAMED;
+static GitRepository* native_repository = NULL;
+static int diff_workers = 0; // 0 = one worker per CPU
 
 // Helper function to execute git commands and capture output
 static FILE* execute_git_command(const char* command) {
@@ -46,133 +65,195 @@ static char* trim_whitespace(char* str) {
 static void parse_commit_line(char* line, char* hash, char* author_name, char* message, char* date) {
     // Format: hash|author|timestamp|message
     char* token = strtok(line, "|");
-    if (token) strcpy(hash, trim_whitespace(token));
+    if (token) snprintf(hash, MAX_COMMIT_HASH_LENGTH, "%s", trim_whitespace(token));
     
     token = strtok(NULL, "|");
     if (token) strcpy(author_name, trim_whitespace(token));
     
     token = strtok(NULL, "|");
-    if (token) strcpy(date, trim_whitespace(token));
+    if (token) snprintf(date, MAX_DATE_LENGTH, "%s", trim_whitespace(token));
     
     token = strtok(NULL, "|");
     if (token) strcpy(message, trim_whitespace(token));
 }
 
-// Parse git diff output to extract modifications
-static List* parse_diff_output(FILE* fp) {
-    List* modifications = initialize_list();
-    char line[MAX_LINE_LENGTH];
-    char* current_file = NULL;
-    char* old_code = NULL;
-    char* new_code = NULL;
-    size_t old_code_len = 0;
-    size_t new_code_len = 0;
-    size_t old_code_capacity = 1024;
-    size_t new_code_capacity = 1024;
-    int start_line = 0;
-    int in_hunk = 0;
-    
-    // Initialize dynamic strings
-    old_code = malloc(old_code_capacity);
-    new_code = malloc(new_code_capacity);
-    if (!old_code || !new_code) {
-        free(old_code);
-        free(new_code);
-        return modifications;
-    }
-    old_code[0] = '\0';
-    new_code[0] = '\0';
-    
-    while (fgets(line, sizeof(line), fp)) {
-        // Remove newline
-        line[strcspn(line, "\n")] = 0;
-        
-        if (strncmp(line, "diff --git", 10) == 0) {
-            // Save previous modification if exists
-            if (current_file && (old_code_len > 0 || new_code_len > 0)) {
-                Modification* mod = initialize_modification(current_file, old_code, new_code, start_line);
-                if (mod) insert_item(modifications, mod);
-            }
-            
-            // Reset for new file
-            old_code[0] = '\0';
-            new_code[0] = '\0';
-            old_code_len = 0;
-            new_code_len = 0;
-            start_line = 0;
-            in_hunk = 0;
-            
-            // Extract filename from "diff --git a/file b/file"
-            char* space = strchr(line + 11, ' ');
-            if (space) {
-                char* filename = space + 3; // Skip " b/"
-                free(current_file); // Free previous filename
-                current_file = malloc(strlen(filename) + 1);
-                if (current_file) {
-                    strcpy(current_file, filename);
-                }
+// Incremental diff parser state. Lines are fed one at a time so the same
+// parser can consume either a whole `git show` output or the patch section of
+// a single commit inside a streamed `git log -p`. Hunk lines are appended to
+// length-tracked builders, so a file's diff is accumulated in linear time and
+// the finished buffers are handed to the Modification without another copy.
+// A deferred parser keeps them as RawModification records instead, for threads that
+// must not touch the commit arena or intern tables.
+typedef struct {
+    List* modifications;     // Modification*, or RawModification* when deferred
+    int deferred;
+    char* current_file;
+    StringBuilder old_code;
+    StringBuilder new_code;
+    int start_line;
+    int in_hunk;
+} DiffParser;
+
+// A file diff parsed off the ingesting thread, turned into a Modification by adopt_raw_modifications()
+typedef struct {
+    char* filepath;
+    char* old_code;
+    char* new_code;
+    int start_line;
+} RawModification;
+
+static int init_diff_parser(DiffParser* parser, int deferred) {
+    parser->modifications = initialize_list();
+    parser->deferred = deferred;
+    parser->current_file = NULL;
+    init_string_builder(&parser->old_code);
+    init_string_builder(&parser->new_code);
+    parser->start_line = 0;
+    parser->in_hunk = 0;
+    return parser->modifications != NULL;
+}
+
+// Save the modification accumulated for the current file, if any
+static void flush_diff_parser_file(DiffParser* parser) {
+    if (parser->current_file && (parser->old_code.length > 0 || parser->new_code.length > 0)) {
+        char* old_code = string_builder_detach(&parser->old_code);
+        char* new_code = string_builder_detach(&parser->new_code);
+        if (old_code && new_code && parser->deferred) {
+            RawModification* raw = malloc(sizeof(RawModification));
+            if (raw) {
+                raw->filepath = parser->current_file;
+                raw->old_code = old_code;
+                raw->new_code = new_code;
+                raw->start_line = parser->start_line;
+                parser->current_file = NULL; // Now owned by the record
+                insert_item(parser->modifications, raw);
+            } else {
+                free(old_code);
+                free(new_code);
             }
+        } else if (old_code && new_code) {
+            Modification* mod = adopt_modification(parser->current_file, old_code, new_code, parser->start_line);
+            parser->current_file = NULL; // Now owned by the modification (or already freed)
+            if (mod) insert_item(parser->modifications, mod);
+        } else {
+            free(old_code);
+            free(new_code);
         }
-        else if (strncmp(line, "@@", 2) == 0) {
-            // Parse hunk header to get line number
-            char* plus_pos = strchr(line, '+');
-            if (plus_pos) {
-                start_line = atoi(plus_pos + 1);
+    }
+}
+
+// Append a hunk line (minus its +/- prefix) and a newline to a code buffer
+static void append_hunk_line(StringBuilder* code, const char* line) {
+    size_t mark = code->length;
+    if (!string_builder_append(code, line + 1, strlen(line + 1)) ||
+        !string_builder_append_char(code, '\n')) {
+        // Skip the line if memory runs out, as before
+        code->length = mark;
+        if (code->data) code->data[mark] = '\0';
+    }
+}
+
+// Feed a single diff line (without trailing newline) to the parser
+static void diff_parser_feed_line(DiffParser* parser, char* line) {
+    if (strncmp(line, "diff --git", 10) == 0) {
+        // Save previous modification if exists
+        flush_diff_parser_file(parser);
+        
+        // Reset for new file
+        string_builder_reset(&parser->old_code);
+        string_builder_reset(&parser->new_code);
+        parser->start_line = 0;
+        parser->in_hunk = 0;
+        
+        // Extract filename from "diff --git a/file b/file"
+        char* space = strchr(line + 11, ' ');
+        if (space) {
+            char* filename = space + 3; // Skip " b/"
+            free(parser->current_file); // Free previous filename
+            parser->current_file = malloc(strlen(filename) + 1);
+            if (parser->current_file) {
+                strcpy(parser->current_file, filename);
             }
-            in_hunk = 1;
         }
-        else if (in_hunk) {
-            if (line[0] == '-' && line[1] != '-') {
-                // Removed line - add to old_code
-                size_t line_len = strlen(line + 1) + 1; // +1 for newline
-                if (old_code_len + line_len + 1 >= old_code_capacity) {
-                    old_code_capacity *= 2;
-                    char* temp = realloc(old_code, old_code_capacity);
-                    if (temp) {
-                        old_code = temp;
-                    } else {
-                        continue; // Skip if realloc fails
-                    }
-                }
-                strcat(old_code, line + 1);
-                strcat(old_code, "\n");
-                old_code_len += line_len;
-            }
-            else if (line[0] == '+' && line[1] != '+') {
-                // Added line - add to new_code
-                size_t line_len = strlen(line + 1) + 1; // +1 for newline
-                if (new_code_len + line_len + 1 >= new_code_capacity) {
-                    new_code_capacity *= 2;
-                    char* temp = realloc(new_code, new_code_capacity);
-                    if (temp) {
-                        new_code = temp;
-                    } else {
-                        continue; // Skip if realloc fails
-                    }
-                }
-                strcat(new_code, line + 1);
-                strcat(new_code, "\n");
-                new_code_len += line_len;
-            }
+    }
+    else if (strncmp(line, "@@", 2) == 0) {
+        // Parse hunk header to get line number
+        char* plus_pos = strchr(line, '+');
+        if (plus_pos) {
+            parser->start_line = atoi(plus_pos + 1);
         }
+        parser->in_hunk = 1;
     }
-    
-    // Save last modification
-    if (current_file && (old_code_len > 0 || new_code_len > 0)) {
-        Modification* mod = initialize_modification(current_file, old_code, new_code, start_line);
-        if (mod) insert_item(modifications, mod);
+    else if (parser->in_hunk) {
+        if (line[0] == '-' && line[1] != '-') {
+            // Removed line - add to old_code
+            append_hunk_line(&parser->old_code, line);
+        }
+        else if (line[0] == '+' && line[1] != '+') {
+            // Added line - add to new_code
+            append_hunk_line(&parser->new_code, line);
+        }
     }
+}
+
+// Save the last modification, release parser buffers and hand back the list
+static List* finish_diff_parser(DiffParser* parser) {
+    flush_diff_parser_file(parser);
     
     // Cleanup
-    free(current_file);
-    free(old_code);
-    free(new_code);
+    free(parser->current_file);
+    parser->current_file = NULL;
+    free_string_builder(&parser->old_code);
+    free_string_builder(&parser->new_code);
+    
+    return parser->modifications;
+}
+
+static List* read_diff(FILE* fp, int deferred) {
+    DiffParser parser;
+    if (!init_diff_parser(&parser, deferred)) {
+        return parser.modifications;
+    }
+    
+    // Read whole lines so long source lines are not split into bogus diff lines
+    StringBuilder line;
+    init_string_builder(&line);
+    while (string_builder_read_line(&line, fp)) {
+        diff_parser_feed_line(&parser, line.data);
+    }
+    free_string_builder(&line);
+    
+    return finish_diff_parser(&parser);
+}
+
+List* parse_git_diff(FILE* fp) {
+    return read_diff(fp, 0);
+}
+
+// Turn deferred records into modifications (on the thread that owns the commit arena and
+// intern tables) and free the records
+static List* adopt_raw_modifications(List* raw_modifications) {
+    if (!raw_modifications) return NULL;
     
+    List* modifications = initialize_list();
+    for (Node* node = get_first_node(raw_modifications); node; node = get_next_node(node)) {
+        RawModification* raw = (RawModification*)get_node_data(node);
+        Modification* mod = modifications ? adopt_modification(raw->filepath, raw->old_code, raw->new_code, raw->start_line) : NULL;
+        if (mod) {
+            insert_item(modifications, mod);
+        } else if (!modifications) {
+            free(raw->filepath);
+            free(raw->old_code);
+            free(raw->new_code);
+        }
+        free(raw);
+    }
+    free_list(raw_modifications);
     return modifications;
 }
 
 int is_git_repository() {
-    FILE* fp = execute_git_command("git rev-parse --git-dir 2>nul");
+    FILE* fp = execute_git_command("git rev-parse --git-dir " DISCARD_STDERR);
     if (!fp) return 0;
     
     char line[MAX_LINE_LENGTH];
@@ -183,7 +264,7 @@ int is_git_repository() {
 }
 
 int get_git_root(char* buffer, size_t buffer_size) {
-    FILE* fp = execute_git_command("git rev-parse --show-toplevel 2>nul");
+    FILE* fp = execute_git_command("git rev-parse --show-toplevel " DISCARD_STDERR);
     if (!fp) return 0;
     
     if (fgets(buffer, buffer_size, fp)) {
@@ -197,106 +278,466 @@ int get_git_root(char* buffer, size_t buffer_size) {
     return 0;
 }
 
+// Open the repository for native reads on first use
+static GitRepository* get_native_repository() {
+    if (!native_repository) {
+        native_repository = open_git_repository();
+    }
+    return native_repository;
+}
+
 List* get_commit_diff(const char* commit_hash) {
+    if (ingest_mode == GIT_INGEST_NATIVE) {
+        return read_native_commit_diff(get_native_repository(), commit_hash);
+    }
+    
     char command[MAX_COMMAND_LENGTH];
     snprintf(command, sizeof(command), "git show --pretty=format: %s", commit_hash);
     
     FILE* fp = execute_git_command(command);
     if (!fp) return NULL;
     
-    List* modifications = parse_diff_output(fp);
+    List* modifications = parse_git_diff(fp);
     close_git_command(fp);
     
     return modifications;
 }
 
-List* get_git_commits(int max_commits) {
-    if (!is_git_repository()) {
-        printf("Error: Not in a git repository\n");
+// Build a Commit from a "hash|author|timestamp|message" log line and its modifications.
+// Returns NULL (and frees nothing else) if the commit could not be created.
+static Commit* create_commit_from_log_line(char* line, int commit_id, List* modifications) {
+    // Size the fields from the line itself; no field can be longer than it
+    size_t field_size = strlen(line) + 1;
+    char hash[MAX_COMMIT_HASH_LENGTH];
+    char* author_name = malloc(field_size);
+    char* message = malloc(field_size);
+    char date[MAX_DATE_LENGTH];
+    
+    if (!author_name || !message) {
+        free(author_name);
+        free(message);
         return NULL;
     }
+    hash[0] = '\0';
+    author_name[0] = '\0';
+    message[0] = '\0';
+    date[0] = '\0';
     
-    char command[MAX_COMMAND_LENGTH];
-    if (max_commits > 0) {
-        snprintf(command, sizeof(command), 
-                "git log --pretty=format:\"%%H|%%an|%%at|%%s\" -n %d", max_commits);
+    // Parse the commit line
+    parse_commit_line(line, hash, author_name, message, date);
+    
+    // Create author
+    Author* author = initialize_author(commit_id, author_name);
+    if (!author) {
+        free(author_name);
+        free(message);
+        return NULL;
+    }
+    
+    // Parse UNIX timestamp from date field (git log %at gives epoch seconds)
+    long long timestamp = 0;
+    if (strlen(date) > 0) {
+        timestamp = atoll(date);
+    }
+
+    // Create commit including timestamp
+    Commit* commit = initialize_commit(commit_id, author, modifications, message, timestamp);
+    if (!commit) {
+        free_author(author);
     } else {
-        strcpy(command, "git log --pretty=format:\"%H|%an|%at|%s\"");
+        set_commit_hash(commit, hash);
     }
     
+    // Free temporary strings (the data is now copied into the structures)
+    free(author_name);
+    free(message);
+    return commit;
+}
+
+// Build a `git log` command; range is a revision range such as "abc..HEAD" (NULL for HEAD)
+static void build_log_command(char* command, size_t size, const char* format_options, const char* range, int max_commits) {
+    char limit[32] = "";
+    if (max_commits > 0) {
+        snprintf(limit, sizeof(limit), " -n %d", max_commits);
+    }
+    snprintf(command, size, "git log %s%s%s%s", format_options, limit, range ? " " : "", range ? range : "");
+}
+
+// A commit whose diff is fetched by a pool worker while the log is still being read
+typedef struct {
+    char* log_line;                        // Untokenized "hash|author|timestamp|message" line
+    char hash[MAX_COMMIT_HASH_LENGTH];
+    List* raw_modifications;               // RawModification*, adopted once the pool is done
+} DiffFetchJob;
+
+// Runs on a pool worker: only parses, so no commit arena or intern table is touched
+static void fetch_commit_diff_task(void* argument) {
+    DiffFetchJob* job = (DiffFetchJob*)argument;
+    char command[MAX_COMMAND_LENGTH];
+    snprintf(command, sizeof(command), "git show --pretty=format: %s", job->hash);
+    
+    FILE* fp = execute_git_command(command);
+    if (!fp) return;
+    job->raw_modifications = read_diff(fp, 1);
+    close_git_command(fp);
+}
+
+// Original ingestion path: one `git log` for metadata plus one `git show` per commit.
+// The `git show` calls run on a worker pool; commits are assembled in log order afterwards
+// so commit ids are the same as with a serial fetch.
+// Returns the (possibly empty) commit list, or NULL if git failed.
+static List* get_git_commits_per_commit(const char* range, int max_commits) {
+    char command[MAX_COMMAND_LENGTH];
+    build_log_command(command, sizeof(command), "--pretty=format:\"%H|%an|%at|%s\"", range, max_commits);
+    
     FILE* fp = execute_git_command(command);
     if (!fp) {
         printf("Error: Failed to execute git command\n");
         return NULL;
     }
     
-    List* commit_list = initialize_list();
-    char line[MAX_LINE_LENGTH];
-    int commit_id = 1;
+    int workers = diff_workers > 0 ? diff_workers : get_cpu_count();
+    ThreadPool* pool = workers > 1 ? create_thread_pool(workers) : NULL;
     
-    while (fgets(line, sizeof(line), fp)) {
-        // Remove newline
-        line[strcspn(line, "\n")] = 0;
-        
-        if (strlen(line) == 0) continue;
+    DiffFetchJob** jobs = NULL;
+    int job_count = 0;
+    int job_capacity = 0;
+    StringBuilder log_line;
+    init_string_builder(&log_line);
+    
+    while (string_builder_read_line(&log_line, fp)) {
+        char* line = log_line.data;
+        if (log_line.length == 0) continue;
         
-        // Use dynamic allocation for parsing variables
-        char hash[MAX_COMMIT_HASH_LENGTH];
-        char* author_name = malloc(256);
-        char* message = malloc(512);
-        char date[64];
+        if (job_count == job_capacity) {
+            int capacity = job_capacity ? job_capacity * 2 : 64;
+            DiffFetchJob** temp = realloc(jobs, capacity * sizeof(DiffFetchJob*));
+            if (!temp) continue;
+            jobs = temp;
+            job_capacity = capacity;
+        }
         
-        if (!author_name || !message) {
-            free(author_name);
-            free(message);
+        DiffFetchJob* job = malloc(sizeof(DiffFetchJob));
+        if (!job) continue;
+        job->log_line = string_builder_detach(&log_line);
+        if (!job->log_line) {
+            free(job);
             continue;
         }
+        line = job->log_line;
+        job->raw_modifications = NULL;
+        
+        // The hash is the first field; grab it before the line is tokenized
+        size_t hash_len = strcspn(line, "|");
+        if (hash_len >= sizeof(job->hash)) hash_len = sizeof(job->hash) - 1;
+        memcpy(job->hash, line, hash_len);
+        job->hash[hash_len] = '\0';
+        char* trimmed_hash = trim_whitespace(job->hash);
+        memmove(job->hash, trimmed_hash, strlen(trimmed_hash) + 1);
         
-        // Parse the commit line
-        parse_commit_line(line, hash, author_name, message, date);
+        jobs[job_count++] = job;
         
-        // Create author
-        Author* author = initialize_author(commit_id, author_name);
-        if (!author) {
-            free(author_name);
-            free(message);
+        // Get modifications for this commit (inline when running serially)
+        if (!pool || !submit_thread_pool_task(pool, fetch_commit_diff_task, job)) {
+            fetch_commit_diff_task(job);
+        }
+    }
+    
+    free_string_builder(&log_line);
+    int failed = close_git_command(fp) != 0;
+    
+    if (pool) {
+        wait_thread_pool(pool);
+        free_thread_pool(pool);
+    }
+    
+    // The commit arena and intern tables serve this thread only, so the modifications are
+    // built here, in log order
+    List* commit_list = initialize_list();
+    int commit_id = 1;
+    for (int i = 0; i < job_count; i++) {
+        List* modifications = adopt_raw_modifications(jobs[i]->raw_modifications);
+        Commit* commit = create_commit_from_log_line(jobs[i]->log_line, commit_id, modifications);
+        if (commit) {
+            insert_item(commit_list, commit);
+            commit_id++;
+        }
+        free(jobs[i]->log_line);
+        free(jobs[i]);
+    }
+    free(jobs);
+    
+    if (failed) {
+        free_commit_list(commit_list);
+        return NULL;
+    }
+    return commit_list;
+}
+
+// Streamed ingestion path: a single `git log -p` whose commit headers are
+// prefixed with COMMIT_HEADER_MARKER, split into commits as the output arrives.
+// Returns the (possibly empty) commit list, or NULL if git failed.
+static List* get_git_commits_streamed(const char* range, int max_commits) {
+    char command[MAX_COMMAND_LENGTH];
+    build_log_command(command, sizeof(command), "-p --pretty=format:\"%x01%H|%an|%at|%s\"", range, max_commits);
+    
+    FILE* fp = execute_git_command(command);
+    if (!fp) {
+        printf("Error: Failed to execute git command\n");
+        return NULL;
+    }
+    
+    List* commit_list = initialize_list();
+    StringBuilder line;
+    StringBuilder header;
+    int have_header = 0;
+    int commit_id = 1;
+    DiffParser parser;
+    init_string_builder(&line);
+    init_string_builder(&header);
+    
+    while (string_builder_read_line(&line, fp)) {
+        if (line.data[0] != COMMIT_HEADER_MARKER) {
+            if (have_header && parser.modifications) {
+                diff_parser_feed_line(&parser, line.data);
+            }
             continue;
         }
         
-        // Get modifications for this commit
-        List* modifications = get_commit_diff(hash);
-        
-        // Parse UNIX timestamp from date field (git log %at gives epoch seconds)
-        long long timestamp = 0;
-        if (strlen(date) > 0) {
-            timestamp = atoll(date);
+        // A new header closes the patch of the previous commit
+        if (have_header) {
+            Commit* commit = create_commit_from_log_line(header.data, commit_id, finish_diff_parser(&parser));
+            if (commit) {
+                insert_item(commit_list, commit);
+                commit_id++;
+            }
         }
-
-        // Create commit including timestamp
-        Commit* commit = initialize_commit(commit_id, author, modifications, message, timestamp);
+        
+        string_builder_reset(&header);
+        have_header = string_builder_append(&header, line.data + 1, line.length - 1);
+        init_diff_parser(&parser, 0);
+    }
+    
+    if (have_header) {
+        Commit* commit = create_commit_from_log_line(header.data, commit_id, finish_diff_parser(&parser));
         if (commit) {
             insert_item(commit_list, commit);
             commit_id++;
         }
+    }
+    
+    free_string_builder(&line);
+    free_string_builder(&header);
+    
+    if (close_git_command(fp) != 0) {
+        free_commit_list(commit_list);
+        return NULL;
+    }
+    return commit_list;
+}
+
+void set_git_ingest_mode(GitIngestMode mode) {
+    ingest_mode = mode;
+}
+
+GitIngestMode get_git_ingest_mode() {
+    return ingest_mode;
+}
+
+void set_git_diff_workers(int workers) {
+    diff_workers = workers > 0 ? workers : 0;
+}
+
+// Read commits in exclude_hash..HEAD (all of HEAD when exclude_hash is NULL) with the current ingestion mode
+static List* read_commit_range(const char* exclude_hash, int max_commits) {
+    if (ingest_mode == GIT_INGEST_NATIVE) {
+        return read_native_commit_range(get_native_repository(), exclude_hash, max_commits);
+    }
+    
+    char range[2 * MAX_COMMIT_HASH_LENGTH + 8];
+    if (exclude_hash) {
+        snprintf(range, sizeof(range), "%s..HEAD", exclude_hash);
+    }
+    if (ingest_mode == GIT_INGEST_PER_COMMIT) {
+        return get_git_commits_per_commit(exclude_hash ? range : NULL, max_commits);
+    }
+    return get_git_commits_streamed(exclude_hash ? range : NULL, max_commits);
+}
+
+// Commit hashes come from state files and end up in shell commands; accept only full hex ids
+static int is_full_commit_hash(const char* hash) {
+    if (!hash || strlen(hash) != MAX_COMMIT_HASH_LENGTH - 1) return 0;
+    for (const char* c = hash; *c; c++) {
+        if (!isxdigit((unsigned char)*c)) return 0;
+    }
+    return 1;
+}
+
+List* get_git_commits_since(const char* watermark, int max_commits) {
+    if (!is_full_commit_hash(watermark)) return NULL;
+    return read_commit_range(watermark, max_commits);
+}
+
+// Commits named by hash per `git log --no-walk` command, so the command fits MAX_COMMAND_LENGTH
+#define HASHES_PER_COMMAND 8
+
+// Read a batch of commits by hash, in the given order; NULL if one could not be read
+static List* read_commit_batch(Node* first, int count) {
+    if (ingest_mode == GIT_INGEST_NATIVE) {
+        List* batch = initialize_list();
+        Node* node = first;
+        for (int i = 0; batch && i < count; i++, node = get_next_node(node)) {
+            List* single = read_native_commit(get_native_repository(), (const char*)get_node_data(node));
+            if (!single) {
+                free_commit_list(batch);
+                return NULL;
+            }
+            insert_item(batch, get_node_data(get_first_node(single)));
+            free_list(single);
+        }
+        return batch;
+    }
+    
+    char revisions[sizeof("--no-walk=unsorted") + HASHES_PER_COMMAND * MAX_COMMIT_HASH_LENGTH];
+    size_t length = (size_t)snprintf(revisions, sizeof(revisions), "--no-walk=unsorted");
+    Node* node = first;
+    for (int i = 0; i < count; i++, node = get_next_node(node)) {
+        length += (size_t)snprintf(revisions + length, sizeof(revisions) - length, " %s", (const char*)get_node_data(node));
+    }
+    if (ingest_mode == GIT_INGEST_PER_COMMIT) {
+        return get_git_commits_per_commit(revisions, 0);
+    }
+    return get_git_commits_streamed(revisions, 0);
+}
+
+List* get_git_commits_by_hash(List* hashes) {
+    if (!hashes) return NULL;
+    for (Node* node = get_first_node(hashes); node; node = get_next_node(node)) {
+        if (!is_full_commit_hash((const char*)get_node_data(node))) return NULL;
+    }
+    
+    List* commits = initialize_list();
+    Node* node = get_first_node(hashes);
+    while (commits && node) {
+        int count = 0;
+        Node* next = node;
+        while (next && count < HASHES_PER_COMMAND) {
+            next = get_next_node(next);
+            count++;
+        }
         
-        // Free temporary strings (the data is now copied into the structures)
-        free(author_name);
-        free(message);
+        List* batch = read_commit_batch(node, count);
+        if (!batch || get_number_of_items(batch) != count) {
+            free_commit_list(batch);
+            free_commit_list(commits);
+            return NULL;
+        }
+        for (Node* item = get_first_node(batch); item; item = get_next_node(item)) {
+            insert_item(commits, get_node_data(item));
+        }
+        free_list(batch);
+        node = next;
+    }
+    return commits;
+}
+
+// Run `git rev-list <arguments>` and collect the printed hashes; NULL if git fails
+static List* read_rev_list(const char* arguments) {
+    char command[MAX_COMMAND_LENGTH];
+    snprintf(command, sizeof(command), "git rev-list %s " DISCARD_STDERR, arguments);
+    
+    FILE* fp = execute_git_command(command);
+    if (!fp) return NULL;
+    
+    List* hashes = initialize_list();
+    char line[MAX_LINE_LENGTH];
+    while (hashes && fgets(line, sizeof(line), fp)) {
+        char* hash = trim_whitespace(line);
+        if (*hash == '\0') continue;
+        char* copy = malloc(strlen(hash) + 1);
+        if (!copy) continue;
+        strcpy(copy, hash);
+        insert_item(hashes, copy);
+    }
+    
+    // An unknown revision (e.g. a watermark pruned after a force-push) makes rev-list fail
+    if (close_git_command(fp) != 0 && hashes) {
+        for (Node* node = get_first_node(hashes); node; node = get_next_node(node)) {
+            free(get_node_data(node));
+        }
+        free_list(hashes);
+        hashes = NULL;
+    }
+    return hashes;
+}
+
+List* get_git_commit_hashes(int max_commits) {
+    if (ingest_mode == GIT_INGEST_NATIVE) {
+        return read_native_commit_hashes(get_native_repository(), "HEAD", NULL, max_commits);
+    }
+    
+    char arguments[32] = "HEAD";
+    if (max_commits > 0) {
+        snprintf(arguments, sizeof(arguments), "-n %d HEAD", max_commits);
+    }
+    return read_rev_list(arguments);
+}
+
+List* get_git_commits_dropped_since(const char* watermark) {
+    if (!is_full_commit_hash(watermark)) return NULL;
+    
+    if (ingest_mode == GIT_INGEST_NATIVE) {
+        return read_native_commit_hashes(get_native_repository(), watermark, "HEAD", 0);
+    }
+    
+    char arguments[2 * MAX_COMMIT_HASH_LENGTH + 8];
+    snprintf(arguments, sizeof(arguments), "HEAD..%s", watermark);
+    return read_rev_list(arguments);
+}
+
+int get_git_dir(char* buffer, size_t buffer_size) {
+    if (ingest_mode == GIT_INGEST_NATIVE && get_native_repository()) {
+        return get_native_git_dir(get_native_repository(), buffer, buffer_size);
+    }
+    
+    FILE* fp = execute_git_command("git rev-parse --absolute-git-dir " DISCARD_STDERR);
+    if (!fp) return 0;
+    
+    int ok = fgets(buffer, buffer_size, fp) != NULL;
+    if (ok) {
+        // Remove newline
+        buffer[strcspn(buffer, "\n")] = 0;
     }
     
     close_git_command(fp);
+    return ok;
+}
+
+List* get_git_commits(int max_commits) {
+    int in_repository = ingest_mode == GIT_INGEST_NATIVE ? get_native_repository() != NULL : is_git_repository();
+    if (!in_repository) {
+        printf("Error: Not in a git repository\n");
+        return NULL;
+    }
+    
+    List* commit_list = read_commit_range(NULL, max_commits);
+    if (commit_list && get_number_of_items(commit_list) == 0) {
+        free_list(commit_list);
+        commit_list = NULL;
+    }
     
-    if (commit_id == 1) {
+    if (!commit_list) {
         printf("Warning: No commits found in repository\n");
         return NULL;
     }
     
-    printf("Successfully loaded %d commits from git repository\n", commit_id - 1);
+    printf("Successfully loaded %d commits from git repository\n", get_number_of_items(commit_list));
     return commit_list;
 }
 
 void cleanup_git_data() {
-    // Currently no persistent resources to clean up
-    // This function is here for future use if needed
+    // Release the mapped object database used by native ingestion
+    close_git_repository(native_repository);
+    native_repository = NULL;
     printf("Git data cleanup completed\n");
 }
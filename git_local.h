@@ -4,6 +4,34 @@
 #include "list.h"
 #include "commit.h"
 #include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Strategies for loading history from the git CLI
+ */
+typedef enum {
+    GIT_INGEST_PER_COMMIT, // `git log` for metadata plus one `git show` per commit
+    GIT_INGEST_STREAMED,   // single streamed `git log -p` split into commits as it is read (default)
+    GIT_INGEST_NATIVE      // read .git/objects directly (loose objects and packs), no git subprocess
+} GitIngestMode;
+
+/**
+ * Select how get_git_commits() reads history
+ * @param mode Ingestion strategy to use for subsequent calls
+ */
+void set_git_ingest_mode(GitIngestMode mode);
+
+/**
+ * Get the ingestion strategy currently used by get_git_commits()
+ * @return Current ingestion mode
+ */
+GitIngestMode get_git_ingest_mode();
+
+/**
+ * Set how many `git show` processes GIT_INGEST_PER_COMMIT runs concurrently
+ * @param workers Number of diff-fetch workers (0 = one per CPU, 1 = serial)
+ */
+void set_git_diff_workers(int workers);
 
 /**
  * Get commits from the local git repository
@@ -12,6 +40,37 @@
  */
 List* get_git_commits(int max_commits);
 
+/**
+ * Get commits in watermark..HEAD (reachable from HEAD but not from the watermark), newest first
+ * @param watermark Full 40-character hash of the newest commit already ingested
+ * @param max_commits Maximum number of commits to retrieve (0 for all)
+ * @return List of Commit* objects (empty if HEAD has not moved on), or NULL on error
+ */
+List* get_git_commits_since(const char* watermark, int max_commits);
+
+/**
+ * Get the commits with these full hashes, each on its own (not its ancestors), in list order
+ * @param hashes List of 40-character hex strings
+ * @return List of Commit* objects, or NULL on error (e.g. an unknown hash)
+ */
+List* get_git_commits_by_hash(List* hashes);
+
+/**
+ * Get hashes of the newest commits reachable from HEAD, in the order get_git_commits() returns them.
+ * Only commit headers are read (no diffs), so this is cheap even for long histories.
+ * @param max_commits Maximum number of hashes to retrieve (0 for all)
+ * @return List of char* hashes, or NULL on error
+ */
+List* get_git_commit_hashes(int max_commits);
+
+/**
+ * Get hashes of commits reachable from the watermark but no longer from HEAD (HEAD..watermark).
+ * A non-empty result means history was rewritten (rebase, amend, force-push) after the watermark.
+ * @param watermark Full 40-character hash of the newest commit already ingested
+ * @return List of char* hashes, or NULL if the watermark is unknown to the repository
+ */
+List* get_git_commits_dropped_since(const char* watermark);
+
 /**
  * Get detailed diff information for a specific commit
  * @param commit_hash The commit hash to get diff for
@@ -19,6 +78,13 @@ List* get_git_commits(int max_commits);
  */
 List* get_commit_diff(const char* commit_hash);
 
+/**
+ * Parse `git show`/`git diff` output into one modification per file with removed or added lines
+ * @param fp Stream positioned at the first "diff --git" line (read to EOF)
+ * @return List of Modification* objects (empty if there are none), or NULL on allocation failure
+ */
+List* parse_git_diff(FILE* fp);
+
 /**
  * Check if current directory is a git repository
  * @return 1 if git repo, 0 otherwise
@@ -33,6 +99,14 @@ int is_git_repository();
  */
 int get_git_root(char* buffer, size_t buffer_size);
 
+/**
+ * Get the absolute path of the repository's .git directory
+ * @param buffer Buffer to store the path
+ * @param buffer_size Size of the buffer
+ * @return 1 on success, 0 on error
+ */
+int get_git_dir(char* buffer, size_t buffer_size);
+
 /**
  * Clean up any resources used by git operations
  */
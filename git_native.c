@@ -0,0 +1,840 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // getcwd
+#endif
+
+#include "git_native.h"
+#include "git_objects.h"
+#include "blob_diff.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
+
+#define MAX_PATH_LENGTH 1024
+#define MAX_REF_LINE_LENGTH 1024
+#define MAX_SYMREF_DEPTH 5
+
+#define GIT_MODE_TYPE_MASK 0170000
+#define GIT_MODE_TREE 0040000
+#define GIT_MODE_GITLINK 0160000
+
+struct GitRepository {
+    char git_dir[MAX_PATH_LENGTH];     // Per-worktree directory (HEAD lives here)
+    char common_dir[MAX_PATH_LENGTH];  // Shared directory (objects, refs, packed-refs)
+    GitObjectDatabase* odb;
+};
+
+// A commit waiting in the history walk queue
+typedef struct {
+    unsigned char sha[GIT_SHA1_RAWSZ];
+    GitCommitInfo info;
+    unsigned long sequence;
+} PendingCommit;
+
+// Max-heap on committer time; ties keep insertion order (as git's prio_queue does)
+typedef struct {
+    PendingCommit** items;
+    int count;
+    int capacity;
+} CommitQueue;
+
+// Flags kept per commit by the history walk
+#define WALK_SEEN 1           // Queued at some point
+#define WALK_UNINTERESTING 2  // Reachable from an excluded commit
+#define WALK_DONE 4           // Already popped from the queue
+
+// Open-addressing set of raw SHA-1s already queued by the walk, with WALK_* flags
+typedef struct {
+    unsigned char (*slots)[GIT_SHA1_RAWSZ];
+    char* used;    // 0 for empty slots, otherwise the commit's WALK_* flags
+    size_t capacity;
+    size_t count;
+} ShaSet;
+
+// One changed path between two trees
+typedef struct {
+    char* path;
+    unsigned char old_sha[GIT_SHA1_RAWSZ];
+    unsigned char new_sha[GIT_SHA1_RAWSZ];
+    unsigned int old_mode;   // 0 if the path did not exist before
+    unsigned int new_mode;   // 0 if the path was deleted
+} TreeChange;
+
+typedef struct {
+    TreeChange* items;
+    int count;
+    int capacity;
+} TreeChangeList;
+
+// Helper function to read the first line of a small file (newline stripped)
+static int read_first_line(const char* path, char* buffer, size_t buffer_size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    int ok = fgets(buffer, (int)buffer_size, fp) != NULL;
+    fclose(fp);
+    if (ok) buffer[strcspn(buffer, "\r\n")] = '\0';
+    return ok;
+}
+
+static int is_absolute_path(const char* path) {
+#ifdef _WIN32
+    if (path[0] && path[1] == ':') return 1;
+    if (path[0] == '\\') return 1;
+#endif
+    return path[0] == '/';
+}
+
+// Resolve `path` relative to `base` unless it is already absolute; returns 0 if it does not fit
+static int join_path(char* out, size_t out_size, const char* base, const char* path) {
+    int written;
+    if (is_absolute_path(path)) {
+        written = snprintf(out, out_size, "%s", path);
+    } else {
+        written = snprintf(out, out_size, "%s/%s", base, path);
+    }
+    return written >= 0 && (size_t)written < out_size;
+}
+
+// Find the .git directory (or gitfile target) above the current directory
+static int discover_git_dir(char* git_dir, size_t size) {
+    char dir[MAX_PATH_LENGTH];
+    if (!getcwd(dir, sizeof(dir))) return 0;
+
+    for (;;) {
+        char candidate[MAX_PATH_LENGTH + 16];
+        char probe[MAX_PATH_LENGTH + 32];
+        char line[MAX_REF_LINE_LENGTH];
+        snprintf(candidate, sizeof(candidate), "%s/.git", dir);
+
+        // Regular repository: .git is a directory with a HEAD file
+        snprintf(probe, sizeof(probe), "%s/HEAD", candidate);
+        if (read_first_line(probe, line, sizeof(line))) {
+            return join_path(git_dir, size, "", candidate);
+        }
+
+        // Worktree or submodule: .git is a file containing "gitdir: <path>"
+        if (read_first_line(candidate, line, sizeof(line)) && strncmp(line, "gitdir: ", 8) == 0) {
+            return join_path(git_dir, size, dir, line + 8);
+        }
+
+        // Move to the parent directory
+        char* slash = strrchr(dir, '/');
+#ifdef _WIN32
+        char* backslash = strrchr(dir, '\\');
+        if (backslash > slash) slash = backslash;
+#endif
+        if (!slash || slash == dir) return 0;
+        *slash = '\0';
+    }
+}
+
+GitRepository* open_git_repository() {
+    GitRepository* repo = malloc(sizeof(GitRepository));
+    if (!repo) return NULL;
+
+    if (!discover_git_dir(repo->git_dir, sizeof(repo->git_dir))) {
+        free(repo);
+        return NULL;
+    }
+
+    // Linked worktrees share objects and refs through "commondir"
+    char path[MAX_PATH_LENGTH + 16];
+    char line[MAX_REF_LINE_LENGTH];
+    snprintf(path, sizeof(path), "%s/commondir", repo->git_dir);
+    if (!read_first_line(path, line, sizeof(line))) {
+        strcpy(line, ".");
+    }
+    if (!join_path(repo->common_dir, sizeof(repo->common_dir), repo->git_dir, line)) {
+        free(repo);
+        return NULL;
+    }
+
+    snprintf(path, sizeof(path), "%s/objects", repo->common_dir);
+    repo->odb = open_object_database(path);
+    if (!repo->odb) {
+        free(repo);
+        return NULL;
+    }
+    return repo;
+}
+
+int get_native_git_dir(GitRepository* repo, char* buffer, size_t buffer_size) {
+    if (!repo) return 0;
+    return snprintf(buffer, buffer_size, "%s", repo->git_dir) < (int)buffer_size;
+}
+
+void close_git_repository(GitRepository* repo) {
+    if (!repo) return;
+    free_object_database(repo->odb);
+    free(repo);
+}
+
+static int lookup_packed_ref(GitRepository* repo, const char* ref, unsigned char* sha) {
+    char path[MAX_PATH_LENGTH + 16];
+    snprintf(path, sizeof(path), "%s/packed-refs", repo->common_dir);
+    FILE* fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    // Lines are "<hex sha> <refname>"; '#' is the header, '^' a peeled tag
+    char line[MAX_REF_LINE_LENGTH];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#' || line[0] == '^') continue;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strlen(line) > GIT_SHA1_HEXSZ + 1 && strcmp(line + GIT_SHA1_HEXSZ + 1, ref) == 0) {
+            found = git_sha_from_hex(line, sha);
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+// Resolve HEAD or a full ref name to a commit id, following symbolic refs
+static int resolve_reference(GitRepository* repo, const char* name, unsigned char* sha) {
+    char ref[MAX_REF_LINE_LENGTH];
+    snprintf(ref, sizeof(ref), "%s", name);
+
+    for (int depth = 0; depth < MAX_SYMREF_DEPTH; depth++) {
+        char path[MAX_PATH_LENGTH + MAX_REF_LINE_LENGTH];
+        char content[MAX_REF_LINE_LENGTH];
+        const char* base = strcmp(ref, "HEAD") == 0 ? repo->git_dir : repo->common_dir;
+        snprintf(path, sizeof(path), "%s/%s", base, ref);
+
+        if (!read_first_line(path, content, sizeof(content))) {
+            return lookup_packed_ref(repo, ref, sha);
+        }
+        if (strncmp(content, "ref: ", 5) != 0) {
+            return git_sha_from_hex(content, sha);
+        }
+        memmove(ref, content + 5, strlen(content + 5) + 1);
+    }
+    return 0;
+}
+
+static int load_commit(GitRepository* repo, const unsigned char* sha, GitCommitInfo* info) {
+    GitObject object;
+    if (!read_git_object(repo->odb, sha, &object)) return 0;
+    int ok = parse_git_commit(&object, info);
+    free_git_object(&object);
+    return ok;
+}
+
+/* ---------- History walk helpers ---------- */
+
+static int queue_before(const PendingCommit* a, const PendingCommit* b) {
+    if (a->info.committer_time != b->info.committer_time) {
+        return a->info.committer_time > b->info.committer_time;
+    }
+    return a->sequence < b->sequence;
+}
+
+static int queue_push(CommitQueue* queue, PendingCommit* item) {
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 64;
+        PendingCommit** temp = realloc(queue->items, capacity * sizeof(PendingCommit*));
+        if (!temp) return 0;
+        queue->items = temp;
+        queue->capacity = capacity;
+    }
+
+    int i = queue->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!queue_before(item, queue->items[parent])) break;
+        queue->items[i] = queue->items[parent];
+        i = parent;
+    }
+    queue->items[i] = item;
+    return 1;
+}
+
+static PendingCommit* queue_pop(CommitQueue* queue) {
+    if (queue->count == 0) return NULL;
+
+    PendingCommit* top = queue->items[0];
+    PendingCommit* last = queue->items[--queue->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= queue->count) break;
+        if (child + 1 < queue->count && queue_before(queue->items[child + 1], queue->items[child])) child++;
+        if (!queue_before(queue->items[child], last)) break;
+        queue->items[i] = queue->items[child];
+        i = child;
+    }
+    if (queue->count > 0) queue->items[i] = last;
+    return top;
+}
+
+static size_t sha_slot(const ShaSet* set, const unsigned char* sha) {
+    size_t hash;
+    memcpy(&hash, sha, sizeof(hash)); // SHA-1 bytes are already uniformly distributed
+    return hash & (set->capacity - 1);
+}
+
+// Returns 1 if the id was added, 0 if it was already present (or memory ran out)
+static int sha_set_insert(ShaSet* set, const unsigned char* sha) {
+    if ((set->count + 1) * 2 > set->capacity) {
+        size_t old_capacity = set->capacity;
+        unsigned char (*old_slots)[GIT_SHA1_RAWSZ] = set->slots;
+        char* old_used = set->used;
+
+        size_t capacity = old_capacity ? old_capacity * 2 : 1024;
+        set->slots = malloc(capacity * sizeof(*set->slots));
+        set->used = calloc(capacity, 1);
+        if (!set->slots || !set->used) {
+            free(set->slots);
+            free(set->used);
+            set->slots = old_slots;
+            set->used = old_used;
+            return 0;
+        }
+        set->capacity = capacity;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (!old_used[i]) continue;
+            size_t slot = sha_slot(set, old_slots[i]);
+            while (set->used[slot]) slot = (slot + 1) & (capacity - 1);
+            memcpy(set->slots[slot], old_slots[i], GIT_SHA1_RAWSZ);
+            set->used[slot] = old_used[i];
+        }
+        free(old_slots);
+        free(old_used);
+    }
+
+    size_t slot = sha_slot(set, sha);
+    while (set->used[slot]) {
+        if (memcmp(set->slots[slot], sha, GIT_SHA1_RAWSZ) == 0) return 0;
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+    memcpy(set->slots[slot], sha, GIT_SHA1_RAWSZ);
+    set->used[slot] = WALK_SEEN;
+    set->count++;
+    return 1;
+}
+
+// Flags of an id in the set, or NULL if it was never inserted
+static char* sha_set_flags(const ShaSet* set, const unsigned char* sha) {
+    if (set->capacity == 0) return NULL;
+    size_t slot = sha_slot(set, sha);
+    while (set->used[slot]) {
+        if (memcmp(set->slots[slot], sha, GIT_SHA1_RAWSZ) == 0) return &set->used[slot];
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+    return NULL;
+}
+
+/* ---------- Tree diff ---------- */
+
+static int is_tree_mode(unsigned int mode) {
+    return (mode & GIT_MODE_TYPE_MASK) == GIT_MODE_TREE;
+}
+
+// Git orders tree entries as if directory names ended with '/'
+static int compare_tree_entries(const GitTreeEntry* a, const GitTreeEntry* b) {
+    size_t length = a->name_length < b->name_length ? a->name_length : b->name_length;
+    int cmp = memcmp(a->name, b->name, length);
+    if (cmp) return cmp;
+
+    unsigned char c1 = length < a->name_length ? (unsigned char)a->name[length] : (is_tree_mode(a->mode) ? '/' : '\0');
+    unsigned char c2 = length < b->name_length ? (unsigned char)b->name[length] : (is_tree_mode(b->mode) ? '/' : '\0');
+    return (int)c1 - (int)c2;
+}
+
+static void add_tree_change(TreeChangeList* changes, const char* prefix, const GitTreeEntry* old_entry, const GitTreeEntry* new_entry) {
+    if (changes->count == changes->capacity) {
+        int capacity = changes->capacity ? changes->capacity * 2 : 16;
+        TreeChange* temp = realloc(changes->items, capacity * sizeof(TreeChange));
+        if (!temp) return;
+        changes->items = temp;
+        changes->capacity = capacity;
+    }
+
+    const GitTreeEntry* named = new_entry ? new_entry : old_entry;
+    size_t prefix_length = strlen(prefix);
+    char* path = malloc(prefix_length + named->name_length + 1);
+    if (!path) return;
+    memcpy(path, prefix, prefix_length);
+    memcpy(path + prefix_length, named->name, named->name_length);
+    path[prefix_length + named->name_length] = '\0';
+
+    TreeChange* change = &changes->items[changes->count++];
+    memset(change, 0, sizeof(TreeChange));
+    change->path = path;
+    if (old_entry) {
+        change->old_mode = old_entry->mode;
+        memcpy(change->old_sha, old_entry->sha, GIT_SHA1_RAWSZ);
+    }
+    if (new_entry) {
+        change->new_mode = new_entry->mode;
+        memcpy(change->new_sha, new_entry->sha, GIT_SHA1_RAWSZ);
+    }
+}
+
+// Recursively collect changed blobs between two trees (either may be NULL for an empty tree)
+static void diff_trees(GitRepository* repo, const unsigned char* old_sha, const unsigned char* new_sha,
+                       const char* prefix, TreeChangeList* changes) {
+    GitObject old_tree = { GIT_OBJECT_NONE, NULL, 0 };
+    GitObject new_tree = { GIT_OBJECT_NONE, NULL, 0 };
+    if (old_sha && (!read_git_object(repo->odb, old_sha, &old_tree) || old_tree.type != GIT_OBJECT_TREE)) {
+        free_git_object(&old_tree);
+        return;
+    }
+    if (new_sha && (!read_git_object(repo->odb, new_sha, &new_tree) || new_tree.type != GIT_OBJECT_TREE)) {
+        free_git_object(&old_tree);
+        free_git_object(&new_tree);
+        return;
+    }
+
+    size_t old_offset = 0, new_offset = 0;
+    GitTreeEntry old_entry, new_entry;
+    int has_old = old_sha && next_git_tree_entry(&old_tree, &old_offset, &old_entry);
+    int has_new = new_sha && next_git_tree_entry(&new_tree, &new_offset, &new_entry);
+
+    while (has_old || has_new) {
+        int cmp = !has_old ? 1 : (!has_new ? -1 : compare_tree_entries(&old_entry, &new_entry));
+        const GitTreeEntry* removed = cmp <= 0 ? &old_entry : NULL;
+        const GitTreeEntry* added = cmp >= 0 ? &new_entry : NULL;
+
+        // Unchanged entries (and mode-only changes) produce no patch
+        if (!(removed && added && memcmp(removed->sha, added->sha, GIT_SHA1_RAWSZ) == 0)) {
+            const GitTreeEntry* named = added ? added : removed;
+            if (is_tree_mode(named->mode)) {
+                size_t prefix_length = strlen(prefix);
+                char* child_prefix = malloc(prefix_length + named->name_length + 2);
+                if (child_prefix) {
+                    memcpy(child_prefix, prefix, prefix_length);
+                    memcpy(child_prefix + prefix_length, named->name, named->name_length);
+                    child_prefix[prefix_length + named->name_length] = '/';
+                    child_prefix[prefix_length + named->name_length + 1] = '\0';
+                    diff_trees(repo, removed ? removed->sha : NULL, added ? added->sha : NULL, child_prefix, changes);
+                    free(child_prefix);
+                }
+            } else {
+                add_tree_change(changes, prefix, removed, added);
+            }
+        }
+
+        if (removed) has_old = next_git_tree_entry(&old_tree, &old_offset, &old_entry);
+        if (added) has_new = next_git_tree_entry(&new_tree, &new_offset, &new_entry);
+    }
+
+    free_git_object(&old_tree);
+    free_git_object(&new_tree);
+}
+
+// Pure renames (same blob deleted at one path and added at another) carry no patch
+// with git's default rename detection, so drop both sides
+static void drop_exact_renames(TreeChangeList* changes) {
+    for (int i = 0; i < changes->count; i++) {
+        TreeChange* deleted = &changes->items[i];
+        if (!deleted->old_mode || deleted->new_mode) continue;
+
+        for (int j = 0; j < changes->count; j++) {
+            TreeChange* added = &changes->items[j];
+            if (added->old_mode || !added->new_mode || !added->path) continue;
+            if (memcmp(deleted->old_sha, added->new_sha, GIT_SHA1_RAWSZ) != 0) continue;
+
+            free(deleted->path);
+            free(added->path);
+            deleted->path = NULL;
+            added->path = NULL;
+            deleted->old_mode = 0; // Mark as consumed
+            break;
+        }
+    }
+}
+
+static int read_blob(GitRepository* repo, const unsigned char* sha, unsigned int mode, GitObject* blob) {
+    blob->type = GIT_OBJECT_NONE;
+    blob->data = NULL;
+    blob->size = 0;
+    if (!mode) return 1; // Missing side of an add/delete is an empty file
+
+    // Submodules are shown by git as a one-line "Subproject commit <id>" file
+    if ((mode & GIT_MODE_TYPE_MASK) == GIT_MODE_GITLINK) {
+        char hex[GIT_SHA1_HEXSZ + 1];
+        git_sha_to_hex(sha, hex);
+        blob->data = malloc(64);
+        if (!blob->data) return 0;
+        blob->size = (size_t)snprintf((char*)blob->data, 64, "Subproject commit %s\n", hex);
+        blob->type = GIT_OBJECT_BLOB;
+        return 1;
+    }
+
+    if (!read_git_object(repo->odb, sha, blob)) return 0;
+    if (blob->type != GIT_OBJECT_BLOB) {
+        free_git_object(blob);
+        return 0;
+    }
+    return 1;
+}
+
+static Modification* create_modification_for_change(GitRepository* repo, const TreeChange* change) {
+    GitObject old_blob, new_blob;
+    if (!read_blob(repo, change->old_sha, change->old_mode, &old_blob) ||
+        !read_blob(repo, change->new_sha, change->new_mode, &new_blob)) {
+        free_git_object(&old_blob);
+        return NULL;
+    }
+
+    Modification* mod = NULL;
+    // Binary files get no hunks from git, hence no modification
+    if (!is_binary_blob((char*)old_blob.data, old_blob.size) && !is_binary_blob((char*)new_blob.data, new_blob.size)) {
+        BlobDiff diff;
+        if (diff_blobs((char*)old_blob.data, old_blob.size, (char*)new_blob.data, new_blob.size, &diff)) {
+            char* path = diff.changed ? malloc(strlen(change->path) + 1) : NULL;
+            if (path) {
+                // The joined hunk buffers move into the modification as they are
+                strcpy(path, change->path);
+                mod = adopt_modification(path, diff.removed_lines, diff.added_lines, diff.start_line);
+                diff.removed_lines = NULL;
+                diff.added_lines = NULL;
+            }
+            free_blob_diff(&diff);
+        }
+    }
+
+    free_git_object(&old_blob);
+    free_git_object(&new_blob);
+    return mod;
+}
+
+// Equivalent of the patch `git log -p` prints for a commit
+static List* diff_commit(GitRepository* repo, const GitCommitInfo* info) {
+    List* modifications = initialize_list();
+    if (!modifications) return NULL;
+
+    // Merges get no plain patch from git log -p / git show
+    if (info->parent_count > 1) return modifications;
+
+    TreeChangeList changes = { NULL, 0, 0 };
+    if (info->parent_count == 1) {
+        GitCommitInfo parent;
+        if (!load_commit(repo, info->parents[0], &parent)) return modifications;
+        diff_trees(repo, parent.tree, info->tree, "", &changes);
+        free_git_commit_info(&parent);
+    } else {
+        diff_trees(repo, NULL, info->tree, "", &changes);
+    }
+
+    drop_exact_renames(&changes);
+
+    for (int i = 0; i < changes.count; i++) {
+        if (changes.items[i].path) {
+            Modification* mod = create_modification_for_change(repo, &changes.items[i]);
+            if (mod) insert_item(modifications, mod);
+        }
+        free(changes.items[i].path);
+    }
+    free(changes.items);
+
+    return modifications;
+}
+
+/* ---------- Public API ---------- */
+
+static PendingCommit* load_pending_commit(GitRepository* repo, const unsigned char* sha, unsigned long sequence) {
+    PendingCommit* pending = malloc(sizeof(PendingCommit));
+    if (!pending) return NULL;
+    if (!load_commit(repo, sha, &pending->info)) {
+        free(pending);
+        return NULL;
+    }
+    memcpy(pending->sha, sha, GIT_SHA1_RAWSZ);
+    pending->sequence = sequence;
+    return pending;
+}
+
+// Called for each commit the walk emits, newest first; return 0 to stop the walk
+typedef int (*commit_walk_visitor)(GitRepository* repo, const unsigned char* sha, GitCommitInfo* info, void* context);
+
+// Mark an already walked commit and its walked ancestors as uninteresting. Only
+// needed when clock skew let an ancestor be popped before the excluded side reached it.
+static void mark_ancestors_uninteresting(GitRepository* repo, ShaSet* seen, const unsigned char* sha) {
+    typedef unsigned char ShaEntry[GIT_SHA1_RAWSZ];
+    ShaEntry* stack = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    char* flags = sha_set_flags(seen, sha);
+    if (!flags || (*flags & WALK_UNINTERESTING)) return;
+    *flags |= WALK_UNINTERESTING;
+    if (!(*flags & WALK_DONE)) return; // Still queued; its parents are marked when it is popped
+
+    stack = malloc(sizeof(ShaEntry) * 16);
+    if (!stack) return;
+    capacity = 16;
+    memcpy(stack[count++], sha, GIT_SHA1_RAWSZ);
+
+    while (count > 0) {
+        unsigned char current[GIT_SHA1_RAWSZ];
+        memcpy(current, stack[--count], GIT_SHA1_RAWSZ);
+
+        GitCommitInfo info;
+        if (!load_commit(repo, current, &info)) continue;
+        for (int i = 0; i < info.parent_count; i++) {
+            char* parent_flags = sha_set_flags(seen, info.parents[i]);
+            if (!parent_flags || (*parent_flags & WALK_UNINTERESTING)) continue;
+            *parent_flags |= WALK_UNINTERESTING;
+            if (!(*parent_flags & WALK_DONE)) continue;
+
+            if (count == capacity) {
+                ShaEntry* temp = realloc(stack, sizeof(ShaEntry) * capacity * 2);
+                if (!temp) continue;
+                stack = temp;
+                capacity *= 2;
+            }
+            memcpy(stack[count++], info.parents[i], GIT_SHA1_RAWSZ);
+        }
+        free_git_commit_info(&info);
+    }
+    free(stack);
+}
+
+// True when only uninteresting commits are left, i.e. nothing more can be emitted
+static int everybody_uninteresting(const CommitQueue* queue, const ShaSet* seen) {
+    for (int i = 0; i < queue->count; i++) {
+        char* flags = sha_set_flags(seen, queue->items[i]->sha);
+        if (flags && !(*flags & WALK_UNINTERESTING)) return 0;
+    }
+    return 1;
+}
+
+static int queue_walk_start(GitRepository* repo, CommitQueue* queue, ShaSet* seen, const unsigned char* sha,
+                            int uninteresting, unsigned long* sequence) {
+    if (!sha_set_insert(seen, sha)) return 1; // Same commit on both sides
+    if (uninteresting) *sha_set_flags(seen, sha) |= WALK_UNINTERESTING;
+
+    PendingCommit* start = load_pending_commit(repo, sha, (*sequence)++);
+    if (!start) return 0;
+    if (!queue_push(queue, start)) {
+        free_git_commit_info(&start->info);
+        free(start);
+        return 0;
+    }
+    return 1;
+}
+
+// Walk commits reachable from `include` but not from `exclude` (NULL for none) in
+// `git log` order. Returns 0 if a start commit could not be read.
+static int walk_commits(GitRepository* repo, const unsigned char* include, const unsigned char* exclude,
+                        commit_walk_visitor visit, void* context) {
+    CommitQueue queue = { NULL, 0, 0 };
+    ShaSet seen = { NULL, NULL, 0, 0 };
+    unsigned long sequence = 0;
+
+    // With an exclude, a commit popped early (equal or skewed dates) can still turn out to be
+    // reachable from the excluded side, so like git's limit_list the range is walked in full
+    // first and emitted afterwards
+    PendingCommit** limited = NULL;
+    int limited_count = 0;
+    int limited_capacity = 0;
+    int keep_going = 1;
+
+    int ok = queue_walk_start(repo, &queue, &seen, include, 0, &sequence);
+    if (ok && exclude) {
+        if (memcmp(include, exclude, GIT_SHA1_RAWSZ) == 0) {
+            *sha_set_flags(&seen, include) |= WALK_UNINTERESTING;
+        } else {
+            ok = queue_walk_start(repo, &queue, &seen, exclude, 1, &sequence);
+        }
+    }
+
+    while (ok && queue.count > 0 && !(exclude && everybody_uninteresting(&queue, &seen))) {
+        PendingCommit* pending = queue_pop(&queue);
+        GitCommitInfo* info = &pending->info;
+        char* flags = sha_set_flags(&seen, pending->sha);
+        *flags |= WALK_DONE;
+        int uninteresting = (*flags & WALK_UNINTERESTING) != 0;
+
+        // Queue parents; missing ones (shallow clones) simply end the walk there
+        for (int i = 0; i < info->parent_count; i++) {
+            if (!sha_set_insert(&seen, info->parents[i])) {
+                if (uninteresting) mark_ancestors_uninteresting(repo, &seen, info->parents[i]);
+                continue;
+            }
+            if (uninteresting) *sha_set_flags(&seen, info->parents[i]) |= WALK_UNINTERESTING;
+            PendingCommit* parent = load_pending_commit(repo, info->parents[i], sequence++);
+            if (parent && !queue_push(&queue, parent)) {
+                free_git_commit_info(&parent->info);
+                free(parent);
+            }
+        }
+
+        if (exclude && !uninteresting) {
+            if (limited_count == limited_capacity) {
+                int capacity = limited_capacity ? limited_capacity * 2 : 64;
+                PendingCommit** temp = realloc(limited, capacity * sizeof(PendingCommit*));
+                if (temp) {
+                    limited = temp;
+                    limited_capacity = capacity;
+                }
+            }
+            if (limited_count < limited_capacity) {
+                limited[limited_count++] = pending;
+                continue;
+            }
+            ok = 0; // Out of memory
+        } else if (!uninteresting) {
+            keep_going = visit(repo, pending->sha, info, context);
+        }
+        free_git_commit_info(info);
+        free(pending);
+        if (!keep_going) break;
+    }
+
+    for (int i = 0; i < limited_count; i++) {
+        PendingCommit* pending = limited[i];
+        char* flags = sha_set_flags(&seen, pending->sha);
+        if (ok && keep_going && !(*flags & WALK_UNINTERESTING)) {
+            keep_going = visit(repo, pending->sha, &pending->info, context);
+        }
+        free_git_commit_info(&pending->info);
+        free(pending);
+    }
+    free(limited);
+
+    while (queue.count > 0) {
+        PendingCommit* pending = queue_pop(&queue);
+        free_git_commit_info(&pending->info);
+        free(pending);
+    }
+    free(queue.items);
+    free(seen.slots);
+    free(seen.used);
+    return ok;
+}
+
+// Builds Commit objects (with their diffs) for read_native_commit_range()
+typedef struct {
+    List* commits;
+    int max_commits;
+    int next_id;
+} CommitCollector;
+
+static int collect_commit(GitRepository* repo, const unsigned char* sha, GitCommitInfo* info, void* context) {
+    CommitCollector* collector = (CommitCollector*)context;
+    int commit_id = collector->next_id;
+
+    Author* author = initialize_author(commit_id, info->author_name);
+    List* modifications = diff_commit(repo, info);
+    Commit* commit = author ? initialize_commit(commit_id, author, modifications, info->subject, info->author_time) : NULL;
+    if (commit) {
+        char hex[GIT_SHA1_HEXSZ + 1];
+        git_sha_to_hex(sha, hex);
+        set_commit_hash(commit, hex);
+        insert_item(collector->commits, commit);
+        collector->next_id++;
+    } else {
+        free_author(author);
+    }
+
+    return collector->max_commits <= 0 || collector->next_id <= collector->max_commits;
+}
+
+// Collects hex ids for read_native_commit_hashes()
+typedef struct {
+    List* hashes;
+    int max_commits;
+} HashCollector;
+
+static int collect_hash(GitRepository* repo, const unsigned char* sha, GitCommitInfo* info, void* context) {
+    (void)repo;
+    (void)info;
+    HashCollector* collector = (HashCollector*)context;
+    char* hex = malloc(GIT_SHA1_HEXSZ + 1);
+    if (hex) {
+        git_sha_to_hex(sha, hex);
+        insert_item(collector->hashes, hex);
+    }
+    return collector->max_commits <= 0 || get_number_of_items(collector->hashes) < collector->max_commits;
+}
+
+// Resolve a full hex commit id or "HEAD" (also used when hash is NULL)
+static int resolve_commit_argument(GitRepository* repo, const char* hash, unsigned char* sha) {
+    if (!hash || strcmp(hash, "HEAD") == 0) return resolve_reference(repo, "HEAD", sha);
+    return strlen(hash) >= GIT_SHA1_HEXSZ && git_sha_from_hex(hash, sha);
+}
+
+List* read_native_commits(GitRepository* repo, int max_commits) {
+    List* commit_list = read_native_commit_range(repo, NULL, max_commits);
+    if (commit_list && get_number_of_items(commit_list) == 0) {
+        free_list(commit_list);
+        return NULL;
+    }
+    return commit_list;
+}
+
+List* read_native_commit_range(GitRepository* repo, const char* exclude_hash, int max_commits) {
+    if (!repo) return NULL;
+
+    unsigned char head[GIT_SHA1_RAWSZ];
+    unsigned char exclude[GIT_SHA1_RAWSZ];
+    if (!resolve_commit_argument(repo, NULL, head)) return NULL;
+    if (exclude_hash && !resolve_commit_argument(repo, exclude_hash, exclude)) return NULL;
+
+    CommitCollector collector = { initialize_list(), max_commits, 1 };
+    if (!collector.commits) return NULL;
+    if (!walk_commits(repo, head, exclude_hash ? exclude : NULL, collect_commit, &collector)) {
+        free_commit_list(collector.commits);
+        return NULL;
+    }
+    return collector.commits;
+}
+
+List* read_native_commit(GitRepository* repo, const char* commit_hash) {
+    if (!repo || !commit_hash) return NULL;
+
+    unsigned char sha[GIT_SHA1_RAWSZ];
+    if (!resolve_commit_argument(repo, commit_hash, sha)) return NULL;
+
+    // The walk stops once the collector has its one commit
+    CommitCollector collector = { initialize_list(), 1, 1 };
+    if (!collector.commits) return NULL;
+    if (!walk_commits(repo, sha, NULL, collect_commit, &collector) || get_number_of_items(collector.commits) != 1) {
+        free_commit_list(collector.commits);
+        return NULL;
+    }
+    return collector.commits;
+}
+
+List* read_native_commit_hashes(GitRepository* repo, const char* include_hash, const char* exclude_hash, int max_commits) {
+    if (!repo) return NULL;
+
+    unsigned char include[GIT_SHA1_RAWSZ];
+    unsigned char exclude[GIT_SHA1_RAWSZ];
+    if (!resolve_commit_argument(repo, include_hash, include)) return NULL;
+    if (exclude_hash && !resolve_commit_argument(repo, exclude_hash, exclude)) return NULL;
+
+    HashCollector collector = { initialize_list(), max_commits };
+    if (!collector.hashes) return NULL;
+    if (!walk_commits(repo, include, exclude_hash ? exclude : NULL, collect_hash, &collector)) {
+        for (Node* node = get_first_node(collector.hashes); node; node = get_next_node(node)) {
+            free(get_node_data(node));
+        }
+        free_list(collector.hashes);
+        return NULL;
+    }
+    return collector.hashes;
+}
+
+List* read_native_commit_diff(GitRepository* repo, const char* commit_hash) {
+    unsigned char sha[GIT_SHA1_RAWSZ];
+    if (!repo || !commit_hash || strlen(commit_hash) < GIT_SHA1_HEXSZ || !git_sha_from_hex(commit_hash, sha)) {
+        return NULL;
+    }
+
+    GitCommitInfo info;
+    if (!load_commit(repo, sha, &info)) return NULL;
+
+    List* modifications = diff_commit(repo, &info);
+    free_git_commit_info(&info);
+    return modifications;
+}
@@ -0,0 +1,72 @@
+#ifndef GIT_NATIVE_H
+#define GIT_NATIVE_H
+
+#include "list.h"
+#include "commit.h"
+#include <stddef.h>
+
+typedef struct GitRepository GitRepository;
+
+/**
+ * Locate and open the repository containing the current directory
+ * by reading .git directly (no git subprocess)
+ * @return Repository handle, or NULL if no repository was found
+ */
+GitRepository* open_git_repository();
+
+/**
+ * Get commits reachable from HEAD, newest first (same order as `git log`)
+ * @param repo Repository opened with open_git_repository()
+ * @param max_commits Maximum number of commits to retrieve (0 for all)
+ * @return List of Commit* objects, or NULL on error
+ */
+List* read_native_commits(GitRepository* repo, int max_commits);
+
+/**
+ * Get commits reachable from HEAD but not from exclude_hash (`exclude..HEAD`), newest first
+ * @param repo Repository opened with open_git_repository()
+ * @param exclude_hash Full 40-character commit hash, or NULL to walk all of HEAD
+ * @param max_commits Maximum number of commits to retrieve (0 for all)
+ * @return List of Commit* objects (empty if there are none), or NULL if a commit could not be read
+ */
+List* read_native_commit_range(GitRepository* repo, const char* exclude_hash, int max_commits);
+
+/**
+ * Get one commit (with its diff) on its own, without walking its ancestors
+ * @param repo Repository opened with open_git_repository()
+ * @param commit_hash Full 40-character commit hash
+ * @return List holding the Commit*, or NULL if the commit could not be read
+ */
+List* read_native_commit(GitRepository* repo, const char* commit_hash);
+
+/**
+ * Get hashes of commits reachable from include_hash but not from exclude_hash, in `git log` order,
+ * without reading any trees or blobs
+ * @param repo Repository opened with open_git_repository()
+ * @param include_hash Full 40-character commit hash or "HEAD" (NULL also means HEAD)
+ * @param exclude_hash Full 40-character commit hash, "HEAD", or NULL to exclude nothing
+ * @param max_commits Maximum number of hashes to return (0 for all)
+ * @return List of malloc'd hex strings, or NULL if a commit is not in the repository
+ */
+List* read_native_commit_hashes(GitRepository* repo, const char* include_hash, const char* exclude_hash, int max_commits);
+
+/**
+ * Diff a commit against its first parent using the built-in blob diff
+ * @param repo Repository opened with open_git_repository()
+ * @param commit_hash Full 40-character commit hash
+ * @return List of Modification* objects (empty for merges), or NULL on error
+ */
+List* read_native_commit_diff(GitRepository* repo, const char* commit_hash);
+
+/**
+ * Copy the repository's (per-worktree) git directory into buffer
+ * @return 1 on success, 0 if the path does not fit
+ */
+int get_native_git_dir(GitRepository* repo, char* buffer, size_t buffer_size);
+
+/**
+ * Release a repository handle and its mapped pack files
+ */
+void close_git_repository(GitRepository* repo);
+
+#endif
@@ -0,0 +1,932 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // opendir/readdir
+#endif
+
+#include "git_objects.h"
+#include "mapped_file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define MAX_PATH_LENGTH 1024
+#define DELTA_CACHE_SLOTS 256
+#define DELTA_CACHE_MAX_BYTES (64 * 1024 * 1024)
+#define MAX_DELTA_DEPTH 10000
+
+// Pack object type codes that only exist inside packfiles
+#define PACK_OBJECT_OFS_DELTA 6
+#define PACK_OBJECT_REF_DELTA 7
+
+/* ===================== zlib inflate (RFC 1950/1951) ===================== */
+
+#define HUFF_MAX_BITS 15
+#define HUFF_FAST_BITS 10
+#define HUFF_MAX_SYMBOLS 288
+
+typedef struct {
+    short count[HUFF_MAX_BITS + 1];    // Number of codes of each length
+    short symbol[HUFF_MAX_SYMBOLS];    // Symbols ordered by code
+    unsigned short fast[1 << HUFF_FAST_BITS]; // (length << 9) | symbol for short codes, 0 if not present
+} Huffman;
+
+typedef struct {
+    const unsigned char* src;
+    size_t src_len;
+    size_t pos;
+    uint64_t bitbuf;
+    int bitcnt;
+    unsigned char* out;
+    size_t out_len;
+    size_t out_cap;
+} InflateState;
+
+static const unsigned short length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const unsigned char length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const unsigned short distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const unsigned char distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const unsigned char code_length_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static void refill_bits(InflateState* s) {
+    while (s->bitcnt <= 56 && s->pos < s->src_len) {
+        s->bitbuf |= (uint64_t)s->src[s->pos++] << s->bitcnt;
+        s->bitcnt += 8;
+    }
+}
+
+static int get_bits(InflateState* s, int n, unsigned* value) {
+    if (s->bitcnt < n) {
+        refill_bits(s);
+        if (s->bitcnt < n) return 0;
+    }
+    *value = (unsigned)(s->bitbuf & ((1ull << n) - 1));
+    s->bitbuf >>= n;
+    s->bitcnt -= n;
+    return 1;
+}
+
+static int ensure_output(InflateState* s, size_t extra) {
+    if (s->out_len + extra <= s->out_cap) return 1;
+
+    size_t capacity = s->out_cap ? s->out_cap : 4096;
+    while (capacity < s->out_len + extra) capacity *= 2;
+
+    // One spare byte so the result can always be NUL terminated
+    unsigned char* temp = realloc(s->out, capacity + 1);
+    if (!temp) return 0;
+    s->out = temp;
+    s->out_cap = capacity;
+    return 1;
+}
+
+// Build canonical Huffman decoding tables from code lengths
+static int build_huffman(Huffman* h, const unsigned char* lengths, int n) {
+    short offsets[HUFF_MAX_BITS + 1];
+    unsigned next_code[HUFF_MAX_BITS + 1];
+
+    memset(h->count, 0, sizeof(h->count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for (int i = 0; i < n; i++) h->count[lengths[i]]++;
+    h->count[0] = 0;
+
+    // Reject over-subscribed code sets (incomplete ones are legal for single-code trees)
+    int left = 1;
+    for (int len = 1; len <= HUFF_MAX_BITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) return 0;
+    }
+
+    offsets[1] = 0;
+    for (int len = 1; len < HUFF_MAX_BITS; len++) {
+        offsets[len + 1] = offsets[len] + h->count[len];
+    }
+    for (int sym = 0; sym < n; sym++) {
+        if (lengths[sym]) h->symbol[offsets[lengths[sym]]++] = (short)sym;
+    }
+
+    // Fill the direct lookup table with every code short enough to fit in it.
+    // Deflate sends codes MSB first inside an LSB-first bit stream, so the table is indexed by reversed codes.
+    unsigned code = 0;
+    next_code[0] = 0;
+    for (int len = 1; len <= HUFF_MAX_BITS; len++) {
+        code = (code + h->count[len - 1]) << 1;
+        next_code[len] = code;
+    }
+    for (int sym = 0; sym < n; sym++) {
+        int len = lengths[sym];
+        if (len == 0) continue;
+        unsigned value = next_code[len]++;
+        if (len > HUFF_FAST_BITS) continue;
+
+        unsigned reversed = 0;
+        for (int i = 0; i < len; i++) {
+            reversed = (reversed << 1) | ((value >> i) & 1);
+        }
+        for (unsigned index = reversed; index < (1u << HUFF_FAST_BITS); index += (1u << len)) {
+            h->fast[index] = (unsigned short)((len << 9) | sym);
+        }
+    }
+    return 1;
+}
+
+static int decode_symbol(InflateState* s, const Huffman* h) {
+    if (s->bitcnt < HUFF_MAX_BITS) refill_bits(s);
+
+    unsigned entry = h->fast[s->bitbuf & ((1u << HUFF_FAST_BITS) - 1)];
+    if (entry) {
+        int len = (int)(entry >> 9);
+        if (len > s->bitcnt) return -1;
+        s->bitbuf >>= len;
+        s->bitcnt -= len;
+        return (int)(entry & 511);
+    }
+
+    // Long code: walk the canonical code one bit at a time
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= HUFF_MAX_BITS; len++) {
+        if (s->bitcnt < 1) return -1;
+        code |= (int)(s->bitbuf & 1);
+        s->bitbuf >>= 1;
+        s->bitcnt--;
+        int count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static int inflate_stored_block(InflateState* s) {
+    // Discard the rest of the current byte, then give back whole buffered bytes
+    s->bitbuf >>= (s->bitcnt & 7);
+    s->bitcnt -= (s->bitcnt & 7);
+    s->pos -= (size_t)(s->bitcnt / 8);
+    s->bitbuf = 0;
+    s->bitcnt = 0;
+
+    if (s->pos + 4 > s->src_len) return 0;
+    unsigned len = s->src[s->pos] | (s->src[s->pos + 1] << 8);
+    unsigned nlen = s->src[s->pos + 2] | (s->src[s->pos + 3] << 8);
+    s->pos += 4;
+    if (len != (~nlen & 0xffff)) return 0;
+    if (s->pos + len > s->src_len) return 0;
+    if (!ensure_output(s, len)) return 0;
+
+    memcpy(s->out + s->out_len, s->src + s->pos, len);
+    s->out_len += len;
+    s->pos += len;
+    return 1;
+}
+
+static int inflate_codes(InflateState* s, const Huffman* lencode, const Huffman* distcode) {
+    for (;;) {
+        int sym = decode_symbol(s, lencode);
+        if (sym < 0) return 0;
+
+        if (sym < 256) {
+            if (!ensure_output(s, 1)) return 0;
+            s->out[s->out_len++] = (unsigned char)sym;
+            continue;
+        }
+        if (sym == 256) return 1;
+
+        sym -= 257;
+        if (sym >= 29) return 0;
+        unsigned extra = 0;
+        if (length_extra[sym] && !get_bits(s, length_extra[sym], &extra)) return 0;
+        size_t length = length_base[sym] + extra;
+
+        int dsym = decode_symbol(s, distcode);
+        if (dsym < 0 || dsym >= 30) return 0;
+        extra = 0;
+        if (distance_extra[dsym] && !get_bits(s, distance_extra[dsym], &extra)) return 0;
+        size_t distance = distance_base[dsym] + extra;
+        if (distance > s->out_len) return 0;
+
+        if (!ensure_output(s, length)) return 0;
+        // Byte-wise copy: source and destination may overlap
+        unsigned char* dst = s->out + s->out_len;
+        const unsigned char* src = dst - distance;
+        for (size_t i = 0; i < length; i++) dst[i] = src[i];
+        s->out_len += length;
+    }
+}
+
+static int inflate_fixed_block(InflateState* s) {
+    unsigned char lengths[HUFF_MAX_SYMBOLS];
+    Huffman lencode, distcode;
+
+    int sym = 0;
+    for (; sym < 144; sym++) lengths[sym] = 8;
+    for (; sym < 256; sym++) lengths[sym] = 9;
+    for (; sym < 280; sym++) lengths[sym] = 7;
+    for (; sym < HUFF_MAX_SYMBOLS; sym++) lengths[sym] = 8;
+    build_huffman(&lencode, lengths, HUFF_MAX_SYMBOLS);
+
+    for (sym = 0; sym < 30; sym++) lengths[sym] = 5;
+    build_huffman(&distcode, lengths, 30);
+
+    return inflate_codes(s, &lencode, &distcode);
+}
+
+static int inflate_dynamic_block(InflateState* s) {
+    unsigned char lengths[320];
+    Huffman lencode, distcode;
+    unsigned nlen, ndist, ncode;
+
+    if (!get_bits(s, 5, &nlen) || !get_bits(s, 5, &ndist) || !get_bits(s, 4, &ncode)) return 0;
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > 286 || ndist > 30) return 0;
+
+    memset(lengths, 0, 19);
+    for (unsigned i = 0; i < ncode; i++) {
+        unsigned value;
+        if (!get_bits(s, 3, &value)) return 0;
+        lengths[code_length_order[i]] = (unsigned char)value;
+    }
+    if (!build_huffman(&lencode, lengths, 19)) return 0;
+
+    unsigned index = 0;
+    while (index < nlen + ndist) {
+        int sym = decode_symbol(s, &lencode);
+        if (sym < 0) return 0;
+        if (sym < 16) {
+            lengths[index++] = (unsigned char)sym;
+            continue;
+        }
+
+        unsigned char repeat_length = 0;
+        unsigned repeat;
+        if (sym == 16) {
+            if (index == 0) return 0;
+            repeat_length = lengths[index - 1];
+            if (!get_bits(s, 2, &repeat)) return 0;
+            repeat += 3;
+        } else if (sym == 17) {
+            if (!get_bits(s, 3, &repeat)) return 0;
+            repeat += 3;
+        } else {
+            if (!get_bits(s, 7, &repeat)) return 0;
+            repeat += 11;
+        }
+        if (index + repeat > nlen + ndist) return 0;
+        while (repeat--) lengths[index++] = repeat_length;
+    }
+
+    // A block without an end-of-block code cannot terminate
+    if (lengths[256] == 0) return 0;
+
+    if (!build_huffman(&lencode, lengths, (int)nlen)) return 0;
+    if (!build_huffman(&distcode, lengths + nlen, (int)ndist)) return 0;
+
+    return inflate_codes(s, &lencode, &distcode);
+}
+
+unsigned char* zlib_inflate(const unsigned char* src, size_t src_len, size_t expected_size, size_t* out_len) {
+    if (!src || src_len < 2 || !out_len) return NULL;
+
+    // zlib header: deflate method, valid check bits, no preset dictionary
+    if ((src[0] & 0x0f) != 8 || ((src[0] << 8) | src[1]) % 31 != 0 || (src[1] & 0x20)) {
+        return NULL;
+    }
+
+    InflateState s;
+    s.src = src;
+    s.src_len = src_len;
+    s.pos = 2;
+    s.bitbuf = 0;
+    s.bitcnt = 0;
+    s.out = NULL;
+    s.out_len = 0;
+    s.out_cap = 0;
+    if (!ensure_output(&s, expected_size ? expected_size : 4096)) return NULL;
+
+    unsigned last = 0;
+    do {
+        unsigned type;
+        int ok = get_bits(&s, 1, &last) && get_bits(&s, 2, &type);
+        if (ok) {
+            if (type == 0) ok = inflate_stored_block(&s);
+            else if (type == 1) ok = inflate_fixed_block(&s);
+            else if (type == 2) ok = inflate_dynamic_block(&s);
+            else ok = 0;
+        }
+        if (!ok) {
+            free(s.out);
+            return NULL;
+        }
+    } while (!last);
+
+    s.out[s.out_len] = '\0';
+    *out_len = s.out_len;
+    return s.out;
+}
+
+/* ===================== Object database ===================== */
+
+typedef struct {
+    MappedFile* idx_file;
+    MappedFile* pack_file;
+    const unsigned char* pack;
+    size_t pack_size;
+    uint32_t object_count;
+    const unsigned char* fanout;
+    const unsigned char* sha_table;
+    const unsigned char* offset_table;
+    const unsigned char* large_offset_table;
+    size_t large_offset_count;
+} PackFile;
+
+// Recently used delta bases, keyed by their position in a pack
+typedef struct {
+    const PackFile* pack;
+    uint64_t offset;
+    GitObjectType type;
+    unsigned char* data;
+    size_t size;
+} DeltaBaseCacheEntry;
+
+struct GitObjectDatabase {
+    char objects_dir[MAX_PATH_LENGTH];
+    PackFile* packs;
+    int pack_count;
+    DeltaBaseCacheEntry cache[DELTA_CACHE_SLOTS];
+    size_t cache_bytes;
+};
+
+static uint32_t read_be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint64_t read_be64(const unsigned char* p) {
+    return ((uint64_t)read_be32(p) << 32) | read_be32(p + 4);
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int git_sha_from_hex(const char* hex, unsigned char* sha) {
+    if (!hex || !sha) return 0;
+    for (int i = 0; i < GIT_SHA1_RAWSZ; i++) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hi >= 0 ? hex_value(hex[2 * i + 1]) : -1;
+        if (hi < 0 || lo < 0) return 0;
+        sha[i] = (unsigned char)((hi << 4) | lo);
+    }
+    return 1;
+}
+
+void git_sha_to_hex(const unsigned char* sha, char* hex) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < GIT_SHA1_RAWSZ; i++) {
+        hex[2 * i] = digits[sha[i] >> 4];
+        hex[2 * i + 1] = digits[sha[i] & 0x0f];
+    }
+    hex[GIT_SHA1_HEXSZ] = '\0';
+}
+
+// Map an .idx (version 2) and its .pack; returns 0 if either is unusable
+static int open_pack(const char* idx_path, PackFile* pack) {
+    memset(pack, 0, sizeof(PackFile));
+
+    pack->idx_file = map_file_readonly(idx_path);
+    if (!pack->idx_file) return 0;
+    const unsigned char* idx = get_mapped_data(pack->idx_file);
+    size_t idx_size = get_mapped_size(pack->idx_file);
+
+    if (idx_size < 8 + 256 * 4 ||
+        memcmp(idx, "\377tOc", 4) != 0 || read_be32(idx + 4) != 2) {
+        unmap_file(pack->idx_file);
+        return 0;
+    }
+
+    pack->fanout = idx + 8;
+    pack->object_count = read_be32(pack->fanout + 255 * 4);
+    size_t n = pack->object_count;
+    size_t min_size = 8 + 256 * 4 + n * (GIT_SHA1_RAWSZ + 4 + 4) + 2 * GIT_SHA1_RAWSZ;
+    if (idx_size < min_size) {
+        unmap_file(pack->idx_file);
+        return 0;
+    }
+    pack->sha_table = pack->fanout + 256 * 4;
+    pack->offset_table = pack->sha_table + n * GIT_SHA1_RAWSZ + n * 4; // Skip the CRC32 table
+    pack->large_offset_table = pack->offset_table + n * 4;
+    pack->large_offset_count = (idx_size - min_size) / 8;
+
+    char pack_path[MAX_PATH_LENGTH];
+    size_t len = strlen(idx_path);
+    if (len < 4 || len + 2 > sizeof(pack_path)) {
+        unmap_file(pack->idx_file);
+        return 0;
+    }
+    memcpy(pack_path, idx_path, len - 4);
+    strcpy(pack_path + len - 4, ".pack");
+
+    pack->pack_file = map_file_readonly(pack_path);
+    pack->pack = get_mapped_data(pack->pack_file);
+    pack->pack_size = get_mapped_size(pack->pack_file);
+    if (!pack->pack || pack->pack_size < 12 || memcmp(pack->pack, "PACK", 4) != 0) {
+        unmap_file(pack->pack_file);
+        unmap_file(pack->idx_file);
+        return 0;
+    }
+    return 1;
+}
+
+static int find_in_pack(const PackFile* pack, const unsigned char* sha, uint64_t* offset) {
+    uint32_t lo = sha[0] ? read_be32(pack->fanout + (sha[0] - 1) * 4) : 0;
+    uint32_t hi = read_be32(pack->fanout + sha[0] * 4);
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(pack->sha_table + (size_t)mid * GIT_SHA1_RAWSZ, sha, GIT_SHA1_RAWSZ);
+        if (cmp == 0) {
+            uint32_t value = read_be32(pack->offset_table + (size_t)mid * 4);
+            if (value & 0x80000000u) {
+                size_t large_index = value & 0x7fffffffu;
+                if (large_index >= pack->large_offset_count) return 0;
+                *offset = read_be64(pack->large_offset_table + large_index * 8);
+            } else {
+                *offset = value;
+            }
+            return 1;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return 0;
+}
+
+static void add_packs_from_directory(GitObjectDatabase* odb) {
+    char pack_dir[MAX_PATH_LENGTH];
+    if (snprintf(pack_dir, sizeof(pack_dir), "%s/pack", odb->objects_dir) >= (int)sizeof(pack_dir)) return;
+
+#ifdef _WIN32
+    char pattern[MAX_PATH_LENGTH];
+    snprintf(pattern, sizeof(pattern), "%s/*.idx", pack_dir);
+    WIN32_FIND_DATAA entry;
+    HANDLE handle = FindFirstFileA(pattern, &entry);
+    if (handle == INVALID_HANDLE_VALUE) return;
+    do {
+        const char* name = entry.cFileName;
+#else
+    DIR* dir = opendir(pack_dir);
+    if (!dir) return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+#endif
+        size_t len = strlen(name);
+        char idx_path[MAX_PATH_LENGTH];
+        if (len > 4 && strcmp(name + len - 4, ".idx") == 0 &&
+            snprintf(idx_path, sizeof(idx_path), "%s/%s", pack_dir, name) < (int)sizeof(idx_path)) {
+            PackFile* temp = realloc(odb->packs, (odb->pack_count + 1) * sizeof(PackFile));
+            if (temp) {
+                odb->packs = temp;
+                if (open_pack(idx_path, &odb->packs[odb->pack_count])) {
+                    odb->pack_count++;
+                }
+            }
+        }
+#ifdef _WIN32
+    } while (FindNextFileA(handle, &entry));
+    FindClose(handle);
+#else
+    }
+    closedir(dir);
+#endif
+}
+
+GitObjectDatabase* open_object_database(const char* objects_dir) {
+    if (!objects_dir || strlen(objects_dir) >= MAX_PATH_LENGTH) return NULL;
+
+    GitObjectDatabase* odb = calloc(1, sizeof(GitObjectDatabase));
+    if (!odb) return NULL;
+    strcpy(odb->objects_dir, objects_dir);
+
+    add_packs_from_directory(odb);
+    return odb;
+}
+
+static size_t cache_slot(const PackFile* pack, uint64_t offset) {
+    uint64_t key = offset ^ ((uint64_t)(uintptr_t)pack << 16);
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 56) % DELTA_CACHE_SLOTS;
+}
+
+static int lookup_cached_base(GitObjectDatabase* odb, const PackFile* pack, uint64_t offset, GitObject* object) {
+    DeltaBaseCacheEntry* entry = &odb->cache[cache_slot(pack, offset)];
+    if (!entry->data || entry->pack != pack || entry->offset != offset) return 0;
+
+    object->data = malloc(entry->size + 1);
+    if (!object->data) return 0;
+    memcpy(object->data, entry->data, entry->size);
+    object->data[entry->size] = '\0';
+    object->size = entry->size;
+    object->type = entry->type;
+    return 1;
+}
+
+// Takes ownership of the object's data (frees it if it is not cached)
+static void cache_base(GitObjectDatabase* odb, const PackFile* pack, uint64_t offset, GitObject* object) {
+    DeltaBaseCacheEntry* entry = &odb->cache[cache_slot(pack, offset)];
+    if (entry->data) {
+        odb->cache_bytes -= entry->size;
+        free(entry->data);
+        entry->data = NULL;
+    }
+    if (odb->cache_bytes + object->size > DELTA_CACHE_MAX_BYTES) {
+        free(object->data);
+        object->data = NULL;
+        return;
+    }
+    entry->pack = pack;
+    entry->offset = offset;
+    entry->type = object->type;
+    entry->data = object->data;
+    entry->size = object->size;
+    odb->cache_bytes += object->size;
+    object->data = NULL;
+}
+
+static size_t read_delta_varint(const unsigned char* delta, size_t delta_size, size_t* pos) {
+    size_t value = 0;
+    int shift = 0;
+    while (*pos < delta_size) {
+        unsigned char c = delta[(*pos)++];
+        value |= (size_t)(c & 0x7f) << shift;
+        shift += 7;
+        if (!(c & 0x80)) break;
+    }
+    return value;
+}
+
+static unsigned char* apply_delta(const unsigned char* base, size_t base_size,
+                                  const unsigned char* delta, size_t delta_size, size_t* result_size) {
+    size_t pos = 0;
+    size_t source_size = read_delta_varint(delta, delta_size, &pos);
+    size_t target_size = read_delta_varint(delta, delta_size, &pos);
+    if (source_size != base_size) return NULL;
+
+    unsigned char* result = malloc(target_size + 1);
+    if (!result) return NULL;
+    size_t out = 0;
+
+    while (pos < delta_size) {
+        unsigned char op = delta[pos++];
+        if (op & 0x80) {
+            // Copy a range of the base object
+            size_t copy_offset = 0, copy_size = 0;
+            for (int i = 0; i < 4; i++) {
+                if (op & (1 << i)) {
+                    if (pos >= delta_size) goto corrupt;
+                    copy_offset |= (size_t)delta[pos++] << (8 * i);
+                }
+            }
+            for (int i = 0; i < 3; i++) {
+                if (op & (0x10 << i)) {
+                    if (pos >= delta_size) goto corrupt;
+                    copy_size |= (size_t)delta[pos++] << (8 * i);
+                }
+            }
+            if (copy_size == 0) copy_size = 0x10000;
+            if (copy_offset + copy_size > base_size || out + copy_size > target_size) goto corrupt;
+            memcpy(result + out, base + copy_offset, copy_size);
+            out += copy_size;
+        } else if (op) {
+            // Insert literal bytes carried by the delta
+            if (pos + op > delta_size || out + op > target_size) goto corrupt;
+            memcpy(result + out, delta + pos, op);
+            out += op;
+            pos += op;
+        } else {
+            goto corrupt; // Opcode 0 is reserved
+        }
+    }
+    if (out != target_size) goto corrupt;
+
+    result[out] = '\0';
+    *result_size = out;
+    return result;
+
+corrupt:
+    free(result);
+    return NULL;
+}
+
+static int unpack_pack_entry(GitObjectDatabase* odb, const PackFile* pack, uint64_t offset, GitObject* object, int depth) {
+    if (depth > MAX_DELTA_DEPTH || offset >= pack->pack_size) return 0;
+    if (lookup_cached_base(odb, pack, offset, object)) return 1;
+
+    // Entry header: type in bits 4-6 of the first byte, size as a little-endian varint
+    size_t pos = (size_t)offset;
+    unsigned char c = pack->pack[pos++];
+    int type = (c >> 4) & 7;
+    size_t size = c & 15;
+    int shift = 4;
+    while (c & 0x80) {
+        if (pos >= pack->pack_size) return 0;
+        c = pack->pack[pos++];
+        size |= (size_t)(c & 0x7f) << shift;
+        shift += 7;
+    }
+
+    GitObject base;
+    base.data = NULL;
+    uint64_t base_offset = 0;
+    const PackFile* base_pack = pack;
+    int have_base = 0;
+
+    if (type == PACK_OBJECT_OFS_DELTA) {
+        // Base position is a negative offset with an "add one per continuation byte" varint
+        if (pos >= pack->pack_size) return 0;
+        c = pack->pack[pos++];
+        uint64_t distance = c & 0x7f;
+        while (c & 0x80) {
+            if (pos >= pack->pack_size) return 0;
+            c = pack->pack[pos++];
+            distance = ((distance + 1) << 7) | (c & 0x7f);
+        }
+        if (distance == 0 || distance > offset) return 0;
+        base_offset = offset - distance;
+        have_base = unpack_pack_entry(odb, pack, base_offset, &base, depth + 1);
+        if (!have_base) return 0;
+    } else if (type == PACK_OBJECT_REF_DELTA) {
+        if (pos + GIT_SHA1_RAWSZ > pack->pack_size) return 0;
+        const unsigned char* base_sha = pack->pack + pos;
+        pos += GIT_SHA1_RAWSZ;
+        if (find_in_pack(pack, base_sha, &base_offset)) {
+            have_base = unpack_pack_entry(odb, pack, base_offset, &base, depth + 1);
+        } else {
+            // Thin-pack style reference to an object stored elsewhere; not cached
+            base_pack = NULL;
+            have_base = read_git_object(odb, base_sha, &base);
+        }
+        if (!have_base) return 0;
+    } else if (type < GIT_OBJECT_COMMIT || type > GIT_OBJECT_TAG) {
+        return 0;
+    }
+
+    size_t inflated_size = 0;
+    unsigned char* inflated = zlib_inflate(pack->pack + pos, pack->pack_size - pos, size, &inflated_size);
+    if (!inflated || inflated_size != size) {
+        free(inflated);
+        free(base.data);
+        return 0;
+    }
+
+    if (!have_base) {
+        object->type = (GitObjectType)type;
+        object->data = inflated;
+        object->size = inflated_size;
+        return 1;
+    }
+
+    object->data = apply_delta(base.data, base.size, inflated, inflated_size, &object->size);
+    object->type = base.type;
+    free(inflated);
+
+    // Keep the base around: sibling deltas usually share it
+    if (base_pack) cache_base(odb, base_pack, base_offset, &base);
+    else free(base.data);
+
+    return object->data != NULL;
+}
+
+static int read_loose_object(GitObjectDatabase* odb, const unsigned char* sha, GitObject* object) {
+    char hex[GIT_SHA1_HEXSZ + 1];
+    char path[MAX_PATH_LENGTH];
+    git_sha_to_hex(sha, hex);
+    if (snprintf(path, sizeof(path), "%s/%.2s/%s", odb->objects_dir, hex, hex + 2) >= (int)sizeof(path)) return 0;
+
+    MappedFile* file = map_file_readonly(path);
+    if (!file) return 0;
+
+    size_t raw_size = 0;
+    unsigned char* raw = zlib_inflate(get_mapped_data(file), get_mapped_size(file), 0, &raw_size);
+    unmap_file(file);
+    if (!raw) return 0;
+
+    // Header: "<type> <size>\0"
+    unsigned char* nul = memchr(raw, '\0', raw_size);
+    if (!nul) {
+        free(raw);
+        return 0;
+    }
+
+    if (strncmp((char*)raw, "commit ", 7) == 0) object->type = GIT_OBJECT_COMMIT;
+    else if (strncmp((char*)raw, "tree ", 5) == 0) object->type = GIT_OBJECT_TREE;
+    else if (strncmp((char*)raw, "blob ", 5) == 0) object->type = GIT_OBJECT_BLOB;
+    else if (strncmp((char*)raw, "tag ", 4) == 0) object->type = GIT_OBJECT_TAG;
+    else {
+        free(raw);
+        return 0;
+    }
+
+    size_t header_size = (size_t)(nul - raw) + 1;
+    object->size = raw_size - header_size;
+    memmove(raw, raw + header_size, object->size + 1); // Includes the terminating NUL
+    object->data = raw;
+    return 1;
+}
+
+int read_git_object(GitObjectDatabase* odb, const unsigned char* sha, GitObject* object) {
+    if (!odb || !sha || !object) return 0;
+
+    object->type = GIT_OBJECT_NONE;
+    object->data = NULL;
+    object->size = 0;
+
+    for (int i = 0; i < odb->pack_count; i++) {
+        uint64_t offset;
+        if (find_in_pack(&odb->packs[i], sha, &offset)) {
+            if (unpack_pack_entry(odb, &odb->packs[i], offset, object, 0)) return 1;
+        }
+    }
+
+    return read_loose_object(odb, sha, object);
+}
+
+void free_git_object(GitObject* object) {
+    if (!object) return;
+    free(object->data);
+    object->data = NULL;
+    object->size = 0;
+}
+
+void free_object_database(GitObjectDatabase* odb) {
+    if (!odb) return;
+
+    for (int i = 0; i < DELTA_CACHE_SLOTS; i++) {
+        free(odb->cache[i].data);
+    }
+    for (int i = 0; i < odb->pack_count; i++) {
+        unmap_file(odb->packs[i].pack_file);
+        unmap_file(odb->packs[i].idx_file);
+    }
+    free(odb->packs);
+    free(odb);
+}
+
+/* ===================== Object parsing ===================== */
+
+static char* copy_range(const char* start, size_t length) {
+    char* copy = malloc(length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, start, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// Parse "Name <email> 1700000000 +0000" into name and timestamp
+static void parse_signature(const char* start, const char* end, char** name, long long* timestamp) {
+    const char* email_start = memchr(start, '<', (size_t)(end - start));
+    const char* name_end = email_start ? email_start : end;
+    while (name_end > start && name_end[-1] == ' ') name_end--;
+    if (name) {
+        free(*name);
+        *name = copy_range(start, (size_t)(name_end - start));
+    }
+
+    const char* email_end = end;
+    while (email_end > start && email_end[-1] != '>') email_end--;
+    *timestamp = email_end > start ? strtoll(email_end, NULL, 10) : 0;
+}
+
+int parse_git_commit(const GitObject* object, GitCommitInfo* info) {
+    if (!object || !info || object->type != GIT_OBJECT_COMMIT) return 0;
+
+    memset(info, 0, sizeof(GitCommitInfo));
+    const char* p = (const char*)object->data;
+    const char* end = p + object->size;
+    int have_tree = 0;
+
+    // Header lines until the first empty line
+    while (p < end && *p != '\n') {
+        const char* line_end = memchr(p, '\n', (size_t)(end - p));
+        if (!line_end) line_end = end;
+
+        if (strncmp(p, "tree ", 5) == 0 && line_end - p >= 5 + GIT_SHA1_HEXSZ) {
+            have_tree = git_sha_from_hex(p + 5, info->tree);
+        } else if (strncmp(p, "parent ", 7) == 0 && line_end - p >= 7 + GIT_SHA1_HEXSZ) {
+            unsigned char (*temp)[GIT_SHA1_RAWSZ] = realloc(info->parents, (info->parent_count + 1) * sizeof(*info->parents));
+            if (temp) {
+                info->parents = temp;
+                if (git_sha_from_hex(p + 7, info->parents[info->parent_count])) {
+                    info->parent_count++;
+                }
+            }
+        } else if (strncmp(p, "author ", 7) == 0) {
+            parse_signature(p + 7, line_end, &info->author_name, &info->author_time);
+        } else if (strncmp(p, "committer ", 10) == 0) {
+            parse_signature(p + 10, line_end, NULL, &info->committer_time);
+        }
+
+        p = line_end < end ? line_end + 1 : end;
+    }
+    if (p < end) p++; // Skip the blank separator line
+
+    // Subject: first paragraph, lines stripped of trailing whitespace and joined by spaces
+    size_t capacity = 128, length = 0;
+    info->subject = malloc(capacity);
+    if (info->subject) {
+        while (p < end) {
+            const char* line_end = memchr(p, '\n', (size_t)(end - p));
+            if (!line_end) line_end = end;
+            const char* content_end = line_end;
+            while (content_end > p && (content_end[-1] == ' ' || content_end[-1] == '\t' || content_end[-1] == '\r')) {
+                content_end--;
+            }
+            if (content_end == p) break;
+
+            size_t line_length = (size_t)(content_end - p);
+            if (length + line_length + 2 > capacity) {
+                while (length + line_length + 2 > capacity) capacity *= 2;
+                char* temp = realloc(info->subject, capacity);
+                if (!temp) break;
+                info->subject = temp;
+            }
+            if (length > 0) info->subject[length++] = ' ';
+            memcpy(info->subject + length, p, line_length);
+            length += line_length;
+
+            p = line_end < end ? line_end + 1 : end;
+        }
+        info->subject[length] = '\0';
+    }
+
+    if (!have_tree || !info->author_name || !info->subject) {
+        free_git_commit_info(info);
+        return 0;
+    }
+    return 1;
+}
+
+void free_git_commit_info(GitCommitInfo* info) {
+    if (!info) return;
+    free(info->parents);
+    free(info->author_name);
+    free(info->subject);
+    info->parents = NULL;
+    info->author_name = NULL;
+    info->subject = NULL;
+    info->parent_count = 0;
+}
+
+int next_git_tree_entry(const GitObject* object, size_t* offset, GitTreeEntry* entry) {
+    if (!object || !offset || !entry || *offset >= object->size) return 0;
+
+    // Entry: "<octal mode> <name>\0<20-byte sha>"
+    const char* p = (const char*)object->data + *offset;
+    const char* end = (const char*)object->data + object->size;
+
+    unsigned int mode = 0;
+    while (p < end && *p >= '0' && *p <= '7') {
+        mode = (mode << 3) | (unsigned int)(*p - '0');
+        p++;
+    }
+    if (p >= end || *p != ' ') return 0;
+    p++;
+
+    const char* name = p;
+    const char* nul = memchr(p, '\0', (size_t)(end - p));
+    if (!nul || end - (nul + 1) < GIT_SHA1_RAWSZ) return 0;
+
+    entry->mode = mode;
+    entry->name = name;
+    entry->name_length = (size_t)(nul - name);
+    entry->sha = (const unsigned char*)nul + 1;
+
+    *offset = (size_t)((nul + 1 + GIT_SHA1_RAWSZ) - (const char*)object->data);
+    return 1;
+}
@@ -0,0 +1,87 @@
+#ifndef GIT_OBJECTS_H
+#define GIT_OBJECTS_H
+
+#include <stddef.h>
+
+#define GIT_SHA1_RAWSZ 20
+#define GIT_SHA1_HEXSZ 40
+
+typedef struct GitObjectDatabase GitObjectDatabase;
+typedef struct GitObject GitObject;
+typedef struct GitCommitInfo GitCommitInfo;
+typedef struct GitTreeEntry GitTreeEntry;
+
+typedef enum {
+    GIT_OBJECT_NONE = 0,
+    GIT_OBJECT_COMMIT = 1,
+    GIT_OBJECT_TREE = 2,
+    GIT_OBJECT_BLOB = 3,
+    GIT_OBJECT_TAG = 4
+} GitObjectType;
+
+/**
+ * A fully inflated (and delta-resolved) object read from .git/objects
+ */
+struct GitObject {
+    GitObjectType type;
+    unsigned char* data;   // Object payload without the "type size\0" header
+    size_t size;
+};
+
+/**
+ * The fields of a commit object that history ingestion needs
+ */
+struct GitCommitInfo {
+    unsigned char tree[GIT_SHA1_RAWSZ];
+    unsigned char (*parents)[GIT_SHA1_RAWSZ];
+    int parent_count;
+    char* author_name;
+    long long author_time;     // unix epoch seconds
+    long long committer_time;  // unix epoch seconds, used for history ordering
+    char* subject;             // First paragraph of the message joined into one line (like %s)
+};
+
+/**
+ * One entry of a tree object; name points into the tree's data buffer
+ */
+struct GitTreeEntry {
+    unsigned int mode;
+    const char* name;
+    size_t name_length;
+    const unsigned char* sha;
+};
+
+// Object database access (loose objects plus pack .idx/.pack files)
+GitObjectDatabase* open_object_database(const char* objects_dir);
+int read_git_object(GitObjectDatabase* odb, const unsigned char* sha, GitObject* object);
+void free_git_object(GitObject* object);
+void free_object_database(GitObjectDatabase* odb);
+
+// Object parsing
+int parse_git_commit(const GitObject* object, GitCommitInfo* info);
+void free_git_commit_info(GitCommitInfo* info);
+
+/**
+ * Iterate over the entries of a tree object
+ * @param object Tree object
+ * @param offset In/out cursor into the tree data, start at 0
+ * @param entry Receives the next entry
+ * @return 1 if an entry was produced, 0 at the end (or on malformed data)
+ */
+int next_git_tree_entry(const GitObject* object, size_t* offset, GitTreeEntry* entry);
+
+// SHA-1 helpers
+int git_sha_from_hex(const char* hex, unsigned char* sha);
+void git_sha_to_hex(const unsigned char* sha, char* hex);
+
+/**
+ * Inflate a zlib stream
+ * @param src Compressed input
+ * @param src_len Number of input bytes available
+ * @param expected_size Output size if known in advance (0 if unknown)
+ * @param out_len Receives the inflated size
+ * @return Newly allocated output buffer (NUL terminated for convenience), or NULL on error
+ */
+unsigned char* zlib_inflate(const unsigned char* src, size_t src_len, size_t expected_size, size_t* out_len);
+
+#endif
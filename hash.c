@@ -0,0 +1,22 @@
+#include "hash.h"
+
+uint32_t fnv1a_32(const char* text) {
+    uint32_t hash = FNV1A_32_INIT;
+    for (const char* p = text; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint64_t fnv1a_64(const char* text) {
+    return fnv1a_64_update(FNV1A_64_INIT, text);
+}
+
+uint64_t fnv1a_64_update(uint64_t hash, const char* text) {
+    for (const char* p = text; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
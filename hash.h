@@ -0,0 +1,26 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+
+/**
+ * FNV-1a string hashes. They are fast and stable across runs and builds, so besides
+ * hash tables they identify commits and file contents in the files GitDive writes;
+ * they are not collision-resistant.
+ */
+#define FNV1A_32_INIT 2166136261u
+#define FNV1A_64_INIT 14695981039346656037ull
+
+// 32-bit hash of a NUL-terminated string
+uint32_t fnv1a_32(const char* text);
+
+// 64-bit hash of a NUL-terminated string
+uint64_t fnv1a_64(const char* text);
+
+/**
+ * Continue a 64-bit hash with more text, so several strings can be hashed as one
+ * @param hash FNV1A_64_INIT, or the result of an earlier call
+ */
+uint64_t fnv1a_64_update(uint64_t hash, const char* text);
+
+#endif
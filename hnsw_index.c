@@ -0,0 +1,545 @@
+#include "hnsw_index.h"
+#include "similarity_kernels.h"
+#include "mapped_file.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Levels are drawn from a geometric distribution; this cap is never reached in practice
+#define HNSW_MAX_LEVEL 31
+
+/*
+ * File layout: HnswFileHeader, then the vectors (count * dimensions doubles), labels,
+ * levels, level 0 links (count * (1 + 2m) ints) and finally the upper level links of
+ * every vector with a level above 0, in id order (level * (1 + m) ints each).
+ */
+#define HNSW_MAGIC "GDHN"
+#define HNSW_VERSION 1
+#define HNSW_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[4];
+    unsigned int version;
+    unsigned int byte_order;     // HNSW_BYTE_ORDER as stored by the writer
+    unsigned int dimensions;
+    unsigned int m;
+    unsigned int ef_construction;
+    unsigned int count;
+    int entry_point;
+    int max_level;
+    unsigned long long upper_links; // ints in the upper level link section
+    unsigned long long key;
+    unsigned long long random_state;
+} HnswFileHeader;
+
+struct HnswIndex {
+    int dimensions;
+    int m;                  // Links per vector on levels above 0 (2 * m on level 0)
+    int ef_construction;
+    int ef_search;
+    double level_factor;    // 1 / ln(m)
+    unsigned long long random_state;
+
+    int count;
+    int capacity;
+    double* vectors;
+    unsigned long long* labels;
+    int* levels;
+    int* base_links;        // Per vector: link count, then up to 2 * m ids (level 0)
+    int** upper_links;      // Per vector: for levels 1..level, link count then up to m ids
+    int entry_point;        // -1 while empty
+    int max_level;
+
+    // Search scratch
+    unsigned int* visit_marks;   // visit_marks[id] == visit_epoch: seen by the current search
+    unsigned int visit_epoch;
+    SimilarityMatch* candidates; // Heap, most similar first
+    int candidate_capacity;
+    SimilarityMatch* found;      // Heap of the best ef so far, least similar first
+    int found_capacity;
+    SimilarityMatch* sorted;     // Search results, most similar first
+    int sorted_capacity;
+    SimilarityMatch* pruning;    // Links of a full list plus the new one
+};
+
+/* ---------- Storage ---------- */
+
+static int base_stride(const HnswIndex* index) {
+    return 1 + 2 * index->m;
+}
+
+static const double* vector_of(const HnswIndex* index, int id) {
+    return index->vectors + (size_t)id * index->dimensions;
+}
+
+// Link count followed by the links of id on a level
+static int* node_links(const HnswIndex* index, int id, int level) {
+    if (level == 0) return index->base_links + (size_t)id * base_stride(index);
+    return index->upper_links[id] + (size_t)(level - 1) * (1 + index->m);
+}
+
+static int grow_hnsw_index(HnswIndex* index, int capacity) {
+    double* vectors = realloc(index->vectors, (size_t)capacity * index->dimensions * sizeof(double));
+    if (vectors) index->vectors = vectors;
+    unsigned long long* labels = realloc(index->labels, (size_t)capacity * sizeof(unsigned long long));
+    if (labels) index->labels = labels;
+    int* levels = realloc(index->levels, (size_t)capacity * sizeof(int));
+    if (levels) index->levels = levels;
+    int* base_links = realloc(index->base_links, (size_t)capacity * base_stride(index) * sizeof(int));
+    if (base_links) index->base_links = base_links;
+    int** upper_links = realloc(index->upper_links, (size_t)capacity * sizeof(int*));
+    if (upper_links) index->upper_links = upper_links;
+    unsigned int* visit_marks = realloc(index->visit_marks, (size_t)capacity * sizeof(unsigned int));
+    if (visit_marks) index->visit_marks = visit_marks;
+    if (!vectors || !labels || !levels || !base_links || !upper_links || !visit_marks) return 0;
+
+    memset(index->visit_marks + index->capacity, 0, (size_t)(capacity - index->capacity) * sizeof(unsigned int));
+    index->capacity = capacity;
+    return 1;
+}
+
+// Make room for needed matches in a scratch array
+static int reserve_matches(SimilarityMatch** matches, int* capacity, int needed) {
+    if (needed <= *capacity) return 1;
+
+    int grown = *capacity > 0 ? *capacity : 64;
+    while (grown < needed) grown *= 2;
+    SimilarityMatch* resized = realloc(*matches, (size_t)grown * sizeof(SimilarityMatch));
+    if (!resized) return 0;
+    *matches = resized;
+    *capacity = grown;
+    return 1;
+}
+
+HnswIndex* create_hnsw_index(int dimensions, int m, int ef_construction) {
+    if (dimensions < 1 || m < 2 || ef_construction < 1) return NULL;
+
+    HnswIndex* index = calloc(1, sizeof(HnswIndex));
+    if (!index) return NULL;
+    index->dimensions = dimensions;
+    index->m = m;
+    index->ef_construction = ef_construction;
+    index->ef_search = HNSW_DEFAULT_EF_SEARCH;
+    index->level_factor = 1.0 / log((double)m);
+    index->random_state = 0x9E3779B97F4A7C15ull;
+    index->entry_point = -1;
+    index->pruning = malloc((size_t)(2 * m + 1) * sizeof(SimilarityMatch));
+    if (!index->pruning || !grow_hnsw_index(index, 64)) {
+        free_hnsw_index(index);
+        return NULL;
+    }
+    return index;
+}
+
+/* ---------- Heaps of matches ---------- */
+
+// 1 if a is more similar than b (ties to the lower id)
+static int match_better(const SimilarityMatch* a, const SimilarityMatch* b) {
+    return a->similarity > b->similarity || (a->similarity == b->similarity && a->index < b->index);
+}
+
+// best_first: the most similar match is on top; otherwise the least similar one
+static int heap_above(const SimilarityMatch* a, const SimilarityMatch* b, int best_first) {
+    return best_first ? match_better(a, b) : match_better(b, a);
+}
+
+static void heap_push(SimilarityMatch* heap, int* length, SimilarityMatch match, int best_first) {
+    int slot = (*length)++;
+    while (slot > 0 && heap_above(&match, &heap[(slot - 1) / 2], best_first)) {
+        heap[slot] = heap[(slot - 1) / 2];
+        slot = (slot - 1) / 2;
+    }
+    heap[slot] = match;
+}
+
+static SimilarityMatch heap_pop(SimilarityMatch* heap, int* length, int best_first) {
+    SimilarityMatch top = heap[0];
+    SimilarityMatch last = heap[--(*length)];
+    int slot = 0;
+    for (;;) {
+        int child = 2 * slot + 1;
+        if (child >= *length) break;
+        if (child + 1 < *length && heap_above(&heap[child + 1], &heap[child], best_first)) child++;
+        if (!heap_above(&heap[child], &last, best_first)) break;
+        heap[slot] = heap[child];
+        slot = child;
+    }
+    if (*length > 0) heap[slot] = last;
+    return top;
+}
+
+static int compare_matches_best_first(const void* a, const void* b) {
+    const SimilarityMatch* first = (const SimilarityMatch*)a;
+    const SimilarityMatch* second = (const SimilarityMatch*)b;
+    if (match_better(first, second)) return -1;
+    if (match_better(second, first)) return 1;
+    return 0;
+}
+
+/* ---------- Graph search ---------- */
+
+static void start_visit(HnswIndex* index) {
+    if (++index->visit_epoch == 0) {
+        memset(index->visit_marks, 0, (size_t)index->capacity * sizeof(unsigned int));
+        index->visit_epoch = 1;
+    }
+}
+
+// Follow links on a level while they lead to a more similar vector (beam of one)
+static SimilarityMatch greedy_search(const HnswIndex* index, const double* query, SimilarityMatch current, int level) {
+    int improved = 1;
+    while (improved) {
+        improved = 0;
+        const int* links = node_links(index, current.index, level);
+        for (int i = 1; i <= links[0]; i++) {
+            double similarity = similarity_dot(query, vector_of(index, links[i]), index->dimensions);
+            if (similarity > current.similarity) {
+                current.index = links[i];
+                current.similarity = similarity;
+                improved = 1;
+            }
+        }
+    }
+    return current;
+}
+
+/*
+ * Beam search on one level from the given entry points (which must not live in
+ * index->found). Leaves the best ef vectors in the index->found heap.
+ * @return Number of vectors found, or -1 on allocation failure
+ */
+static int search_level(HnswIndex* index, const double* query, const SimilarityMatch* entries, int entry_count,
+                        int ef, int level) {
+    if (!reserve_matches(&index->found, &index->found_capacity, ef + 1) ||
+        !reserve_matches(&index->candidates, &index->candidate_capacity, entry_count)) {
+        return -1;
+    }
+
+    start_visit(index);
+    int found_length = 0;
+    int candidate_length = 0;
+    for (int i = 0; i < entry_count; i++) {
+        index->visit_marks[entries[i].index] = index->visit_epoch;
+        heap_push(index->candidates, &candidate_length, entries[i], 1);
+        heap_push(index->found, &found_length, entries[i], 0);
+        if (found_length > ef) heap_pop(index->found, &found_length, 0);
+    }
+
+    while (candidate_length > 0) {
+        SimilarityMatch current = heap_pop(index->candidates, &candidate_length, 1);
+        // Every remaining candidate is less similar than the worst of a full beam
+        if (found_length >= ef && current.similarity < index->found[0].similarity) break;
+
+        const int* links = node_links(index, current.index, level);
+        for (int i = 1; i <= links[0]; i++) {
+            int neighbor = links[i];
+            if (index->visit_marks[neighbor] == index->visit_epoch) continue;
+            index->visit_marks[neighbor] = index->visit_epoch;
+
+            SimilarityMatch match = { neighbor, similarity_dot(query, vector_of(index, neighbor), index->dimensions) };
+            if (found_length < ef || match.similarity > index->found[0].similarity) {
+                if (!reserve_matches(&index->candidates, &index->candidate_capacity, candidate_length + 1)) return -1;
+                heap_push(index->candidates, &candidate_length, match, 1);
+                heap_push(index->found, &found_length, match, 0);
+                if (found_length > ef) heap_pop(index->found, &found_length, 0);
+            }
+        }
+    }
+    return found_length;
+}
+
+// Copy the found heap to index->sorted, most similar first
+static int sort_found(HnswIndex* index, int found) {
+    if (!reserve_matches(&index->sorted, &index->sorted_capacity, found > 0 ? found : 1)) return 0;
+    memcpy(index->sorted, index->found, (size_t)found * sizeof(SimilarityMatch));
+    qsort(index->sorted, found, sizeof(SimilarityMatch), compare_matches_best_first);
+    return 1;
+}
+
+/*
+ * Neighbour selection heuristic: walking the candidates from the most similar, keep
+ * one only if it is more similar to the base vector than to every kept one. Links
+ * then point in different directions instead of into a single cluster.
+ */
+static int select_neighbors(const HnswIndex* index, const SimilarityMatch* candidates, int count, int max,
+                            int* selected) {
+    int length = 0;
+    for (int i = 0; i < count && length < max; i++) {
+        const double* vector = vector_of(index, candidates[i].index);
+        int keep = 1;
+        for (int j = 0; j < length && keep; j++) {
+            if (similarity_dot(vector, vector_of(index, selected[j]), index->dimensions) > candidates[i].similarity) {
+                keep = 0;
+            }
+        }
+        if (keep) selected[length++] = candidates[i].index;
+    }
+    return length;
+}
+
+// Link id from neighbor on a level; a full list is re-selected from its links plus id
+static void add_link(HnswIndex* index, int neighbor, int level, int id, double similarity) {
+    int* links = node_links(index, neighbor, level);
+    int max = level == 0 ? 2 * index->m : index->m;
+    if (links[0] < max) {
+        links[++links[0]] = id;
+        return;
+    }
+
+    const double* base = vector_of(index, neighbor);
+    for (int i = 0; i < max; i++) {
+        index->pruning[i].index = links[i + 1];
+        index->pruning[i].similarity = similarity_dot(base, vector_of(index, links[i + 1]), index->dimensions);
+    }
+    index->pruning[max].index = id;
+    index->pruning[max].similarity = similarity;
+    qsort(index->pruning, max + 1, sizeof(SimilarityMatch), compare_matches_best_first);
+    links[0] = select_neighbors(index, index->pruning, max + 1, max, links + 1);
+}
+
+static int random_level(HnswIndex* index) {
+    // xorshift64*, mapped to (0, 1]
+    unsigned long long state = index->random_state;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    index->random_state = state;
+    double uniform = (double)((state * 0x2545F4914F6CDD1Dull) >> 11) / 9007199254740992.0;
+    int level = (int)(-log(1.0 - uniform) * index->level_factor);
+    return level < HNSW_MAX_LEVEL ? level : HNSW_MAX_LEVEL;
+}
+
+int add_hnsw_vector(HnswIndex* index, const double* vector, unsigned long long label) {
+    if (!index || !vector) return -1;
+    if (index->count == index->capacity && !grow_hnsw_index(index, index->capacity * 2)) return -1;
+
+    int level = random_level(index);
+    int* upper = NULL;
+    if (level > 0) {
+        upper = malloc((size_t)level * (1 + index->m) * sizeof(int));
+        if (!upper) return -1;
+        for (int l = 0; l < level; l++) upper[(size_t)l * (1 + index->m)] = 0;
+    }
+
+    int id = index->count++;
+    memcpy(index->vectors + (size_t)id * index->dimensions, vector, (size_t)index->dimensions * sizeof(double));
+    index->labels[id] = label;
+    index->levels[id] = level;
+    index->base_links[(size_t)id * base_stride(index)] = 0;
+    index->upper_links[id] = upper;
+    if (index->entry_point < 0) {
+        index->entry_point = id;
+        index->max_level = level;
+        return id;
+    }
+
+    const double* query = vector_of(index, id);
+    SimilarityMatch current = { index->entry_point,
+                                similarity_dot(query, vector_of(index, index->entry_point), index->dimensions) };
+    for (int l = index->max_level; l > level; l--) {
+        current = greedy_search(index, query, current, l);
+    }
+
+    // On each level from the new vector's top down, link it to neighbours selected from
+    // the beam; the beam is the entry for the level below
+    if (!reserve_matches(&index->sorted, &index->sorted_capacity, 1)) return id;
+    index->sorted[0] = current;
+    int entry_count = 1;
+    for (int l = level < index->max_level ? level : index->max_level; l >= 0; l--) {
+        int found = search_level(index, query, index->sorted, entry_count, index->ef_construction, l);
+        if (found < 0 || !sort_found(index, found)) break;
+
+        int* links = node_links(index, id, l);
+        links[0] = select_neighbors(index, index->sorted, found, index->m, links + 1);
+        for (int i = 1; i <= links[0]; i++) {
+            add_link(index, links[i], l, id, similarity_dot(query, vector_of(index, links[i]), index->dimensions));
+        }
+        entry_count = found;
+    }
+
+    if (level > index->max_level) {
+        index->max_level = level;
+        index->entry_point = id;
+    }
+    return id;
+}
+
+void set_hnsw_ef_search(HnswIndex* index, int ef_search) {
+    if (index && ef_search > 0) index->ef_search = ef_search;
+}
+
+int search_hnsw_index(HnswIndex* index, const double* query, int k, SimilarityMatch* results) {
+    if (!index || !query || !results || k < 1 || index->entry_point < 0) return 0;
+
+    SimilarityMatch current = { index->entry_point,
+                                similarity_dot(query, vector_of(index, index->entry_point), index->dimensions) };
+    for (int l = index->max_level; l > 0; l--) {
+        current = greedy_search(index, query, current, l);
+    }
+
+    int ef = index->ef_search > k ? index->ef_search : k;
+    int found = search_level(index, query, &current, 1, ef, 0);
+    if (found < 0 || !sort_found(index, found)) return 0;
+
+    int length = found < k ? found : k;
+    memcpy(results, index->sorted, (size_t)length * sizeof(SimilarityMatch));
+    return length;
+}
+
+int get_hnsw_count(const HnswIndex* index) {
+    return index ? index->count : 0;
+}
+
+unsigned long long get_hnsw_label(const HnswIndex* index, int id) {
+    return index && id >= 0 && id < index->count ? index->labels[id] : 0;
+}
+
+/* ---------- Files ---------- */
+
+int save_hnsw_index(const HnswIndex* index, const char* path, unsigned long long key) {
+    if (!index || !path) return 0;
+
+    HnswFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HNSW_MAGIC, 4);
+    header.version = HNSW_VERSION;
+    header.byte_order = HNSW_BYTE_ORDER;
+    header.dimensions = (unsigned int)index->dimensions;
+    header.m = (unsigned int)index->m;
+    header.ef_construction = (unsigned int)index->ef_construction;
+    header.count = (unsigned int)index->count;
+    header.entry_point = index->entry_point;
+    header.max_level = index->max_level;
+    for (int id = 0; id < index->count; id++) {
+        header.upper_links += (unsigned long long)index->levels[id] * (1 + index->m);
+    }
+    header.key = key;
+    header.random_state = index->random_state;
+
+    size_t path_length = strlen(path);
+    char* temp_path = malloc(path_length + 5);
+    FILE* fp = NULL;
+    if (temp_path) {
+        memcpy(temp_path, path, path_length);
+        strcpy(temp_path + path_length, ".tmp");
+        fp = fopen(temp_path, "wb");
+    }
+
+    size_t count = (size_t)index->count;
+    size_t base_links = count * base_stride(index);
+    int ok = fp != NULL &&
+             fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(index->vectors, sizeof(double), count * index->dimensions, fp) == count * index->dimensions &&
+             fwrite(index->labels, sizeof(unsigned long long), count, fp) == count &&
+             fwrite(index->levels, sizeof(int), count, fp) == count &&
+             fwrite(index->base_links, sizeof(int), base_links, fp) == base_links;
+    for (int id = 0; ok && id < index->count; id++) {
+        size_t links = (size_t)index->levels[id] * (1 + index->m);
+        if (links > 0 && fwrite(index->upper_links[id], sizeof(int), links, fp) != links) ok = 0;
+    }
+    if (fp && fclose(fp) != 0) ok = 0;
+
+    if (ok) {
+#ifdef _WIN32
+        remove(path);
+#endif
+        ok = rename(temp_path, path) == 0;
+    }
+    if (!ok && temp_path) remove(temp_path);
+    free(temp_path);
+    return ok;
+}
+
+// Copy size bytes from the file at *offset, advancing it
+static int read_section(const unsigned char* data, size_t file_size, size_t* offset, void* target, size_t size) {
+    if (size > file_size - *offset) return 0;
+    memcpy(target, data + *offset, size);
+    *offset += size;
+    return 1;
+}
+
+HnswIndex* load_hnsw_index(const char* path, unsigned long long key) {
+    if (!path) return NULL;
+
+    MappedFile* mapping = map_file_readonly(path);
+    if (!mapping) return NULL;
+    const unsigned char* data = get_mapped_data(mapping);
+    size_t file_size = get_mapped_size(mapping);
+    size_t offset = 0;
+
+    HnswFileHeader header;
+    int valid = data && read_section(data, file_size, &offset, &header, sizeof(header)) &&
+                memcmp(header.magic, HNSW_MAGIC, 4) == 0 && header.version == HNSW_VERSION &&
+                header.byte_order == HNSW_BYTE_ORDER && header.key == key && header.count <= 0x7FFFFFFF &&
+                header.max_level >= 0 && header.max_level <= HNSW_MAX_LEVEL &&
+                (header.count == 0 ? header.entry_point == -1 :
+                 header.entry_point >= 0 && (unsigned int)header.entry_point < header.count);
+    HnswIndex* index = valid ? create_hnsw_index((int)header.dimensions, (int)header.m, (int)header.ef_construction) : NULL;
+    int count = index ? (int)header.count : 0;
+    if (index && count > index->capacity && !grow_hnsw_index(index, count)) {
+        free_hnsw_index(index);
+        index = NULL;
+    }
+
+    if (index) {
+        size_t base_links = (size_t)count * base_stride(index);
+        valid = read_section(data, file_size, &offset, index->vectors, (size_t)count * index->dimensions * sizeof(double)) &&
+                read_section(data, file_size, &offset, index->labels, (size_t)count * sizeof(unsigned long long)) &&
+                read_section(data, file_size, &offset, index->levels, (size_t)count * sizeof(int)) &&
+                read_section(data, file_size, &offset, index->base_links, base_links * sizeof(int));
+
+        // Every level and link must stay inside the index
+        for (int id = 0; valid && id < count; id++) {
+            int level = index->levels[id];
+            valid = level >= 0 && level <= header.max_level;
+            if (valid && level > 0) {
+                index->upper_links[id] = malloc((size_t)level * (1 + index->m) * sizeof(int));
+                valid = index->upper_links[id] &&
+                        read_section(data, file_size, &offset, index->upper_links[id],
+                                     (size_t)level * (1 + index->m) * sizeof(int));
+                if (!valid && index->upper_links[id]) {
+                    free(index->upper_links[id]);
+                    index->upper_links[id] = NULL;
+                }
+            } else {
+                index->upper_links[id] = NULL;
+            }
+            for (int l = 0; valid && l <= level; l++) {
+                const int* links = node_links(index, id, l);
+                valid = links[0] >= 0 && links[0] <= (l == 0 ? 2 * index->m : index->m);
+                for (int i = 1; valid && i <= links[0]; i++) valid = links[i] >= 0 && links[i] < count;
+            }
+            index->count = valid ? id + 1 : id;
+        }
+        valid = valid && offset == file_size;
+
+        if (valid) {
+            index->entry_point = count > 0 ? header.entry_point : -1;
+            index->max_level = header.max_level;
+            index->random_state = header.random_state;
+        } else {
+            free_hnsw_index(index);
+            index = NULL;
+        }
+    }
+    unmap_file(mapping);
+    return index;
+}
+
+void free_hnsw_index(HnswIndex* index) {
+    if (!index) return;
+
+    for (int id = 0; id < index->count; id++) free(index->upper_links[id]);
+    free(index->vectors);
+    free(index->labels);
+    free(index->levels);
+    free(index->base_links);
+    free(index->upper_links);
+    free(index->visit_marks);
+    free(index->candidates);
+    free(index->found);
+    free(index->sorted);
+    free(index->pruning);
+    free(index);
+}
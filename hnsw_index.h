@@ -0,0 +1,65 @@
+#ifndef HNSW_INDEX_H
+#define HNSW_INDEX_H
+
+#include "fingerprint_index.h"
+
+#define HNSW_DEFAULT_M 16
+#define HNSW_DEFAULT_EF_CONSTRUCTION 200
+#define HNSW_DEFAULT_EF_SEARCH 64
+
+/**
+ * Hierarchical navigable small-world graph over unit-length vectors, for approximate
+ * nearest-neighbour search by dot-product similarity. Each vector is linked to about
+ * m others on every level it appears on (2 * m on level 0); a query descends greedily
+ * from the top level and searches level 0 with a beam of ef_search vectors.
+ * Searches use scratch space in the index, so an index must not be searched or
+ * changed from two threads at once.
+ */
+typedef struct HnswIndex HnswIndex;
+
+/**
+ * Create an empty index
+ * @param m Links per vector and level (at least 2)
+ * @param ef_construction Beam width used to find the links of a new vector
+ * @return New index, or NULL on allocation failure or invalid parameters
+ */
+HnswIndex* create_hnsw_index(int dimensions, int m, int ef_construction);
+
+/**
+ * Insert a vector (copied)
+ * @param label Caller data kept with the vector (and in saved files)
+ * @return Id of the vector (ids count up from 0), or -1 on allocation failure
+ */
+int add_hnsw_vector(HnswIndex* index, const double* vector, unsigned long long label);
+
+/**
+ * Beam width of searches (default HNSW_DEFAULT_EF_SEARCH; raised to k when smaller)
+ */
+void set_hnsw_ef_search(HnswIndex* index, int ef_search);
+
+/**
+ * Approximate k most similar vectors to query
+ * @param results Array of k matches (index = vector id), filled most similar first
+ * @return Number of matches (fewer than k only if the index is smaller)
+ */
+int search_hnsw_index(HnswIndex* index, const double* query, int k, SimilarityMatch* results);
+
+int get_hnsw_count(const HnswIndex* index);
+unsigned long long get_hnsw_label(const HnswIndex* index, int id);
+
+/**
+ * Write the index to path (through a temporary file)
+ * @param key Chosen by the caller; load_hnsw_index() only accepts the same key
+ * @return 1 on success, 0 on error
+ */
+int save_hnsw_index(const HnswIndex* index, const char* path, unsigned long long key);
+
+/**
+ * Read an index written by save_hnsw_index(); more vectors can be added to it
+ * @return The index, or NULL if the file is missing, damaged or has another key
+ */
+HnswIndex* load_hnsw_index(const char* path, unsigned long long key);
+
+void free_hnsw_index(HnswIndex* index);
+
+#endif
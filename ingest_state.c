@@ -0,0 +1,412 @@
+#include "ingest_state.h"
+#include "git_local.h"
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * State file layout (integers little-endian):
+ *   "GDST" magic, u32 version, u32 max_commits, u32 commit_count
+ *   per commit:       str hash, str author, str message, i64 timestamp, u32 modification_count
+ *   per modification: str filepath, i32 start_line, u32 lines_removed, u32 lines_added,
+ *                     u32 declares_struct
+ * where str is a u32 byte length followed by the bytes (NULL_STRING_LENGTH for NULL).
+ * Only this summary of each diff is kept, not its code: it is all analysis reads.
+ */
+#define STATE_MAGIC "GDST"
+#define STATE_VERSION 2
+#define NULL_STRING_LENGTH 0xFFFFFFFFu
+
+/* ---------- Writing ---------- */
+
+static int write_u32(FILE* fp, unsigned int value) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++) bytes[i] = (unsigned char)(value >> (8 * i));
+    return fwrite(bytes, 1, 4, fp) == 4;
+}
+
+static int write_i64(FILE* fp, long long value) {
+    unsigned long long bits = (unsigned long long)value;
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) bytes[i] = (unsigned char)(bits >> (8 * i));
+    return fwrite(bytes, 1, 8, fp) == 8;
+}
+
+static int write_string(FILE* fp, const char* text) {
+    if (!text) return write_u32(fp, NULL_STRING_LENGTH);
+    size_t length = strlen(text);
+    return write_u32(fp, (unsigned int)length) && fwrite(text, 1, length, fp) == length;
+}
+
+static int write_commit(FILE* fp, Commit* commit) {
+    List* modifications = get_commit_modifications(commit);
+    int ok = write_string(fp, get_commit_hash(commit)) &&
+             write_string(fp, get_author_name(get_commit_author(commit))) &&
+             write_string(fp, get_commit_message(commit)) &&
+             write_i64(fp, get_commit_timestamp(commit)) &&
+             write_u32(fp, modifications ? (unsigned int)get_number_of_items(modifications) : 0);
+
+    Node* node = modifications ? get_first_node(modifications) : NULL;
+    while (ok && node) {
+        Modification* mod = (Modification*)get_node_data(node);
+        ok = write_string(fp, get_modification_filepath(mod)) &&
+             write_u32(fp, (unsigned int)get_modification_start_line(mod)) &&
+             write_u32(fp, (unsigned int)get_modification_lines_removed(mod)) &&
+             write_u32(fp, (unsigned int)get_modification_lines_added(mod)) &&
+             write_u32(fp, (unsigned int)modification_declares_struct(mod));
+        node = get_next_node(node);
+    }
+    return ok;
+}
+
+int save_ingest_state(const char* path, List* commits, int max_commits) {
+    if (!path || !commits) return 0;
+
+    // Write next to the real file and rename, so an interrupted run never leaves a torn state
+    size_t path_length = strlen(path);
+    char* temp_path = malloc(path_length + 5);
+    if (!temp_path) return 0;
+    memcpy(temp_path, path, path_length);
+    strcpy(temp_path + path_length, ".tmp");
+
+    FILE* fp = fopen(temp_path, "wb");
+    if (!fp) {
+        free(temp_path);
+        return 0;
+    }
+
+    int ok = fwrite(STATE_MAGIC, 1, 4, fp) == 4 &&
+             write_u32(fp, STATE_VERSION) &&
+             write_u32(fp, (unsigned int)max_commits) &&
+             write_u32(fp, (unsigned int)get_number_of_items(commits));
+    for (Node* node = get_first_node(commits); ok && node; node = get_next_node(node)) {
+        ok = write_commit(fp, (Commit*)get_node_data(node));
+    }
+    if (fclose(fp) != 0) ok = 0;
+
+#ifdef _WIN32
+    if (ok) remove(path); // rename() does not replace existing files on Windows
+#endif
+    if (!ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        ok = 0;
+    }
+    free(temp_path);
+    return ok;
+}
+
+/* ---------- Reading ---------- */
+
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    size_t position;
+    int ok;              // Cleared on truncation or allocation failure
+} StateReader;
+
+static unsigned int read_u32(StateReader* reader) {
+    if (!reader->ok || reader->size - reader->position < 4) {
+        reader->ok = 0;
+        return 0;
+    }
+    const unsigned char* bytes = reader->data + reader->position;
+    reader->position += 4;
+    return (unsigned int)bytes[0] | ((unsigned int)bytes[1] << 8) |
+           ((unsigned int)bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+static long long read_i64(StateReader* reader) {
+    if (!reader->ok || reader->size - reader->position < 8) {
+        reader->ok = 0;
+        return 0;
+    }
+    unsigned long long bits = 0;
+    for (int i = 7; i >= 0; i--) {
+        bits = (bits << 8) | reader->data[reader->position + i];
+    }
+    reader->position += 8;
+    return (long long)bits;
+}
+
+// Returns a malloc'd copy, or NULL for a saved NULL string (or on error, with ok cleared)
+static char* read_string(StateReader* reader) {
+    unsigned int length = read_u32(reader);
+    if (!reader->ok || length == NULL_STRING_LENGTH) return NULL;
+    if (reader->size - reader->position < length) {
+        reader->ok = 0;
+        return NULL;
+    }
+
+    char* text = malloc((size_t)length + 1);
+    if (!text) {
+        reader->ok = 0;
+        return NULL;
+    }
+    memcpy(text, reader->data + reader->position, length);
+    text[length] = '\0';
+    reader->position += length;
+    return text;
+}
+
+static Commit* read_commit(StateReader* reader, int commit_id) {
+    char* hash = read_string(reader);
+    char* author_name = read_string(reader);
+    char* message = read_string(reader);
+    long long timestamp = read_i64(reader);
+    unsigned int modification_count = read_u32(reader);
+
+    List* modifications = initialize_list();
+    for (unsigned int i = 0; reader->ok && modifications && i < modification_count; i++) {
+        char* filepath = read_string(reader);
+        int start_line = (int)read_u32(reader);
+        int lines_removed = (int)read_u32(reader);
+        int lines_added = (int)read_u32(reader);
+        int declares_struct = (int)read_u32(reader);
+        if (!reader->ok) {
+            free(filepath);
+            break;
+        }
+        Modification* mod = initialize_modification_summary(filepath, start_line, lines_removed, lines_added, declares_struct);
+        free(filepath);
+        if (mod) insert_item(modifications, mod);
+    }
+
+    Commit* commit = NULL;
+    Author* author = reader->ok && modifications ? initialize_author(commit_id, author_name) : NULL;
+    if (author) {
+        commit = initialize_commit(commit_id, author, modifications, message, timestamp);
+        if (!commit || !set_commit_hash(commit, hash)) {
+            if (commit) {
+                free_commit(commit);
+            } else {
+                free_author(author);
+            }
+            commit = NULL;
+        }
+    }
+    if (!commit && modifications) {
+        for (Node* node = get_first_node(modifications); node; node = get_next_node(node)) {
+            free_modification((Modification*)get_node_data(node));
+        }
+        free_list(modifications);
+    }
+
+    free(hash);
+    free(author_name);
+    free(message);
+    if (!commit) reader->ok = 0;
+    return commit;
+}
+
+List* load_ingest_state(const char* path, int* max_commits) {
+    MappedFile* file = map_file_readonly(path);
+    if (!file) return NULL;
+
+    StateReader reader = { (const unsigned char*)get_mapped_data(file), get_mapped_size(file), 0, 1 };
+    if (!reader.data || reader.size < 4 || memcmp(reader.data, STATE_MAGIC, 4) != 0) {
+        unmap_file(file);
+        return NULL;
+    }
+    reader.position = 4;
+
+    unsigned int version = read_u32(&reader);
+    unsigned int saved_max = read_u32(&reader);
+    unsigned int commit_count = read_u32(&reader);
+    if (!reader.ok || version != STATE_VERSION) {
+        unmap_file(file);
+        return NULL;
+    }
+
+    List* commits = initialize_list();
+    for (unsigned int i = 0; commits && reader.ok && i < commit_count; i++) {
+        Commit* commit = read_commit(&reader, (int)i + 1);
+        if (commit) insert_item(commits, commit);
+    }
+    unmap_file(file);
+
+    if (!commits || !reader.ok) {
+        free_commit_list(commits);
+        return NULL;
+    }
+    if (max_commits) *max_commits = (int)saved_max;
+    return commits;
+}
+
+/* ---------- Incremental update ---------- */
+
+// Where a commit that may go into the updated window comes from
+typedef enum {
+    CANDIDATE_ADDED,     // Read from watermark..HEAD
+    CANDIDATE_SAVED,     // Reused from the state file
+    CANDIDATE_REFILLED   // Older commit read by hash to refill a window a rewrite shrank
+} CandidateSource;
+
+// A commit that may go into the updated window, looked up by hash
+typedef struct {
+    const char* hash;
+    Commit* commit;      // Set to NULL once placed
+    CandidateSource source;
+} CandidateCommit;
+
+static int compare_candidates(const void* a, const void* b) {
+    const CandidateCommit* left = (const CandidateCommit*)a;
+    const CandidateCommit* right = (const CandidateCommit*)b;
+    if (!left->hash || !right->hash) return (left->hash == NULL) - (right->hash == NULL);
+    return strcmp(left->hash, right->hash);
+}
+
+static void discard_commit(Commit* commit) {
+    List* modifications = get_commit_modifications(commit);
+    if (modifications) {
+        for (Node* node = get_first_node(modifications); node; node = get_next_node(node)) {
+            free_modification((Modification*)get_node_data(node));
+        }
+        free_list(modifications);
+    }
+    free_commit(commit);
+}
+
+static void free_hash_list(List* hashes) {
+    if (!hashes) return;
+    for (Node* node = get_first_node(hashes); node; node = get_next_node(node)) {
+        free(get_node_data(node));
+    }
+    free_list(hashes);
+}
+
+// Append a candidate for every commit in commits
+static void add_candidates(CandidateCommit* candidates, int* count, List* commits, CandidateSource source) {
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        CandidateCommit candidate = { get_commit_hash(commit), commit, source };
+        candidates[(*count)++] = candidate;
+    }
+}
+
+// Hashes in order (borrowed from it) that no candidate has
+static List* find_missing_hashes(List* order, CandidateCommit* candidates, int count) {
+    List* missing = initialize_list();
+    for (Node* node = get_first_node(order); missing && node; node = get_next_node(node)) {
+        CandidateCommit key = { (const char*)get_node_data(node), NULL, CANDIDATE_ADDED };
+        if (!bsearch(&key, candidates, count, sizeof(CandidateCommit), compare_candidates)) {
+            insert_item(missing, get_node_data(node));
+        }
+    }
+    return missing;
+}
+
+// Lay out the new window in `git log` order, taking each commit from watermark..HEAD or
+// from the state file. When a rewrite removed more saved commits than it added, older
+// commits that were never saved move into the window; only those are read, by hash.
+// Consumes `saved`; returns NULL if a commit could not be read so the caller reloads.
+static List* merge_new_commits(List* saved, int max_commits, IngestSummary* summary) {
+    const char* watermark = get_commit_hash((Commit*)get_node_data(get_first_node(saved)));
+    List* dropped = watermark ? get_git_commits_dropped_since(watermark) : NULL;
+    List* added = dropped ? get_git_commits_since(watermark, max_commits) : NULL;
+    List* order = added ? get_git_commit_hashes(max_commits) : NULL;
+
+    // Room for every commit of the window besides the added and saved ones
+    int candidate_count = added ? get_number_of_items(added) + get_number_of_items(saved) : 0;
+    if (order) candidate_count += get_number_of_items(order);
+    CandidateCommit* candidates = order ? malloc((candidate_count + 1) * sizeof(CandidateCommit)) : NULL;
+    List* merged = candidates ? initialize_list() : NULL;
+    if (!merged) {
+        free(candidates);
+        free_hash_list(order);
+        free_hash_list(dropped);
+        free_commit_list(added);
+        free_commit_list(saved);
+        return NULL;
+    }
+
+    int count = 0;
+    add_candidates(candidates, &count, added, CANDIDATE_ADDED);
+    add_candidates(candidates, &count, saved, CANDIDATE_SAVED);
+    qsort(candidates, count, sizeof(CandidateCommit), compare_candidates);
+
+    List* missing = find_missing_hashes(order, candidates, count);
+    List* refilled = missing && get_number_of_items(missing) > 0 ? get_git_commits_by_hash(missing) : NULL;
+    if (refilled) {
+        add_candidates(candidates, &count, refilled, CANDIDATE_REFILLED);
+        qsort(candidates, count, sizeof(CandidateCommit), compare_candidates);
+    }
+    free_list(missing);
+
+    // Merges can interleave new commits with saved ones, so follow rev-list order exactly
+    int complete = 1;
+    for (Node* node = get_first_node(order); node && complete; node = get_next_node(node)) {
+        CandidateCommit key = { (const char*)get_node_data(node), NULL, CANDIDATE_ADDED };
+        CandidateCommit* found = bsearch(&key, candidates, count, sizeof(CandidateCommit), compare_candidates);
+        if (!found || !found->commit) {
+            complete = 0;
+            break;
+        }
+        insert_item(merged, found->commit);
+        if (found->source == CANDIDATE_SAVED) {
+            summary->reused++;
+        } else if (found->source == CANDIDATE_REFILLED) {
+            summary->refilled++;
+        } else {
+            summary->added++;
+        }
+        found->commit = NULL;
+    }
+    summary->dropped = get_number_of_items(dropped);
+
+    // Saved commits that fell out of the window (or were rewritten away) and unused new ones
+    for (int i = 0; i < count; i++) {
+        if (candidates[i].commit) discard_commit(candidates[i].commit);
+    }
+    free(candidates);
+    free_list(added);
+    free_list(saved);
+    free_list(refilled);
+    free_hash_list(order);
+    free_hash_list(dropped);
+
+    if (!complete) {
+        free_commit_list(merged);
+        return NULL;
+    }
+
+    // Ids are positions in log order, exactly as a full ingestion assigns them
+    int commit_id = 1;
+    for (Node* node = get_first_node(merged); node; node = get_next_node(node)) {
+        set_commit_id((Commit*)get_node_data(node), commit_id++);
+    }
+    return merged;
+}
+
+List* get_git_commits_incremental(const char* state_path, int max_commits, IngestSummary* summary) {
+    IngestSummary result = { 0, 0, 0, 0, 0 };
+    int saved_max = 0;
+    List* saved = state_path ? load_ingest_state(state_path, &saved_max) : NULL;
+
+    List* commits = NULL;
+    if (saved && saved_max == max_commits && get_number_of_items(saved) > 0) {
+        commits = merge_new_commits(saved, max_commits, &result);
+    } else {
+        free_commit_list(saved);
+    }
+
+    if (!commits) {
+        // No usable state (first run, other --max-commits, unknown watermark): read everything
+        IngestSummary reload = { 0, 0, 0, 0, 1 };
+        reload.dropped = result.dropped;
+        result = reload;
+        commits = get_git_commits(max_commits);
+        if (commits) result.added = get_number_of_items(commits);
+    }
+
+    // Saved and discarded commits interned their names and paths before the commits read
+    // from git; renumber them so ids (and ties ranked by id) match a fresh ingestion
+    if (commits) renumber_commit_strings(commits);
+
+    if (commits && state_path && !save_ingest_state(state_path, commits, max_commits)) {
+        printf("Warning: Could not write ingestion state to %s\n", state_path);
+    }
+
+    if (summary) *summary = result;
+    return commits;
+}
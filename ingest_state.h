@@ -0,0 +1,50 @@
+#ifndef INGEST_STATE_H
+#define INGEST_STATE_H
+
+#include "list.h"
+#include "commit.h"
+
+// State file written inside the repository's .git directory
+#define INGEST_STATE_FILENAME "gitdive-state"
+
+/**
+ * What an incremental ingestion run did
+ */
+typedef struct {
+    int reused;       // Commits taken from the state file
+    int added;        // Commits read from watermark..HEAD
+    int dropped;      // Saved commits no longer reachable from HEAD (history was rewritten)
+    int refilled;     // Older commits read by hash because a rewrite shrank the saved window
+    int full_reload;  // 1 if history had to be read from scratch
+} IngestSummary;
+
+/**
+ * Load the commits saved by a previous run, newest first
+ * @param path State file path
+ * @param max_commits Receives the commit limit the state was saved with
+ * @return List of Commit* objects, or NULL if the file is missing, corrupt or from another version
+ */
+List* load_ingest_state(const char* path, int* max_commits);
+
+/**
+ * Save commits (newest first) with their hashes, metadata and a summary of each
+ * modification (path, start line, line counts), not its code.
+ * The first commit's hash becomes the watermark for the next run.
+ * @return 1 on success, 0 on error
+ */
+int save_ingest_state(const char* path, List* commits, int max_commits);
+
+/**
+ * Get the newest max_commits commits, reusing the state file and reading only
+ * watermark..HEAD from git. Commits dropped by a history rewrite are removed
+ * and the replacement commits read, plus any older commits the window now reaches
+ * (read by hash); commit ids and interned author and path ids are renumbered in log
+ * order, so the result matches get_git_commits(max_commits). The state file is updated afterwards.
+ * @param state_path State file path
+ * @param max_commits Maximum number of commits to keep (0 for all)
+ * @param summary Optional; receives what was reused, added and dropped
+ * @return List of Commit* objects, or NULL on error
+ */
+List* get_git_commits_incremental(const char* state_path, int max_commits, IngestSummary* summary);
+
+#endif
@@ -1,24 +1,59 @@
 #include <stdlib.h>
 #include "list.h"
 
+// Smallest node block; later blocks double with the list, so nodes inserted one after
+// the other sit next to each other in memory
+#define LIST_BLOCK_NODES 16
+
+typedef struct NodeBlock{
+    struct NodeBlock* next;
+    int capacity;
+    int used;
+    Node nodes[];
+} NodeBlock;
+
 struct List{
     Node* first;
     Node* last;
     int items_num;
+    NodeBlock* blocks;    // Newest first; nodes are only taken from the newest
+    int reserved;         // Nodes of the first block (0: LIST_BLOCK_NODES)
 };
 
 List* initialize_list() {
+    return create_list_with_capacity(0);
+}
+
+List* create_list_with_capacity(int capacity) {
     List* list = malloc(sizeof(List));
     if (list == NULL) return NULL; // Check allocation
     list->first = NULL;
     list->last = NULL;
     list->items_num = 0;
+    list->blocks = NULL;
+    list->reserved = capacity > 0 ? capacity : 0;
     return list;
 }
 
+static Node* allocate_node(List* list){
+    NodeBlock* block = list->blocks;
+    if (!block || block->used == block->capacity) {
+        int capacity = list->reserved > 0 && !block ? list->reserved : LIST_BLOCK_NODES;
+        if (block && list->items_num > capacity) capacity = list->items_num;
+        block = malloc(sizeof(NodeBlock) + (size_t)capacity * sizeof(Node));
+        if (!block) return NULL;
+        block->capacity = capacity;
+        block->used = 0;
+        block->next = list->blocks;
+        list->blocks = block;
+    }
+    return &block->nodes[block->used++];
+}
+
 void insert_item(List* list, void* data){
 
-    Node* node = malloc(sizeof(Node));
+    Node* node = allocate_node(list);
+    if (node == NULL) return;
     node->data = data;
 
     if(list->first == NULL){
@@ -117,11 +152,11 @@ void* get_node_data(Node* node) {
 void free_list(List* list) {
     if (!list) return;
     
-    Node* current = list->first;
-    while (current) {
-        Node* next = current->next;
-        free(current);
-        current = next;
+    NodeBlock* block = list->blocks;
+    while (block) {
+        NodeBlock* next = block->next;
+        free(block);
+        block = next;
     }
     
     free(list);
@@ -11,6 +11,8 @@ typedef struct List List;
 
 List* initialize_list();
 List* create_list(); // Alias for initialize_list
+// Empty list whose first capacity items get their nodes from one contiguous array
+List* create_list_with_capacity(int capacity);
 void insert_item(List* list, void* data);
 void print_list(List* list, void (*print_function)(void*));
 void* traverse_list(List* list, void* (*callback_function)(void*));
@@ -1,22 +1,176 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "list.h"
 #include "commit.h"
+#include "commit_store.h"
 #include "git_local.h"
+#include "ingest_state.h"
 #include "binary_search_tree.h"
 #include "semantic_fingerprint.h"
+#include "fingerprint_cache.h"
 #include "commit_similarity_tree.h"
+#include "similarity_kernels.h"
 
-// Callback used to insert each commit into the BST when traversing the list.
-// - item: pointer to a Commit
-// - ctx: pointer to TreeNode* (i.e., &timestamp_tree), so we can update the root as we insert
-static void* insert_commit_to_bst(void* item, void* ctx){
-    TreeNode** tree_ref = (TreeNode**)ctx;
-    *tree_ref = insert_bst(*tree_ref, item, compare_commits_by_timestamp);
-    return NULL; // return non-NULL to stop traversal early (not used here)
+// Callback counting near-duplicate commit pairs and printing the first few.
+// - ctx: pointer to the running count
+static int print_clone_pair(const SimilarityPair* pair, void* ctx){
+    int* found = (int*)ctx;
+    if (++*found <= 5) {
+        char* hash1 = get_commit_hash(pair->commit1);
+        char* hash2 = get_commit_hash(pair->commit2);
+        printf("Similarity: %.3f - %.12s %.12s\n", pair->similarity_score,
+               hash1 ? hash1 : "(no hash)", hash2 ? hash2 : "(no hash)");
+    }
+    return 0;
+}
+
+// Print the (at most) limit ids with the highest counts, highest first, with their strings.
+// - counts: one count per id of table
+static void print_top_counts(const StringTable* table, const int* counts, int limit){
+    int count = get_string_table_count(table);
+    char* shown = calloc(count > 0 ? count : 1, 1);
+    if (!shown) return;
+    for (int rank = 1; rank <= limit; rank++) {
+        int best = -1;
+        for (int id = 0; id < count; id++) {
+            if (!shown[id] && counts[id] > 0 && (best < 0 || counts[id] > counts[best])) best = id;
+        }
+        if (best < 0) break;
+        shown[best] = 1;
+        printf("%d. %d - %s\n", rank, counts[best], get_interned_string(table, best));
+    }
+    free(shown);
+}
+
+// Read history incrementally and reuse cached fingerprints through the state files in .git
+// (disabled by --no-state)
+static int use_ingest_state = 1;
+
+// Commits to analyse, newest first (--max-commits; 0 = the whole history)
+static int max_commits = 15;
+
+// Out-of-core similarity matrix (--matrix-file, --matrix-budget)
+static const char* matrix_file = NULL;
+static size_t matrix_budget = (size_t)256 << 20;
+
+static void print_usage(const char* program){
+    printf("Usage: %s [--ingest streamed|per-commit|native] [--workers N] [--no-state]\n", program);
+    printf("          [--simd auto|scalar|sse2|avx2|avx512] [--precision double|float32|int8]\n");
+    printf("          [--matrix double|float32|half] [--matrix-file PATH] [--matrix-budget MB]\n");
+    printf("          [--max-commits N] [--neighbors K] [--ann-file PATH] [--hnsw M,EFC,EFS]\n");
+    printf("  --ingest    how history is read (default: streamed)\n");
+    printf("  --workers   concurrent `git show` processes for per-commit ingestion (0 = one per CPU)\n");
+    printf("  --no-state  read all history and recompute all fingerprints instead of using\n");
+    printf("              the state and fingerprint cache files in .git\n");
+    printf("  --simd      similarity kernel (default: best supported by the CPU)\n");
+    printf("  --precision vector precision for the similarity matrix (default: double)\n");
+    printf("  --matrix    element type of the cached similarity matrix (default: float32)\n");
+    printf("  --matrix-file   keep the similarity matrix in a memory-mapped file (reused by later\n");
+    printf("                  runs over the same commits) instead of in memory\n");
+    printf("  --matrix-budget memory for matrix tiles while the file is written (default: 256)\n");
+    printf("  --max-commits   newest commits to analyse (default: 15, 0 = whole history)\n");
+    printf("  --neighbors     keep only the K most similar commits of each commit in a sparse\n");
+    printf("                  graph instead of the dense similarity matrix\n");
+    printf("  --ann-file      keep the nearest-commit index in a file (later runs only add new commits)\n");
+    printf("  --hnsw          index links per commit, construction and search beam widths\n");
+    printf("                  (default: %d,%d,%d)\n", HNSW_DEFAULT_M, HNSW_DEFAULT_EF_CONSTRUCTION,
+           HNSW_DEFAULT_EF_SEARCH);
+}
+
+// Apply command line options; returns 0 if an option is not recognized
+static int parse_options(int argc, char** argv){
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ingest") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "streamed") == 0) {
+                set_git_ingest_mode(GIT_INGEST_STREAMED);
+            } else if (strcmp(mode, "per-commit") == 0) {
+                set_git_ingest_mode(GIT_INGEST_PER_COMMIT);
+            } else if (strcmp(mode, "native") == 0) {
+                set_git_ingest_mode(GIT_INGEST_NATIVE);
+            } else {
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            set_git_diff_workers(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--no-state") == 0) {
+            use_ingest_state = 0;
+        } else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            const char* precision = argv[++i];
+            if (strcmp(precision, "double") == 0) {
+                set_similarity_precision(FINGERPRINT_PRECISION_DOUBLE);
+            } else if (strcmp(precision, "float32") == 0) {
+                set_similarity_precision(FINGERPRINT_PRECISION_FLOAT32);
+            } else if (strcmp(precision, "int8") == 0) {
+                set_similarity_precision(FINGERPRINT_PRECISION_INT8);
+            } else {
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--matrix") == 0 && i + 1 < argc) {
+            const char* storage = argv[++i];
+            if (strcmp(storage, "double") == 0) {
+                set_similarity_storage(SIMILARITY_STORAGE_DOUBLE);
+            } else if (strcmp(storage, "float32") == 0) {
+                set_similarity_storage(SIMILARITY_STORAGE_FLOAT32);
+            } else if (strcmp(storage, "half") == 0) {
+                set_similarity_storage(SIMILARITY_STORAGE_HALF);
+            } else {
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--matrix-file") == 0 && i + 1 < argc) {
+            matrix_file = argv[++i];
+        } else if (strcmp(argv[i], "--matrix-budget") == 0 && i + 1 < argc) {
+            int megabytes = atoi(argv[++i]);
+            if (megabytes <= 0) return 0;
+            matrix_budget = (size_t)megabytes << 20;
+        } else if (strcmp(argv[i], "--max-commits") == 0 && i + 1 < argc) {
+            max_commits = atoi(argv[++i]);
+            if (max_commits < 0) return 0;
+        } else if (strcmp(argv[i], "--neighbors") == 0 && i + 1 < argc) {
+            int neighbors = atoi(argv[++i]);
+            if (neighbors <= 0) return 0;
+            set_similarity_neighbors(neighbors);
+        } else if (strcmp(argv[i], "--ann-file") == 0 && i + 1 < argc) {
+            set_similarity_ann_file(argv[++i]);
+        } else if (strcmp(argv[i], "--hnsw") == 0 && i + 1 < argc) {
+            int m, ef_construction, ef_search;
+            if (sscanf(argv[++i], "%d,%d,%d", &m, &ef_construction, &ef_search) != 3 ||
+                m < 2 || ef_construction < 1 || ef_search < 1) {
+                return 0;
+            }
+            set_hnsw_parameters(m, ef_construction, ef_search);
+        } else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            static const struct { const char* name; SimilarityKernelLevel level; } kernels[] = {
+                { "auto", SIMILARITY_KERNEL_AUTO }, { "scalar", SIMILARITY_KERNEL_SCALAR },
+                { "sse2", SIMILARITY_KERNEL_SSE2 }, { "avx2", SIMILARITY_KERNEL_AVX2 },
+                { "avx512", SIMILARITY_KERNEL_AVX512 }
+            };
+            const char* name = argv[++i];
+            size_t k = 0;
+            while (k < sizeof(kernels) / sizeof(kernels[0]) && strcmp(name, kernels[k].name) != 0) k++;
+            if (k == sizeof(kernels) / sizeof(kernels[0])) return 0;
+            if (!select_similarity_kernel(kernels[k].level)) {
+                printf("Error: the %s kernel is not supported on this CPU\n", name);
+                return 0;
+            }
+        } else {
+            return 0;
+        }
+    }
+    return 1;
 }
 
-int main(){
+int main(int argc, char** argv){
+    // Pick the widest similarity kernel the CPU supports (--simd may override it)
+    select_similarity_kernel(SIMILARITY_KERNEL_AUTO);
+    
+    if (!parse_options(argc, argv)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    set_similarity_matrix_file(matrix_file, matrix_budget);
+    
     printf("GitDive - Commit-Genealogy: Semantic Change Similarity Explorer\n");
     printf("================================================================\n\n");
     
@@ -35,23 +189,68 @@ int main(){
     }
     
     if (get_git_root(repo_path, 1024)) {
-        printf("Repository root: %s\n\n", repo_path);
+        printf("Repository root: %s\n", repo_path);
+        printf("Similarity kernel: %s\n\n", get_similarity_kernel_name());
     }
     
     free(repo_path); // Free the allocated buffer
     
     // Get real commits from the local git repository
     printf("Fetching commits from local git repository...\n");
-    List* commit_list = get_git_commits(15); // Get more commits for better analysis
+    // Commits, authors and modifications of this run share one arena, released at the end
+    Arena* commit_arena = create_arena(0);
+    set_commit_arena(commit_arena);
+    // Author names and file paths are stored once each and referred to by id
+    StringTable* author_names = create_string_table(0);
+    StringTable* file_paths = create_string_table(0);
+    set_commit_string_tables(author_names, file_paths);
+    List* ingested_commits = NULL;
+    FingerprintCache* fingerprint_cache = NULL;
+    char git_dir[1024];
+    if (use_ingest_state && get_git_dir(git_dir, sizeof(git_dir))) {
+        // Only commits added since the last run are read from git
+        char state_path[1024 + sizeof(INGEST_STATE_FILENAME) + 1];
+        snprintf(state_path, sizeof(state_path), "%s/%s", git_dir, INGEST_STATE_FILENAME);
+        
+        IngestSummary summary;
+        ingested_commits = get_git_commits_incremental(state_path, max_commits, &summary);
+        if (ingested_commits && !summary.full_reload) {
+            printf("Reused %d commits from %s: %d new, %d dropped by history rewrite",
+                   summary.reused, INGEST_STATE_FILENAME, summary.added, summary.dropped);
+            if (summary.refilled > 0) printf(", %d older read to refill the window", summary.refilled);
+            printf("\n");
+        }
+        
+        // Fingerprints of commits seen before are read back instead of recomputed
+        char cache_path[1024 + sizeof(FINGERPRINT_CACHE_FILENAME) + 1];
+        snprintf(cache_path, sizeof(cache_path), "%s/%s", git_dir, FINGERPRINT_CACHE_FILENAME);
+        fingerprint_cache = open_fingerprint_cache(cache_path);
+        set_fingerprint_cache(fingerprint_cache);
+    } else {
+        ingested_commits = get_git_commits(max_commits);
+    }
     
-    if (commit_list == NULL) {
+    if (ingested_commits == NULL) {
         printf("Error: Could not retrieve commits from git repository.\n");
         printf("Please ensure:\n");
         printf("1. Git is installed and available in PATH\n");
         printf("2. The repository has commits\n");
+        set_fingerprint_cache(NULL);
+        close_fingerprint_cache(fingerprint_cache);
+        set_commit_arena(NULL);
+        free_arena(commit_arena);
+        set_commit_string_tables(NULL, NULL);
+        free_string_table(author_names);
+        free_string_table(file_paths);
         return 1;
     }
     
+    // The analysis works on a columnar copy of the history, through its list view (one
+    // array of nodes, in ingestion order); the ingested list still owns the commits
+    CommitStore* commit_store = build_commit_store(ingested_commits);
+    List* commit_list = commit_store ? get_commit_store_list(commit_store) : NULL;
+    if (!commit_list) commit_list = ingested_commits;
+    
     // Print the entire commit list with real git data
     printf("\n========== COMMIT HISTORY ==========\n");
     print_list(commit_list, (void (*)(void*))print_commit);
@@ -60,18 +259,76 @@ int main(){
     // Build a traditional BST of commits ordered by timestamp (for comparison)
     TreeNode* timestamp_tree = NULL;
     if (commit_list && get_number_of_items(commit_list) > 0) {
-        // Insert each commit pointer into the BST using the timestamp comparator
-        traverse_list_with_context(commit_list, insert_commit_to_bst, &timestamp_tree);
+        // Bulk-load the commit pointers with the timestamp comparator (git log order is
+        // already sorted, newest first, so the balanced tree is built in linear time)
+        int commit_count = get_number_of_items(commit_list);
+        void** commits_by_time = malloc(commit_count * sizeof(void*));
+        if (commits_by_time) {
+            int i = 0;
+            for (Node* node = get_first_node(commit_list); node; node = get_next_node(node)) {
+                commits_by_time[i++] = get_node_data(node);
+            }
+            timestamp_tree = build_bst(commits_by_time, commit_count, compare_commits_by_timestamp);
+            free(commits_by_time);
+        }
 
         printf("\n========== TRADITIONAL BST (by timestamp) =========\n");
         print_btree(timestamp_tree, print_commit_for_tree, 0);
         printf("===================================================\n");
     }
 
+    // Per-author and per-file activity of the analysed commits, counted by interned id (no
+    // string comparisons). The tables may also hold names and paths of commits dropped
+    // since, so the totals come from the counts, not from the table sizes.
+    if (commit_store && author_names && file_paths) {
+        int author_count = get_string_table_count(author_names);
+        int path_count = get_string_table_count(file_paths);
+        int* commits_per_author = calloc(author_count > 0 ? author_count : 1, sizeof(int));
+        int* changes_per_file = calloc(path_count > 0 ? path_count : 1, sizeof(int));
+        if (commits_per_author && changes_per_file) {
+            const int* author_ids = get_commit_store_author_ids(commit_store);
+            int store_size = get_commit_store_size(commit_store);
+            for (int i = 0; i < store_size; i++) {
+                if (author_ids[i] >= 0 && author_ids[i] < author_count) commits_per_author[author_ids[i]]++;
+                List* modifications = get_commit_modifications(get_store_commit(commit_store, i));
+                for (Node* node = get_first_node(modifications); node; node = get_next_node(node)) {
+                    int path_id = get_modification_path_id((Modification*)get_node_data(node));
+                    if (path_id >= 0) changes_per_file[path_id]++;
+                }
+            }
+            
+            int distinct_authors = 0;
+            for (int id = 0; id < author_count; id++) {
+                if (commits_per_author[id] > 0) distinct_authors++;
+            }
+            int distinct_paths = 0;
+            long long file_changes = 0;
+            size_t path_bytes = 0;
+            for (int id = 0; id < path_count; id++) {
+                if (changes_per_file[id] == 0) continue;
+                distinct_paths++;
+                file_changes += changes_per_file[id];
+                path_bytes += strlen(get_interned_string(file_paths, id)) + 1;
+            }
+            printf("\n========== MOST ACTIVE AUTHORS ==========\n");
+            printf("%d distinct authors\n", distinct_authors);
+            print_top_counts(author_names, commits_per_author, 5);
+            printf("\n========== MOST CHANGED FILES ==========\n");
+            printf("%d distinct paths (%zu bytes) for %lld file changes\n", distinct_paths, path_bytes, file_changes);
+            print_top_counts(file_paths, changes_per_file, 5);
+            printf("========================================\n");
+        }
+        free(commits_per_author);
+        free(changes_per_file);
+    }
+
     // === NEW: COMMIT-GENEALOGY ANALYSIS ===
     
     printf("\n========== SEMANTIC FINGERPRINT ANALYSIS ==========\n");
     
+    // Fingerprints are created once per commit and shared with the similarity tree
+    FingerprintRegistry* fingerprints = create_fingerprint_registry();
+    
     // Create semantic fingerprints for a few commits and show them
     Node* current = get_first_node(commit_list);
     int fingerprint_count = 0;
@@ -79,10 +336,9 @@ int main(){
         Commit* commit = (Commit*)get_node_data(current);
         printf("\nFingerprint for Commit ID %d:\n", get_commit_id(commit));
         
-        SemanticFingerprint* fp = create_semantic_fingerprint(commit);
+        SemanticFingerprint* fp = get_registered_fingerprint(fingerprints, commit);
         if (fp) {
             print_semantic_fingerprint(fp);
-            free_semantic_fingerprint(fp);
         }
         
         fingerprint_count++;
@@ -92,7 +348,9 @@ int main(){
     
     // Build the semantic similarity tree
     printf("\n========== BUILDING COMMIT SIMILARITY TREE ==========\n");
-    CommitSimilarityTree* similarity_tree = build_similarity_tree(commit_list);
+    CommitSimilarityTree* similarity_tree = build_similarity_tree(commit_list, fingerprints);
+    ArenaStats fingerprint_arena_stats;
+    get_fingerprint_registry_arena_stats(NULL, &fingerprint_arena_stats);
     
     if (similarity_tree) {
         // Print tree statistics
@@ -124,7 +382,80 @@ int main(){
                 free_list(precedents);
             }
             printf("================================================\n");
+            
+            // Demonstrate precedents restricted to a time window (the 30 days up to the root commit)
+            long long window_end = get_commit_timestamp(similarity_tree->root->commit);
+            long long window_start = window_end - 30LL * 86400;
+            printf("\n========== PRECEDENTS IN THE PRECEDING 30 DAYS ==========\n");
+            List* recent = find_historical_precedents_in_window(similarity_tree, similarity_tree->root->commit, 5,
+                                                                 window_start, window_end);
+            if (recent) {
+                print_historical_precedents(recent);
+                Node* prec_node = get_first_node(recent);
+                while (prec_node) {
+                    free_historical_precedent((HistoricalPrecedent*)get_node_data(prec_node));
+                    prec_node = get_next_node(prec_node);
+                }
+                free_list(recent);
+            }
+            printf("=========================================================\n");
+            
+            // Demonstrate approximate nearest-commit search
+            printf("\n========== NEAREST COMMITS ==========\n");
+            List* nearest = find_most_similar_commits(similarity_tree, similarity_tree->root->commit, 5);
+            if (nearest) {
+                Node* near_node = get_first_node(nearest);
+                int rank = 1;
+                while (near_node) {
+                    SimilarityTreeNode* tree_node = (SimilarityTreeNode*)get_node_data(near_node);
+                    char* hash = get_commit_hash(tree_node->commit);
+                    printf("%d. Similarity: %.3f - %.12s\n", rank++,
+                           get_cached_similarity(similarity_tree, similarity_tree->root->commit, tree_node->commit),
+                           hash ? hash : "(no hash)");
+                    near_node = get_next_node(near_node);
+                }
+                free_list(nearest); // Nodes belong to the tree
+            }
+            printf("=====================================\n");
+            
+            // Demonstrate exact similarity range search
+            List* cluster = get_similarity_cluster(similarity_tree, similarity_tree->root->commit, 0.9);
+            if (cluster) {
+                printf("\nCommits with similarity >= 0.90 to the root commit: %d\n", get_number_of_items(cluster));
+                free_list(cluster); // Nodes belong to the tree
+            }
+        }
+        
+        // Demonstrate the most similar pairs over the whole history
+        List* top_pairs = get_top_similar_pairs(similarity_tree, 5);
+        if (top_pairs) {
+            printf("\n========== MOST SIMILAR COMMIT PAIRS ==========\n");
+            Node* pair_node = get_first_node(top_pairs);
+            int rank = 1;
+            while (pair_node) {
+                SimilarityPair* pair = (SimilarityPair*)get_node_data(pair_node);
+                char* hash1 = get_commit_hash(pair->commit1);
+                char* hash2 = get_commit_hash(pair->commit2);
+                printf("%d. Similarity: %.3f - %.12s %.12s\n", rank++, pair->similarity_score,
+                       hash1 ? hash1 : "(no hash)", hash2 ? hash2 : "(no hash)");
+                free_similarity_pair(pair);
+                pair_node = get_next_node(pair_node);
+            }
+            free_list(top_pairs);
+            printf("===============================================\n");
+        }
+        
+        // Demonstrate the threshold join: every pair of likely re-implementations
+        int clone_pairs = 0;
+        SimilarityJoinStats join_stats;
+        printf("\n========== NEAR-DUPLICATE COMMITS (>= 0.95) ==========\n");
+        if (find_similar_commit_pairs(similarity_tree, 0.95, print_clone_pair, &clone_pairs, &join_stats)) {
+            printf("%d pair(s); scored %lld of %lld pairs (%.1f%% pruned)\n", clone_pairs,
+                   join_stats.candidate_pairs, join_stats.total_pairs,
+                   join_stats.total_pairs > 0 ?
+                       100.0 * (join_stats.total_pairs - join_stats.candidate_pairs) / join_stats.total_pairs : 0.0);
         }
+        printf("=======================================================\n");
         
         // Demonstrate similarity comparison between commits
         if (get_number_of_items(commit_list) >= 2) {
@@ -137,23 +468,22 @@ int main(){
                 Commit* commit1 = (Commit*)get_node_data(node1);
                 Commit* commit2 = (Commit*)get_node_data(node2);
                 
-                SemanticFingerprint* fp1 = create_semantic_fingerprint(commit1);
-                SemanticFingerprint* fp2 = create_semantic_fingerprint(commit2);
+                SemanticFingerprint* fp1 = get_tree_fingerprint(similarity_tree, commit1);
+                SemanticFingerprint* fp2 = get_tree_fingerprint(similarity_tree, commit2);
                 
                 if (fp1 && fp2) {
                     printf("Comparing first two commits:\n");
                     printf("Commit 1 ID: %d\n", get_commit_id(commit1));
                     printf("Commit 2 ID: %d\n", get_commit_id(commit2));
                     print_fingerprint_similarity(fp1, fp2);
-                    
-                    free_semantic_fingerprint(fp1);
-                    free_semantic_fingerprint(fp2);
                 }
             }
             printf("==================================================\n");
         }
+
+        get_fingerprint_registry_arena_stats(similarity_tree->fingerprints, &fingerprint_arena_stats);
         
-        // Clean up similarity tree
+        // Clean up similarity tree (and the fingerprints it owns)
         free_commit_similarity_tree(similarity_tree);
     } else {
         printf("Failed to build similarity tree.\n");
@@ -161,9 +491,43 @@ int main(){
 
     // Clean up traditional BST
     free_tree(timestamp_tree);
+    
+    int fingerprints_created, fingerprints_freed;
+    get_fingerprint_allocation_counts(&fingerprints_created, &fingerprints_freed);
+    printf("\nFingerprint allocations: %d created, %d freed (%d commits)\n",
+           fingerprints_created, fingerprints_freed, get_number_of_items(commit_list));
+    
+    ArenaStats commit_arena_stats;
+    get_arena_stats(commit_arena, &commit_arena_stats);
+    printf("Commit arena: %lld allocations, %zu bytes in %d blocks (%zu bytes reserved), %lld diff buffers adopted\n",
+           commit_arena_stats.allocations, commit_arena_stats.bytes_allocated,
+           commit_arena_stats.blocks, commit_arena_stats.bytes_reserved, commit_arena_stats.adopted);
+    printf("Fingerprint arena: %lld allocations, %zu bytes in %d blocks (%zu bytes reserved)\n",
+           fingerprint_arena_stats.allocations, fingerprint_arena_stats.bytes_allocated,
+           fingerprint_arena_stats.blocks, fingerprint_arena_stats.bytes_reserved);
+    
+    if (fingerprint_cache) {
+        int hits, misses;
+        get_fingerprint_cache_stats(fingerprint_cache, &hits, &misses);
+        printf("Fingerprint cache: %d reused, %d computed\n", hits, misses);
+        if (!save_fingerprint_cache(fingerprint_cache)) {
+            printf("Warning: could not write %s\n", FINGERPRINT_CACHE_FILENAME);
+        }
+        set_fingerprint_cache(NULL);
+        close_fingerprint_cache(fingerprint_cache);
+    }
 
     cleanup_git_data();
     
+    // Commits not taken from the arena are freed one by one, the rest all at once
+    free_commit_store(commit_store);
+    free_commit_list(ingested_commits);
+    set_commit_arena(NULL);
+    free_arena(commit_arena);
+    set_commit_string_tables(NULL, NULL);
+    free_string_table(author_names);
+    free_string_table(file_paths);
+    
     printf("\n========== COMMIT-GENEALOGY ANALYSIS COMPLETE ==========\n");
     printf("This tool reveals the hidden conceptual relationships between commits,\n");
     printf("moving beyond simple chronological order to show semantic similarity.\n");
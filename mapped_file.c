@@ -0,0 +1,120 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // mmap/fstat
+#endif
+
+#include "mapped_file.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct MappedFile {
+    unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file_handle;
+    HANDLE mapping_handle;
+#endif
+};
+
+MappedFile* map_file_readonly(const char* path) {
+    if (!path) return NULL;
+
+    MappedFile* file = malloc(sizeof(MappedFile));
+    if (!file) return NULL;
+    file->data = NULL;
+    file->size = 0;
+
+#ifdef _WIN32
+    file->mapping_handle = NULL;
+    file->file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->file_handle == INVALID_HANDLE_VALUE) {
+        free(file);
+        return NULL;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->file_handle, &size)) {
+        CloseHandle(file->file_handle);
+        free(file);
+        return NULL;
+    }
+    file->size = (size_t)size.QuadPart;
+
+    // Empty files cannot be mapped; they are represented by a NULL data pointer
+    if (file->size > 0) {
+        file->mapping_handle = CreateFileMappingA(file->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (file->mapping_handle) {
+            file->data = MapViewOfFile(file->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (!file->data) {
+            if (file->mapping_handle) CloseHandle(file->mapping_handle);
+            CloseHandle(file->file_handle);
+            free(file);
+            return NULL;
+        }
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        free(file);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        free(file);
+        return NULL;
+    }
+    file->size = (size_t)st.st_size;
+
+    // Empty files cannot be mapped; they are represented by a NULL data pointer
+    if (file->size > 0) {
+        void* data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            free(file);
+            return NULL;
+        }
+        file->data = data;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+
+    return file;
+}
+
+const unsigned char* get_mapped_data(MappedFile* file) {
+    if (!file) return NULL;
+    return file->data;
+}
+
+size_t get_mapped_size(MappedFile* file) {
+    if (!file) return 0;
+    return file->size;
+}
+
+void unmap_file(MappedFile* file) {
+    if (!file) return;
+
+#ifdef _WIN32
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->mapping_handle) CloseHandle(file->mapping_handle);
+    CloseHandle(file->file_handle);
+#else
+    if (file->data) munmap(file->data, file->size);
+#endif
+
+    free(file);
+}
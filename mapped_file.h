@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+typedef struct MappedFile MappedFile;
+
+/**
+ * Map a whole file read-only into memory
+ * @param path Path of the file to map
+ * @return Mapping handle, or NULL if the file could not be opened
+ */
+MappedFile* map_file_readonly(const char* path);
+
+/**
+ * Get the mapped bytes of a file (NULL for empty files)
+ */
+const unsigned char* get_mapped_data(MappedFile* file);
+
+/**
+ * Get the size in bytes of a mapped file
+ */
+size_t get_mapped_size(MappedFile* file);
+
+/**
+ * Release a mapping created by map_file_readonly()
+ */
+void unmap_file(MappedFile* file);
+
+#endif
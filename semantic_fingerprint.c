@@ -1,4 +1,9 @@
 #include "semantic_fingerprint.h"
+#include "fingerprint_cache.h"
+#include "similarity_kernels.h"
+#include "commit_index_map.h"
+#include "hash.h"
+#include "thread_pool.h"
 #include "list.h"
 #include <stdlib.h>
 #include <string.h>
@@ -10,8 +15,51 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Cache consulted by create_semantic_fingerprint (NULL = always compute)
+static FingerprintCache* active_cache = NULL;
+
+// Allocation counters reported by get_fingerprint_allocation_counts
+static int fingerprints_created = 0;
+static int fingerprints_freed = 0;
+
+static void destroy_semantic_fingerprint(SemanticFingerprint* fingerprint);
+
+void set_fingerprint_cache(FingerprintCache* cache) {
+    active_cache = cache;
+}
+
+// Seed for the filler dimensions: derived from the hash when known so a commit keeps
+// the same vector when incremental ingestion renumbers it (FNV-1a)
+static unsigned int fingerprint_noise_seed(Commit* commit) {
+    const char* hash = get_commit_hash(commit);
+    if (!hash) return (unsigned int)get_commit_id(commit);
+    
+    return fnv1a_32(hash);
+}
+
+// Next value of a per-call xorshift32 generator in [0, 1]; unlike rand() it keeps no
+// global state, so fingerprints can be computed on several threads
+static double next_noise(unsigned int* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (double)*state / 4294967295.0;
+}
+
+// Retained analysis data comes from the fingerprint's arena when it has one; scratch
+// buffers always use malloc
+static void* analysis_alloc(Arena* arena, size_t size) {
+    return arena ? arena_alloc(arena, size) : malloc(size);
+}
+
+static char* analysis_strdup(Arena* arena, const char* text) {
+    char* copy = analysis_alloc(arena, strlen(text) + 1);
+    if (copy) strcpy(copy, text);
+    return copy;
+}
+
 // Helper function to extract intent from commit message
-static char* extract_intent_type(const char* message) {
+static char* extract_intent_type(const char* message, Arena* arena) {
     if (!message) return NULL;
     
     // Convert to lowercase for analysis
@@ -27,23 +75,17 @@ static char* extract_intent_type(const char* message) {
     
     // Check for conventional commit patterns
     if (strstr(lower_msg, "fix:") || strstr(lower_msg, "bug") || strstr(lower_msg, "error")) {
-        intent = malloc(4);
-        if (intent) strcpy(intent, "fix");
+        intent = analysis_strdup(arena, "fix");
     } else if (strstr(lower_msg, "feat:") || strstr(lower_msg, "add") || strstr(lower_msg, "new")) {
-        intent = malloc(5);
-        if (intent) strcpy(intent, "feat");
+        intent = analysis_strdup(arena, "feat");
     } else if (strstr(lower_msg, "refactor") || strstr(lower_msg, "restructure") || strstr(lower_msg, "cleanup")) {
-        intent = malloc(9);
-        if (intent) strcpy(intent, "refactor");
+        intent = analysis_strdup(arena, "refactor");
     } else if (strstr(lower_msg, "docs:") || strstr(lower_msg, "documentation") || strstr(lower_msg, "readme")) {
-        intent = malloc(5);
-        if (intent) strcpy(intent, "docs");
+        intent = analysis_strdup(arena, "docs");
     } else if (strstr(lower_msg, "test") || strstr(lower_msg, "spec")) {
-        intent = malloc(5);
-        if (intent) strcpy(intent, "test");
+        intent = analysis_strdup(arena, "test");
     } else {
-        intent = malloc(6);
-        if (intent) strcpy(intent, "chore");
+        intent = analysis_strdup(arena, "chore");
     }
     
     free(lower_msg);
@@ -51,7 +93,7 @@ static char* extract_intent_type(const char* message) {
 }
 
 // Helper function to extract ticket references
-static char* extract_ticket_reference(const char* message) {
+static char* extract_ticket_reference(const char* message, Arena* arena) {
     if (!message) return NULL;
     
     // Look for patterns like JIRA-123, #456, etc.
@@ -67,7 +109,7 @@ static char* extract_ticket_reference(const char* message) {
         }
         if (num_end > num_start) {
             int len = num_end;
-            ticket = malloc(len + 1);
+            ticket = analysis_alloc(arena, len + 1);
             if (ticket) {
                 strncpy(ticket, hash_pos, len);
                 ticket[len] = '\0';
@@ -86,7 +128,7 @@ static char* extract_ticket_reference(const char* message) {
                     const char* num_start = pos + 1;
                     while (*pos && isdigit(*pos)) pos++;
                     int total_len = pos - word_start;
-                    ticket = malloc(total_len + 1);
+                    ticket = analysis_alloc(arena, total_len + 1);
                     if (ticket) {
                         strncpy(ticket, word_start, total_len);
                         ticket[total_len] = '\0';
@@ -140,14 +182,14 @@ static double calculate_sentiment_score(const char* message) {
     return score;
 }
 
-CommitKeywords* analyze_commit_message(const char* message) {
+static CommitKeywords* build_commit_keywords(const char* message, Arena* arena) {
     if (!message) return NULL;
     
-    CommitKeywords* keywords = malloc(sizeof(CommitKeywords));
+    CommitKeywords* keywords = analysis_alloc(arena, sizeof(CommitKeywords));
     if (!keywords) return NULL;
     
-    keywords->intent_type = extract_intent_type(message);
-    keywords->ticket_reference = extract_ticket_reference(message);
+    keywords->intent_type = extract_intent_type(message, arena);
+    keywords->ticket_reference = extract_ticket_reference(message, arena);
     keywords->sentiment_score = calculate_sentiment_score(message);
     keywords->keyword_count = 0;
     
@@ -159,31 +201,41 @@ CommitKeywords* analyze_commit_message(const char* message) {
     // Simple keyword extraction (words longer than 3 characters)
     char* msg_copy = malloc(strlen(message) + 1);
     if (!msg_copy) {
-        free_commit_keywords(keywords);
+        if (!arena) free_commit_keywords(keywords);
         return NULL;
     }
     strcpy(msg_copy, message);
     
-    char* token = strtok(msg_copy, " \t\n\r.,;:!?()[]{}");
-    while (token && keywords->keyword_count < MAX_KEYWORDS) {
-        if (strlen(token) > 3) {
-            keywords->keywords[keywords->keyword_count] = malloc(strlen(token) + 1);
+    // Tokens are cut in place with strspn/strcspn (strtok keeps global state)
+    const char* separators = " \t\n\r.,;:!?()[]{}";
+    char* token = msg_copy + strspn(msg_copy, separators);
+    while (*token && keywords->keyword_count < MAX_KEYWORDS) {
+        size_t length = strcspn(token, separators);
+        char* next = token + length;
+        if (*next) next++;
+        token[length] = '\0';
+        if (length > 3) {
+            keywords->keywords[keywords->keyword_count] = analysis_alloc(arena, length + 1);
             if (keywords->keywords[keywords->keyword_count]) {
                 strcpy(keywords->keywords[keywords->keyword_count], token);
                 keywords->keyword_count++;
             }
         }
-        token = strtok(NULL, " \t\n\r.,;:!?()[]{}");
+        token = next + strspn(next, separators);
     }
     
     free(msg_copy);
     return keywords;
 }
 
-FilePathAnalysis* analyze_file_paths(List* modifications) {
+CommitKeywords* analyze_commit_message(const char* message) {
+    return build_commit_keywords(message, NULL);
+}
+
+static FilePathAnalysis* build_file_path_analysis(List* modifications, Arena* arena) {
     if (!modifications) return NULL;
     
-    FilePathAnalysis* analysis = malloc(sizeof(FilePathAnalysis));
+    FilePathAnalysis* analysis = analysis_alloc(arena, sizeof(FilePathAnalysis));
     if (!analysis) return NULL;
     
     analysis->primary_module = NULL;
@@ -224,17 +276,13 @@ FilePathAnalysis* analyze_file_paths(List* modifications) {
     
     // Determine primary module
     if (src_count > test_count && src_count > docs_count && src_count > config_count) {
-        analysis->primary_module = malloc(4);
-        if (analysis->primary_module) strcpy(analysis->primary_module, "src");
+        analysis->primary_module = analysis_strdup(arena, "src");
     } else if (test_count > docs_count && test_count > config_count) {
-        analysis->primary_module = malloc(5);
-        if (analysis->primary_module) strcpy(analysis->primary_module, "test");
+        analysis->primary_module = analysis_strdup(arena, "test");
     } else if (docs_count > config_count) {
-        analysis->primary_module = malloc(5);
-        if (analysis->primary_module) strcpy(analysis->primary_module, "docs");
+        analysis->primary_module = analysis_strdup(arena, "docs");
     } else {
-        analysis->primary_module = malloc(7);
-        if (analysis->primary_module) strcpy(analysis->primary_module, "config");
+        analysis->primary_module = analysis_strdup(arena, "config");
     }
     
     // Calculate file diversity (simplified)
@@ -252,10 +300,14 @@ FilePathAnalysis* analyze_file_paths(List* modifications) {
     return analysis;
 }
 
-CodeDeltaAnalysis* analyze_code_delta(List* modifications) {
+FilePathAnalysis* analyze_file_paths(List* modifications) {
+    return build_file_path_analysis(modifications, NULL);
+}
+
+static CodeDeltaAnalysis* build_code_delta_analysis(List* modifications, Arena* arena) {
     if (!modifications) return NULL;
     
-    CodeDeltaAnalysis* analysis = malloc(sizeof(CodeDeltaAnalysis));
+    CodeDeltaAnalysis* analysis = analysis_alloc(arena, sizeof(CodeDeltaAnalysis));
     if (!analysis) return NULL;
     
     analysis->semantic_distance = 0.0;
@@ -268,31 +320,16 @@ CodeDeltaAnalysis* analyze_code_delta(List* modifications) {
     Node* current = get_first_node(modifications);
     while (current) {
         Modification* mod = (Modification*)get_node_data(current);
-        char* old_code = get_modification_old_code(mod);
-        char* new_code = get_modification_new_code(mod);
-        
-        // Count lines in old and new code
-        if (old_code) {
-            char* line = old_code;
-            while ((line = strchr(line, '\n')) != NULL) {
-                analysis->lines_removed++;
-                line++;
-            }
-        }
         
-        if (new_code) {
-            char* line = new_code;
-            while ((line = strchr(line, '\n')) != NULL) {
-                analysis->lines_added++;
-                line++;
-            }
-        }
+        // Lines in old and new code (counted when the modification was created)
+        analysis->lines_removed += get_modification_lines_removed(mod);
+        analysis->lines_added += get_modification_lines_added(mod);
         
         // Simple heuristic: assume each modification affects at least one function
         analysis->functions_modified++;
         
         // Count classes (simple heuristic for C: look for struct definitions)
-        if (new_code && (strstr(new_code, "struct ") || strstr(new_code, "typedef struct"))) {
+        if (modification_declares_struct(mod)) {
             analysis->classes_modified++;
         }
         
@@ -323,11 +360,17 @@ CodeDeltaAnalysis* analyze_code_delta(List* modifications) {
     return analysis;
 }
 
-SemanticFingerprint* create_semantic_fingerprint(Commit* commit) {
-    if (!commit) return NULL;
-    
-    SemanticFingerprint* fingerprint = malloc(sizeof(SemanticFingerprint));
+CodeDeltaAnalysis* analyze_code_delta(List* modifications) {
+    return build_code_delta_analysis(modifications, NULL);
+}
+
+// Compute a fingerprint from the commit alone: no cache, no counters, so it may run on
+// several threads at once (each with its own arena, or NULL for the heap)
+static SemanticFingerprint* compute_semantic_fingerprint(Commit* commit, Arena* arena) {
+    char* hash = get_commit_hash(commit);
+    SemanticFingerprint* fingerprint = analysis_alloc(arena, sizeof(SemanticFingerprint));
     if (!fingerprint) return NULL;
+    fingerprint->arena = arena;
     
     // Initialize vector to zero
     for (int i = 0; i < FINGERPRINT_DIMENSIONS; i++) {
@@ -335,18 +378,19 @@ SemanticFingerprint* create_semantic_fingerprint(Commit* commit) {
     }
     
     fingerprint->magnitude = 0.0;
-    fingerprint->commit_hash = NULL; // We'll need to add hash to Commit struct
+    fingerprint->commit_hash = NULL;
+    if (hash) fingerprint->commit_hash = analysis_strdup(arena, hash);
     
     // Analyze components using the actual commit data
     char* commit_message = get_commit_message(commit);
     List* modifications = get_commit_modifications(commit);
     
-    fingerprint->keywords = analyze_commit_message(commit_message);
-    fingerprint->file_analysis = analyze_file_paths(modifications);
-    fingerprint->code_delta = analyze_code_delta(modifications);
+    fingerprint->keywords = build_commit_keywords(commit_message, arena);
+    fingerprint->file_analysis = build_file_path_analysis(modifications, arena);
+    fingerprint->code_delta = build_code_delta_analysis(modifications, arena);
     
     if (!fingerprint->keywords || !fingerprint->file_analysis || !fingerprint->code_delta) {
-        free_semantic_fingerprint(fingerprint);
+        destroy_semantic_fingerprint(fingerprint);
         return NULL;
     }
     
@@ -411,17 +455,41 @@ SemanticFingerprint* create_semantic_fingerprint(Commit* commit) {
     
     // Remaining dimensions (24-31) can be used for future features
     // For now, add some controlled noise based on commit properties to make fingerprints unique
-    int commit_id = get_commit_id(commit);
-    srand(commit_id); // Use commit ID as seed for reproducible "randomness"
+    unsigned int noise = fingerprint_noise_seed(commit) | 1u; // Reproducible "randomness" per commit
     for (int i = 24; i < FINGERPRINT_DIMENSIONS; i++) {
-        fingerprint->vector[i] = ((double)rand() / RAND_MAX - 0.5) * 0.05; // Small random component
+        fingerprint->vector[i] = (next_noise(&noise) - 0.5) * 0.05; // Small random component
     }
     
     normalize_fingerprint_vector(fingerprint);
+    return fingerprint;
+}
+
+// Cached fingerprint, or one computed in arena (NULL for the heap) and stored in the cache
+static SemanticFingerprint* obtain_semantic_fingerprint(Commit* commit, Arena* arena) {
+    if (!commit) return NULL;
     
+    char* hash = get_commit_hash(commit);
+    if (active_cache && hash) {
+        SemanticFingerprint* cached = lookup_cached_fingerprint(active_cache, hash);
+        if (cached) {
+            fingerprints_created++;
+            return cached;
+        }
+    }
+    
+    SemanticFingerprint* fingerprint = compute_semantic_fingerprint(commit, arena);
+    if (!fingerprint) return NULL;
+    
+    store_cached_fingerprint(active_cache, fingerprint);
+    
+    fingerprints_created++;
     return fingerprint;
 }
 
+SemanticFingerprint* create_semantic_fingerprint(Commit* commit) {
+    return obtain_semantic_fingerprint(commit, NULL);
+}
+
 void normalize_fingerprint_vector(SemanticFingerprint* fingerprint) {
     if (!fingerprint) return;
     
@@ -445,13 +513,14 @@ void normalize_fingerprint_vector(SemanticFingerprint* fingerprint) {
 double cosine_similarity(const double* vec1, const double* vec2, int dimensions) {
     if (!vec1 || !vec2) return 0.0;
     
-    double dot_product = 0.0;
-    for (int i = 0; i < dimensions; i++) {
-        dot_product += vec1[i] * vec2[i];
-    }
-    
     // Since vectors are normalized, their magnitudes are 1
-    return dot_product;
+    return similarity_dot(vec1, vec2, dimensions);
+}
+
+void cosine_similarity_batch(const double* query, const double* vectors, int count, int dimensions, double* results) {
+    if (!query || !vectors || !results || count <= 0) return;
+    
+    similarity_dot_many(query, vectors, count, dimensions, results);
 }
 
 double calculate_fingerprint_similarity(const SemanticFingerprint* fp1, const SemanticFingerprint* fp2) {
@@ -542,6 +611,20 @@ void free_code_delta_analysis(CodeDeltaAnalysis* analysis) {
 void free_semantic_fingerprint(SemanticFingerprint* fingerprint) {
     if (!fingerprint) return;
     
+    fingerprints_freed++;
+    destroy_semantic_fingerprint(fingerprint);
+}
+
+void get_fingerprint_allocation_counts(int* created, int* freed) {
+    if (created) *created = fingerprints_created;
+    if (freed) *freed = fingerprints_freed;
+}
+
+// Release without counting (partially built fingerprints inside this file); fingerprints
+// in an arena go with it
+static void destroy_semantic_fingerprint(SemanticFingerprint* fingerprint) {
+    if (!fingerprint || fingerprint->arena) return;
+    
     free_commit_keywords(fingerprint->keywords);
     free_file_path_analysis(fingerprint->file_analysis);
     free_code_delta_analysis(fingerprint->code_delta);
@@ -549,3 +632,185 @@ void free_semantic_fingerprint(SemanticFingerprint* fingerprint) {
     
     free(fingerprint);
 }
+
+// ==================== Per-run fingerprint registry ====================
+
+// Arena blocks of the registry and of each registering task: a task fills a few (about
+// 700 bytes per fingerprint), so little is left unused in its last one
+#define FINGERPRINT_ARENA_BLOCK ((size_t)16 << 10)
+
+struct FingerprintRegistry {
+    Commit** commits;
+    SemanticFingerprint** fingerprints;
+    int count;
+    int capacity;
+    CommitIndexMap* slots; // Commit -> slot in the arrays above
+    Arena* arena;          // Computed fingerprints (cache hits are on the heap)
+};
+
+FingerprintRegistry* create_fingerprint_registry(void) {
+    FingerprintRegistry* registry = malloc(sizeof(FingerprintRegistry));
+    if (!registry) return NULL;
+    
+    registry->commits = NULL;
+    registry->fingerprints = NULL;
+    registry->count = 0;
+    registry->capacity = 0;
+    registry->slots = create_commit_index_map(0);
+    registry->arena = create_arena(FINGERPRINT_ARENA_BLOCK);
+    if (!registry->slots || !registry->arena) {
+        free_commit_index_map(registry->slots);
+        free_arena(registry->arena);
+        free(registry);
+        return NULL;
+    }
+    return registry;
+}
+
+// Take ownership of a fingerprint for an unregistered commit; 0 on allocation failure
+static int add_registered_fingerprint(FingerprintRegistry* registry, Commit* commit, SemanticFingerprint* fingerprint) {
+    if (registry->count == registry->capacity) {
+        int capacity = registry->capacity ? registry->capacity * 2 : 16;
+        Commit** commits = realloc(registry->commits, capacity * sizeof(Commit*));
+        if (!commits) return 0;
+        registry->commits = commits;
+        SemanticFingerprint** fingerprints = realloc(registry->fingerprints, capacity * sizeof(SemanticFingerprint*));
+        if (!fingerprints) return 0;
+        registry->fingerprints = fingerprints;
+        registry->capacity = capacity;
+    }
+    if (!put_commit_index(registry->slots, commit, registry->count)) return 0;
+    
+    registry->commits[registry->count] = commit;
+    registry->fingerprints[registry->count] = fingerprint;
+    registry->count++;
+    return 1;
+}
+
+SemanticFingerprint* get_registered_fingerprint(FingerprintRegistry* registry, Commit* commit) {
+    if (!registry || !commit) return NULL;
+    
+    int slot = get_commit_index(registry->slots, commit);
+    if (slot >= 0) return registry->fingerprints[slot];
+    
+    SemanticFingerprint* fingerprint = obtain_semantic_fingerprint(commit, registry->arena);
+    if (!fingerprint) return NULL; // Not registered, so a later request retries
+    if (!add_registered_fingerprint(registry, commit, fingerprint)) {
+        free_semantic_fingerprint(fingerprint);
+        return NULL;
+    }
+    return fingerprint;
+}
+
+// Commits per fingerprinting task: enough work to hide the queueing cost
+#define FINGERPRINTS_PER_TASK 64
+
+typedef struct {
+    Commit** commits;
+    SemanticFingerprint** fingerprints; // Entries already set came from the cache
+    int begin;
+    int end;
+    Arena* arena;                       // Of this task alone (NULL: the heap)
+} FingerprintTask;
+
+static void compute_fingerprint_range(void* argument) {
+    FingerprintTask* task = (FingerprintTask*)argument;
+    for (int i = task->begin; i < task->end; i++) {
+        if (!task->fingerprints[i]) task->fingerprints[i] = compute_semantic_fingerprint(task->commits[i], task->arena);
+    }
+}
+
+int register_fingerprints(FingerprintRegistry* registry, List* commits, int workers) {
+    if (!registry || !commits) return 0;
+    
+    int total = get_number_of_items(commits);
+    size_t slots = total > 0 ? (size_t)total : 1;
+    Commit** pending = malloc(slots * sizeof(Commit*));
+    SemanticFingerprint** fingerprints = calloc(slots, sizeof(SemanticFingerprint*));
+    char* from_cache = calloc(slots, 1);
+    if (!pending || !fingerprints || !from_cache) {
+        free(pending);
+        free(fingerprints);
+        free(from_cache);
+        return 0;
+    }
+    
+    // The cache is only used on this thread: hits are looked up before the workers start
+    // and the computed fingerprints are stored after they finish
+    int count = 0;
+    for (Node* node = get_first_node(commits); node; node = get_next_node(node)) {
+        Commit* commit = (Commit*)get_node_data(node);
+        if (!commit || get_commit_index(registry->slots, commit) >= 0) continue;
+        char* hash = get_commit_hash(commit);
+        if (active_cache && hash) {
+            fingerprints[count] = lookup_cached_fingerprint(active_cache, hash);
+            from_cache[count] = fingerprints[count] != NULL;
+        }
+        pending[count++] = commit;
+    }
+    
+    // Ranges of commits run on the pool (inline if it cannot be started or a task cannot be queued)
+    int task_count = (count + FINGERPRINTS_PER_TASK - 1) / FINGERPRINTS_PER_TASK;
+    FingerprintTask* tasks = malloc((task_count > 0 ? task_count : 1) * sizeof(FingerprintTask));
+    ThreadPool* pool = tasks && task_count > 1 ? create_thread_pool(workers) : NULL;
+    for (int t = 0; tasks && t < task_count; t++) {
+        tasks[t].commits = pending;
+        tasks[t].fingerprints = fingerprints;
+        tasks[t].begin = t * FINGERPRINTS_PER_TASK;
+        tasks[t].end = tasks[t].begin + FINGERPRINTS_PER_TASK < count ? tasks[t].begin + FINGERPRINTS_PER_TASK : count;
+        tasks[t].arena = create_arena(FINGERPRINT_ARENA_BLOCK);
+        if (!pool || !submit_thread_pool_task(pool, compute_fingerprint_range, &tasks[t])) {
+            compute_fingerprint_range(&tasks[t]);
+        }
+    }
+    if (pool) {
+        wait_thread_pool(pool);
+        free_thread_pool(pool);
+    }
+    for (int t = 0; tasks && t < task_count; t++) absorb_arena(registry->arena, tasks[t].arena);
+    
+    // Register in list order; a commit listed twice keeps its first fingerprint, and one
+    // that failed is left for get_registered_fingerprint() to retry
+    int registered = tasks != NULL;
+    for (int i = 0; i < count; i++) {
+        if (!fingerprints[i]) continue;
+        if (get_commit_index(registry->slots, pending[i]) >= 0) {
+            destroy_semantic_fingerprint(fingerprints[i]);
+            continue;
+        }
+        if (!from_cache[i]) store_cached_fingerprint(active_cache, fingerprints[i]);
+        if (!add_registered_fingerprint(registry, pending[i], fingerprints[i])) {
+            destroy_semantic_fingerprint(fingerprints[i]);
+            registered = 0;
+            continue;
+        }
+        fingerprints_created++;
+    }
+    
+    free(tasks);
+    free(from_cache);
+    free(fingerprints);
+    free(pending);
+    return registered;
+}
+
+int get_registered_fingerprint_count(FingerprintRegistry* registry) {
+    return registry ? registry->count : 0;
+}
+
+void get_fingerprint_registry_arena_stats(FingerprintRegistry* registry, ArenaStats* stats) {
+    get_arena_stats(registry ? registry->arena : NULL, stats);
+}
+
+void free_fingerprint_registry(FingerprintRegistry* registry) {
+    if (!registry) return;
+    
+    for (int i = 0; i < registry->count; i++) {
+        free_semantic_fingerprint(registry->fingerprints[i]);
+    }
+    free(registry->commits);
+    free(registry->fingerprints);
+    free_commit_index_map(registry->slots);
+    free_arena(registry->arena);
+    free(registry);
+}
@@ -2,6 +2,7 @@
 #define SEMANTIC_FINGERPRINT_H
 
 #include "commit.h"
+#include "arena.h"
 #include <stddef.h>
 
 // Semantic fingerprint dimensions
@@ -9,10 +10,16 @@
 #define MAX_KEYWORDS 20
 #define MAX_FILE_PATTERNS 10
 
+// Version of the fingerprint algorithm; bump whenever the analysis or vector layout
+// changes so that cached fingerprints computed by older builds are discarded
+#define FINGERPRINT_SCHEMA_VERSION 2
+
 typedef struct SemanticFingerprint SemanticFingerprint;
 typedef struct CommitKeywords CommitKeywords;
 typedef struct FilePathAnalysis FilePathAnalysis;
 typedef struct CodeDeltaAnalysis CodeDeltaAnalysis;
+typedef struct FingerprintCache FingerprintCache;
+typedef struct FingerprintRegistry FingerprintRegistry;
 
 /**
  * Represents the semantic fingerprint of a commit
@@ -30,6 +37,7 @@ struct SemanticFingerprint {
     // Metadata
     double magnitude;  // Original magnitude before normalization
     char* commit_hash; // Reference to the commit this fingerprint represents
+    Arena* arena;      // Holds the fingerprint and its components (NULL = heap, freed one by one)
 };
 
 /**
@@ -70,9 +78,47 @@ struct CodeDeltaAnalysis {
 SemanticFingerprint* create_semantic_fingerprint(Commit* commit);
 void free_semantic_fingerprint(SemanticFingerprint* fingerprint);
 
+/**
+ * Serve create_semantic_fingerprint() from a persistent cache (see fingerprint_cache.h).
+ * Commits with a full hash are looked up first and stored after being computed.
+ * Pass NULL to compute every fingerprint.
+ */
+void set_fingerprint_cache(FingerprintCache* cache);
+
+/**
+ * Number of fingerprints returned by create_semantic_fingerprint() and released by
+ * free_semantic_fingerprint() so far in this process
+ */
+void get_fingerprint_allocation_counts(int* created, int* freed);
+
+/**
+ * Per-run registry holding one fingerprint per commit. The fingerprint is created on
+ * the first request and shared by reference afterwards; the registry owns it and frees
+ * it in free_fingerprint_registry(). Computed fingerprints live in an arena of the
+ * registry, released in one go with it.
+ */
+FingerprintRegistry* create_fingerprint_registry(void);
+SemanticFingerprint* get_registered_fingerprint(FingerprintRegistry* registry, Commit* commit);
+
+/**
+ * Register the fingerprint of every commit in commits not registered yet. Cached
+ * fingerprints are looked up first; the rest are computed in parallel and stored in the
+ * cache afterwards, so the results match get_registered_fingerprint() one commit at a time.
+ * @param workers Threads to use (values < 1 use one per CPU)
+ * @return 1 on success, 0 on allocation failure (commits left out are fingerprinted on
+ *         their first get_registered_fingerprint())
+ */
+int register_fingerprints(FingerprintRegistry* registry, List* commits, int workers);
+int get_registered_fingerprint_count(FingerprintRegistry* registry);
+// Usage of the arena holding the registry's computed fingerprints
+void get_fingerprint_registry_arena_stats(FingerprintRegistry* registry, ArenaStats* stats);
+void free_fingerprint_registry(FingerprintRegistry* registry);
+
 // Similarity calculation
 double calculate_fingerprint_similarity(const SemanticFingerprint* fp1, const SemanticFingerprint* fp2);
 double cosine_similarity(const double* vec1, const double* vec2, int dimensions);
+// Similarity of query to count normalized vectors stored back to back (dimensions doubles each)
+void cosine_similarity_batch(const double* query, const double* vectors, int count, int dimensions, double* results);
 
 // Component analysis functions
 CommitKeywords* analyze_commit_message(const char* message);
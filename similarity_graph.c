@@ -0,0 +1,304 @@
+#include "similarity_graph.h"
+#include "similarity_kernels.h"
+#include "thread_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Rows/columns per block of the all-pairs product; two 32 x 32 blocks of doubles stay in L1
+#define GRAPH_BLOCK 32
+
+struct SimilarityGraph {
+    int count;
+    int degree;            // k
+    int* offsets;          // Row i is entries [offsets[i], offsets[i + 1])
+    int* neighbors;
+    double* similarities;
+};
+
+typedef struct {
+    double similarity;
+    int neighbor;
+} GraphCandidate;
+
+// Shared state of a build. Row i's neighbours are written to the k slots starting at
+// i * k and lengths[i] receives their number.
+typedef struct {
+    const double* vectors;
+    const char* has_vector;
+    int count;
+    int dimensions;
+    int degree;
+    int* neighbors;
+    double* similarities;
+    int* lengths;
+} GraphBuild;
+
+// One block of GRAPH_BLOCK rows; every row belongs to exactly one task
+typedef struct {
+    GraphBuild* build;
+    int first_row;
+    double total;          // Sum of the similarities seen by the block's rows
+    long long pairs;
+    int failed;
+} GraphBlockTask;
+
+// 1 if neighbour (a, index_a) ranks below (b, index_b): less similar, ties to the higher index
+static int ranks_below(double a, int index_a, double b, int index_b) {
+    return a < b || (a == b && index_a > index_b);
+}
+
+static void swap_candidates(GraphCandidate* a, GraphCandidate* b) {
+    GraphCandidate swap = *a;
+    *a = *b;
+    *b = swap;
+}
+
+// Move the best count of length candidates to the front, in no particular order (quickselect)
+static void select_best_candidates(GraphCandidate* candidates, int length, int count) {
+    int low = 0;
+    int high = length - 1;
+    while (low < high) {
+        GraphCandidate pivot = candidates[low + (high - low) / 2];
+        int i = low;
+        int j = high;
+        while (i <= j) {
+            while (ranks_below(pivot.similarity, pivot.neighbor, candidates[i].similarity, candidates[i].neighbor)) i++;
+            while (ranks_below(candidates[j].similarity, candidates[j].neighbor, pivot.similarity, pivot.neighbor)) j--;
+            if (i <= j) swap_candidates(&candidates[i++], &candidates[j--]);
+        }
+        if (count - 1 <= j) {
+            high = j;
+        } else if (count - 1 >= i) {
+            low = i;
+        } else {
+            break;
+        }
+    }
+}
+
+// qsort order: most similar first
+static int compare_candidates(const void* a, const void* b) {
+    const GraphCandidate* first = (const GraphCandidate*)a;
+    const GraphCandidate* second = (const GraphCandidate*)b;
+    if (ranks_below(second->similarity, second->neighbor, first->similarity, first->neighbor)) return -1;
+    if (ranks_below(first->similarity, first->neighbor, second->similarity, second->neighbor)) return 1;
+    return 0;
+}
+
+/*
+ * Each row collects candidates that beat its current threshold in a buffer of 2k.
+ * When the buffer fills, the best k are selected and the worst of them becomes the
+ * new threshold, so a row costs O(1) amortized per candidate whatever the order in
+ * which similar commits turn up.
+ */
+static void build_graph_rows(void* argument) {
+    GraphBlockTask* task = (GraphBlockTask*)argument;
+    GraphBuild* build = task->build;
+    int degree = build->degree;
+    int first_row = task->first_row;
+    int rows = build->count - first_row < GRAPH_BLOCK ? build->count - first_row : GRAPH_BLOCK;
+    int capacity = degree < build->count / 2 ? 2 * degree : build->count;
+    double tile[GRAPH_BLOCK * GRAPH_BLOCK];
+    GraphCandidate thresholds[GRAPH_BLOCK];
+    int limited[GRAPH_BLOCK] = { 0 };
+    int lengths[GRAPH_BLOCK] = { 0 };
+    double total = 0.0;
+    long long pairs = 0;
+
+    GraphCandidate* candidates = malloc((size_t)rows * capacity * sizeof(GraphCandidate));
+    if (!candidates) {
+        task->failed = 1;
+        return;
+    }
+
+    for (int column_start = 0; column_start < build->count; column_start += GRAPH_BLOCK) {
+        int columns = build->count - column_start < GRAPH_BLOCK ? build->count - column_start : GRAPH_BLOCK;
+        similarity_dot_block(build->vectors + (size_t)first_row * build->dimensions, rows,
+                             build->vectors + (size_t)column_start * build->dimensions, columns,
+                             build->dimensions, tile, GRAPH_BLOCK);
+
+        for (int r = 0; r < rows; r++) {
+            int i = first_row + r;
+            if (!build->has_vector[i]) continue;
+            GraphCandidate* row = candidates + (size_t)r * capacity;
+            for (int c = 0; c < columns; c++) {
+                int j = column_start + c;
+                if (j == i || !build->has_vector[j]) continue;
+                double similarity = tile[r * GRAPH_BLOCK + c];
+                total += similarity;
+                pairs++;
+                if (limited[r] && !ranks_below(thresholds[r].similarity, thresholds[r].neighbor, similarity, j)) continue;
+
+                row[lengths[r]].similarity = similarity;
+                row[lengths[r]].neighbor = j;
+                if (++lengths[r] == capacity) {
+                    select_best_candidates(row, capacity, degree);
+                    int worst = 0;
+                    for (int k = 1; k < degree; k++) {
+                        if (ranks_below(row[k].similarity, row[k].neighbor, row[worst].similarity, row[worst].neighbor)) {
+                            worst = k;
+                        }
+                    }
+                    thresholds[r] = row[worst];
+                    limited[r] = 1;
+                    lengths[r] = degree;
+                }
+            }
+        }
+    }
+
+    for (int r = 0; r < rows; r++) {
+        int i = first_row + r;
+        GraphCandidate* row = candidates + (size_t)r * capacity;
+        int length = lengths[r];
+        if (length > degree) {
+            select_best_candidates(row, length, degree);
+            length = degree;
+        }
+        qsort(row, length, sizeof(GraphCandidate), compare_candidates);
+        for (int k = 0; k < length; k++) {
+            build->neighbors[(size_t)i * degree + k] = row[k].neighbor;
+            build->similarities[(size_t)i * degree + k] = row[k].similarity;
+        }
+        build->lengths[i] = length;
+    }
+    free(candidates);
+    task->total = total;
+    task->pairs = pairs;
+}
+
+SimilarityGraph* build_similarity_graph(const double* vectors, const char* has_vector, int count, int dimensions,
+                                        int neighbors, int workers, double* average_similarity) {
+    if (average_similarity) *average_similarity = 0.0;
+    if (!vectors || !has_vector || count < 0 || neighbors < 1) return NULL;
+
+    SimilarityGraph* graph = calloc(1, sizeof(SimilarityGraph));
+    if (!graph) return NULL;
+    // No vector has more than count - 1 neighbours
+    if (neighbors >= count) neighbors = count > 1 ? count - 1 : 1;
+    graph->count = count;
+    graph->degree = neighbors;
+
+    size_t slots = (size_t)count * neighbors;
+    int task_count = (count + GRAPH_BLOCK - 1) / GRAPH_BLOCK;
+    GraphBuild build = { vectors, has_vector, count, dimensions, neighbors, NULL, NULL, NULL };
+    build.neighbors = malloc((slots > 0 ? slots : 1) * sizeof(int));
+    build.similarities = malloc((slots > 0 ? slots : 1) * sizeof(double));
+    build.lengths = calloc(count > 0 ? count : 1, sizeof(int));
+    graph->offsets = malloc(((size_t)count + 1) * sizeof(int));
+    GraphBlockTask* tasks = calloc(task_count > 0 ? task_count : 1, sizeof(GraphBlockTask));
+    if (!build.neighbors || !build.similarities || !build.lengths || !graph->offsets || !tasks) {
+        free(build.neighbors);
+        free(build.similarities);
+        free(build.lengths);
+        free(tasks);
+        free_similarity_graph(graph);
+        return NULL;
+    }
+
+    // Row blocks run on the pool (inline if it cannot be started or a task cannot be queued)
+    ThreadPool* pool = task_count > 1 ? create_thread_pool(workers) : NULL;
+    for (int t = 0; t < task_count; t++) {
+        tasks[t].build = &build;
+        tasks[t].first_row = t * GRAPH_BLOCK;
+        if (!pool || !submit_thread_pool_task(pool, build_graph_rows, &tasks[t])) {
+            build_graph_rows(&tasks[t]);
+        }
+    }
+    if (pool) {
+        wait_thread_pool(pool);
+        free_thread_pool(pool);
+    }
+
+    // Sum in block order so the average does not depend on scheduling
+    double total = 0.0;
+    long long pairs = 0;
+    int failed = 0;
+    for (int t = 0; t < task_count; t++) {
+        total += tasks[t].total;
+        pairs += tasks[t].pairs;
+        failed |= tasks[t].failed;
+    }
+    free(tasks);
+    if (failed) {
+        free(build.neighbors);
+        free(build.similarities);
+        free(build.lengths);
+        free_similarity_graph(graph);
+        return NULL;
+    }
+    if (average_similarity) *average_similarity = pairs > 0 ? total / pairs : 0.0;
+
+    // Pack the rows to the front (rows only move towards lower addresses)
+    graph->offsets[0] = 0;
+    for (int i = 0; i < count; i++) {
+        int length = build.lengths[i];
+        memmove(build.neighbors + graph->offsets[i], build.neighbors + (size_t)i * neighbors, length * sizeof(int));
+        memmove(build.similarities + graph->offsets[i], build.similarities + (size_t)i * neighbors,
+                length * sizeof(double));
+        graph->offsets[i + 1] = graph->offsets[i] + length;
+    }
+    free(build.lengths);
+
+    size_t entries = (size_t)graph->offsets[count];
+    int* packed_neighbors = realloc(build.neighbors, (entries > 0 ? entries : 1) * sizeof(int));
+    double* packed_similarities = realloc(build.similarities, (entries > 0 ? entries : 1) * sizeof(double));
+    graph->neighbors = packed_neighbors ? packed_neighbors : build.neighbors;
+    graph->similarities = packed_similarities ? packed_similarities : build.similarities;
+    return graph;
+}
+
+int get_similarity_graph_size(const SimilarityGraph* graph) {
+    return graph ? graph->count : 0;
+}
+
+int get_similarity_graph_degree(const SimilarityGraph* graph) {
+    return graph ? graph->degree : 0;
+}
+
+int get_graph_neighbors(const SimilarityGraph* graph, int node, const int** neighbors, const double** similarities) {
+    if (!graph || node < 0 || node >= graph->count) {
+        if (neighbors) *neighbors = NULL;
+        if (similarities) *similarities = NULL;
+        return 0;
+    }
+
+    int start = graph->offsets[node];
+    if (neighbors) *neighbors = graph->neighbors + start;
+    if (similarities) *similarities = graph->similarities + start;
+    return graph->offsets[node + 1] - start;
+}
+
+// Position of neighbor in node's row, or -1
+static int find_neighbor_entry(const SimilarityGraph* graph, int node, int neighbor) {
+    for (int entry = graph->offsets[node]; entry < graph->offsets[node + 1]; entry++) {
+        if (graph->neighbors[entry] == neighbor) return entry;
+    }
+    return -1;
+}
+
+int find_graph_similarity(const SimilarityGraph* graph, int i, int j, double* similarity) {
+    if (!graph || i < 0 || j < 0 || i >= graph->count || j >= graph->count || i == j) return 0;
+
+    int entry = find_neighbor_entry(graph, i, j);
+    if (entry < 0) entry = find_neighbor_entry(graph, j, i);
+    if (entry < 0) return 0;
+
+    if (similarity) *similarity = graph->similarities[entry];
+    return 1;
+}
+
+size_t get_similarity_graph_bytes(const SimilarityGraph* graph) {
+    if (!graph) return 0;
+    return ((size_t)graph->count + 1) * sizeof(int) +
+           (size_t)graph->offsets[graph->count] * (sizeof(int) + sizeof(double));
+}
+
+void free_similarity_graph(SimilarityGraph* graph) {
+    if (!graph) return;
+
+    free(graph->offsets);
+    free(graph->neighbors);
+    free(graph->similarities);
+    free(graph);
+}
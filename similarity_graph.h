@@ -0,0 +1,57 @@
+#ifndef SIMILARITY_GRAPH_H
+#define SIMILARITY_GRAPH_H
+
+#include <stddef.h>
+
+/**
+ * Sparse k-nearest-neighbour graph: for every vector, the (at most) k others it is
+ * most similar to, in compressed sparse row form. Memory is O(count * k) instead of
+ * the O(count^2) of a SimilarityMatrix; similarities are exact.
+ */
+typedef struct SimilarityGraph SimilarityGraph;
+
+/**
+ * Build the graph over count vectors stored back to back (vector i starts at
+ * vectors + i * dimensions). Every pair is compared; rows are split between workers
+ * and each row keeps its best neighbours in a bounded heap, so the result does not
+ * depend on the number of workers.
+ * @param has_vector has_vector[i] == 0 marks a missing vector (no neighbours, and
+ *        never a neighbour)
+ * @param neighbors k, the neighbours kept per vector
+ * @param workers Threads to use (values < 1 use one per CPU)
+ * @param average_similarity Receives the mean similarity over ordered pairs of
+ *        distinct vectors that both exist (may be NULL)
+ * @return New graph, or NULL on allocation failure or if neighbors < 1
+ */
+SimilarityGraph* build_similarity_graph(const double* vectors, const char* has_vector, int count, int dimensions,
+                                        int neighbors, int workers, double* average_similarity);
+
+int get_similarity_graph_size(const SimilarityGraph* graph);
+
+/**
+ * k (at most size - 1), the most neighbours stored for any vector
+ */
+int get_similarity_graph_degree(const SimilarityGraph* graph);
+
+/**
+ * Neighbours of vector node, most similar first (ties: lower index first)
+ * @param neighbors Receives the neighbour indices (may be NULL)
+ * @param similarities Receives their similarities (may be NULL)
+ * @return Number of neighbours
+ */
+int get_graph_neighbors(const SimilarityGraph* graph, int node, const int** neighbors, const double** similarities);
+
+/**
+ * Look up the similarity of vectors i and j (i != j) if either lists the other
+ * @return 1 if found (stored in *similarity), 0 if the pair is not in the graph
+ */
+int find_graph_similarity(const SimilarityGraph* graph, int i, int j, double* similarity);
+
+/**
+ * Bytes held by the graph's arrays
+ */
+size_t get_similarity_graph_bytes(const SimilarityGraph* graph);
+
+void free_similarity_graph(SimilarityGraph* graph);
+
+#endif
@@ -0,0 +1,556 @@
+#include "similarity_join.h"
+#include "similarity_kernels.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Rows/columns per tile of the all-pairs product; two 32 x 32 blocks of doubles stay in L1
+#define JOIN_BLOCK 32
+
+// Tasks per worker: row blocks are dealt out round-robin, so every task gets a similar
+// share of the triangle, and spare tasks absorb uneven progress
+#define JOIN_TASKS_PER_WORKER 4
+
+typedef struct {
+    const double* vectors;
+    const char* has_vector;
+    int count;
+    int dimensions;
+    int top_n;             // Pairs to keep (at most the number of pairs)
+    int block_count;
+    int task_count;
+} TopPairJoin;
+
+// Row blocks first_block, first_block + task_count, ... against every block at or
+// after them (the upper triangle)
+typedef struct {
+    const TopPairJoin* join;
+    int first_block;
+    SimilarityJoinPair* heap; // Best pairs of the task, least similar on top
+    int length;
+    int capacity;             // Grows up to top_n as pairs are kept
+    int failed;
+} TopPairTask;
+
+// 1 if a ranks below b: less similar, ties to the higher first, then second index
+static int pair_ranks_below(const SimilarityJoinPair* a, const SimilarityJoinPair* b) {
+    if (a->similarity != b->similarity) return a->similarity < b->similarity;
+    if (a->first != b->first) return a->first > b->first;
+    return a->second > b->second;
+}
+
+static void sift_down_pair(SimilarityJoinPair* heap, int length, int slot) {
+    for (;;) {
+        int worst = slot;
+        int left = 2 * slot + 1;
+        int right = left + 1;
+        if (left < length && pair_ranks_below(&heap[left], &heap[worst])) worst = left;
+        if (right < length && pair_ranks_below(&heap[right], &heap[worst])) worst = right;
+        if (worst == slot) return;
+
+        SimilarityJoinPair swap = heap[slot];
+        heap[slot] = heap[worst];
+        heap[worst] = swap;
+        slot = worst;
+    }
+}
+
+static void offer_pair(TopPairTask* task, int first, int second, double similarity) {
+    SimilarityJoinPair pair = { first, second, similarity };
+    if (task->length == task->capacity && task->capacity < task->join->top_n) {
+        int capacity = task->capacity * 2 < task->join->top_n ? task->capacity * 2 : task->join->top_n;
+        SimilarityJoinPair* heap = realloc(task->heap, (size_t)capacity * sizeof(SimilarityJoinPair));
+        if (!heap) {
+            task->failed = 1;
+            return;
+        }
+        task->heap = heap;
+        task->capacity = capacity;
+    }
+
+    SimilarityJoinPair* heap = task->heap;
+    if (task->length < task->join->top_n) {
+        int slot = task->length++;
+        while (slot > 0 && pair_ranks_below(&pair, &heap[(slot - 1) / 2])) {
+            heap[slot] = heap[(slot - 1) / 2];
+            slot = (slot - 1) / 2;
+        }
+        heap[slot] = pair;
+    } else if (pair_ranks_below(&heap[0], &pair)) {
+        heap[0] = pair;
+        sift_down_pair(heap, task->length, 0);
+    }
+}
+
+static void join_top_pairs(void* argument) {
+    TopPairTask* task = (TopPairTask*)argument;
+    const TopPairJoin* join = task->join;
+    double tile[JOIN_BLOCK * JOIN_BLOCK];
+
+    task->capacity = join->top_n < 1024 ? join->top_n : 1024;
+    task->heap = malloc((size_t)task->capacity * sizeof(SimilarityJoinPair));
+    if (!task->heap) {
+        task->failed = 1;
+        return;
+    }
+
+    for (int row_block = task->first_block; row_block < join->block_count; row_block += join->task_count) {
+        int first_row = row_block * JOIN_BLOCK;
+        int rows = join->count - first_row < JOIN_BLOCK ? join->count - first_row : JOIN_BLOCK;
+        for (int column_block = row_block; column_block < join->block_count; column_block++) {
+            int first_column = column_block * JOIN_BLOCK;
+            int columns = join->count - first_column < JOIN_BLOCK ? join->count - first_column : JOIN_BLOCK;
+            similarity_dot_block(join->vectors + (size_t)first_row * join->dimensions, rows,
+                                 join->vectors + (size_t)first_column * join->dimensions, columns,
+                                 join->dimensions, tile, JOIN_BLOCK);
+
+            for (int r = 0; r < rows; r++) {
+                int i = first_row + r;
+                if (!join->has_vector[i]) continue;
+                for (int c = column_block == row_block ? r + 1 : 0; c < columns; c++) {
+                    int j = first_column + c;
+                    double similarity = tile[r * JOIN_BLOCK + c];
+                    // Most pairs lose to the worst kept pair without touching the heap
+                    if (!join->has_vector[j] || (task->length == join->top_n && similarity < task->heap[0].similarity)) {
+                        continue;
+                    }
+                    offer_pair(task, i, j, similarity);
+                    if (task->failed) return;
+                }
+            }
+        }
+    }
+}
+
+// qsort order: most similar first
+static int compare_pairs(const void* a, const void* b) {
+    const SimilarityJoinPair* first = (const SimilarityJoinPair*)a;
+    const SimilarityJoinPair* second = (const SimilarityJoinPair*)b;
+    if (pair_ranks_below(second, first)) return -1;
+    if (pair_ranks_below(first, second)) return 1;
+    return 0;
+}
+
+int find_top_similar_pairs(const double* vectors, const char* has_vector, int count, int dimensions, int top_n,
+                           int workers, SimilarityJoinPair* results) {
+    if (!vectors || !has_vector || !results || count < 0 || dimensions < 1) return -1;
+
+    long long pair_count = (long long)count * (count - 1) / 2;
+    if (top_n > pair_count) top_n = (int)pair_count;
+    if (top_n < 1) return 0;
+
+    TopPairJoin join = { vectors, has_vector, count, dimensions, top_n, (count + JOIN_BLOCK - 1) / JOIN_BLOCK, 1 };
+    ThreadPool* pool = join.block_count > 1 ? create_thread_pool(workers) : NULL;
+    if (pool) join.task_count = get_thread_pool_size(pool) * JOIN_TASKS_PER_WORKER;
+    if (join.task_count > join.block_count) join.task_count = join.block_count;
+
+    TopPairTask* tasks = calloc(join.task_count, sizeof(TopPairTask));
+    if (!tasks) {
+        free_thread_pool(pool);
+        return -1;
+    }
+    // Tasks run on the pool (inline if it cannot be started or a task cannot be queued)
+    for (int t = 0; t < join.task_count; t++) {
+        tasks[t].join = &join;
+        tasks[t].first_block = t;
+        if (!pool || !submit_thread_pool_task(pool, join_top_pairs, &tasks[t])) {
+            join_top_pairs(&tasks[t]);
+        }
+    }
+    if (pool) {
+        wait_thread_pool(pool);
+        free_thread_pool(pool);
+    }
+
+    // Merge: every global top pair is in the heap of the task that saw it
+    size_t total = 0;
+    int failed = 0;
+    for (int t = 0; t < join.task_count; t++) {
+        total += (size_t)tasks[t].length;
+        failed |= tasks[t].failed;
+    }
+    SimilarityJoinPair* merged = failed ? NULL : malloc((total > 0 ? total : 1) * sizeof(SimilarityJoinPair));
+    size_t length = 0;
+    for (int t = 0; t < join.task_count; t++) {
+        if (merged) {
+            memcpy(merged + length, tasks[t].heap, (size_t)tasks[t].length * sizeof(SimilarityJoinPair));
+            length += (size_t)tasks[t].length;
+        }
+        free(tasks[t].heap);
+    }
+    free(tasks);
+    if (!merged) return -1;
+
+    qsort(merged, length, sizeof(SimilarityJoinPair), compare_pairs);
+    int found = length < (size_t)top_n ? (int)length : top_n;
+    memcpy(results, merged, (size_t)found * sizeof(SimilarityJoinPair));
+    free(merged);
+    return found;
+}
+
+// Vectors per leaf ball of the threshold join: small balls are tight, and the ball
+// tree above them keeps the number of ball pairs tested low
+#define JOIN_BALL 8
+
+// Leaf balls per threshold join task
+#define JOIN_TASK_BALLS 32
+
+// Added to every angular bound: acos() of a rounded dot product may be off by about
+// 1e-8 near similarity 1, and pruning must never drop a true match
+#define ANGLE_SLACK 1e-6
+
+#define JOIN_PI 3.14159265358979323846
+
+// Node of the ball tree: a contiguous run of the reordered vectors
+typedef struct {
+    int begin;             // Positions [begin, end)
+    int end;
+    int children[2];       // -1 for a leaf ball
+    double radius;         // Largest angle between the centroid and a member
+    double cos_radius;
+    double sin_radius;
+} JoinNode;
+
+typedef struct {
+    const double* ordered; // Present vectors in ball tree order
+    const int* ids;        // Caller's index of each ordered vector
+    const JoinNode* nodes; // Root first
+    const double* centroids; // Unit mean direction of each node
+    const int* leaves;     // Leaf nodes in position order
+    int leaf_count;
+    int dimensions;
+    double min_similarity;
+    double max_angle;      // Largest angle between the vectors of a result pair, plus the slack
+} ThresholdJoin;
+
+// Pairs of leaves [first_leaf, end_leaf) with themselves and every later leaf
+typedef struct {
+    const ThresholdJoin* join;
+    int first_leaf;
+    int end_leaf;
+    SimilarityJoinPair* pairs;
+    int length;
+    int capacity;
+    long long candidates;
+    int failed;
+} ThresholdTask;
+
+static double angle_between(double similarity) {
+    if (similarity >= 1.0) return 0.0;
+    if (similarity <= -1.0) return acos(-1.0);
+    return acos(similarity);
+}
+
+/*
+ * Whether every member of node is more than angle radians from a vector with the given
+ * similarity to the node's centroid, i.e. acos(similarity) - radius > angle. Compared
+ * in cosine space, as similarity < cos(angle + radius), so the hot loops need no acos().
+ */
+static int beyond_node(double similarity, double angle, double cos_angle, double sin_angle, const JoinNode* node) {
+    if (angle + node->radius >= JOIN_PI) return 0;
+    return similarity < cos_angle * node->cos_radius - sin_angle * node->sin_radius;
+}
+
+static int add_result_pair(ThresholdTask* task, int first, int second, double similarity) {
+    if (task->length == task->capacity) {
+        int capacity = task->capacity > 0 ? task->capacity * 2 : 64;
+        SimilarityJoinPair* pairs = realloc(task->pairs, (size_t)capacity * sizeof(SimilarityJoinPair));
+        if (!pairs) return 0;
+        task->pairs = pairs;
+        task->capacity = capacity;
+    }
+    SimilarityJoinPair* pair = &task->pairs[task->length++];
+    pair->first = first < second ? first : second;
+    pair->second = first < second ? second : first;
+    pair->similarity = similarity;
+    return 1;
+}
+
+// Score the pairs of leaf ball with other (a later leaf, or itself); 0 on allocation failure
+static int join_leaf_pair(ThresholdTask* task, const JoinNode* ball, const JoinNode* other, const double* other_centroid) {
+    const ThresholdJoin* join = task->join;
+    int dimensions = join->dimensions;
+    int same = ball == other;
+    double cos_angle = cos(join->max_angle);
+    double sin_angle = sin(join->max_angle);
+    double scores[JOIN_BALL];
+
+    for (int position = ball->begin; position < ball->end; position++) {
+        const double* vector = join->ordered + (size_t)position * dimensions;
+        if (!same && beyond_node(similarity_dot(vector, other_centroid, dimensions), join->max_angle, cos_angle,
+                                 sin_angle, other)) {
+            continue;
+        }
+
+        int first_column = same ? position + 1 : other->begin;
+        int columns = other->end - first_column;
+        if (columns <= 0) continue;
+        similarity_dot_many(vector, join->ordered + (size_t)first_column * dimensions, columns, dimensions, scores);
+        task->candidates += columns;
+        for (int c = 0; c < columns; c++) {
+            if (scores[c] >= join->min_similarity &&
+                !add_result_pair(task, join->ids[position], join->ids[first_column + c], scores[c])) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * Each leaf ball walks the tree from the root. A node is skipped when it lies wholly
+ * before the ball (those pairs belong to an earlier ball) or when no two members can
+ * be closer than the centroids' angle minus both radii allows.
+ */
+static void join_ball_pairs(void* argument) {
+    ThresholdTask* task = (ThresholdTask*)argument;
+    const ThresholdJoin* join = task->join;
+    int dimensions = join->dimensions;
+    int stack[256];        // Depth is bounded by split_into_ball_tree()
+
+    for (int leaf = task->first_leaf; leaf < task->end_leaf; leaf++) {
+        const JoinNode* ball = &join->nodes[join->leaves[leaf]];
+        const double* centroid = join->centroids + (size_t)join->leaves[leaf] * dimensions;
+        double angle = join->max_angle + ball->radius;
+        double cos_angle = cos(angle);
+        double sin_angle = sin(angle);
+        int depth = 0;
+        stack[depth++] = 0;
+        while (depth > 0) {
+            int index = stack[--depth];
+            const JoinNode* node = &join->nodes[index];
+            if (node->end <= ball->begin) continue;
+            const double* node_centroid = join->centroids + (size_t)index * dimensions;
+            if (beyond_node(similarity_dot(centroid, node_centroid, dimensions), angle, cos_angle, sin_angle, node)) {
+                continue;
+            }
+
+            if (node->children[0] < 0) {
+                if (!join_leaf_pair(task, ball, node, node_centroid)) {
+                    task->failed = 1;
+                    return;
+                }
+            } else {
+                stack[depth++] = node->children[1];
+                stack[depth++] = node->children[0];
+            }
+        }
+    }
+}
+
+// Reorder ids[begin, end) with their margins so the nth smallest margin is at nth,
+// no larger margin before it and no smaller one after it
+static void select_by_margin(int* ids, double* margins, int begin, int end, int nth) {
+    while (end - begin > 1) {
+        double pivot = margins[begin + (end - begin) / 2];
+        int i = begin;
+        int j = end - 1;
+        while (i <= j) {
+            while (margins[i] < pivot) i++;
+            while (margins[j] > pivot) j--;
+            if (i <= j) {
+                double margin = margins[i];
+                margins[i] = margins[j];
+                margins[j] = margin;
+                int id = ids[i];
+                ids[i++] = ids[j];
+                ids[j--] = id;
+            }
+        }
+        if (nth <= j) {
+            end = j + 1;
+        } else if (nth >= i) {
+            begin = i;
+        } else {
+            return;
+        }
+    }
+}
+
+/*
+ * Build a ball tree over ids[0, count), reordering ids so every node is a contiguous
+ * run. A node is split by whether each vector is more similar to one or the other of
+ * two far-apart members (the one least similar to its first vector, and the one least
+ * similar to that). A split leaving less than a quarter on one side is moved to the
+ * median, so the depth stays below 2.5 log2(count).
+ * @param margins Scratch for count values
+ * @return Number of nodes written to nodes (capacity 2 * count)
+ */
+static int split_into_ball_tree(const double* vectors, int* ids, double* margins, int count, int dimensions,
+                                JoinNode* nodes) {
+    if (count == 0) return 0;
+
+    int node_count = 1;
+    nodes[0].begin = 0;
+    nodes[0].end = count;
+    for (int index = 0; index < node_count; index++) {
+        JoinNode* node = &nodes[index];
+        node->children[0] = node->children[1] = -1;
+        int size = node->end - node->begin;
+        if (size <= JOIN_BALL) continue;
+
+        int pivots[2] = { ids[node->begin], ids[node->begin] };
+        for (int p = 0; p < 2; p++) {
+            const double* from = vectors + (size_t)(p == 0 ? ids[node->begin] : pivots[0]) * dimensions;
+            double lowest = 2.0;
+            for (int i = node->begin; i < node->end; i++) {
+                double similarity = similarity_dot(from, vectors + (size_t)ids[i] * dimensions, dimensions);
+                if (similarity < lowest) {
+                    lowest = similarity;
+                    pivots[p] = ids[i];
+                }
+            }
+        }
+
+        // Margin: how much more similar a vector is to the second pivot than to the first
+        const double* first_pivot = vectors + (size_t)pivots[0] * dimensions;
+        const double* second_pivot = vectors + (size_t)pivots[1] * dimensions;
+        int middle = node->begin;
+        for (int i = node->begin; i < node->end; i++) {
+            const double* vector = vectors + (size_t)ids[i] * dimensions;
+            margins[i] = similarity_dot(vector, second_pivot, dimensions) - similarity_dot(vector, first_pivot, dimensions);
+            if (margins[i] <= 0.0) middle++;
+        }
+        if (middle - node->begin < size / 4 || node->end - middle < size / 4) middle = node->begin + size / 2;
+        select_by_margin(ids, margins, node->begin, node->end, middle);
+
+        for (int c = 0; c < 2; c++) {
+            node->children[c] = node_count;
+            nodes[node_count].begin = c == 0 ? node->begin : middle;
+            nodes[node_count].end = c == 0 ? middle : node->end;
+            node_count++;
+        }
+    }
+    return node_count;
+}
+
+// Unit mean direction of a node (its first vector if the mean is near zero) and the
+// largest angle from it to a member
+static void measure_node(const double* ordered, JoinNode* node, int dimensions, double* centroid) {
+    memset(centroid, 0, (size_t)dimensions * sizeof(double));
+    for (int position = node->begin; position < node->end; position++) {
+        const double* vector = ordered + (size_t)position * dimensions;
+        for (int d = 0; d < dimensions; d++) centroid[d] += vector[d];
+    }
+    double norm = sqrt(similarity_dot(centroid, centroid, dimensions));
+    if (norm > 1e-6) {
+        for (int d = 0; d < dimensions; d++) centroid[d] /= norm;
+    } else {
+        memcpy(centroid, ordered + (size_t)node->begin * dimensions, (size_t)dimensions * sizeof(double));
+    }
+
+    node->radius = 0.0;
+    for (int position = node->begin; position < node->end; position++) {
+        double angle = angle_between(similarity_dot(centroid, ordered + (size_t)position * dimensions, dimensions));
+        if (angle > node->radius) node->radius = angle;
+    }
+    node->cos_radius = cos(node->radius);
+    node->sin_radius = sin(node->radius);
+}
+
+// Leaf nodes in position order, by a depth-first walk; returns their number
+static int collect_leaves(const JoinNode* nodes, int node_count, int* leaves) {
+    if (node_count == 0) return 0;
+
+    int stack[256];
+    int depth = 0;
+    int leaf_count = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const JoinNode* node = &nodes[stack[--depth]];
+        if (node->children[0] < 0) {
+            leaves[leaf_count++] = (int)(node - nodes);
+        } else {
+            stack[depth++] = node->children[1];
+            stack[depth++] = node->children[0];
+        }
+    }
+    return leaf_count;
+}
+
+int join_similar_pairs(const double* vectors, const char* has_vector, int count, int dimensions,
+                       double min_similarity, int workers, similarity_pair_callback callback, void* context,
+                       SimilarityJoinStats* stats) {
+    SimilarityJoinStats counts = { 0, 0, 0 };
+    if (stats) *stats = counts;
+    if (!vectors || !has_vector || count < 0 || dimensions < 1) return 0;
+
+    int present = 0;
+    for (int i = 0; i < count; i++) present += has_vector[i] != 0;
+    counts.total_pairs = (long long)present * (present - 1) / 2;
+
+    size_t slots = present > 0 ? (size_t)present : 1;
+    int* ids = malloc(slots * sizeof(int));
+    double* margins = malloc(slots * sizeof(double));
+    double* ordered = malloc(slots * dimensions * sizeof(double));
+    JoinNode* nodes = malloc(2 * slots * sizeof(JoinNode));
+    double* centroids = malloc(2 * slots * dimensions * sizeof(double));
+    int* leaves = malloc(slots * sizeof(int));
+    int failed = !ids || !margins || !ordered || !nodes || !centroids || !leaves;
+
+    int node_count = 0;
+    int leaf_count = 0;
+    if (!failed) {
+        for (int i = 0, position = 0; i < count; i++) {
+            if (has_vector[i]) ids[position++] = i;
+        }
+        node_count = split_into_ball_tree(vectors, ids, margins, present, dimensions, nodes);
+        for (int position = 0; position < present; position++) {
+            memcpy(ordered + (size_t)position * dimensions, vectors + (size_t)ids[position] * dimensions,
+                   (size_t)dimensions * sizeof(double));
+        }
+        for (int index = 0; index < node_count; index++) {
+            measure_node(ordered, &nodes[index], dimensions, centroids + (size_t)index * dimensions);
+        }
+        leaf_count = collect_leaves(nodes, node_count, leaves);
+    }
+    free(margins);
+
+    ThresholdJoin join = { ordered, ids, nodes, centroids, leaves, leaf_count, dimensions, min_similarity,
+                           min_similarity <= -1.0 ? JOIN_PI : angle_between(min_similarity) + ANGLE_SLACK };
+
+    // Leaves are joined in batches of tasks; each batch's pairs are passed to the
+    // callback on this thread before the next batch starts, which keeps buffered pairs
+    // bounded
+    int task_total = (leaf_count + JOIN_TASK_BALLS - 1) / JOIN_TASK_BALLS;
+    ThreadPool* pool = !failed && task_total > 1 ? create_thread_pool(workers) : NULL;
+    int batch = pool ? get_thread_pool_size(pool) * JOIN_TASKS_PER_WORKER : 1;
+    ThresholdTask* tasks = failed ? NULL : calloc(batch, sizeof(ThresholdTask));
+    failed |= tasks == NULL;
+    int stopped = 0;
+    for (int first = 0; first < task_total && !failed && !stopped; first += batch) {
+        int task_count = task_total - first < batch ? task_total - first : batch;
+        for (int t = 0; t < task_count; t++) {
+            memset(&tasks[t], 0, sizeof(ThresholdTask));
+            tasks[t].join = &join;
+            tasks[t].first_leaf = (first + t) * JOIN_TASK_BALLS;
+            tasks[t].end_leaf = tasks[t].first_leaf + JOIN_TASK_BALLS < leaf_count ?
+                                tasks[t].first_leaf + JOIN_TASK_BALLS : leaf_count;
+            if (!pool || !submit_thread_pool_task(pool, join_ball_pairs, &tasks[t])) {
+                join_ball_pairs(&tasks[t]);
+            }
+        }
+        if (pool) wait_thread_pool(pool);
+
+        for (int t = 0; t < task_count; t++) {
+            failed |= tasks[t].failed;
+            counts.candidate_pairs += tasks[t].candidates;
+            for (int p = 0; p < tasks[t].length && !failed && !stopped; p++) {
+                counts.result_pairs++;
+                if (callback && callback(&tasks[t].pairs[p], context)) stopped = 1;
+            }
+            free(tasks[t].pairs);
+        }
+    }
+    free_thread_pool(pool);
+    free(tasks);
+    free(leaves);
+    free(centroids);
+    free(nodes);
+    free(ordered);
+    free(ids);
+
+    if (stats) *stats = counts;
+    return !failed;
+}
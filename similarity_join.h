@@ -0,0 +1,65 @@
+#ifndef SIMILARITY_JOIN_H
+#define SIMILARITY_JOIN_H
+
+/**
+ * Joins over all pairs of a set of unit-length vectors stored back to back (vector i
+ * starts at vectors + i * dimensions). Pairs are computed a tile at a time and never
+ * stored as a whole.
+ */
+
+/**
+ * A pair of vectors, first < second
+ */
+typedef struct {
+    int first;
+    int second;
+    double similarity;
+} SimilarityJoinPair;
+
+/**
+ * The top_n most similar pairs of distinct vectors, most similar first (ties go to the
+ * lower first, then the lower second index). Row blocks are split between workers,
+ * each keeping its best pairs in a bounded heap; the heaps are merged at the end, so
+ * the result does not depend on the number of workers.
+ * @param has_vector has_vector[i] == 0 leaves vector i out
+ * @param workers Threads to use (values < 1 use one per CPU)
+ * @param results Array of top_n pairs
+ * @return Number of pairs (fewer than top_n only if there are fewer pairs), or -1 on
+ *         allocation failure
+ */
+int find_top_similar_pairs(const double* vectors, const char* has_vector, int count, int dimensions, int top_n,
+                           int workers, SimilarityJoinPair* results);
+
+/**
+ * Called for each pair found by join_similar_pairs(), on the calling thread
+ * @return Nonzero to stop the join
+ */
+typedef int (*similarity_pair_callback)(const SimilarityJoinPair* pair, void* context);
+
+/**
+ * How much of the all-pairs product a threshold join computed
+ */
+typedef struct {
+    long long total_pairs;      // Pairs of distinct present vectors
+    long long candidate_pairs;  // Pairs whose similarity was computed (the rest were pruned)
+    long long result_pairs;     // Pairs passed to the callback
+} SimilarityJoinStats;
+
+/**
+ * Every pair of distinct vectors with similarity >= min_similarity, passed to callback
+ * in no particular order. The vectors are split into a tree of balls (angular centroid
+ * and radius) down to leaves of a few vectors; every leaf walks the tree, skipping the
+ * subtrees, and then the single vectors, that the triangle inequality on angles puts
+ * below the threshold, and scores the remaining candidates exactly. Leaves are joined
+ * in parallel.
+ * @param has_vector has_vector[i] == 0 leaves vector i out
+ * @param workers Threads to use (values < 1 use one per CPU)
+ * @param stats Receives the pair counts (may be NULL); candidate_pairs / total_pairs is
+ *        the share of the product that survived pruning
+ * @return 1 if the join ran to the end or was stopped by the callback, 0 on allocation failure
+ */
+int join_similar_pairs(const double* vectors, const char* has_vector, int count, int dimensions,
+                       double min_similarity, int workers, similarity_pair_callback callback, void* context,
+                       SimilarityJoinStats* stats);
+
+#endif
@@ -0,0 +1,667 @@
+#include "similarity_kernels.h"
+#include "semantic_fingerprint.h"
+#include <stddef.h>
+
+/*
+ * Results must not depend on the selected kernel, so products and sums are kept as
+ * separate roundings (no fused multiply-add contraction) in every implementation.
+ */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMILARITY_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MinGW gcc does not align the stack for spilled 256/512-bit registers, so only
+// the SSE2 kernel is used there
+#if defined(SIMILARITY_X86) && !(defined(_WIN32) && defined(__GNUC__) && !defined(__clang__))
+#define SIMILARITY_WIDE_VECTORS 1
+#endif
+
+#if defined(__GNUC__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+typedef struct {
+    const char* name;
+    double (*dot)(const double* a, const double* b, int dimensions);
+    void (*dot_many)(const double* query, const double* rows, int count, int dimensions, double* results);
+    void (*dot_block)(const double* rows, int row_count, const double* columns, int column_count,
+                      int dimensions, double* results, size_t result_stride);
+    float (*dot_float)(const float* a, const float* b, int dimensions);
+    void (*dot_float_many)(const float* query, const float* rows, int count, int dimensions, float* results);
+    int (*dot_int8)(const signed char* a, const signed char* b, int dimensions);
+    void (*dot_int8_many)(const signed char* query, const signed char* rows, int count, int dimensions, int* results);
+} SimilarityKernel;
+
+/*
+ * Row loops shared by every kernel: the FINGERPRINT_DIMENSIONS case is written out
+ * separately so the inlined dot product is specialized for the usual width.
+ */
+#define DEFINE_DOT_MANY(target, name, dot, type, result_type)                                          \
+    target static void name(const type* query, const type* rows, int count, int dimensions,          \
+                            result_type* results) {                                                    \
+        if (dimensions == FINGERPRINT_DIMENSIONS) {                                                    \
+            for (int r = 0; r < count; r++) {                                                          \
+                results[r] = dot(query, rows + (size_t)r * FINGERPRINT_DIMENSIONS, FINGERPRINT_DIMENSIONS); \
+            }                                                                                          \
+            return;                                                                                    \
+        }                                                                                              \
+        for (int r = 0; r < count; r++) {                                                              \
+            results[r] = dot(query, rows + (size_t)r * dimensions, dimensions);                        \
+        }                                                                                              \
+    }
+
+/* ---------- Scalar reference ---------- */
+
+// Fixed reduction of the eight partial sums (lane k holds elements i with i % 8 == k)
+static double reduce_partial_sums(const double* acc) {
+    double t0 = acc[0] + acc[4];
+    double t1 = acc[1] + acc[5];
+    double t2 = acc[2] + acc[6];
+    double t3 = acc[3] + acc[7];
+    return (t0 + t2) + (t1 + t3);
+}
+
+double similarity_dot_scalar(const double* a, const double* b, int dimensions) {
+    double acc[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    int i = 0;
+    for (; i + 8 <= dimensions; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            acc[k] += a[i + k] * b[i + k];
+        }
+    }
+
+    double sum = reduce_partial_sums(acc);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Fixed reduction of sixteen float partial sums: lanes k and k + 8 first, then as above
+static float reduce_float_partial_sums(const float* acc) {
+    float t[8];
+    for (int k = 0; k < 8; k++) {
+        t[k] = acc[k] + acc[k + 8];
+    }
+    float u0 = t[0] + t[4];
+    float u1 = t[1] + t[5];
+    float u2 = t[2] + t[6];
+    float u3 = t[3] + t[7];
+    return (u0 + u2) + (u1 + u3);
+}
+
+float similarity_dot_float_scalar(const float* a, const float* b, int dimensions) {
+    float acc[16];
+    for (int k = 0; k < 16; k++) acc[k] = 0.0f;
+    int i = 0;
+    for (; i + 16 <= dimensions; i += 16) {
+        for (int k = 0; k < 16; k++) {
+            acc[k] += a[i + k] * b[i + k];
+        }
+    }
+
+    float sum = reduce_float_partial_sums(acc);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+int similarity_dot_int8_scalar(const signed char* a, const signed char* b, int dimensions) {
+    int sum = 0;
+    for (int i = 0; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+DEFINE_DOT_MANY(, dot_many_scalar, similarity_dot_scalar, double, double)
+
+static void dot_block_scalar(const double* rows, int row_count, const double* columns, int column_count,
+                             int dimensions, double* results, size_t result_stride) {
+    for (int r = 0; r < row_count; r++) {
+        dot_many_scalar(rows + (size_t)r * dimensions, columns, column_count, dimensions, results + (size_t)r * result_stride);
+    }
+}
+DEFINE_DOT_MANY(, dot_float_many_scalar, similarity_dot_float_scalar, float, float)
+DEFINE_DOT_MANY(, dot_int8_many_scalar, similarity_dot_int8_scalar, signed char, int)
+
+#ifdef SIMILARITY_X86
+
+/* ---------- SSE2: four 2-lane accumulators ---------- */
+
+KERNEL_TARGET("sse2")
+static inline double reduce_sse2(__m128d acc01, __m128d acc23, __m128d acc45, __m128d acc67) {
+    __m128d t01 = _mm_add_pd(acc01, acc45);          // (t0, t1)
+    __m128d t23 = _mm_add_pd(acc23, acc67);          // (t2, t3)
+    __m128d u = _mm_add_pd(t01, t23);                // (t0 + t2, t1 + t3)
+    return _mm_cvtsd_f64(_mm_add_sd(u, _mm_unpackhi_pd(u, u)));
+}
+
+KERNEL_TARGET("sse2")
+static inline double dot_sse2(const double* a, const double* b, int dimensions) {
+    __m128d acc01 = _mm_setzero_pd();
+    __m128d acc23 = _mm_setzero_pd();
+    __m128d acc45 = _mm_setzero_pd();
+    __m128d acc67 = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= dimensions; i += 8) {
+        acc01 = _mm_add_pd(acc01, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc23 = _mm_add_pd(acc23, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        acc45 = _mm_add_pd(acc45, _mm_mul_pd(_mm_loadu_pd(a + i + 4), _mm_loadu_pd(b + i + 4)));
+        acc67 = _mm_add_pd(acc67, _mm_mul_pd(_mm_loadu_pd(a + i + 6), _mm_loadu_pd(b + i + 6)));
+    }
+
+    double sum = reduce_sse2(acc01, acc23, acc45, acc67);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("sse2")
+static double dot_sse2_entry(const double* a, const double* b, int dimensions) {
+    return dot_sse2(a, b, dimensions);
+}
+
+KERNEL_TARGET("sse2")
+static inline float dot_float_sse2(const float* a, const float* b, int dimensions) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= dimensions; i += 16) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+
+    __m128 t = _mm_add_ps(_mm_add_ps(acc0, acc2), _mm_add_ps(acc1, acc3)); // (t0..t3)
+    __m128 u = _mm_add_ps(t, _mm_movehl_ps(t, t));                          // (t0 + t2, t1 + t3)
+    float sum = _mm_cvtss_f32(_mm_add_ss(u, _mm_shuffle_ps(u, u, 1)));
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("sse2")
+static inline int dot_int8_sse2(const signed char* a, const signed char* b, int dimensions) {
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= dimensions; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        // Sign-extend to 16 bits by placing each byte in the high half and shifting back
+        __m128i x_low = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        __m128i x_high = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        __m128i y_low = _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8);
+        __m128i y_high = _mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(x_low, y_low));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(x_high, y_high));
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    int sum = _mm_cvtsi128_si32(acc);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("sse2")
+static float dot_float_sse2_entry(const float* a, const float* b, int dimensions) {
+    return dot_float_sse2(a, b, dimensions);
+}
+
+KERNEL_TARGET("sse2")
+static int dot_int8_sse2_entry(const signed char* a, const signed char* b, int dimensions) {
+    return dot_int8_sse2(a, b, dimensions);
+}
+
+DEFINE_DOT_MANY(KERNEL_TARGET("sse2"), dot_many_sse2, dot_sse2, double, double)
+
+// Two rows per column pass: each column chunk is loaded once for both rows
+KERNEL_TARGET("sse2")
+static void dot_block_sse2(const double* rows, int row_count, const double* columns, int column_count,
+                           int dimensions, double* results, size_t result_stride) {
+    int r = 0;
+    if (dimensions % 8 == 0) {
+        for (; r + 2 <= row_count; r += 2) {
+            const double* a = rows + (size_t)r * dimensions;
+            const double* b = a + dimensions;
+            double* out = results + (size_t)r * result_stride;
+            for (int c = 0; c < column_count; c++) {
+                const double* y = columns + (size_t)c * dimensions;
+                __m128d a01 = _mm_setzero_pd(), a23 = _mm_setzero_pd(), a45 = _mm_setzero_pd(), a67 = _mm_setzero_pd();
+                __m128d b01 = _mm_setzero_pd(), b23 = _mm_setzero_pd(), b45 = _mm_setzero_pd(), b67 = _mm_setzero_pd();
+                for (int i = 0; i < dimensions; i += 8) {
+                    __m128d y01 = _mm_loadu_pd(y + i);
+                    __m128d y23 = _mm_loadu_pd(y + i + 2);
+                    __m128d y45 = _mm_loadu_pd(y + i + 4);
+                    __m128d y67 = _mm_loadu_pd(y + i + 6);
+                    a01 = _mm_add_pd(a01, _mm_mul_pd(_mm_loadu_pd(a + i), y01));
+                    a23 = _mm_add_pd(a23, _mm_mul_pd(_mm_loadu_pd(a + i + 2), y23));
+                    a45 = _mm_add_pd(a45, _mm_mul_pd(_mm_loadu_pd(a + i + 4), y45));
+                    a67 = _mm_add_pd(a67, _mm_mul_pd(_mm_loadu_pd(a + i + 6), y67));
+                    b01 = _mm_add_pd(b01, _mm_mul_pd(_mm_loadu_pd(b + i), y01));
+                    b23 = _mm_add_pd(b23, _mm_mul_pd(_mm_loadu_pd(b + i + 2), y23));
+                    b45 = _mm_add_pd(b45, _mm_mul_pd(_mm_loadu_pd(b + i + 4), y45));
+                    b67 = _mm_add_pd(b67, _mm_mul_pd(_mm_loadu_pd(b + i + 6), y67));
+                }
+                out[c] = reduce_sse2(a01, a23, a45, a67);
+                out[result_stride + c] = reduce_sse2(b01, b23, b45, b67);
+            }
+        }
+    }
+    for (; r < row_count; r++) {
+        dot_many_sse2(rows + (size_t)r * dimensions, columns, column_count, dimensions, results + (size_t)r * result_stride);
+    }
+}
+DEFINE_DOT_MANY(KERNEL_TARGET("sse2"), dot_float_many_sse2, dot_float_sse2, float, float)
+DEFINE_DOT_MANY(KERNEL_TARGET("sse2"), dot_int8_many_sse2, dot_int8_sse2, signed char, int)
+
+#ifdef SIMILARITY_WIDE_VECTORS
+
+/* ---------- AVX2: two 4-lane accumulators ---------- */
+
+KERNEL_TARGET("avx2")
+static inline double reduce_avx2(__m256d acc0123, __m256d acc4567) {
+    __m256d t = _mm256_add_pd(acc0123, acc4567);                                 // (t0, t1, t2, t3)
+    __m128d u = _mm_add_pd(_mm256_castpd256_pd128(t), _mm256_extractf128_pd(t, 1)); // (t0 + t2, t1 + t3)
+    return _mm_cvtsd_f64(_mm_add_sd(u, _mm_unpackhi_pd(u, u)));
+}
+
+KERNEL_TARGET("avx2")
+static inline double dot_avx2(const double* a, const double* b, int dimensions) {
+    __m256d acc0123 = _mm256_setzero_pd();
+    __m256d acc4567 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= dimensions; i += 8) {
+        acc0123 = _mm256_add_pd(acc0123, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc4567 = _mm256_add_pd(acc4567, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+
+    double sum = reduce_avx2(acc0123, acc4567);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("avx2")
+static double dot_avx2_entry(const double* a, const double* b, int dimensions) {
+    return dot_avx2(a, b, dimensions);
+}
+
+KERNEL_TARGET("avx2")
+static inline float dot_float_avx2(const float* a, const float* b, int dimensions) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= dimensions; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+
+    __m256 s = _mm256_add_ps(acc0, acc1);                                            // lanes k + (k + 8)
+    __m128 t = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)); // (t0..t3)
+    __m128 u = _mm_add_ps(t, _mm_movehl_ps(t, t));
+    float sum = _mm_cvtss_f32(_mm_add_ss(u, _mm_shuffle_ps(u, u, 1)));
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("avx2")
+static inline int dot_int8_avx2(const signed char* a, const signed char* b, int dimensions) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= dimensions; i += 16) {
+        __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256i y = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+    }
+
+    __m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+    int sum = _mm_cvtsi128_si32(sum4);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("avx2")
+static float dot_float_avx2_entry(const float* a, const float* b, int dimensions) {
+    return dot_float_avx2(a, b, dimensions);
+}
+
+KERNEL_TARGET("avx2")
+static int dot_int8_avx2_entry(const signed char* a, const signed char* b, int dimensions) {
+    return dot_int8_avx2(a, b, dimensions);
+}
+
+DEFINE_DOT_MANY(KERNEL_TARGET("avx2"), dot_many_avx2, dot_avx2, double, double)
+
+// Four rows per column pass (eight accumulators plus the shared column chunk)
+KERNEL_TARGET("avx2")
+static void dot_block_avx2(const double* rows, int row_count, const double* columns, int column_count,
+                           int dimensions, double* results, size_t result_stride) {
+    int r = 0;
+    if (dimensions % 8 == 0) {
+        for (; r + 4 <= row_count; r += 4) {
+            const double* x0 = rows + (size_t)r * dimensions;
+            const double* x1 = x0 + dimensions;
+            const double* x2 = x1 + dimensions;
+            const double* x3 = x2 + dimensions;
+            double* out = results + (size_t)r * result_stride;
+            for (int c = 0; c < column_count; c++) {
+                const double* y = columns + (size_t)c * dimensions;
+                __m256d low0 = _mm256_setzero_pd(), high0 = _mm256_setzero_pd();
+                __m256d low1 = _mm256_setzero_pd(), high1 = _mm256_setzero_pd();
+                __m256d low2 = _mm256_setzero_pd(), high2 = _mm256_setzero_pd();
+                __m256d low3 = _mm256_setzero_pd(), high3 = _mm256_setzero_pd();
+                for (int i = 0; i < dimensions; i += 8) {
+                    __m256d y_low = _mm256_loadu_pd(y + i);
+                    __m256d y_high = _mm256_loadu_pd(y + i + 4);
+                    low0 = _mm256_add_pd(low0, _mm256_mul_pd(_mm256_loadu_pd(x0 + i), y_low));
+                    high0 = _mm256_add_pd(high0, _mm256_mul_pd(_mm256_loadu_pd(x0 + i + 4), y_high));
+                    low1 = _mm256_add_pd(low1, _mm256_mul_pd(_mm256_loadu_pd(x1 + i), y_low));
+                    high1 = _mm256_add_pd(high1, _mm256_mul_pd(_mm256_loadu_pd(x1 + i + 4), y_high));
+                    low2 = _mm256_add_pd(low2, _mm256_mul_pd(_mm256_loadu_pd(x2 + i), y_low));
+                    high2 = _mm256_add_pd(high2, _mm256_mul_pd(_mm256_loadu_pd(x2 + i + 4), y_high));
+                    low3 = _mm256_add_pd(low3, _mm256_mul_pd(_mm256_loadu_pd(x3 + i), y_low));
+                    high3 = _mm256_add_pd(high3, _mm256_mul_pd(_mm256_loadu_pd(x3 + i + 4), y_high));
+                }
+                out[c] = reduce_avx2(low0, high0);
+                out[result_stride + c] = reduce_avx2(low1, high1);
+                out[2 * result_stride + c] = reduce_avx2(low2, high2);
+                out[3 * result_stride + c] = reduce_avx2(low3, high3);
+            }
+        }
+    }
+    for (; r < row_count; r++) {
+        dot_many_avx2(rows + (size_t)r * dimensions, columns, column_count, dimensions, results + (size_t)r * result_stride);
+    }
+}
+DEFINE_DOT_MANY(KERNEL_TARGET("avx2"), dot_float_many_avx2, dot_float_avx2, float, float)
+DEFINE_DOT_MANY(KERNEL_TARGET("avx2"), dot_int8_many_avx2, dot_int8_avx2, signed char, int)
+
+/* ---------- AVX-512: one 8-lane accumulator ---------- */
+
+KERNEL_TARGET("avx512f")
+static inline double reduce_avx512(__m512d acc) {
+    __m256d t = _mm256_add_pd(_mm512_castpd512_pd256(acc), _mm512_extractf64x4_pd(acc, 1));
+    __m128d u = _mm_add_pd(_mm256_castpd256_pd128(t), _mm256_extractf128_pd(t, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(u, _mm_unpackhi_pd(u, u)));
+}
+
+KERNEL_TARGET("avx512f")
+static inline double dot_avx512(const double* a, const double* b, int dimensions) {
+    __m512d acc = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= dimensions; i += 8) {
+        acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+    }
+
+    double sum = reduce_avx512(acc);
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("avx512f")
+static double dot_avx512_entry(const double* a, const double* b, int dimensions) {
+    return dot_avx512(a, b, dimensions);
+}
+
+KERNEL_TARGET("avx512f")
+static inline float dot_float_avx512(const float* a, const float* b, int dimensions) {
+    __m512 acc = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= dimensions; i += 16) {
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+
+    // Upper eight lanes through the 64-bit extract, which needs only AVX-512F
+    __m256 high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(acc), 1));
+    __m256 s = _mm256_add_ps(_mm512_castps512_ps256(acc), high);
+    __m128 t = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    __m128 u = _mm_add_ps(t, _mm_movehl_ps(t, t));
+    float sum = _mm_cvtss_f32(_mm_add_ss(u, _mm_shuffle_ps(u, u, 1)));
+    for (; i < dimensions; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+KERNEL_TARGET("avx512f")
+static float dot_float_avx512_entry(const float* a, const float* b, int dimensions) {
+    return dot_float_avx512(a, b, dimensions);
+}
+
+DEFINE_DOT_MANY(KERNEL_TARGET("avx512f"), dot_many_avx512, dot_avx512, double, double)
+
+// Four rows per column pass, one accumulator each (wider blocks spill at -O2)
+KERNEL_TARGET("avx512f")
+static void dot_block_avx512(const double* rows, int row_count, const double* columns, int column_count,
+                             int dimensions, double* results, size_t result_stride) {
+    int r = 0;
+    if (dimensions % 8 == 0) {
+        for (; r + 4 <= row_count; r += 4) {
+            const double* x0 = rows + (size_t)r * dimensions;
+            const double* x1 = x0 + dimensions;
+            const double* x2 = x1 + dimensions;
+            const double* x3 = x2 + dimensions;
+            double* out = results + (size_t)r * result_stride;
+            for (int c = 0; c < column_count; c++) {
+                const double* y = columns + (size_t)c * dimensions;
+                __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+                __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+                for (int i = 0; i < dimensions; i += 8) {
+                    __m512d chunk = _mm512_loadu_pd(y + i);
+                    acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(_mm512_loadu_pd(x0 + i), chunk));
+                    acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(_mm512_loadu_pd(x1 + i), chunk));
+                    acc2 = _mm512_add_pd(acc2, _mm512_mul_pd(_mm512_loadu_pd(x2 + i), chunk));
+                    acc3 = _mm512_add_pd(acc3, _mm512_mul_pd(_mm512_loadu_pd(x3 + i), chunk));
+                }
+                out[c] = reduce_avx512(acc0);
+                out[result_stride + c] = reduce_avx512(acc1);
+                out[2 * result_stride + c] = reduce_avx512(acc2);
+                out[3 * result_stride + c] = reduce_avx512(acc3);
+            }
+        }
+    }
+    for (; r < row_count; r++) {
+        dot_many_avx512(rows + (size_t)r * dimensions, columns, column_count, dimensions, results + (size_t)r * result_stride);
+    }
+}
+DEFINE_DOT_MANY(KERNEL_TARGET("avx512f"), dot_float_many_avx512, dot_float_avx512, float, float)
+
+#endif /* SIMILARITY_WIDE_VECTORS */
+
+/* ---------- CPU feature detection ---------- */
+
+static void query_cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned int)values[i];
+#else
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    if (leaf > __get_cpuid_max(0, NULL)) return;
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+#ifdef SIMILARITY_WIDE_VECTORS
+// Register state the OS saves on context switches (XCR0)
+static unsigned long long read_enabled_state(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((unsigned long long)high << 32) | low;
+#endif
+}
+#endif
+
+static int cpu_supports(SimilarityKernelLevel level) {
+    unsigned int basic[4];
+    query_cpuid(1, 0, basic);
+
+    switch (level) {
+    case SIMILARITY_KERNEL_SCALAR:
+        return 1;
+    case SIMILARITY_KERNEL_SSE2:
+        return (basic[3] >> 26) & 1;
+#ifdef SIMILARITY_WIDE_VECTORS
+    case SIMILARITY_KERNEL_AVX2:
+    case SIMILARITY_KERNEL_AVX512: {
+        int osxsave = (basic[2] >> 27) & 1;
+        int avx = (basic[2] >> 28) & 1;
+        if (!osxsave || !avx) return 0;
+
+        unsigned long long enabled = read_enabled_state();
+        unsigned int extended[4];
+        query_cpuid(7, 0, extended);
+        if (level == SIMILARITY_KERNEL_AVX2) {
+            return (enabled & 0x6) == 0x6 && ((extended[1] >> 5) & 1);
+        }
+        // AVX-512 additionally needs the opmask and upper ZMM state enabled
+        return (enabled & 0xE6) == 0xE6 && ((extended[1] >> 16) & 1);
+    }
+#endif
+    default:
+        return 0;
+    }
+}
+
+#else /* !SIMILARITY_X86 */
+
+static int cpu_supports(SimilarityKernelLevel level) {
+    return level == SIMILARITY_KERNEL_SCALAR;
+}
+
+#endif /* SIMILARITY_X86 */
+
+/* ---------- Dispatch ---------- */
+
+static const SimilarityKernel scalar_kernel = {
+    "scalar", similarity_dot_scalar, dot_many_scalar, dot_block_scalar,
+    similarity_dot_float_scalar, dot_float_many_scalar, similarity_dot_int8_scalar, dot_int8_many_scalar
+};
+#ifdef SIMILARITY_X86
+static const SimilarityKernel sse2_kernel = {
+    "sse2", dot_sse2_entry, dot_many_sse2, dot_block_sse2,
+    dot_float_sse2_entry, dot_float_many_sse2, dot_int8_sse2_entry, dot_int8_many_sse2
+};
+#endif
+#ifdef SIMILARITY_WIDE_VECTORS
+static const SimilarityKernel avx2_kernel = {
+    "avx2", dot_avx2_entry, dot_many_avx2, dot_block_avx2,
+    dot_float_avx2_entry, dot_float_many_avx2, dot_int8_avx2_entry, dot_int8_many_avx2
+};
+// Widening int8 to 512 bits needs AVX-512BW; the AVX2 int8 kernel is used instead
+static const SimilarityKernel avx512_kernel = {
+    "avx512", dot_avx512_entry, dot_many_avx512, dot_block_avx512,
+    dot_float_avx512_entry, dot_float_many_avx512, dot_int8_avx2_entry, dot_int8_many_avx2
+};
+#endif
+
+static const SimilarityKernel* active_kernel = NULL;
+
+static const SimilarityKernel* kernel_for_level(SimilarityKernelLevel level) {
+    switch (level) {
+#ifdef SIMILARITY_WIDE_VECTORS
+    case SIMILARITY_KERNEL_AVX512: return &avx512_kernel;
+    case SIMILARITY_KERNEL_AVX2: return &avx2_kernel;
+#endif
+#ifdef SIMILARITY_X86
+    case SIMILARITY_KERNEL_SSE2: return &sse2_kernel;
+#endif
+    case SIMILARITY_KERNEL_SCALAR: return &scalar_kernel;
+    default: return NULL;
+    }
+}
+
+int select_similarity_kernel(SimilarityKernelLevel level) {
+    if (level == SIMILARITY_KERNEL_AUTO) {
+        static const SimilarityKernelLevel preference[] = {
+            SIMILARITY_KERNEL_AVX512, SIMILARITY_KERNEL_AVX2, SIMILARITY_KERNEL_SSE2, SIMILARITY_KERNEL_SCALAR
+        };
+        for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+            const SimilarityKernel* kernel = kernel_for_level(preference[i]);
+            if (kernel && cpu_supports(preference[i])) {
+                active_kernel = kernel;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    const SimilarityKernel* kernel = kernel_for_level(level);
+    if (!kernel || !cpu_supports(level)) return 0;
+    active_kernel = kernel;
+    return 1;
+}
+
+static const SimilarityKernel* current_kernel(void) {
+    if (!active_kernel) select_similarity_kernel(SIMILARITY_KERNEL_AUTO);
+    return active_kernel;
+}
+
+const char* get_similarity_kernel_name(void) {
+    return current_kernel()->name;
+}
+
+double similarity_dot(const double* a, const double* b, int dimensions) {
+    return current_kernel()->dot(a, b, dimensions);
+}
+
+void similarity_dot_many(const double* query, const double* rows, int count, int dimensions, double* results) {
+    current_kernel()->dot_many(query, rows, count, dimensions, results);
+}
+
+void similarity_dot_block(const double* rows, int row_count, const double* columns, int column_count,
+                          int dimensions, double* results, size_t result_stride) {
+    current_kernel()->dot_block(rows, row_count, columns, column_count, dimensions, results, result_stride);
+}
+
+float similarity_dot_float(const float* a, const float* b, int dimensions) {
+    return current_kernel()->dot_float(a, b, dimensions);
+}
+
+void similarity_dot_float_many(const float* query, const float* rows, int count, int dimensions, float* results) {
+    current_kernel()->dot_float_many(query, rows, count, dimensions, results);
+}
+
+int similarity_dot_int8(const signed char* a, const signed char* b, int dimensions) {
+    return current_kernel()->dot_int8(a, b, dimensions);
+}
+
+void similarity_dot_int8_many(const signed char* query, const signed char* rows, int count, int dimensions, int* results) {
+    current_kernel()->dot_int8_many(query, rows, count, dimensions, results);
+}
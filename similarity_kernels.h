@@ -0,0 +1,69 @@
+#ifndef SIMILARITY_KERNELS_H
+#define SIMILARITY_KERNELS_H
+
+#include <stddef.h>
+
+/*
+ * Dot-product kernels behind cosine_similarity(). Every implementation adds the
+ * products in the same order (eight interleaved partial sums, reduced pairwise),
+ * so the SIMD kernels return bit-identical results to the scalar reference.
+ */
+
+typedef enum {
+    SIMILARITY_KERNEL_AUTO,    // Best kernel the CPU and OS support
+    SIMILARITY_KERNEL_SCALAR,
+    SIMILARITY_KERNEL_SSE2,
+    SIMILARITY_KERNEL_AVX2,
+    SIMILARITY_KERNEL_AVX512
+} SimilarityKernelLevel;
+
+/**
+ * Select the kernel used by similarity_dot() and similarity_dot_many(). Called at
+ * startup; if it is not, the best kernel is selected on first use.
+ * @return 1 on success, 0 if the CPU does not support the requested level
+ */
+int select_similarity_kernel(SimilarityKernelLevel level);
+
+/**
+ * Name of the selected kernel ("scalar", "sse2", "avx2", "avx512")
+ */
+const char* get_similarity_kernel_name(void);
+
+/**
+ * Dot product of two vectors with the selected kernel
+ */
+double similarity_dot(const double* a, const double* b, int dimensions);
+
+/**
+ * Dot product of query with count vectors stored back to back (row i starts at
+ * rows + i * dimensions); results[i] receives the product with row i
+ */
+void similarity_dot_many(const double* query, const double* rows, int count, int dimensions, double* results);
+
+/**
+ * Block of a matrix product F * G^T: results[r * result_stride + c] receives the dot
+ * product of row r of rows with row c of columns (both stored back to back).
+ * Several rows share each column load; values equal similarity_dot() exactly.
+ */
+void similarity_dot_block(const double* rows, int row_count, const double* columns, int column_count,
+                          int dimensions, double* results, size_t result_stride);
+
+/**
+ * Portable reference implementation (same summation order as the SIMD kernels)
+ */
+double similarity_dot_scalar(const double* a, const double* b, int dimensions);
+
+/*
+ * Kernels for compact fingerprints (see compact_fingerprints.h). float32 products are
+ * summed as sixteen interleaved partial sums in a fixed order, so they are also
+ * identical across kernels; int8 products are summed exactly in 32-bit integers.
+ */
+float similarity_dot_float(const float* a, const float* b, int dimensions);
+void similarity_dot_float_many(const float* query, const float* rows, int count, int dimensions, float* results);
+float similarity_dot_float_scalar(const float* a, const float* b, int dimensions);
+
+int similarity_dot_int8(const signed char* a, const signed char* b, int dimensions);
+void similarity_dot_int8_many(const signed char* query, const signed char* rows, int count, int dimensions, int* results);
+int similarity_dot_int8_scalar(const signed char* a, const signed char* b, int dimensions);
+
+#endif
@@ -0,0 +1,535 @@
+#include "similarity_matrix.h"
+#include "mapped_file.h"
+#include <float.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Spacing of half precision values just above 1.0 (2^-10)
+#define HALF_EPSILON 9.765625e-4
+
+#define TILE SIMILARITY_MATRIX_TILE
+#define TILE_ENTRIES (TILE * TILE)
+
+/*
+ * Tile (I, J), I <= J, holds rows I * TILE.. and columns J * TILE.. row by row and is
+ * tile number J * (J + 1) / 2 + I. Entries on or below the diagonal of diagonal tiles
+ * are unused (zero).
+ *
+ * File layout: MatrixFileHeader padded to MATRIX_HEADER_SIZE (so tiles stay
+ * page-aligned in the mapping), then every tile in order. Tiles are read in place, so
+ * byte_order guards against reading a file written on another architecture.
+ */
+#define MATRIX_MAGIC "GDSM"
+#define MATRIX_VERSION 1
+#define MATRIX_BYTE_ORDER 0x01020304u
+#define MATRIX_HEADER_SIZE 4096
+
+typedef struct {
+    char magic[4];
+    unsigned int version;
+    unsigned int byte_order;     // MATRIX_BYTE_ORDER as stored by the writer
+    unsigned int storage;
+    unsigned int tile;
+    unsigned int count;
+    unsigned long long key;
+    double average_similarity;
+    double error_bound;
+} MatrixFileHeader;
+
+struct SimilarityMatrix {
+    SimilarityStorage storage;
+    int count;                // Commits (rows and columns)
+    int capacity;             // Commits the tiles have room for
+    unsigned char* values;    // Resident tiles, starting with tile number first_tile
+    size_t first_tile;
+    size_t resident_tiles;
+    
+    // Writing a file: tile columns [band_first, band_end) are resident
+    FILE* output;
+    char* path;
+    char* temp_path;
+    size_t band_capacity;     // Bytes allocated for the band
+    int band_first;
+    int band_end;
+    int write_failed;
+    
+    // Finished or reopened file
+    MappedFile* mapping;
+};
+
+/* ---------- IEEE half precision conversion (round to nearest even) ---------- */
+
+static uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude > 0x7F800000) return sign | 0x7E00;   // NaN
+    if (magnitude >= 0x47800000) return sign | 0x7C00;  // 65536 and above overflow to infinity
+
+    if (magnitude < 0x38800000) {
+        // Below the smallest normal half (2^-14): subnormal result, h * 2^-24
+        if (magnitude < 0x33000000) return sign;        // At most half of the smallest subnormal
+        uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+        int shift = 126 - (int)(magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+        return sign | (uint16_t)half;
+    }
+
+    // Rebias the exponent (127 -> 15) and round away the low 13 mantissa bits;
+    // a carry moves into the exponent, up to infinity
+    uint32_t half = (magnitude >> 13) - ((127 - 15) << 10);
+    uint32_t remainder = magnitude & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+    return sign | (uint16_t)half;
+}
+
+static float half_to_float(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Subnormal half: normalize into a float exponent
+        exponent = 127 - 14;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* ---------- Layout ---------- */
+
+static size_t storage_size(SimilarityStorage storage) {
+    switch (storage) {
+    case SIMILARITY_STORAGE_DOUBLE: return sizeof(double);
+    case SIMILARITY_STORAGE_FLOAT32: return sizeof(float);
+    case SIMILARITY_STORAGE_HALF: return sizeof(uint16_t);
+    default: return 0;
+    }
+}
+
+static size_t tile_bytes(const SimilarityMatrix* matrix) {
+    return TILE_ENTRIES * storage_size(matrix->storage);
+}
+
+static int tile_columns(int count) {
+    return (count + TILE - 1) / TILE;
+}
+
+// Tiles in tile columns 0 .. columns - 1
+static size_t tiles_before_column(int columns) {
+    return (size_t)columns * (size_t)(columns + 1) / 2;
+}
+
+// Resident address of entry (row, column) of tile (tile_row, tile_column), or NULL
+static unsigned char* tile_entry(const SimilarityMatrix* matrix, int tile_row, int tile_column, int row, int column) {
+    size_t tile = tiles_before_column(tile_column) + (size_t)tile_row;
+    if (tile < matrix->first_tile || tile - matrix->first_tile >= matrix->resident_tiles) return NULL;
+    
+    size_t entry = (tile - matrix->first_tile) * TILE_ENTRIES + (size_t)(row % TILE) * TILE + (size_t)(column % TILE);
+    return matrix->values + entry * storage_size(matrix->storage);
+}
+
+static void write_values(SimilarityStorage storage, unsigned char* destination, size_t destination_stride,
+                         const double* values, int count) {
+    switch (storage) {
+    case SIMILARITY_STORAGE_FLOAT32: {
+        float* out = (float*)destination;
+        for (int k = 0; k < count; k++) out[k * destination_stride] = (float)values[k];
+        break;
+    }
+    case SIMILARITY_STORAGE_HALF: {
+        uint16_t* out = (uint16_t*)destination;
+        for (int k = 0; k < count; k++) out[k * destination_stride] = float_to_half((float)values[k]);
+        break;
+    }
+    default: {
+        double* out = (double*)destination;
+        for (int k = 0; k < count; k++) out[k * destination_stride] = values[k];
+        break;
+    }
+    }
+}
+
+static void read_values(SimilarityStorage storage, const unsigned char* source, size_t source_stride,
+                        double* results, int count) {
+    switch (storage) {
+    case SIMILARITY_STORAGE_FLOAT32: {
+        const float* in = (const float*)source;
+        for (int k = 0; k < count; k++) results[k] = in[k * source_stride];
+        break;
+    }
+    case SIMILARITY_STORAGE_HALF: {
+        const uint16_t* in = (const uint16_t*)source;
+        for (int k = 0; k < count; k++) results[k] = half_to_float(in[k * source_stride]);
+        break;
+    }
+    default: {
+        const double* in = (const double*)source;
+        for (int k = 0; k < count; k++) results[k] = in[k * source_stride];
+        break;
+    }
+    }
+}
+
+/* ---------- Writing files ---------- */
+
+// Make tile columns [first, ...) resident: as many as fit in the band, at least one
+static void start_band(SimilarityMatrix* matrix, int first) {
+    int columns = tile_columns(matrix->count);
+    size_t bytes = 0;
+    int end = first;
+    while (end < columns) {
+        size_t column_bytes = (size_t)(end + 1) * tile_bytes(matrix);
+        if (end > first && bytes + column_bytes > matrix->band_capacity) break;
+        bytes += column_bytes;
+        end++;
+    }
+    
+    memset(matrix->values, 0, bytes);
+    matrix->band_first = first;
+    matrix->band_end = end;
+    matrix->first_tile = tiles_before_column(first);
+    matrix->resident_tiles = tiles_before_column(end) - matrix->first_tile;
+}
+
+static int write_band(SimilarityMatrix* matrix) {
+    size_t bytes = matrix->resident_tiles * tile_bytes(matrix);
+    if (bytes > 0 && fwrite(matrix->values, 1, bytes, matrix->output) != bytes) matrix->write_failed = 1;
+    return !matrix->write_failed;
+}
+
+// Move the band forward until tile column is resident (earlier columns are final)
+static int make_column_resident(SimilarityMatrix* matrix, int tile_column) {
+    if (!matrix->output) return 1;
+    while (!matrix->write_failed && tile_column >= matrix->band_end) {
+        if (write_band(matrix)) start_band(matrix, matrix->band_end);
+    }
+    return !matrix->write_failed && tile_column >= matrix->band_first;
+}
+
+SimilarityMatrix* create_similarity_matrix_file(SimilarityStorage storage, int count, const char* path,
+                                                size_t memory_budget) {
+    if (storage_size(storage) == 0 || count < 0 || !path) return NULL;
+
+    SimilarityMatrix* matrix = calloc(1, sizeof(SimilarityMatrix));
+    if (!matrix) return NULL;
+    matrix->storage = storage;
+    matrix->count = count;
+    matrix->capacity = count;
+    
+    // The band holds the last (largest) tile column at least, and never more than the file
+    size_t largest_column = (size_t)tile_columns(count) * tile_bytes(matrix);
+    size_t all_tiles = tiles_before_column(tile_columns(count)) * tile_bytes(matrix);
+    matrix->band_capacity = memory_budget > largest_column ? memory_budget : largest_column;
+    if (matrix->band_capacity > all_tiles) matrix->band_capacity = all_tiles;
+    
+    size_t path_length = strlen(path);
+    matrix->path = malloc(path_length + 1);
+    matrix->temp_path = malloc(path_length + 5);
+    matrix->values = malloc(matrix->band_capacity > 0 ? matrix->band_capacity : 1);
+    if (matrix->path && matrix->temp_path) {
+        memcpy(matrix->path, path, path_length + 1);
+        memcpy(matrix->temp_path, path, path_length);
+        strcpy(matrix->temp_path + path_length, ".tmp");
+        if (matrix->values) matrix->output = fopen(matrix->temp_path, "wb");
+    }
+    
+    // The header is written last; reserve its space
+    static const unsigned char no_header[MATRIX_HEADER_SIZE];
+    if (!matrix->output || fwrite(no_header, 1, sizeof(no_header), matrix->output) != sizeof(no_header)) {
+        free_similarity_matrix(matrix);
+        return NULL;
+    }
+    start_band(matrix, 0);
+    return matrix;
+}
+
+static void discard_values(SimilarityMatrix* matrix) {
+    free(matrix->values);
+    matrix->values = NULL;
+    matrix->first_tile = 0;
+    matrix->resident_tiles = 0;
+}
+
+int finish_similarity_matrix_file(SimilarityMatrix* matrix, const SimilarityMatrixInfo* info) {
+    if (!matrix || !matrix->output || !info) return 0;
+
+    int columns = tile_columns(matrix->count);
+    int ok = (columns == 0 || make_column_resident(matrix, columns - 1)) && write_band(matrix);
+    discard_values(matrix);
+    
+    MatrixFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MATRIX_MAGIC, 4);
+    header.version = MATRIX_VERSION;
+    header.byte_order = MATRIX_BYTE_ORDER;
+    header.storage = (unsigned int)matrix->storage;
+    header.tile = TILE;
+    header.count = (unsigned int)matrix->count;
+    header.key = info->key;
+    header.average_similarity = info->average_similarity;
+    header.error_bound = info->error_bound;
+    
+    ok = ok && fseek(matrix->output, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, matrix->output) == 1;
+    if (fclose(matrix->output) != 0) ok = 0;
+    matrix->output = NULL;
+    
+    if (ok) {
+#ifdef _WIN32
+        remove(matrix->path);
+#endif
+        ok = rename(matrix->temp_path, matrix->path) == 0;
+    }
+    if (!ok) {
+        remove(matrix->temp_path);
+        return 0;
+    }
+    
+    matrix->mapping = map_file_readonly(matrix->path);
+    if (!matrix->mapping) return 0;
+    matrix->values = (unsigned char*)get_mapped_data(matrix->mapping) + MATRIX_HEADER_SIZE;
+    matrix->resident_tiles = tiles_before_column(tile_columns(matrix->count));
+    return 1;
+}
+
+SimilarityMatrix* open_similarity_matrix_file(const char* path, SimilarityStorage storage, int count,
+                                              unsigned long long key, SimilarityMatrixInfo* info) {
+    if (storage_size(storage) == 0 || count < 0 || !path) return NULL;
+
+    MappedFile* mapping = map_file_readonly(path);
+    if (!mapping) return NULL;
+    
+    size_t tiles = tiles_before_column(tile_columns(count));
+    const unsigned char* data = get_mapped_data(mapping);
+    MatrixFileHeader header;
+    int valid = get_mapped_size(mapping) == MATRIX_HEADER_SIZE + tiles * TILE_ENTRIES * storage_size(storage);
+    if (valid) {
+        memcpy(&header, data, sizeof(header));
+        valid = memcmp(header.magic, MATRIX_MAGIC, 4) == 0 && header.version == MATRIX_VERSION &&
+                header.byte_order == MATRIX_BYTE_ORDER && header.storage == (unsigned int)storage &&
+                header.tile == TILE && header.count == (unsigned int)count && header.key == key;
+    }
+    
+    SimilarityMatrix* matrix = valid ? calloc(1, sizeof(SimilarityMatrix)) : NULL;
+    if (!matrix) {
+        unmap_file(mapping);
+        return NULL;
+    }
+    matrix->storage = storage;
+    matrix->count = count;
+    matrix->capacity = count;
+    matrix->mapping = mapping;
+    matrix->values = (unsigned char*)data + MATRIX_HEADER_SIZE;
+    matrix->resident_tiles = tiles;
+    
+    if (info) {
+        info->key = header.key;
+        info->average_similarity = header.average_similarity;
+        info->error_bound = header.error_bound;
+    }
+    return matrix;
+}
+
+/* ---------- Matrix ---------- */
+
+SimilarityMatrix* create_similarity_matrix(SimilarityStorage storage, int count) {
+    if (storage_size(storage) == 0 || count < 0) return NULL;
+
+    SimilarityMatrix* matrix = calloc(1, sizeof(SimilarityMatrix));
+    if (!matrix) return NULL;
+    matrix->storage = storage;
+    matrix->count = count;
+    matrix->capacity = tile_columns(count) * TILE;
+    matrix->resident_tiles = tiles_before_column(tile_columns(count));
+    
+    matrix->values = calloc(matrix->resident_tiles > 0 ? matrix->resident_tiles : 1, tile_bytes(matrix));
+    if (!matrix->values) {
+        free(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+int get_similarity_matrix_size(const SimilarityMatrix* matrix) {
+    return matrix ? matrix->count : 0;
+}
+
+SimilarityStorage get_similarity_matrix_storage(const SimilarityMatrix* matrix) {
+    return matrix ? matrix->storage : SIMILARITY_STORAGE_DOUBLE;
+}
+
+int is_similarity_matrix_mapped(const SimilarityMatrix* matrix) {
+    return matrix && (matrix->mapping || matrix->output);
+}
+
+size_t get_similarity_matrix_bytes(const SimilarityMatrix* matrix) {
+    return matrix ? tiles_before_column(tile_columns(matrix->capacity)) * tile_bytes(matrix) : 0;
+}
+
+double get_matrix_similarity(const SimilarityMatrix* matrix, int i, int j) {
+    if (!matrix || i < 0 || j < 0 || i >= matrix->count || j >= matrix->count) return 0.0;
+    if (i == j) return 1.0;
+    if (i > j) {
+        int swap = i;
+        i = j;
+        j = swap;
+    }
+
+    const unsigned char* entry = tile_entry(matrix, i / TILE, j / TILE, i, j);
+    double value = 0.0;
+    if (entry) read_values(matrix->storage, entry, 1, &value, 1);
+    return value;
+}
+
+void get_matrix_row(const SimilarityMatrix* matrix, int row, double* results) {
+    if (!matrix || !results || row < 0 || row >= matrix->count) return;
+
+    int tile_row = row / TILE;
+    for (int start = 0; start < matrix->count; start += TILE) {
+        int count = matrix->count - start < TILE ? matrix->count - start : TILE;
+        int tile = start / TILE;
+        
+        // Left of the diagonal the row is a column of tile (tile, tile_row); right of it,
+        // a row of tile (tile_row, tile). The diagonal tile supplies both halves.
+        const unsigned char* column_run = tile <= tile_row ? tile_entry(matrix, tile, tile_row, start, row) : NULL;
+        const unsigned char* row_run = tile >= tile_row ? tile_entry(matrix, tile_row, tile, row, start) : NULL;
+        for (int k = 0; k < count; k++) results[start + k] = 0.0;
+        
+        int split = row - start; // Entries before it come from column_run
+        if (split > count) split = count;
+        if (column_run && split > 0) read_values(matrix->storage, column_run, TILE, results + start, split);
+        if (row_run && split + 1 < count) {
+            int first = split < 0 ? 0 : split + 1;
+            read_values(matrix->storage, row_run + (size_t)first * storage_size(matrix->storage), 1,
+                        results + start + first, count - first);
+        }
+    }
+    results[row] = 1.0;
+}
+
+void set_matrix_similarity(SimilarityMatrix* matrix, int i, int j, double value) {
+    if (!matrix || i == j || i < 0 || j < 0 || i >= matrix->count || j >= matrix->count) return;
+    if (i > j) {
+        int swap = i;
+        i = j;
+        j = swap;
+    }
+    store_similarity_column(matrix, j, i, &value, 1);
+}
+
+void store_similarity_column(SimilarityMatrix* matrix, int column, int first_row, const double* values, int count) {
+    if (!matrix || !values || count <= 0 || first_row < 0 || first_row + count > column || column >= matrix->capacity) return;
+    if (matrix->mapping || !make_column_resident(matrix, column / TILE)) return;
+
+    // One strided run per tile the column crosses
+    int done = 0;
+    while (done < count) {
+        int row = first_row + done;
+        int run = TILE - row % TILE;
+        if (run > count - done) run = count - done;
+        unsigned char* destination = tile_entry(matrix, row / TILE, column / TILE, row, column);
+        if (destination) write_values(matrix->storage, destination, TILE, values + done, run);
+        done += run;
+    }
+}
+
+void store_similarity_block(SimilarityMatrix* matrix, int first_row, int first_column, int rows, int columns,
+                            const double* values, size_t stride) {
+    if (!matrix || !values || rows <= 0 || columns <= 0 || first_row < 0 || first_column < 0) return;
+    if (first_column + columns > matrix->capacity || first_row + rows > matrix->capacity || matrix->mapping) return;
+
+    int end_column = first_column + columns;
+    for (int tile_start = first_column - first_column % TILE; tile_start < end_column; tile_start += TILE) {
+        if (!make_column_resident(matrix, tile_start / TILE)) return;
+        int tile_end = tile_start + TILE < end_column ? tile_start + TILE : end_column;
+        
+        // One contiguous run per row: the part of the row inside this tile and above the diagonal
+        for (int r = 0; r < rows; r++) {
+            int row = first_row + r;
+            int start = tile_start > first_column ? tile_start : first_column;
+            if (start <= row) start = row + 1;
+            if (start >= tile_end) continue;
+            unsigned char* destination = tile_entry(matrix, row / TILE, tile_start / TILE, row, start);
+            if (destination) {
+                write_values(matrix->storage, destination, 1, values + (size_t)r * stride + (start - first_column),
+                             tile_end - start);
+            }
+        }
+    }
+}
+
+int append_similarity_column(SimilarityMatrix* matrix, const double* values) {
+    if (!matrix || (!values && matrix->count > 0) || matrix->output || matrix->mapping) return 0;
+
+    if (matrix->count == matrix->capacity) {
+        // Grow by whole tile columns, about half the matrix at a time
+        int columns = tile_columns(matrix->capacity);
+        int added = columns / 2 > 0 ? columns / 2 : 1;
+        size_t old_tiles = tiles_before_column(columns);
+        size_t new_tiles = tiles_before_column(columns + added);
+        unsigned char* grown = realloc(matrix->values, new_tiles * tile_bytes(matrix));
+        if (!grown) return 0;
+        memset(grown + old_tiles * tile_bytes(matrix), 0, (new_tiles - old_tiles) * tile_bytes(matrix));
+        matrix->values = grown;
+        matrix->resident_tiles = new_tiles;
+        matrix->capacity = (columns + added) * TILE;
+    }
+    store_similarity_column(matrix, matrix->count, 0, values, matrix->count);
+    matrix->count++;
+    return 1;
+}
+
+double get_similarity_storage_error(SimilarityStorage storage) {
+    switch (storage) {
+    case SIMILARITY_STORAGE_FLOAT32: return FLT_EPSILON / 2.0;
+    // Half values are rounded from the float32 value (two roundings)
+    case SIMILARITY_STORAGE_HALF: return HALF_EPSILON / 2.0 + FLT_EPSILON / 2.0;
+    default: return 0.0;
+    }
+}
+
+const char* get_similarity_storage_name(SimilarityStorage storage) {
+    switch (storage) {
+    case SIMILARITY_STORAGE_FLOAT32: return "float32";
+    case SIMILARITY_STORAGE_HALF: return "half";
+    default: return "double";
+    }
+}
+
+void free_similarity_matrix(SimilarityMatrix* matrix) {
+    if (!matrix) return;
+
+    if (matrix->output) {
+        fclose(matrix->output);
+        remove(matrix->temp_path);
+    }
+    if (matrix->mapping) {
+        unmap_file(matrix->mapping);
+    } else {
+        free(matrix->values);
+    }
+    free(matrix->path);
+    free(matrix->temp_path);
+    free(matrix);
+}
@@ -0,0 +1,131 @@
+#ifndef SIMILARITY_MATRIX_H
+#define SIMILARITY_MATRIX_H
+
+#include <stddef.h>
+
+/**
+ * Element type of the cached similarity matrix
+ */
+typedef enum {
+    SIMILARITY_STORAGE_DOUBLE,  // Exact values, 8 bytes each
+    SIMILARITY_STORAGE_FLOAT32, // 4 bytes each
+    SIMILARITY_STORAGE_HALF     // IEEE half precision, 2 bytes each
+} SimilarityStorage;
+
+// Rows/columns per storage tile (a float32 tile is one 4 KB page)
+#define SIMILARITY_MATRIX_TILE 32
+
+/**
+ * Symmetric count x count similarity matrix holding only its upper triangle. The
+ * triangle is cut into SIMILARITY_MATRIX_TILE square tiles stored column of tiles by
+ * column of tiles, so a lookup touches one tile, a row scan reads a contiguous run of
+ * values from each tile it crosses, and adding a commit only adds tiles at the end.
+ * The diagonal is not stored (it is always 1.0).
+ *
+ * The tiles live in memory, or in a file: written through a bounded in-memory band,
+ * then memory-mapped read-only (and reopened by later runs without recomputing).
+ */
+typedef struct SimilarityMatrix SimilarityMatrix;
+
+/**
+ * Identifies the contents of a matrix file, plus statistics kept with it
+ */
+typedef struct {
+    unsigned long long key;     // Chosen by the caller; a file only reopens with the same key
+    double average_similarity;
+    double error_bound;
+} SimilarityMatrixInfo;
+
+/**
+ * Create an in-memory matrix for count commits (entries start at 0.0)
+ * @return New matrix, or NULL on allocation failure or unsupported storage
+ */
+SimilarityMatrix* create_similarity_matrix(SimilarityStorage storage, int count);
+
+/**
+ * Create a matrix that is written to path. Columns must be stored in increasing
+ * order of their tile column; at most memory_budget bytes of tiles are held at once
+ * (but always at least one column of tiles). Entries are only readable after
+ * finish_similarity_matrix_file().
+ * @return New matrix, or NULL if the temporary file or band cannot be created
+ */
+SimilarityMatrix* create_similarity_matrix_file(SimilarityStorage storage, int count, const char* path,
+                                                size_t memory_budget);
+
+/**
+ * Write the remaining tiles and info, replace path and map the file read-only
+ * @return 1 on success, 0 on error (the matrix then holds no values)
+ */
+int finish_similarity_matrix_file(SimilarityMatrix* matrix, const SimilarityMatrixInfo* info);
+
+/**
+ * Map a matrix file written by an earlier run
+ * @param info Receives the stored info (may be NULL)
+ * @return Read-only matrix, or NULL if the file is missing or was written for another
+ *         storage, count or key
+ */
+SimilarityMatrix* open_similarity_matrix_file(const char* path, SimilarityStorage storage, int count,
+                                              unsigned long long key, SimilarityMatrixInfo* info);
+
+int get_similarity_matrix_size(const SimilarityMatrix* matrix);
+SimilarityStorage get_similarity_matrix_storage(const SimilarityMatrix* matrix);
+
+/**
+ * 1 if the matrix is backed by a file (values are paged in on demand)
+ */
+int is_similarity_matrix_mapped(const SimilarityMatrix* matrix);
+
+/**
+ * Bytes of tiles in the matrix (in memory or in its file)
+ */
+size_t get_similarity_matrix_bytes(const SimilarityMatrix* matrix);
+
+/**
+ * Similarity between commits i and j in either order (1.0 when i == j, 0.0 out of range)
+ */
+double get_matrix_similarity(const SimilarityMatrix* matrix, int i, int j);
+
+/**
+ * Similarities of commit row to every commit
+ * @param results Array of get_similarity_matrix_size(matrix) values
+ */
+void get_matrix_row(const SimilarityMatrix* matrix, int row, double* results);
+
+/**
+ * Store the similarity between commits i and j (i != j)
+ */
+void set_matrix_similarity(SimilarityMatrix* matrix, int i, int j, double value);
+
+/**
+ * Store entries (first_row + k, column) for k < count; first_row + count <= column
+ */
+void store_similarity_column(SimilarityMatrix* matrix, int column, int first_row, const double* values, int count);
+
+/**
+ * Store the upper-triangle entries of a block: values[r * stride + c] is the
+ * similarity of commits first_row + r and first_column + c (entries with
+ * row >= column are ignored)
+ */
+void store_similarity_block(SimilarityMatrix* matrix, int first_row, int first_column, int rows, int columns,
+                            const double* values, size_t stride);
+
+/**
+ * Add a commit to an in-memory matrix: values[i] is its similarity to commit i
+ * @return 1 on success, 0 on allocation failure or for file-backed matrices (the
+ *         matrix is unchanged)
+ */
+int append_similarity_column(SimilarityMatrix* matrix, const double* values);
+
+/**
+ * Largest |stored - value| for values with |value| <= 2 (0 for double storage)
+ */
+double get_similarity_storage_error(SimilarityStorage storage);
+
+const char* get_similarity_storage_name(SimilarityStorage storage);
+
+/**
+ * Release the matrix (an unfinished file is deleted)
+ */
+void free_similarity_matrix(SimilarityMatrix* matrix);
+
+#endif
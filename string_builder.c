@@ -0,0 +1,82 @@
+#include "string_builder.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_BUILDER_MIN_CAPACITY 64
+#define LINE_CHUNK_SIZE 4096
+
+static int reserve(StringBuilder* builder, size_t extra) {
+    if (builder->data && builder->length + extra <= builder->capacity) return 1;
+
+    size_t capacity = builder->capacity ? builder->capacity : STRING_BUILDER_MIN_CAPACITY;
+    while (capacity < builder->length + extra) capacity *= 2;
+
+    char* temp = realloc(builder->data, capacity + 1);
+    if (!temp) return 0;
+    builder->data = temp;
+    builder->capacity = capacity;
+    return 1;
+}
+
+void init_string_builder(StringBuilder* builder) {
+    builder->data = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+}
+
+void free_string_builder(StringBuilder* builder) {
+    if (!builder) return;
+    free(builder->data);
+    init_string_builder(builder);
+}
+
+int string_builder_append(StringBuilder* builder, const char* text, size_t length) {
+    if (!reserve(builder, length)) return 0;
+    memcpy(builder->data + builder->length, text, length);
+    builder->length += length;
+    builder->data[builder->length] = '\0';
+    return 1;
+}
+
+int string_builder_append_char(StringBuilder* builder, char c) {
+    if (!reserve(builder, 1)) return 0;
+    builder->data[builder->length++] = c;
+    builder->data[builder->length] = '\0';
+    return 1;
+}
+
+void string_builder_reset(StringBuilder* builder) {
+    builder->length = 0;
+    if (builder->data) builder->data[0] = '\0';
+}
+
+char* string_builder_detach(StringBuilder* builder) {
+    if (!reserve(builder, 0)) return NULL;
+
+    // Give back the unused tail of the doubling growth
+    char* result = realloc(builder->data, builder->length + 1);
+    if (!result) result = builder->data;
+    result[builder->length] = '\0';
+
+    init_string_builder(builder);
+    return result;
+}
+
+int string_builder_read_line(StringBuilder* builder, FILE* fp) {
+    char chunk[LINE_CHUNK_SIZE];
+    int read_any = 0;
+
+    string_builder_reset(builder);
+    while (fgets(chunk, sizeof(chunk), fp)) {
+        read_any = 1;
+        size_t length = strlen(chunk);
+        int complete = length > 0 && chunk[length - 1] == '\n';
+        if (complete) length--;
+        if (!string_builder_append(builder, chunk, length)) return 0;
+        if (complete) break;
+    }
+
+    // Callers always get a valid (possibly empty) string for a line that was read
+    if (read_any && !reserve(builder, 0)) return 0;
+    return read_any;
+}
@@ -0,0 +1,43 @@
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Growable, length-tracked string buffer. Appends are amortized O(1)
+ * (no rescanning for the terminator), and the finished buffer can be
+ * detached and handed to its new owner without another copy.
+ */
+typedef struct {
+    char* data;        // NUL terminated when non-NULL
+    size_t length;     // Bytes used, excluding the terminator
+    size_t capacity;   // Bytes allocated, excluding the terminator
+} StringBuilder;
+
+// Lifecycle
+void init_string_builder(StringBuilder* builder);
+void free_string_builder(StringBuilder* builder);
+
+// Appending (return 1 on success, 0 on allocation failure)
+int string_builder_append(StringBuilder* builder, const char* text, size_t length);
+int string_builder_append_char(StringBuilder* builder, char c);
+
+/**
+ * Drop the contents but keep the allocation for reuse
+ */
+void string_builder_reset(StringBuilder* builder);
+
+/**
+ * Take ownership of the built string (never NULL unless memory runs out);
+ * the builder is left empty and can be reused
+ */
+char* string_builder_detach(StringBuilder* builder);
+
+/**
+ * Read one whole line of any length, without its trailing newline
+ * @return 1 if a line was read, 0 at end of file
+ */
+int string_builder_read_line(StringBuilder* builder, FILE* fp);
+
+#endif
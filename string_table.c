@@ -0,0 +1,144 @@
+#include "string_table.h"
+#include "arena.h"
+#include "hash.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Linear-probing slots hold ids (-1 = empty); there are capacity slots (a power of
+// two), at most half full. Strings are packed in an arena, never freed one by one.
+struct StringTable {
+    int* slots;
+    int capacity;
+    const char** strings;   // By id
+    uint32_t* hashes;       // By id, to rehash without rescanning the strings
+    int count;
+    int string_capacity;
+    Arena* arena;
+};
+
+// Slot of text, or of the empty slot where it belongs
+static size_t find_slot(const StringTable* table, const char* text, uint32_t hash) {
+    size_t mask = (size_t)table->capacity - 1;
+    size_t slot = (size_t)hash & mask;
+    while (table->slots[slot] >= 0) {
+        int id = table->slots[slot];
+        if (table->hashes[id] == hash && strcmp(table->strings[id], text) == 0) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int grow_slots(StringTable* table, int capacity) {
+    int* slots = malloc((size_t)capacity * sizeof(int));
+    if (!slots) return 0;
+    for (int i = 0; i < capacity; i++) slots[i] = -1;
+
+    size_t mask = (size_t)capacity - 1;
+    for (int id = 0; id < table->count; id++) {
+        size_t slot = (size_t)table->hashes[id] & mask;
+        while (slots[slot] >= 0) slot = (slot + 1) & mask;
+        slots[slot] = id;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return 1;
+}
+
+StringTable* create_string_table(int capacity) {
+    StringTable* table = calloc(1, sizeof(StringTable));
+    if (!table) return NULL;
+
+    int slots = 16;
+    while (slots < 2 * capacity && slots < (1 << 30)) slots *= 2;
+    table->arena = create_arena(0);
+    if (!table->arena || !grow_slots(table, slots)) {
+        free_string_table(table);
+        return NULL;
+    }
+    return table;
+}
+
+int intern_string(StringTable* table, const char* text) {
+    if (!table || !text) return -1;
+
+    uint32_t hash = fnv1a_32(text);
+    size_t slot = find_slot(table, text, hash);
+    if (table->slots[slot] >= 0) return table->slots[slot];
+
+    if (table->count == table->string_capacity) {
+        int capacity = table->string_capacity ? table->string_capacity * 2 : 16;
+        const char** strings = realloc(table->strings, (size_t)capacity * sizeof(const char*));
+        if (!strings) return -1;
+        table->strings = strings;
+        uint32_t* hashes = realloc(table->hashes, (size_t)capacity * sizeof(uint32_t));
+        if (!hashes) return -1;
+        table->hashes = hashes;
+        table->string_capacity = capacity;
+    }
+    if (2 * (table->count + 1) > table->capacity) {
+        if (!grow_slots(table, table->capacity * 2)) return -1;
+        slot = find_slot(table, text, hash);
+    }
+
+    char* copy = arena_strdup(table->arena, text);
+    if (!copy) return -1;
+
+    int id = table->count++;
+    table->strings[id] = copy;
+    table->hashes[id] = hash;
+    table->slots[slot] = id;
+    return id;
+}
+
+int find_interned_string(const StringTable* table, const char* text) {
+    if (!table || !text) return -1;
+    return table->slots[find_slot(table, text, fnv1a_32(text))];
+}
+
+const char* get_interned_string(const StringTable* table, int id) {
+    if (!table || id < 0 || id >= table->count) return NULL;
+    return table->strings[id];
+}
+
+int get_string_table_count(const StringTable* table) {
+    return table ? table->count : 0;
+}
+
+int renumber_string_table(StringTable* table, const int* new_ids) {
+    if (!table || !new_ids) return 0;
+    if (table->count == 0) return 1;
+
+    const char** strings = malloc((size_t)table->count * sizeof(const char*));
+    uint32_t* hashes = malloc((size_t)table->count * sizeof(uint32_t));
+    if (!strings || !hashes) {
+        free(strings);
+        free(hashes);
+        return 0;
+    }
+    for (int id = 0; id < table->count; id++) {
+        strings[new_ids[id]] = table->strings[id];
+        hashes[new_ids[id]] = table->hashes[id];
+    }
+    for (int slot = 0; slot < table->capacity; slot++) {
+        if (table->slots[slot] >= 0) table->slots[slot] = new_ids[table->slots[slot]];
+    }
+
+    free(table->strings);
+    free(table->hashes);
+    table->strings = strings;
+    table->hashes = hashes;
+    table->string_capacity = table->count;
+    return 1;
+}
+
+void free_string_table(StringTable* table) {
+    if (!table) return;
+
+    free(table->slots);
+    free(table->strings);
+    free(table->hashes);
+    free_arena(table->arena);
+    free(table);
+}
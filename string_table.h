@@ -0,0 +1,46 @@
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+/**
+ * Intern table: one copy of each distinct string, numbered 0, 1, 2... in the order
+ * first seen. Ids and the strings they name stay valid until the table is freed, so
+ * equal strings can be compared, grouped and counted by id. Not thread-safe.
+ */
+typedef struct StringTable StringTable;
+
+/**
+ * Create an empty table
+ * @param capacity Expected number of distinct strings (grows as needed)
+ * @return New table, or NULL on allocation failure
+ */
+StringTable* create_string_table(int capacity);
+
+/**
+ * Id of text, adding a copy of it the first time it is seen
+ * @return Id, or -1 for NULL text or on allocation failure
+ */
+int intern_string(StringTable* table, const char* text);
+
+/**
+ * Id of text if it was interned, else -1 (the table is unchanged)
+ */
+int find_interned_string(const StringTable* table, const char* text);
+
+/**
+ * The string with this id (owned by the table), or NULL if there is none
+ */
+const char* get_interned_string(const StringTable* table, int id);
+
+// Number of distinct strings (ids run from 0 to count - 1)
+int get_string_table_count(const StringTable* table);
+
+/**
+ * Give every string a new id; the strings themselves do not move
+ * @param new_ids Indexed by current id: a permutation of 0 to count - 1
+ * @return 1 on success, 0 on allocation failure (ids unchanged)
+ */
+int renumber_string_table(StringTable* table, const int* new_ids);
+
+void free_string_table(StringTable* table);
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // sysconf
+#endif
+
+#include "thread_pool.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION pool_mutex;
+typedef CONDITION_VARIABLE pool_condition;
+typedef HANDLE pool_thread;
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_mutex_t pool_mutex;
+typedef pthread_cond_t pool_condition;
+typedef pthread_t pool_thread;
+#endif
+
+typedef struct ThreadPoolTask {
+    thread_pool_task function;
+    void* argument;
+    struct ThreadPoolTask* next;
+} ThreadPoolTask;
+
+struct ThreadPool {
+    pool_mutex lock;
+    pool_condition work_available;
+    pool_condition work_done;
+    ThreadPoolTask* head;
+    ThreadPoolTask* tail;
+    int unfinished;      // Queued plus running tasks
+    int shutting_down;
+    int worker_count;
+    pool_thread* workers;
+};
+
+static void lock_pool(ThreadPool* pool) {
+#ifdef _WIN32
+    EnterCriticalSection(&pool->lock);
+#else
+    pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+static void unlock_pool(ThreadPool* pool) {
+#ifdef _WIN32
+    LeaveCriticalSection(&pool->lock);
+#else
+    pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+static void wait_condition(ThreadPool* pool, pool_condition* condition) {
+#ifdef _WIN32
+    SleepConditionVariableCS(condition, &pool->lock, INFINITE);
+#else
+    pthread_cond_wait(condition, &pool->lock);
+#endif
+}
+
+static void signal_condition(pool_condition* condition) {
+#ifdef _WIN32
+    WakeConditionVariable(condition);
+#else
+    pthread_cond_signal(condition);
+#endif
+}
+
+static void broadcast_condition(pool_condition* condition) {
+#ifdef _WIN32
+    WakeAllConditionVariable(condition);
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
+
+static void run_worker(ThreadPool* pool) {
+    for (;;) {
+        lock_pool(pool);
+        while (!pool->head && !pool->shutting_down) {
+            wait_condition(pool, &pool->work_available);
+        }
+        if (!pool->head) {
+            unlock_pool(pool);
+            return;
+        }
+
+        ThreadPoolTask* task = pool->head;
+        pool->head = task->next;
+        if (!pool->head) pool->tail = NULL;
+        unlock_pool(pool);
+
+        task->function(task->argument);
+        free(task);
+
+        lock_pool(pool);
+        pool->unfinished--;
+        if (pool->unfinished == 0) {
+            broadcast_condition(&pool->work_done);
+        }
+        unlock_pool(pool);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_entry(LPVOID argument) {
+    run_worker((ThreadPool*)argument);
+    return 0;
+}
+#else
+static void* worker_entry(void* argument) {
+    run_worker((ThreadPool*)argument);
+    return NULL;
+}
+#endif
+
+int get_cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+ThreadPool* create_thread_pool(int worker_count) {
+    if (worker_count < 1) worker_count = get_cpu_count();
+
+    ThreadPool* pool = malloc(sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->workers = malloc(worker_count * sizeof(pool_thread));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->unfinished = 0;
+    pool->shutting_down = 0;
+    pool->worker_count = 0;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->work_available);
+    InitializeConditionVariable(&pool->work_done);
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+#endif
+
+    for (int i = 0; i < worker_count; i++) {
+#ifdef _WIN32
+        pool->workers[i] = CreateThread(NULL, 0, worker_entry, pool, 0, NULL);
+        if (!pool->workers[i]) break;
+#else
+        if (pthread_create(&pool->workers[i], NULL, worker_entry, pool) != 0) break;
+#endif
+        pool->worker_count++;
+    }
+
+    // Run with however many workers could be started
+    if (pool->worker_count == 0) {
+        free_thread_pool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int submit_thread_pool_task(ThreadPool* pool, thread_pool_task task, void* argument) {
+    if (!pool || !task) return 0;
+
+    ThreadPoolTask* item = malloc(sizeof(ThreadPoolTask));
+    if (!item) return 0;
+    item->function = task;
+    item->argument = argument;
+    item->next = NULL;
+
+    lock_pool(pool);
+    if (pool->tail) {
+        pool->tail->next = item;
+    } else {
+        pool->head = item;
+    }
+    pool->tail = item;
+    pool->unfinished++;
+    signal_condition(&pool->work_available);
+    unlock_pool(pool);
+    return 1;
+}
+
+void wait_thread_pool(ThreadPool* pool) {
+    if (!pool) return;
+
+    lock_pool(pool);
+    while (pool->unfinished > 0) {
+        wait_condition(pool, &pool->work_done);
+    }
+    unlock_pool(pool);
+}
+
+int get_thread_pool_size(ThreadPool* pool) {
+    if (!pool) return 0;
+    return pool->worker_count;
+}
+
+void free_thread_pool(ThreadPool* pool) {
+    if (!pool) return;
+
+    lock_pool(pool);
+    pool->shutting_down = 1;
+    broadcast_condition(&pool->work_available);
+    unlock_pool(pool);
+
+    for (int i = 0; i < pool->worker_count; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(pool->workers[i], INFINITE);
+        CloseHandle(pool->workers[i]);
+#else
+        pthread_join(pool->workers[i], NULL);
+#endif
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&pool->lock);
+#else
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->work_done);
+#endif
+
+    free(pool->workers);
+    free(pool);
+}
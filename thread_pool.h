@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+typedef struct ThreadPool ThreadPool;
+
+// Work item executed on a pool thread
+typedef void (*thread_pool_task)(void* argument);
+
+/**
+ * Start a pool of worker threads
+ * @param worker_count Number of threads (values < 1 use get_cpu_count())
+ * @return Pool handle, or NULL if no thread could be started
+ */
+ThreadPool* create_thread_pool(int worker_count);
+
+/**
+ * Queue a task; tasks start in submission order on the first free worker
+ * @return 1 on success, 0 on allocation failure
+ */
+int submit_thread_pool_task(ThreadPool* pool, thread_pool_task task, void* argument);
+
+/**
+ * Block until every submitted task has finished
+ */
+void wait_thread_pool(ThreadPool* pool);
+
+/**
+ * Get the number of worker threads in the pool
+ */
+int get_thread_pool_size(ThreadPool* pool);
+
+/**
+ * Finish outstanding tasks, stop the workers and release the pool
+ */
+void free_thread_pool(ThreadPool* pool);
+
+/**
+ * Number of online processors (at least 1)
+ */
+int get_cpu_count();
+
+#endif
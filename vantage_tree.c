@@ -0,0 +1,375 @@
+#include "vantage_tree.h"
+#include "similarity_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Vectors per leaf; a leaf is scored in one pass over contiguous vectors
+#define VANTAGE_LEAF 16
+
+// Added to every search radius: acos() of a rounded dot product may be off by about
+// 1e-8 near similarity 1, and the triangle inequality must never drop a true match
+#define DISTANCE_SLACK 1e-6
+
+typedef struct {
+    int begin;              // Positions covered (internal nodes keep their vantage vector at begin)
+    int end;
+    int inside;             // Child with the vectors at most the median distance away (-1 for a leaf)
+    int outside;            // Child with the rest
+    double inside_min;      // Distance range from the vantage vector, per child
+    double inside_max;
+    double outside_min;
+    double outside_max;
+} VantageNode;
+
+struct VantageTree {
+    int dimensions;
+    int size;               // Vectors the tree was built over, present or not
+    int count;              // Vectors in the tree
+    int* ids;               // Index of the vector at each position
+    double* vectors;        // Vectors in tree order, so each subtree is one contiguous run
+    VantageNode* nodes;
+    int node_count;
+    int root;               // -1 when empty
+};
+
+typedef struct {
+    double distance;        // From the vantage vector of the node being built
+    int id;
+} VantageItem;
+
+typedef struct {
+    const double* vectors;  // Caller's vectors, by index
+    VantageItem* items;
+    unsigned long long random_state;
+} VantageBuild;
+
+static double angular_distance(double similarity) {
+    if (similarity >= 1.0) return 0.0;
+    if (similarity <= -1.0) return acos(-1.0);
+    return acos(similarity);
+}
+
+static const double* tree_vector(const VantageTree* tree, int position) {
+    return tree->vectors + (size_t)position * tree->dimensions;
+}
+
+/* ---------- Construction ---------- */
+
+// Reorder items[begin, end) so the item at nth has the nth smallest distance, with no
+// larger distances before it and no smaller ones after it
+static void select_items(VantageItem* items, int begin, int end, int nth) {
+    while (end - begin > 1) {
+        double pivot = items[begin + (end - begin) / 2].distance;
+        int i = begin;
+        int j = end - 1;
+        while (i <= j) {
+            while (items[i].distance < pivot) i++;
+            while (items[j].distance > pivot) j--;
+            if (i <= j) {
+                VantageItem swap = items[i];
+                items[i] = items[j];
+                items[j] = swap;
+                i++;
+                j--;
+            }
+        }
+        if (nth <= j) {
+            end = j + 1;
+        } else if (nth >= i) {
+            begin = i;
+        } else {
+            return; // Between the two halves: equal to the pivot
+        }
+    }
+}
+
+static unsigned int next_random(VantageBuild* build) {
+    unsigned long long state = build->random_state;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    build->random_state = state;
+    return (unsigned int)((state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static void distance_range(const VantageItem* items, int begin, int end, double* min, double* max) {
+    *min = items[begin].distance;
+    *max = items[begin].distance;
+    for (int i = begin + 1; i < end; i++) {
+        if (items[i].distance < *min) *min = items[i].distance;
+        if (items[i].distance > *max) *max = items[i].distance;
+    }
+}
+
+// Build the subtree over items[begin, end) (not empty); returns its node
+static int build_node(VantageTree* tree, VantageBuild* build, int begin, int end) {
+    int index = tree->node_count++;
+    VantageNode* node = &tree->nodes[index];
+    node->begin = begin;
+    node->end = end;
+    node->inside = -1;
+    node->outside = -1;
+    if (end - begin <= VANTAGE_LEAF) return index;
+
+    // A random vantage vector; the others are split at their median distance from it
+    VantageItem* items = build->items;
+    int vantage = begin + (int)(next_random(build) % (unsigned int)(end - begin));
+    VantageItem swap = items[begin];
+    items[begin] = items[vantage];
+    items[vantage] = swap;
+
+    const double* vantage_vector = build->vectors + (size_t)items[begin].id * tree->dimensions;
+    for (int i = begin + 1; i < end; i++) {
+        const double* vector = build->vectors + (size_t)items[i].id * tree->dimensions;
+        items[i].distance = angular_distance(similarity_dot(vantage_vector, vector, tree->dimensions));
+    }
+    int middle = begin + 1 + (end - begin - 1) / 2;
+    select_items(items, begin + 1, end, middle);
+    distance_range(items, begin + 1, middle, &node->inside_min, &node->inside_max);
+    distance_range(items, middle, end, &node->outside_min, &node->outside_max);
+
+    // Children are built after node is filled in (nodes never move: the array is preallocated)
+    int inside = build_node(tree, build, begin + 1, middle);
+    int outside = build_node(tree, build, middle, end);
+    tree->nodes[index].inside = inside;
+    tree->nodes[index].outside = outside;
+    return index;
+}
+
+VantageTree* build_vantage_tree(const double* vectors, const char* has_vector, int count, int dimensions) {
+    if ((!vectors && count > 0) || count < 0 || dimensions < 1) return NULL;
+
+    VantageTree* tree = calloc(1, sizeof(VantageTree));
+    if (!tree) return NULL;
+    tree->dimensions = dimensions;
+    tree->size = count;
+    tree->root = -1;
+
+    int present = 0;
+    for (int i = 0; i < count; i++) {
+        if (!has_vector || has_vector[i]) present++;
+    }
+    size_t slots = present > 0 ? (size_t)present : 1;
+    tree->ids = malloc(slots * sizeof(int));
+    tree->vectors = malloc(slots * dimensions * sizeof(double));
+    tree->nodes = malloc(slots * sizeof(VantageNode)); // Every node owns at least one vector
+    VantageBuild build;
+    build.vectors = vectors;
+    build.items = malloc(slots * sizeof(VantageItem));
+    build.random_state = 0x9E3779B97F4A7C15ull;
+    if (!tree->ids || !tree->vectors || !tree->nodes || !build.items) {
+        free(build.items);
+        free_vantage_tree(tree);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (has_vector && !has_vector[i]) continue;
+        build.items[tree->count].id = i;
+        build.items[tree->count].distance = 0.0;
+        tree->count++;
+    }
+    if (tree->count > 0) tree->root = build_node(tree, &build, 0, tree->count);
+
+    for (int position = 0; position < tree->count; position++) {
+        tree->ids[position] = build.items[position].id;
+        memcpy(tree->vectors + (size_t)position * dimensions, vectors + (size_t)build.items[position].id * dimensions,
+               (size_t)dimensions * sizeof(double));
+    }
+    free(build.items);
+    return tree;
+}
+
+int get_vantage_tree_size(const VantageTree* tree) {
+    return tree ? tree->size : 0;
+}
+
+/* ---------- Queries ---------- */
+
+// 1 if a is more similar than b (ties to the lower index)
+static int match_better(const SimilarityMatch* a, const SimilarityMatch* b) {
+    return a->similarity > b->similarity || (a->similarity == b->similarity && a->index < b->index);
+}
+
+static int compare_matches_best_first(const void* a, const void* b) {
+    const SimilarityMatch* first = (const SimilarityMatch*)a;
+    const SimilarityMatch* second = (const SimilarityMatch*)b;
+    if (match_better(first, second)) return -1;
+    if (match_better(second, first)) return 1;
+    return 0;
+}
+
+// Can a child whose distances from the vantage vector lie in [min, max] hold a vector
+// within radius of a query at distance from the vantage vector?
+static int child_in_reach(double distance, double radius, double min, double max) {
+    return distance - radius <= max && distance + radius >= min;
+}
+
+typedef struct {
+    SimilarityMatch* matches;
+    int length;
+    int capacity;
+    int failed;
+} RangeResults;
+
+static void add_range_match(RangeResults* results, int id, double similarity) {
+    if (results->length == results->capacity) {
+        int capacity = results->capacity > 0 ? results->capacity * 2 : 64;
+        SimilarityMatch* matches = realloc(results->matches, (size_t)capacity * sizeof(SimilarityMatch));
+        if (!matches) {
+            results->failed = 1;
+            return;
+        }
+        results->matches = matches;
+        results->capacity = capacity;
+    }
+    results->matches[results->length].index = id;
+    results->matches[results->length].similarity = similarity;
+    results->length++;
+}
+
+static void search_range(const VantageTree* tree, int index, const double* query, double min_similarity,
+                         double radius, RangeResults* results) {
+    const VantageNode* node = &tree->nodes[index];
+    if (node->inside < 0) {
+        double scores[VANTAGE_LEAF];
+        int count = node->end - node->begin;
+        similarity_dot_many(query, tree_vector(tree, node->begin), count, tree->dimensions, scores);
+        for (int i = 0; i < count; i++) {
+            if (scores[i] >= min_similarity) add_range_match(results, tree->ids[node->begin + i], scores[i]);
+        }
+        return;
+    }
+
+    double similarity = similarity_dot(query, tree_vector(tree, node->begin), tree->dimensions);
+    if (similarity >= min_similarity) add_range_match(results, tree->ids[node->begin], similarity);
+    double distance = angular_distance(similarity);
+    if (child_in_reach(distance, radius, node->inside_min, node->inside_max)) {
+        search_range(tree, node->inside, query, min_similarity, radius, results);
+    }
+    if (child_in_reach(distance, radius, node->outside_min, node->outside_max)) {
+        search_range(tree, node->outside, query, min_similarity, radius, results);
+    }
+}
+
+int find_vantage_range(const VantageTree* tree, const double* query, double min_similarity, SimilarityMatch** results) {
+    if (!results) return -1;
+    *results = NULL;
+    if (!tree || !query) return -1;
+
+    RangeResults found = { NULL, 0, 0, 0 };
+    if (tree->root >= 0) {
+        double radius = angular_distance(min_similarity) + DISTANCE_SLACK;
+        search_range(tree, tree->root, query, min_similarity, radius, &found);
+    }
+    if (found.failed) {
+        free(found.matches);
+        return -1;
+    }
+
+    if (found.length > 1) qsort(found.matches, found.length, sizeof(SimilarityMatch), compare_matches_best_first);
+    *results = found.matches ? found.matches : malloc(sizeof(SimilarityMatch));
+    if (!*results) return -1;
+    return found.length;
+}
+
+/* ---------- k nearest: min-heap of k matches, worst first ---------- */
+
+typedef struct {
+    SimilarityMatch* heap;
+    int length;
+    int k;
+    int exclude;
+} NearestResults;
+
+static void sift_down_match(SimilarityMatch* heap, int length, int slot) {
+    for (;;) {
+        int worst = slot;
+        int left = 2 * slot + 1;
+        int right = left + 1;
+        if (left < length && match_better(&heap[worst], &heap[left])) worst = left;
+        if (right < length && match_better(&heap[worst], &heap[right])) worst = right;
+        if (worst == slot) return;
+
+        SimilarityMatch swap = heap[slot];
+        heap[slot] = heap[worst];
+        heap[worst] = swap;
+        slot = worst;
+    }
+}
+
+static void offer_nearest(NearestResults* results, int id, double similarity) {
+    if (id == results->exclude) return;
+
+    SimilarityMatch match = { id, similarity };
+    if (results->length < results->k) {
+        int slot = results->length++;
+        while (slot > 0 && match_better(&results->heap[(slot - 1) / 2], &match)) {
+            results->heap[slot] = results->heap[(slot - 1) / 2];
+            slot = (slot - 1) / 2;
+        }
+        results->heap[slot] = match;
+    } else if (match_better(&match, &results->heap[0])) {
+        results->heap[0] = match;
+        sift_down_match(results->heap, results->length, 0);
+    }
+}
+
+// Distance within which a vector could still enter the results
+static double nearest_radius(const NearestResults* results) {
+    if (results->length < results->k) return 8.0; // Beyond any angle
+    return angular_distance(results->heap[0].similarity) + DISTANCE_SLACK;
+}
+
+static void search_nearest(const VantageTree* tree, int index, const double* query, NearestResults* results) {
+    const VantageNode* node = &tree->nodes[index];
+    if (node->inside < 0) {
+        double scores[VANTAGE_LEAF];
+        int count = node->end - node->begin;
+        similarity_dot_many(query, tree_vector(tree, node->begin), count, tree->dimensions, scores);
+        for (int i = 0; i < count; i++) offer_nearest(results, tree->ids[node->begin + i], scores[i]);
+        return;
+    }
+
+    double similarity = similarity_dot(query, tree_vector(tree, node->begin), tree->dimensions);
+    offer_nearest(results, tree->ids[node->begin], similarity);
+    double distance = angular_distance(similarity);
+
+    // The child on the query's side of the median first: its matches shrink the radius
+    int first = distance <= node->inside_max ? node->inside : node->outside;
+    int second = first == node->inside ? node->outside : node->inside;
+    for (int pass = 0; pass < 2; pass++) {
+        int child = pass == 0 ? first : second;
+        int inside = child == node->inside;
+        if (child_in_reach(distance, nearest_radius(results), inside ? node->inside_min : node->outside_min,
+                           inside ? node->inside_max : node->outside_max)) {
+            search_nearest(tree, child, query, results);
+        }
+    }
+}
+
+int find_vantage_nearest(const VantageTree* tree, const double* query, int k, int exclude, SimilarityMatch* results) {
+    if (!tree || !query || !results || k < 1 || tree->root < 0) return 0;
+
+    NearestResults found = { results, 0, k, exclude };
+    search_nearest(tree, tree->root, query, &found);
+
+    // Heap sort: each removed worst match goes to the end, leaving the best first
+    for (int end = found.length - 1; end > 0; end--) {
+        SimilarityMatch swap = results[0];
+        results[0] = results[end];
+        results[end] = swap;
+        sift_down_match(results, end, 0);
+    }
+    return found.length;
+}
+
+void free_vantage_tree(VantageTree* tree) {
+    if (!tree) return;
+
+    free(tree->ids);
+    free(tree->vectors);
+    free(tree->nodes);
+    free(tree);
+}
@@ -0,0 +1,46 @@
+#ifndef VANTAGE_TREE_H
+#define VANTAGE_TREE_H
+
+#include "fingerprint_index.h"
+
+/**
+ * Vantage-point tree over unit-length vectors with the angular distance
+ * acos(a . b), a metric on the sphere. Each node splits its vectors at the median
+ * distance from a vantage vector, so a query skips every subtree the triangle
+ * inequality rules out. Results are exact: a vector is reported by its dot-product
+ * similarity, the same value a full scan computes.
+ */
+typedef struct VantageTree VantageTree;
+
+/**
+ * Build the tree over count vectors stored back to back (vector i starts at
+ * vectors + i * dimensions; they are copied). O(count log count) distance computations.
+ * @param has_vector has_vector[i] == 0 leaves vector i out (may be NULL: all present)
+ * @return New tree, or NULL on allocation failure
+ */
+VantageTree* build_vantage_tree(const double* vectors, const char* has_vector, int count, int dimensions);
+
+/**
+ * Number of vectors the tree was built over (count passed to build_vantage_tree())
+ */
+int get_vantage_tree_size(const VantageTree* tree);
+
+/**
+ * Range query: every vector with similarity >= min_similarity to query
+ * @param results Receives a malloc'd array of the matches, most similar first (ties go
+ *        to the lower index); free it with free()
+ * @return Number of matches, or -1 on allocation failure
+ */
+int find_vantage_range(const VantageTree* tree, const double* query, double min_similarity, SimilarityMatch** results);
+
+/**
+ * The k vectors most similar to query, most similar first (ties go to the lower index)
+ * @param exclude Index to leave out (-1 for none)
+ * @param results Array of k matches
+ * @return Number of matches
+ */
+int find_vantage_nearest(const VantageTree* tree, const double* query, int k, int exclude, SimilarityMatch* results);
+
+void free_vantage_tree(VantageTree* tree);
+
+#endif